@@ -18,6 +18,8 @@ limitations under the License.
 #include "Network.h"
 
 #include "AsioSocket.h"
+#include "Resolver.h"
+#include "VirtualNetwork.h"
 
 #include <HermesData.hpp>
 #include "IService.h"
@@ -33,6 +35,8 @@ namespace Hermes
     struct ClientSocket : IClientSocket
     {
         AsioSocket m_socket;
+        Resolver m_resolver{m_socket.m_executor};
+        RetryBackoff m_retryBackoff;
 
         ClientSocket(unsigned sessionId, const NetworkConfiguration& configuration, 
             IAsioService& asioService) :
@@ -68,9 +72,9 @@ namespace Hermes
             AsyncConnect_();
         }
 
-        void Send(StringView message) override 
+        void Send(StringView message, unsigned serializeTimeInMicroseconds) override 
         { 
-            m_socket.Send(message); 
+            m_socket.Send(message, serializeTimeInMicroseconds); 
         }
 
         void Close() override 
@@ -95,24 +99,43 @@ namespace Hermes
             m_socket.m_service.Log(m_socket.m_sessionId, "AsyncConnect_ to host=", 
                 m_socket.m_configuration.m_hostName, " on port=", m_socket.m_configuration.m_port);
 
-            asio::ip::tcp::resolver resolver(m_socket.m_asioService);
-            asio::ip::tcp::resolver::query query(asio::ip::tcp::v4(), m_socket.m_configuration.m_hostName, "");
+            m_resolver.AsyncResolve(m_socket.m_configuration.m_hostName,
+                [wpThis = std::weak_ptr<ClientSocket>(shared_from_this())](const boost::system::error_code& ec, const ResolvedAddresses& addresses)
+            {
+                auto spThis = wpThis.lock();
+                if (!spThis || spThis->m_socket.Closed())
+                    return;
 
-            boost::system::error_code ec;
-            auto itEndpoint = resolver.resolve(query, ec);
+                spThis->OnResolved_(ec, addresses);
+            });
+        }
+
+        void OnResolved_(const boost::system::error_code& ec, const ResolvedAddresses& addresses)
+        {
             if (ec)
             {
-                m_socket.Alarm(ec, "Unable to resolve ", query.host_name());
+                m_socket.Alarm(ec, "Unable to resolve ", m_socket.m_configuration.m_hostName);
                 RetryLater_();
                 return;
             }
-                
-            asio::ip::tcp::endpoint endpoint(*itEndpoint);
-            endpoint.port(m_socket.m_configuration.m_port);
+
+            asio::ip::tcp::endpoint endpoint(addresses.front(), m_socket.m_configuration.m_port);
 
             m_socket.m_connectionInfo.m_address = endpoint.address().to_string();
             m_socket.m_connectionInfo.m_port = endpoint.port();
-            m_socket.m_connectionInfo.m_hostName = itEndpoint->host_name();
+            m_socket.m_connectionInfo.m_hostName = m_socket.m_configuration.m_hostName;
+
+            // a fresh socket for every attempt, tuned before the handshake:
+            boost::system::error_code ecOpen;
+            m_socket.m_socket.close(ecOpen);
+            m_socket.m_socket.open(endpoint.protocol(), ecOpen);
+            if (ecOpen)
+            {
+                m_socket.Alarm(ecOpen, "Unable to open socket");
+                RetryLater_();
+                return;
+            }
+            m_socket.ApplySocketSettings();
 
             m_socket.m_service.Log(m_socket.m_sessionId, "Connecting to ", m_socket.m_connectionInfo, " ...");
             m_socket.m_socket.async_connect(endpoint, 
@@ -142,7 +165,9 @@ namespace Hermes
                 return;
             }
 
+            m_retryBackoff.Reset();
             m_socket.m_service.Inform(m_socket.m_sessionId, "OnConnected ", m_socket.m_connectionInfo);
+            m_socket.m_service.OnSocketConnected(m_socket.m_sessionId);
             m_socket.m_pCallback->OnConnected(m_socket.m_connectionInfo);
             m_socket.StartReceiving();
         }
@@ -152,16 +177,14 @@ namespace Hermes
             if (m_socket.Closed())
                 return;
 
-            m_socket.m_timer.expires_from_now(
-                boost::posix_time::milliseconds(static_cast<int>(1000.0 * m_socket.m_configuration.m_retryDelayInSeconds)));
-            m_socket.m_timer.async_wait([spThis = shared_from_this()](const boost::system::error_code& ec)
+            auto delayInSeconds = m_retryBackoff.NextDelayInSeconds(m_socket.m_configuration.m_retryPolicy);
+            m_socket.m_service.Log(m_socket.m_sessionId, "Retry connecting in ", delayInSeconds, "s, attempt=", m_retryBackoff.Attempt());
+            m_socket.m_timer.ExpiresFromNow(std::chrono::milliseconds(static_cast<int>(1000.0 * delayInSeconds)),
+                [spThis = shared_from_this()]()
             {
                 if (spThis->m_socket.Closed())
                     return;
 
-                if (ec) // we were canccelled
-                    return;
-
                 spThis->AsyncConnect_();
             });
         }
@@ -171,5 +194,7 @@ namespace Hermes
 std::unique_ptr<Hermes::IClientSocket> Hermes::CreateClientSocket(unsigned sessionId,
     const NetworkConfiguration& configuration, IAsioService& asioService)
 {
+    if (auto* pVirtualNetwork = asioService.GetVirtualNetwork())
+        return CreateVirtualClientSocket(sessionId, configuration, asioService, *pVirtualNetwork);
     return std::make_unique<ClientSocket>(sessionId, configuration, asioService);
 }
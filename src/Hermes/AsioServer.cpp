@@ -18,13 +18,18 @@ limitations under the License.
 #include "AsioSocket.h"
 #include "IService.h"
 #include "MessageSerialization.h"
+#include "Resolver.h"
 #include "StringBuilder.h"
+#include "VirtualNetwork.h"
 
 #include <HermesData.hpp>
 
 #include <boost/asio.hpp>
 
+#include <cstdint>
 #include <mutex>
+#include <unordered_set>
+#include <vector>
 
 namespace asio = boost::asio;
 
@@ -32,6 +37,31 @@ namespace Hermes
 {
     using AsioSocketSp = std::shared_ptr<AsioSocket>;
 
+    // on the socket's strand once the session has taken over, as from then on only the session reads the connection info:
+    inline void AsyncReverseLookup(const AsioSocketSp& spSocket, const asio::ip::tcp::endpoint& endpoint)
+    {
+        auto spResolver = std::make_shared<asio::ip::tcp::resolver>(spSocket->m_executor);
+        spResolver->async_resolve(endpoint, [spResolver, wpSocket = std::weak_ptr<AsioSocket>(spSocket), endpoint]
+            (const boost::system::error_code& ec, asio::ip::tcp::resolver::iterator itResolved)
+        {
+            auto spSocket = wpSocket.lock();
+            if (!spSocket || spSocket->Closed())
+                return;
+
+            if (ec)
+            {
+                spSocket->Info(ec, "Unable to resolve ip address ", endpoint);
+                return;
+            }
+
+            spSocket->m_connectionInfo.m_hostName = itResolved->host_name();
+            auto duration = std::chrono::duration_cast<std::chrono::milliseconds>(
+                std::chrono::steady_clock::now() - spSocket->m_acceptTime);
+            spSocket->m_service.Log(spSocket->m_sessionId, "Reverse lookup after ", duration.count(), "ms: ", spSocket->m_connectionInfo);
+            spSocket->m_service.OnHostNameResolved(spSocket->m_sessionId, spSocket->m_connectionInfo.m_hostName);
+        });
+    }
+
     struct ServerSocket : IServerSocket
     {
         AsioSocketSp m_spSocket;
@@ -65,46 +95,192 @@ namespace Hermes
         {
             m_spSocket->m_wpOwner = std::move(wpOwner);
             m_spSocket->m_pCallback = &callback;
-            m_spSocket->m_asioService.post([spSocket = m_spSocket]()
+            asio::post(m_spSocket->m_executor, [spSocket = m_spSocket]()
             {
                 if (spSocket->Closed())
                     return;
+
+                auto latency = std::chrono::duration_cast<std::chrono::microseconds>(
+                    std::chrono::steady_clock::now() - spSocket->m_acceptTime);
+                spSocket->m_service.Inform(spSocket->m_sessionId, "Accept to OnConnected latency=", latency.count(), "us");
+                spSocket->m_service.OnSocketConnected(spSocket->m_sessionId, static_cast<unsigned>(latency.count()));
                 spSocket->m_pCallback->OnConnected(spSocket->m_connectionInfo);
+
+                // the host name is filled in once known, so the handshake need not wait for a reverse lookup:
+                boost::system::error_code ec;
+                const auto& endpoint = spSocket->m_socket.remote_endpoint(ec);
+                if (!ec && spSocket->m_configuration.m_reverseLookupMode == EReverseLookupMode::eASYNCHRONOUS)
+                {
+                    AsyncReverseLookup(spSocket, endpoint);
+                }
             });
             m_spSocket->StartReceiving();
         }
 
-        void Send(StringView message) override
+        void Send(StringView message, unsigned serializeTimeInMicroseconds) override
         {
-            m_spSocket->Send(message);
+            m_spSocket->Send(message, serializeTimeInMicroseconds);
         }
 
         void Close() override
         {
             m_spSocket->Close();
         }
+
+        void Post(Task&& f) override
+        {
+            asio::post(m_spSocket->m_executor, std::move(f));
+        }
+
+        void Dispatch(Task&& f) override
+        {
+            asio::dispatch(m_spSocket->m_executor, std::move(f));
+        }
     };
 
     struct AcceptorResources
     {
-        asio::deadline_timer m_timer;
+        WheelTimer m_timer;
+        WheelTimer m_refreshTimer;
         asio::ip::tcp::acceptor m_acceptor;
         bool m_closed = false;
 
-        AcceptorResources(asio::io_service& asioService) :
-            m_timer(asioService),
-            m_acceptor(asioService)
+        AcceptorResources(IAsioService& service, const AsioExecutor& executor) :
+            m_timer(service, executor),
+            m_refreshTimer(service, executor),
+            m_acceptor(executor)
         {}
     };
 
+    // how often the host names of the allowed peers are resolved again:
+    constexpr double cALLOWED_PEERS_REFRESH_IN_SECONDS = 60.0;
+
+    // The peers allowed to connect, as configured in NetworkConfiguration::m_hostName:
+    // host names, ip addresses and CIDR ranges (e.g. 192.168.1.0/24), separated by ',', ';' or blanks.
+    // The host names are resolved in the background, so that checking a peer is just a lookup.
+    struct AllowedPeers
+    {
+        using Network = std::pair<std::uint32_t, std::uint32_t>; // address, mask
+
+        std::vector<std::string> m_hostNames;
+        std::vector<ResolvedAddresses> m_resolvedAddresses; // per host name, kept if a refresh fails
+        std::vector<std::uint32_t> m_literalAddresses;
+        std::vector<Network> m_networks;
+        std::unordered_set<std::uint32_t> m_addresses; // literal and resolved ones
+        std::size_t m_unresolvedCount = 0U;
+
+        bool Allows(const asio::ip::address& address) const
+        {
+            if (!address.is_v4())
+                return false;
+
+            auto value = static_cast<std::uint32_t>(address.to_v4().to_ulong());
+            if (m_addresses.count(value))
+                return true;
+
+            for (const auto& network : m_networks)
+            {
+                if ((value & network.second) == network.first)
+                    return true;
+            }
+            return false;
+        }
+
+        void Rebuild()
+        {
+            m_addresses.clear();
+            m_addresses.insert(m_literalAddresses.begin(), m_literalAddresses.end());
+            for (const auto& addresses : m_resolvedAddresses)
+            {
+                for (const auto& address : addresses)
+                {
+                    if (address.is_v4())
+                    {
+                        m_addresses.insert(static_cast<std::uint32_t>(address.to_v4().to_ulong()));
+                    }
+                }
+            }
+        }
+
+        template<class S>
+        friend S& operator<<(S& s, const AllowedPeers& peers)
+        {
+            s << "{m_addresses=";
+            for (auto address : peers.m_addresses)
+            {
+                s << asio::ip::address_v4(address).to_string() << ' ';
+            }
+            s << ",m_networks=";
+            for (const auto& network : peers.m_networks)
+            {
+                s << asio::ip::address_v4(network.first).to_string() << '/' << asio::ip::address_v4(network.second).to_string() << ' ';
+            }
+            s << ",m_unresolvedCount=" << peers.m_unresolvedCount << '}';
+            return s;
+        }
+    };
+
+    inline AllowedPeers ParseAllowedPeers(IAsioService& service, unsigned sessionId, const std::string& text)
+    {
+        AllowedPeers peers;
+        std::size_t pos = 0U;
+        while (pos < text.size())
+        {
+            std::size_t endPos = text.find_first_of(",; \t", pos);
+            if (endPos == std::string::npos)
+            {
+                endPos = text.size();
+            }
+            std::string entry = text.substr(pos, endPos - pos);
+            pos = endPos + 1U;
+            if (entry.empty())
+                continue;
+
+            boost::system::error_code ec;
+            std::size_t slashPos = entry.find('/');
+            if (slashPos != std::string::npos)
+            {
+                auto address = asio::ip::address_v4::from_string(entry.substr(0U, slashPos), ec);
+                const std::string& prefixText = entry.substr(slashPos + 1U);
+                if (ec || prefixText.empty() || prefixText.size() > 2U 
+                    || prefixText.find_first_not_of("0123456789") != std::string::npos || std::stoi(prefixText) > 32)
+                {
+                    service.Warn(sessionId, "Ignoring invalid allowed network ", entry);
+                    continue;
+                }
+                int prefix = std::stoi(prefixText);
+                std::uint32_t mask = prefix ? ~std::uint32_t{0U} << (32 - prefix) : 0U;
+                peers.m_networks.emplace_back(static_cast<std::uint32_t>(address.to_ulong()) & mask, mask);
+                continue;
+            }
+
+            auto address = asio::ip::address_v4::from_string(entry, ec);
+            if (!ec)
+            {
+                peers.m_literalAddresses.push_back(static_cast<std::uint32_t>(address.to_ulong()));
+                continue;
+            }
+            peers.m_hostNames.push_back(entry);
+        }
+        peers.m_resolvedAddresses.resize(peers.m_hostNames.size());
+        peers.m_unresolvedCount = peers.m_hostNames.size();
+        peers.Rebuild();
+        return peers;
+    }
+
     struct AsioAcceptor : IAcceptor
     {
         unsigned m_sessionId = 1U;
         IAsioService& m_service;
-        asio::io_service& m_asioService{m_service.GetUnderlyingService()};
+        AsioExecutor m_executor{m_service.GetExecutor()};
         Optional<NetworkConfiguration> m_optionalConfiguration;
         IAcceptorCallback& m_callback;
-        std::shared_ptr<AcceptorResources> m_spResources{std::make_shared<AcceptorResources>(m_asioService)};
+        std::shared_ptr<AcceptorResources> m_spResources{std::make_shared<AcceptorResources>(m_service, m_executor)};
+        AllowedPeers m_allowedPeers;
+        std::vector<std::unique_ptr<Resolver>> m_upResolvers; // one per allowed host name
+        std::size_t m_pendingResolveCount = 0U;
+        bool m_allowedPeersResolved = false;
+        RetryBackoff m_retryBackoff;
 
         AsioAcceptor(IAsioService& asioService, IAcceptorCallback& callback) :
             m_service(asioService),
@@ -125,20 +301,102 @@ namespace Hermes
                 return;
 
             m_optionalConfiguration = configuration;
+            m_retryBackoff.Reset();
             boost::system::error_code ecDummy;
             m_spResources->m_acceptor.cancel(ecDummy);
             m_spResources->m_acceptor.close(ecDummy);
-            Listen_();
+            m_spResources->m_refreshTimer.Cancel();
+
+            // listen only once we know whom to accept:
+            m_allowedPeers = ParseAllowedPeers(m_service, m_sessionId, configuration.m_hostName);
+            m_upResolvers.clear();
+            m_allowedPeersResolved = m_allowedPeers.m_hostNames.empty();
+            if (m_allowedPeersResolved)
+            {
+                Listen_();
+                return;
+            }
+            ResolveAllowedPeers_();
         }
 
         void StopListening() override
         {
             m_optionalConfiguration.reset();
+            m_upResolvers.clear();
             boost::system::error_code ecDummy;
             m_spResources->m_acceptor.close(ecDummy);
+            m_spResources->m_refreshTimer.Cancel();
         }
 
         // internals
+        void ResolveAllowedPeers_()
+        {
+            if (m_spResources->m_closed)
+                return;
+
+            const auto& hostNames = m_allowedPeers.m_hostNames;
+            m_upResolvers.resize(hostNames.size());
+            m_pendingResolveCount = hostNames.size();
+            for (std::size_t i = 0U; i < hostNames.size(); ++i)
+            {
+                if (!m_upResolvers[i])
+                {
+                    m_upResolvers[i] = std::make_unique<Resolver>(m_executor);
+                }
+                m_upResolvers[i]->AsyncResolve(hostNames[i],
+                    [this, i, spResources = m_spResources](const boost::system::error_code& ec, const ResolvedAddresses& addresses)
+                {
+                    if (spResources->m_closed)
+                        return;
+
+                    OnAllowedPeerResolved_(i, ec, addresses);
+                });
+            }
+        }
+
+        void OnAllowedPeerResolved_(std::size_t index, const boost::system::error_code& ec, const ResolvedAddresses& addresses)
+        {
+            if (ec)
+            {
+                Alarm(ec, "Unable to resolve allowed host ", m_allowedPeers.m_hostNames[index]);
+            }
+            else
+            {
+                m_allowedPeers.m_resolvedAddresses[index] = addresses;
+            }
+
+            if (--m_pendingResolveCount)
+                return;
+
+            m_allowedPeers.m_unresolvedCount = 0U;
+            for (const auto& resolvedAddresses : m_allowedPeers.m_resolvedAddresses)
+            {
+                m_allowedPeers.m_unresolvedCount += resolvedAddresses.empty() ? 1U : 0U;
+            }
+            m_allowedPeers.Rebuild();
+            m_service.Log(m_sessionId, "Allowed peers ", m_allowedPeers);
+
+            if (!m_optionalConfiguration)
+                return;
+
+            // retry unresolved host names sooner:
+            double refreshInSeconds = m_allowedPeers.m_unresolvedCount ? 
+                m_optionalConfiguration->m_retryPolicy.m_maxDelayInSeconds : cALLOWED_PEERS_REFRESH_IN_SECONDS;
+            m_spResources->m_refreshTimer.ExpiresFromNow(std::chrono::milliseconds(static_cast<int>(1000.0 * refreshInSeconds)),
+                [this, spResources = m_spResources]()
+            {
+                if (spResources->m_closed)
+                    return;
+
+                ResolveAllowedPeers_();
+            });
+
+            if (m_allowedPeersResolved)
+                return;
+            m_allowedPeersResolved = true;
+            Listen_();
+        }
+
         void Listen_()
         {
             if (m_spResources->m_closed)
@@ -151,20 +409,6 @@ namespace Hermes
             m_service.Log(m_sessionId, "Listen_ on ", configuration.m_hostName,
                 ", port=", configuration.m_port);
 
-            if (!m_optionalConfiguration->m_hostName.empty())
-            {
-                asio::ip::tcp::resolver resolver(m_asioService);
-                asio::ip::tcp::resolver::query query(asio::ip::tcp::v4(), configuration.m_hostName, "");
-                boost::system::error_code ec;
-                resolver.resolve(query, ec);
-                if (ec)
-                {
-                    Alarm(ec, "Unable to resolve ", query.host_name());
-                    RetryLater_();
-                    return;
-                }
-            }
-
             asio::ip::tcp::endpoint endpoint(asio::ip::tcp::v4(), configuration.m_port);
 
             boost::system::error_code ec;
@@ -185,6 +429,9 @@ namespace Hermes
             //    return;
             //}
 
+            // accepted sockets inherit the buffer sizes, which must be in place before the handshake:
+            ApplySocketSettings(m_service, m_sessionId, m_spResources->m_acceptor, configuration.m_socketSettings);
+
             m_spResources->m_acceptor.bind(endpoint, ec);
             if (ec)
             {
@@ -217,7 +464,13 @@ namespace Hermes
             m_service.Log(m_sessionId, "AsyncAccept_ on ", configuration.m_hostName,
                 ", port=", configuration.m_port);
 
-            auto spSocket = std::make_shared<AsioSocket>(m_sessionId, configuration, m_service);
+            auto spSocket = configuration.m_strandPerSession ?
+                std::make_shared<AsioSocket>(m_sessionId, configuration, m_service, asio::make_strand(m_service.GetUnderlyingService())) :
+                std::make_shared<AsioSocket>(m_sessionId, configuration, m_service);
+            // m_wpOwner is weak, it does not keep the socket alive: until a session takes over in Connect(),
+            // the shared_ptrs captured by its pending handlers do (the accept handler below, then those taken with
+            // shared_from_this(), e.g. for writing a refusing notification):
+            spSocket->m_wpOwner = spSocket;
             spSocket->m_connectionInfo.m_port = configuration.m_port;
             auto& asioSocket = spSocket->m_socket;
             m_spResources->m_acceptor.async_accept(asioSocket,
@@ -244,6 +497,10 @@ namespace Hermes
                 return;
             }
 
+            spSocket->m_acceptTime = std::chrono::steady_clock::now();
+            // only reset when accepting works, a successful listen may be followed by failing accepts:
+            m_retryBackoff.Reset();
+
             // we have accepted, so increment the session id:
             m_sessionId = m_sessionId == std::numeric_limits<unsigned>::max() ? 1U : m_sessionId + 1U;
 
@@ -254,71 +511,64 @@ namespace Hermes
                 NotificationData notification(ENotificationCode::eCONNECTION_RESET_BECAUSE_OF_CHANGED_CONFIGURATION,
                     ESeverity::eINFO, "ConfigurationChanged");
                 const std::string& xmlString = Serialize(notification);
-                spSocket->Send(xmlString);
+                spSocket->Send(xmlString, 0U);
                 AsyncAccept_();
                 return;
             }
             auto& configuration = *m_optionalConfiguration;
             
-            asio::ip::tcp::resolver resolver(m_asioService);
-            boost::system::error_code ecResolve;
-            const auto& endpoint = spSocket->m_socket.remote_endpoint();
-            const auto& remoteAddress = endpoint.address();
-            spSocket->m_connectionInfo.m_address = remoteAddress.to_string();
-
-            // try and resolve the remote address to a name:
-            auto itResolved = resolver.resolve(endpoint, ecResolve);
-            if (ec)
+            boost::system::error_code ecEndpoint;
+            const auto& endpoint = spSocket->m_socket.remote_endpoint(ecEndpoint);
+            if (ecEndpoint)
             {
-                spSocket->Alarm(ec, "Unable to resolve ip address ", endpoint);
+                spSocket->Info(ecEndpoint, "Accepted socket already disconnected");
+                AsyncAccept_();
+                return;
             }
-            else
+            spSocket->m_connectionInfo.m_address = endpoint.address().to_string();
+
+            if (!configuration.m_hostName.empty() && !m_allowedPeers.Allows(endpoint.address()))
             {
-                spSocket->m_connectionInfo.m_hostName = itResolved->host_name();
+                RefusePeer_(*spSocket, configuration);
+                AsyncAccept_();
+                return;
             }
 
+            spSocket->ApplySocketSettings();
+
             spSocket->m_service.Inform(spSocket->m_sessionId, "OnAccepted ", spSocket->m_connectionInfo);
+            m_callback.OnAccepted(std::make_unique<ServerSocket>(std::move(spSocket)));
+            AsyncAccept_();
+        }
 
-            if (!configuration.m_hostName.empty())
+        void RefusePeer_(AsioSocket& socket, const NetworkConfiguration& configuration)
+        {
+            std::ostringstream oss;
+            oss << "Remote host does not match allowed host " << configuration.m_hostName
+                << ",\nAllowed peers=" << m_allowedPeers
+                << ",\nRemote address=" << socket.m_connectionInfo.m_address;
+
+            // not being able to resolve an allowed host is rather our problem than the peer's:
+            auto severity = ESeverity::eWARNING;
+            if (m_allowedPeers.m_unresolvedCount)
             {
-                asio::ip::tcp::resolver::query query(asio::ip::tcp::v4(), configuration.m_hostName, "");
-                auto itAllowedEndpoint = resolver.resolve(query, ecResolve);
-                if (ecResolve)
+                severity = ESeverity::eERROR;
+                oss << ",\nConnection only allowed from a hostname which cannot be resolved:";
+                for (std::size_t i = 0U; i < m_allowedPeers.m_hostNames.size(); ++i)
                 {
-                    spSocket->Alarm(ec, "Unable to resolve ", query.host_name());
-                    NotificationData notification(ENotificationCode::eCONFIGURATION_ERROR, ESeverity::eERROR,
-                        "Connection only allowed from a hostname which cannot be resolved: " + configuration.m_hostName);
-                    const std::string& xmlString = Serialize(notification);
-                    spSocket->Send(xmlString);
-                    spSocket->Close();
-                    RetryLater_();
-                    return;
-                }
-
-                const auto& allowedEndpoint = itAllowedEndpoint->endpoint();
-                const auto& allowedAddress = allowedEndpoint.address();
-                if (remoteAddress != allowedAddress)
-                {
-                    std::ostringstream oss;
-                    oss << "Remote host does not match allowed host " << configuration.m_hostName
-                        << ",\nAllowed resolved hostname=" << itAllowedEndpoint->host_name()
-                        << ",\nAllowed address=" << allowedAddress.to_string()
-                        << ",\nRemote resolved hostname=" << spSocket->m_connectionInfo.m_hostName
-                        << ",\nRemote address=" << spSocket->m_connectionInfo.m_address;
-                    const std::string& text = oss.str();
-                    m_service.Warn(m_sessionId, text);
-
-                    NotificationData notification(ENotificationCode::eCONFIGURATION_ERROR, ESeverity::eWARNING, text);
-                    const std::string& xmlString = Serialize(notification);
-                    spSocket->Send(xmlString);
-                    spSocket->Close();
-                    AsyncAccept_();
-                    return;
+                    if (m_allowedPeers.m_resolvedAddresses[i].empty())
+                    {
+                        oss << ' ' << m_allowedPeers.m_hostNames[i];
+                    }
                 }
             }
+            const std::string& text = oss.str();
+            m_service.Warn(socket.m_sessionId, text);
 
-            m_callback.OnAccepted(std::make_unique<ServerSocket>(std::move(spSocket)));
-            AsyncAccept_();
+            NotificationData notification(ENotificationCode::eCONFIGURATION_ERROR, severity, text);
+            const std::string& xmlString = Serialize(notification);
+            socket.Send(xmlString, 0U);
+            socket.Close();
         }
 
         void RetryLater_()
@@ -334,15 +584,14 @@ namespace Hermes
             boost::system::error_code ecDummy;
             m_spResources->m_acceptor.close(ecDummy);
 
-            m_spResources->m_timer.expires_from_now(boost::posix_time::milliseconds(static_cast<int>(1000.0 * configuration.m_retryDelayInSeconds)));
-            m_spResources->m_timer.async_wait([this, spResources = m_spResources](const boost::system::error_code& ec)
+            auto delayInSeconds = m_retryBackoff.NextDelayInSeconds(configuration.m_retryPolicy);
+            m_service.Log(m_sessionId, "Retry listening in ", delayInSeconds, "s, attempt=", m_retryBackoff.Attempt());
+            m_spResources->m_timer.ExpiresFromNow(std::chrono::milliseconds(static_cast<int>(1000.0 * delayInSeconds)),
+                [this, spResources = m_spResources]()
             {
                 if (spResources->m_closed)
                     return;
 
-                if (ec) // we were canccelled
-                    return;
-
                 Listen_();
             });
         }
@@ -357,7 +606,9 @@ namespace Hermes
 
             boost::system::error_code ecDummy;
             m_spResources->m_acceptor.close(ecDummy);
-            m_spResources->m_timer.cancel(ecDummy);
+            m_spResources->m_timer.Cancel();
+            m_spResources->m_refreshTimer.Cancel();
+            m_upResolvers.clear();
         }
 
         template<class... Ts>
@@ -370,5 +621,7 @@ namespace Hermes
 }
 std::unique_ptr<Hermes::IAcceptor> Hermes::CreateAcceptor(IAsioService& asioService, IAcceptorCallback& callback)
 {
+    if (auto* pVirtualNetwork = asioService.GetVirtualNetwork())
+        return CreateVirtualAcceptor(asioService, callback, *pVirtualNetwork);
     return std::make_unique<AsioAcceptor>(asioService, callback);
 }
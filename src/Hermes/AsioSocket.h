@@ -21,13 +21,19 @@ limitations under the License.
 #include "IService.h"
 #include "Network.h"
 #include "MessageSerialization.h"
+#include "SocketTimers.h"
 #include "StringBuilder.h"
 
 #include <HermesData.hpp>
 
 #include <boost/asio.hpp>
 
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <deque>
 #include <memory>
+#include <vector>
 
 namespace asio = boost::asio;
 
@@ -45,20 +51,139 @@ namespace Hermes
         service.Inform(sessionId, trace..., ": ", ec.message(), '(', ec.value(), ')');
     }
 
+    template<class SocketT, class OptionT>
+    void SetSocketOption(IAsioService& service, unsigned sessionId, SocketT& socket, const OptionT& option, const char* name)
+    {
+        boost::system::error_code ec;
+        socket.set_option(option, ec);
+        if (ec)
+        {
+            // not fatal, the connection works with the OS defaults as well:
+            Info(service, sessionId, ec, "Cannot set ", name);
+        }
+    }
+
+    template<int cOPTION>
+    using TcpOption = asio::detail::socket_option::integer<IPPROTO_TCP, cOPTION>;
+
+    // outbound messages are queued and written asynchronously, see SocketSettings::m_sendQueueHighWatermark:
+    inline std::size_t SendQueueHighWatermark(const SocketSettings& settings)
+    {
+        return settings.m_sendQueueHighWatermark ? settings.m_sendQueueHighWatermark : 1024U * 1024U;
+    }
+
+    inline std::size_t SendQueueLowWatermark(const SocketSettings& settings)
+    {
+        auto highWatermark = SendQueueHighWatermark(settings);
+        return settings.m_sendQueueLowWatermark ? std::min<std::size_t>(settings.m_sendQueueLowWatermark, highWatermark) : highWatermark / 4U;
+    }
+
+    // for sockets and acceptors; the buffer sizes should be set before connecting or listening,
+    // as they determine the TCP window scaling negotiated with the peer:
+    template<class SocketT>
+    void ApplySocketSettings(IAsioService& service, unsigned sessionId, SocketT& socket, const SocketSettings& settings)
+    {
+        if (settings.m_sendBufferSize)
+        {
+            SetSocketOption(service, sessionId, socket,
+                asio::socket_base::send_buffer_size(static_cast<int>(settings.m_sendBufferSize)), "SO_SNDBUF");
+        }
+        if (settings.m_receiveBufferSize)
+        {
+            SetSocketOption(service, sessionId, socket,
+                asio::socket_base::receive_buffer_size(static_cast<int>(settings.m_receiveBufferSize)), "SO_RCVBUF");
+        }
+
+        if (settings.m_profile == ESocketProfile::eLOW_LATENCY)
+        {
+            SetSocketOption(service, sessionId, socket, asio::ip::tcp::no_delay(true), "TCP_NODELAY");
+#if defined(TCP_QUICKACK)
+            SetSocketOption(service, sessionId, socket, TcpOption<TCP_QUICKACK>(1), "TCP_QUICKACK");
+#endif
+        }
+
+        if (!settings.m_keepAliveIdleInSeconds)
+            return;
+
+        SetSocketOption(service, sessionId, socket, asio::socket_base::keep_alive(true), "SO_KEEPALIVE");
+        // not every platform lets us tune the probes, the OS defaults apply then:
+#if defined(TCP_KEEPIDLE)
+        SetSocketOption(service, sessionId, socket,
+            TcpOption<TCP_KEEPIDLE>(static_cast<int>(settings.m_keepAliveIdleInSeconds)), "TCP_KEEPIDLE");
+#elif defined(TCP_KEEPALIVE)
+        SetSocketOption(service, sessionId, socket,
+            TcpOption<TCP_KEEPALIVE>(static_cast<int>(settings.m_keepAliveIdleInSeconds)), "TCP_KEEPALIVE");
+#endif
+#if defined(TCP_KEEPINTVL)
+        if (settings.m_keepAliveIntervalInSeconds)
+        {
+            SetSocketOption(service, sessionId, socket,
+                TcpOption<TCP_KEEPINTVL>(static_cast<int>(settings.m_keepAliveIntervalInSeconds)), "TCP_KEEPINTVL");
+        }
+#endif
+#if defined(TCP_KEEPCNT)
+        if (settings.m_keepAliveProbeCount)
+        {
+            SetSocketOption(service, sessionId, socket,
+                TcpOption<TCP_KEEPCNT>(static_cast<int>(settings.m_keepAliveProbeCount)), "TCP_KEEPCNT");
+        }
+#endif
+    }
+
+    // how long a closed socket keeps trying to deliver its pending messages (e.g. a final notification):
+    constexpr double cCLOSE_LINGER_TIME_IN_SECONDS = 5.0;
+
+    // counters of the outbound traffic, to see how well queued messages get coalesced into single writes.
+    // Traced and signalled as ETraceEventType::eSEND_STATISTICS every cSEND_STATISTICS_INTERVAL writes and on closing:
+    constexpr std::uint64_t cSEND_STATISTICS_INTERVAL = 1024U;
+
+    struct SendStatistics
+    {
+        std::uint64_t m_writeCount{0U};
+        std::uint64_t m_messageCount{0U};
+        std::uint64_t m_byteCount{0U};
+        std::size_t m_maxMessagesPerWrite{0U};
+
+        template<class S>
+        friend S& operator<<(S& s, const SendStatistics& statistics)
+        {
+            s << "{m_writeCount=" << statistics.m_writeCount
+                << ",m_messageCount=" << statistics.m_messageCount
+                << ",m_byteCount=" << statistics.m_byteCount
+                << ",m_maxMessagesPerWrite=" << statistics.m_maxMessagesPerWrite
+                << '}';
+            return s;
+        }
+    };
+
     struct AsioSocket
     {
         unsigned m_sessionId;
         std::weak_ptr<void> m_wpOwner;
         IAsioService& m_service;
-        std::array<char, 1024> m_receivedData;
-        asio::io_service& m_asioService{m_service.GetUnderlyingService()};
-        asio::ip::tcp::socket m_socket{m_asioService};
-        asio::deadline_timer m_timer{m_asioService};
+        IAsioServiceSp m_spServiceLifetime{m_service.Lifetime()};
+        AsioExecutor m_executor{m_service.GetExecutor()};
+        asio::ip::tcp::socket m_socket{m_executor};
+        WheelTimer m_timer{m_service, m_executor};
         ISocketCallback* m_pCallback{nullptr};
         NetworkConfiguration m_configuration;
+        SocketTimers m_timers{m_service, m_executor, m_configuration}; // the last send time is that of the last completed write
         ConnectionInfo m_connectionInfo;
+        std::chrono::steady_clock::time_point m_acceptTime; // only set for accepted connections
         bool m_closed{false};
 
+        // outbound queue, drained by async_write; the first m_writingCount messages are currently being written:
+        std::deque<std::string> m_sendQueue;
+        std::size_t m_queuedBytes{0U};
+        std::size_t m_writingCount{0U};
+        std::deque<std::chrono::steady_clock::time_point> m_sendTimes; // of m_sendQueue, only with latency histograms
+        bool m_flushPosted{false};
+        std::size_t m_sendQueueHighWatermark{SendQueueHighWatermark(m_configuration.m_socketSettings)};
+        std::size_t m_sendQueueLowWatermark{SendQueueLowWatermark(m_configuration.m_socketSettings)};
+        bool m_aboveHighWatermark{false};
+        std::size_t m_receiveSize{std::max<std::size_t>(m_configuration.m_minReceiveSize, 1U)};
+        SendStatistics m_sendStatistics;
+
         explicit AsioSocket(unsigned sessionId,
             const NetworkConfiguration& configuration, IAsioService& service) :
             m_sessionId(sessionId),
@@ -66,12 +191,22 @@ namespace Hermes
             m_configuration(configuration)
         {}
 
+        AsioSocket(unsigned sessionId,
+            const NetworkConfiguration& configuration, IAsioService& service, const AsioExecutor& executor) :
+            m_sessionId(sessionId),
+            m_service(service),
+            m_executor(executor),
+            m_configuration(configuration)
+        {}
+
         AsioSocket(const AsioSocket&) = delete;
         AsioSocket& operator=(const AsioSocket&) = delete;
 
         ~AsioSocket()
         {
+            m_sendQueue.clear();
             Close_();
+            CloseSocket_();
         }
 
         std::shared_ptr<AsioSocket> shared_from_this() { return std::shared_ptr<AsioSocket>(m_wpOwner.lock(), this); }
@@ -80,20 +215,38 @@ namespace Hermes
         {
             assert(m_pCallback);
             AsyncReceive_();
+            m_timers.Start(*this);
         }
 
-        void Send(StringView message)
+        void Send(StringView message, unsigned serializeTimeInMicroseconds)
         {
             if (m_closed)
                 return m_service.Log(m_sessionId, "Already closed on Send: ", message);
 
-            boost::system::error_code ec;
-            asio::write(m_socket, asio::buffer(message.data(), message.size()), ec);
-            if (ec)
-                return DisconnectOnError_(ec, "Cannot write ", message);
+            m_service.OnSending(m_sessionId, message, serializeTimeInMicroseconds);
+            m_sendQueue.emplace_back(message.data(), message.size());
+            if (m_service.GetLatencyHistograms())
+            {
+                m_sendTimes.push_back(std::chrono::steady_clock::now());
+            }
+            m_queuedBytes += message.size();
+            if (!m_aboveHighWatermark && m_queuedBytes > m_sendQueueHighWatermark)
+            {
+                m_aboveHighWatermark = true;
+                m_service.Warn(m_sessionId, "Send queue above high watermark: queuedBytes=", m_queuedBytes,
+                    ", queuedMessages=", m_sendQueue.size(), ", highWatermark=", m_sendQueueHighWatermark);
+                m_service.OnSendQueueWatermark(m_sessionId, true, m_queuedBytes);
+            }
 
-            m_service.Trace(ETraceType::eSENT, m_sessionId, message);
-            RestartCheckAliveTimer_();
+            // messages sent from the same io tick are gathered into a single write:
+            if (m_writingCount || m_flushPosted)
+                return;
+            m_flushPosted = true;
+            asio::post(m_executor, [spThis = shared_from_this()]()
+            {
+                spThis->m_flushPosted = false;
+                spThis->AsyncWrite_();
+            });
         }
 
         void Close() 
@@ -101,11 +254,23 @@ namespace Hermes
             Close_(); 
         }
 
+        void ApplySocketSettings()
+        {
+            m_service.Log(m_sessionId, "ApplySocketSettings ", m_configuration.m_socketSettings);
+            Hermes::ApplySocketSettings(m_service, m_sessionId, m_socket, m_configuration.m_socketSettings);
+        }
+
         bool Closed() const 
         { 
             return m_closed; 
         }
 
+        // see SocketTimers:
+        void OnReceiveTimeout()
+        {
+            DisconnectOnError_(asio::error::timed_out, "Nothing received for ", m_configuration.m_receiveTimeoutInSeconds, " seconds");
+        }
+
         template<class... Ts>
         Error Alarm(const boost::system::error_code& ec, const Ts&... trace)
         {
@@ -146,32 +311,153 @@ namespace Hermes
             m_closed = true;
             m_service.Log(m_sessionId, "Close socket");
 
-            boost::system::error_code ecDummy;
-            m_socket.shutdown(asio::socket_base::shutdown_both, ecDummy);
-            m_socket.close(ecDummy);
-            m_timer.cancel(ecDummy);
+            m_timer.Cancel();
+            m_timers.Cancel();
+            if (m_sendQueue.empty())
+            {
+                CloseSocket_();
+            }
+            else
+            {
+                // let the pending messages go out first, but do not wait forever for a stalled peer:
+                m_service.Log(m_sessionId, "Delay closing the socket until ", m_sendQueue.size(), " pending messages are sent");
+                m_timer.ExpiresFromNow(ToDuration_(cCLOSE_LINGER_TIME_IN_SECONDS), [spThis = shared_from_this()]()
+                {
+                    spThis->m_service.Warn(spThis->m_sessionId, "Discarding ", spThis->m_sendQueue.size(), " unsent messages on close");
+                    spThis->CloseSocket_();
+                });
+            }
 
             auto* pCallback = m_pCallback;
             m_pCallback = nullptr;
             return pCallback;
         }
 
+        void SignalSendStatistics_()
+        {
+            m_service.OnSendStatistics(m_sessionId, m_sendStatistics.m_writeCount, m_sendStatistics.m_messageCount,
+                m_sendStatistics.m_byteCount, m_sendStatistics.m_maxMessagesPerWrite);
+        }
+
+        void CloseSocket_()
+        {
+            if (!m_socket.is_open())
+                return;
+
+            m_service.Log(m_sessionId, "Close socket, sendStatistics=", m_sendStatistics);
+            SignalSendStatistics_();
+            boost::system::error_code ecDummy;
+            m_socket.shutdown(asio::socket_base::shutdown_both, ecDummy);
+            m_socket.close(ecDummy);
+            m_timer.Cancel();
+            m_timers.Cancel();
+        }
+
         //================ internally used methods, must all be called from the asio service thread =====================
+        void AsyncWrite_()
+        {
+            if (m_writingCount || m_sendQueue.empty())
+                return;
+
+            // scatter-gather write of everything queued so far:
+            std::vector<asio::const_buffer> buffers;
+            buffers.reserve(m_sendQueue.size());
+            for (const auto& message : m_sendQueue)
+            {
+                buffers.emplace_back(message.data(), message.size());
+            }
+            m_writingCount = m_sendQueue.size();
+
+            asio::async_write(m_socket, buffers, 
+                [spThis = shared_from_this()](const boost::system::error_code& ec, std::size_t size)
+            {
+                spThis->OnWritten_(ec, size);
+            });
+        }
+
+        void OnWritten_(const boost::system::error_code& ec, std::size_t size)
+        {
+            auto writtenCount = m_writingCount;
+            m_writingCount = 0U;
+            if (m_sendQueue.empty())
+                return;
+
+            if (ec)
+            {
+                std::string message = std::move(m_sendQueue.front());
+                m_sendQueue.clear();
+                m_sendTimes.clear();
+                m_queuedBytes = 0U;
+                if (m_closed)
+                    return CloseSocket_();
+                return DisconnectOnError_(ec, "Cannot write ", writtenCount, " messages, first=", message);
+            }
+
+            m_timers.OnSent();
+            ++m_sendStatistics.m_writeCount;
+            m_sendStatistics.m_messageCount += writtenCount;
+            m_sendStatistics.m_byteCount += size;
+            if (m_sendStatistics.m_maxMessagesPerWrite < writtenCount)
+            {
+                m_sendStatistics.m_maxMessagesPerWrite = writtenCount;
+            }
+            if (m_sendStatistics.m_writeCount % cSEND_STATISTICS_INTERVAL == 0U)
+            {
+                m_service.Log(m_sessionId, "sendStatistics=", m_sendStatistics);
+                SignalSendStatistics_();
+            }
+            m_service.Log(m_sessionId, "Written ", writtenCount, " messages, ", size, " bytes in one write");
+
+            auto* pHistograms = m_service.GetLatencyHistograms();
+            for (std::size_t i = 0U; i < writtenCount; ++i)
+            {
+                const auto& message = m_sendQueue.front();
+                m_service.Trace(ETraceType::eSENT, m_sessionId, message);
+                if (pHistograms && !m_sendTimes.empty())
+                {
+                    pHistograms->Record(IAsioService::MessageTag_(message), ELatencyStage::eSEND_WRITE, m_sendTimes.front());
+                    m_sendTimes.pop_front();
+                }
+                m_queuedBytes -= message.size();
+                m_sendQueue.pop_front();
+            }
+
+            if (m_aboveHighWatermark && m_queuedBytes <= m_sendQueueLowWatermark)
+            {
+                m_aboveHighWatermark = false;
+                m_service.Inform(m_sessionId, "Send queue below low watermark: queuedBytes=", m_queuedBytes,
+                    ", queuedMessages=", m_sendQueue.size(), ", lowWatermark=", m_sendQueueLowWatermark);
+                m_service.OnSendQueueWatermark(m_sessionId, false, m_queuedBytes);
+            }
+
+            if (m_closed && m_sendQueue.empty())
+                return CloseSocket_();
+
+            AsyncWrite_();
+        }
+
         void AsyncReceive_()
         {
             if (m_closed)
                 return;
 
+            assert(m_pCallback);
+            if (!m_pCallback)
+                return;
+
+            // receive directly into the buffer of the message dispatcher:
+            auto receiveBuffer = m_pCallback->ReceiveBuffer(m_receiveSize);
             m_service.Log(m_sessionId, "async_receive");
-            m_socket.async_receive(asio::buffer(m_receivedData), [spThis = shared_from_this()](const boost::system::error_code& ec, std::size_t size)
+            m_socket.async_receive(asio::buffer(receiveBuffer.data(), receiveBuffer.size()), 
+                [spThis = shared_from_this(), receiveBuffer](const boost::system::error_code& ec, std::size_t size)
             {
-                spThis->OnReceive_(ec, size);
+                spThis->OnReceive_(receiveBuffer, ec, size);
             });
         }
 
-        void OnReceive_(const boost::system::error_code& ec, std::size_t size)
+        void OnReceive_(StringSpan receiveBuffer, const boost::system::error_code& ec, std::size_t size)
         {
-            StringSpan data(&m_receivedData.front(), size);
+            StringSpan data(receiveBuffer.data(), size);
 
             if (size)
             {
@@ -187,6 +473,17 @@ namespace Hermes
             if (ec)
                 return DisconnectOnError_(ec, "OnReceive");
 
+            m_timers.OnReceived();
+            AdaptReceiveSize_(size);
+#if defined(TCP_QUICKACK)
+            // Linux falls back to delayed acknowledgements after a while, so re-enable quick ones with every receive:
+            if (m_configuration.m_socketSettings.m_profile == ESocketProfile::eLOW_LATENCY)
+            {
+                boost::system::error_code ecDummy;
+                m_socket.set_option(TcpOption<TCP_QUICKACK>(1), ecDummy);
+            }
+#endif
+
             assert(m_pCallback);
             if (!m_pCallback)
             {
@@ -198,33 +495,24 @@ namespace Hermes
             AsyncReceive_();
         }
 
-        void RestartCheckAliveTimer_()
+        // see NetworkConfiguration::m_minReceiveSize:
+        void AdaptReceiveSize_(std::size_t receivedSize)
         {
-            if (m_closed)
-                return;
-
-            if (!m_configuration.m_checkAlivePeriodInSeconds)
-                return;
-
-            m_timer.expires_from_now(boost::posix_time::milliseconds(static_cast<int>(1000.0 * m_configuration.m_checkAlivePeriodInSeconds)));
-            m_timer.async_wait([spThis = shared_from_this()](const boost::system::error_code& ec)
+            if (receivedSize >= m_receiveSize && m_receiveSize < m_configuration.m_maxReceiveSize)
             {
-                spThis->OnCheckAliveTrigger_(ec);
-            });
+                m_receiveSize = std::min(2U * m_receiveSize, m_configuration.m_maxReceiveSize);
+            }
+            else if (receivedSize < m_receiveSize / 4U && m_receiveSize > m_configuration.m_minReceiveSize)
+            {
+                m_receiveSize = std::max<std::size_t>(std::max(m_receiveSize / 2U, m_configuration.m_minReceiveSize), 1U);
+            }
         }
 
-        void OnCheckAliveTrigger_(const boost::system::error_code& ec)
+        static std::chrono::steady_clock::duration ToDuration_(double seconds)
         {
-            if (m_closed)
-                return;
-
-            if (ec) // cancelled or whatever
-                return;
-
-            Send(Serialize(CheckAliveData()));
+            return std::chrono::duration_cast<std::chrono::steady_clock::duration>(
+                std::chrono::duration<double>(seconds));
         }
-
-
     };
 
 }
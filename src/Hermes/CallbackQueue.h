@@ -0,0 +1,226 @@
+/***********************************************************************
+Copyright 2018 ASM Assembly Systems GmbH & Co. KG
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+************************************************************************/
+
+
+// Copyright (c) ASM Assembly Systems GmbH & Co. KG
+#pragma once
+
+#include <HermesDataConversion.hpp>
+#include "ApiCallback.h"
+#include "Task.h"
+
+#include <algorithm>
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+namespace Hermes
+{
+    // Delivers the application callbacks of one Hermes instance on a thread of their own, in order,
+    // so a slow application does not hold up the network thread. Bounded by capacity, see ECallbackQueueOverflow.
+    class CallbackQueue
+    {
+    public:
+        CallbackQueue(std::size_t capacity, ECallbackQueueOverflow overflow) :
+            m_spState(std::make_shared<State>(capacity ? capacity : 1U, overflow))
+        {
+            m_thread = std::thread([spState = m_spState]() { spState->Run(); });
+        }
+
+        CallbackQueue(const CallbackQueue&) = delete;
+        CallbackQueue& operator=(const CallbackQueue&) = delete;
+
+        ~CallbackQueue()
+        {
+            Stop();
+        }
+
+        // false if the queue is full and the policy is ECallbackQueueOverflow::eDISCONNECT; the session is then marked
+        // as overflowed and its further tasks are dropped, so that the application sees no gap in what it gets.
+        // Forced tasks (the final disconnected callback) are always queued, and clear the mark.
+        bool Push(Task&& task, unsigned sessionId, bool force)
+        {
+            auto& state = *m_spState;
+            std::unique_lock<std::mutex> lock(state.m_mutex);
+            if (state.m_stopped)
+                return true;
+
+            auto& overflowed = state.m_overflowedSessionIds;
+            auto itOverflowed = std::find(overflowed.begin(), overflowed.end(), sessionId);
+            if (itOverflowed != overflowed.end())
+            {
+                if (!force)
+                    return true;
+                overflowed.erase(itOverflowed);
+            }
+            else if (!force && state.m_tasks.size() >= state.m_capacity)
+            {
+                if (state.m_overflow == ECallbackQueueOverflow::eDISCONNECT)
+                {
+                    overflowed.push_back(sessionId);
+                    return false;
+                }
+
+                state.m_room.wait(lock, [&state]() { return state.m_stopped || state.m_tasks.size() < state.m_capacity; });
+                if (state.m_stopped)
+                    return true;
+            }
+            state.m_tasks.push_back(std::move(task));
+            lock.unlock();
+            state.m_items.notify_one();
+            return true;
+        }
+
+        // Delivers what is still queued, then ends the thread. When called from a callback,
+        // the queued callbacks are discarded instead, as the instance is about to go.
+        void Stop()
+        {
+            if (!m_thread.joinable())
+                return;
+
+            auto& state = *m_spState;
+            const bool fromCallback = m_thread.get_id() == std::this_thread::get_id();
+            std::deque<Task> discarded;
+            {
+                std::lock_guard<std::mutex> lock(state.m_mutex);
+                state.m_stopped = true;
+                if (fromCallback)
+                {
+                    discarded.swap(state.m_tasks);
+                }
+            }
+            state.m_items.notify_all();
+            state.m_room.notify_all();
+            if (fromCallback)
+            {
+                m_thread.detach();
+                return;
+            }
+            m_thread.join();
+        }
+
+    private:
+        struct State
+        {
+            State(std::size_t capacity, ECallbackQueueOverflow overflow) :
+                m_capacity(capacity),
+                m_overflow(overflow)
+            {}
+
+            void Run()
+            {
+                for (;;)
+                {
+                    Task task;
+                    {
+                        std::unique_lock<std::mutex> lock(m_mutex);
+                        m_items.wait(lock, [this]() { return m_stopped || !m_tasks.empty(); });
+                        if (m_tasks.empty())
+                            return;
+
+                        task = std::move(m_tasks.front());
+                        m_tasks.pop_front();
+                    }
+                    m_room.notify_one();
+                    task();
+                }
+            }
+
+            const std::size_t m_capacity;
+            const ECallbackQueueOverflow m_overflow;
+            std::mutex m_mutex;
+            std::condition_variable m_items;
+            std::condition_variable m_room;
+            std::deque<Task> m_tasks;
+            std::vector<unsigned> m_overflowedSessionIds; // see Push()
+            bool m_stopped{false};
+        };
+
+        std::shared_ptr<State> m_spState; // shared with the thread, which may outlive us when detached
+        std::thread m_thread;
+    };
+
+    // On a shared pool, eWAIT would park a pool thread and with it every instance on the pool,
+    // so eWAIT is not supported there and falls back to eDISCONNECT:
+    template<class ServiceT>
+    std::unique_ptr<CallbackQueue> CreateCallbackQueue(ServiceT& service, std::size_t capacity, ECallbackQueueOverflow overflow)
+    {
+        if (overflow == ECallbackQueueOverflow::eWAIT && service.m_pPool)
+        {
+            service.Warn(0U, "ECallbackQueueOverflow::eWAIT is not supported on a shared pool, using eDISCONNECT");
+            overflow = ECallbackQueueOverflow::eDISCONNECT;
+        }
+        return std::make_unique<CallbackQueue>(capacity, overflow);
+    }
+
+    // the C view of a callback argument: Hermes data is converted, enums are passed as they are
+    template<class T, bool = std::is_enum<T>::value>
+    struct CallbackArg
+    {
+        explicit CallbackArg(const T& data) : m_converter(data) {}
+        auto Get() const { return m_converter.CPointer(); }
+
+        Converter2C<T> m_converter;
+    };
+
+    template<class T>
+    struct CallbackArg<T, true>
+    {
+        explicit CallbackArg(T value) : m_value(value) {}
+        T Get() const { return m_value; }
+
+        T m_value;
+    };
+
+    template<class F, class... Ts>
+    bool DeliverCallback_(CallbackQueue* pQueue, bool force, const ApiCallback<F>& callback, unsigned sessionId, const Ts&... args)
+    {
+        if (!callback)
+            return true;
+
+        if (!pQueue)
+        {
+            callback(sessionId, CallbackArg<Ts>(args).Get()...);
+            return true;
+        }
+
+        return pQueue->Push([callback, sessionId, args...]()
+        {
+            callback(sessionId, CallbackArg<Ts>(args).Get()...);
+        }, sessionId, force);
+    }
+
+    // Calls callback(sessionId, C view of args...) right away without a queue, otherwise queues a copy of the args.
+    // False if the queue overflowed, callbacks of that session are then dropped up to the final one:
+    template<class F, class... Ts>
+    bool DeliverCallback(CallbackQueue* pQueue, const ApiCallback<F>& callback, unsigned sessionId, const Ts&... args)
+    {
+        return DeliverCallback_(pQueue, false, callback, sessionId, args...);
+    }
+
+    // for the disconnected callback, which must not get lost:
+    template<class F, class... Ts>
+    void DeliverFinalCallback(CallbackQueue* pQueue, const ApiCallback<F>& callback, unsigned sessionId, const Ts&... args)
+    {
+        DeliverCallback_(pQueue, true, callback, sessionId, args...);
+    }
+}
@@ -57,7 +57,6 @@ namespace
         ErrorCallback m_errorCallback;
 
         static const std::size_t cCHUNK_SIZE = 4096;
-        std::array<char, cCHUNK_SIZE> m_receivedData;
 
         bool m_receiving = false;
 
@@ -101,6 +100,8 @@ namespace
 
         bool Connect()
         {
+            // Not through the shared Resolver: a query of another instance pending for the same host would complete
+            // on that instance's executor, leaving nothing to run on m_asioService. We block here anyway:
             asio::ip::tcp::resolver resolver(m_asioService);
             asio::ip::tcp::resolver::query query(asio::ip::tcp::v4(), m_hostName, "");
 
@@ -174,9 +175,11 @@ namespace
 
             while (m_receiving)
             {
-                m_socket.async_receive(asio::buffer(m_receivedData), [this](const boost::system::error_code ecReceive, std::size_t size)
+                auto receiveBuffer = m_dispatcher.ReceiveBuffer(cCHUNK_SIZE);
+                m_socket.async_receive(asio::buffer(receiveBuffer.data(), receiveBuffer.size()), 
+                    [this, receiveBuffer](const boost::system::error_code ecReceive, std::size_t size)
                 {
-                    OnAsyncReceive_(ecReceive, size);
+                    OnAsyncReceive_(receiveBuffer, ecReceive, size);
                 });
                 m_asioService.reset();
                 boost::system::error_code ecRun;
@@ -186,7 +189,7 @@ namespace
             }
         }
 
-        void OnAsyncReceive_(const boost::system::error_code& ecReceive, std::size_t size)
+        void OnAsyncReceive_(StringSpan receiveBuffer, const boost::system::error_code& ecReceive, std::size_t size)
         {
             if (ecReceive)
             {
@@ -194,9 +197,10 @@ namespace
                 return GenerateError(EErrorCode::eNETWORK_ERROR, "asio::async_receive: ", ecReceive.message());
             }
 
-            m_service.Trace(ETraceType::eRECEIVED, 0U, StringView{&m_receivedData[0], size});
+            StringSpan data{receiveBuffer.data(), size};
+            m_service.Trace(ETraceType::eRECEIVED, 0U, data);
 
-            if (auto error = m_dispatcher.Dispatch(StringSpan{&m_receivedData[0], size}))
+            if (auto error = m_dispatcher.Dispatch(data))
             {
                 m_receiving = false;
                 m_service.Alarm(0U, EErrorCode::ePEER_ERROR, error.m_text);
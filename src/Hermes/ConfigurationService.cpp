@@ -55,7 +55,8 @@ using namespace Hermes;
 
 struct HermesConfigurationService : IAcceptorCallback, IConfigurationServiceSessionCallback
 {
-    Service m_service;
+    std::shared_ptr<Service> m_spService;
+    Service& m_service{*m_spService};
     ConfigurationServiceSettings m_settings;;
 
     // we only hold on to the accepting session
@@ -72,8 +73,8 @@ struct HermesConfigurationService : IAcceptorCallback, IConfigurationServiceSess
 
     bool m_enabled{false};
 
-    HermesConfigurationService(const HermesConfigurationServiceCallbacks& callbacks) :
-        m_service(callbacks.m_traceCallback),
+    HermesConfigurationService(const HermesConfigurationServiceCallbacks& callbacks, ServicePool* pPool) :
+        m_spService(std::make_shared<Service>(callbacks.m_traceCallback, pPool)),
         m_connectedCallback(callbacks.m_connectedCallback),
         m_setConfigurationCallback(callbacks.m_setConfigurationCallback),
         m_getConfigurationCallback(callbacks.m_getConfigurationCallback),
@@ -100,7 +101,7 @@ struct HermesConfigurationService : IAcceptorCallback, IConfigurationServiceSess
 
         NetworkConfiguration networkConfiguration;
         networkConfiguration.m_port = settings.m_port ? settings.m_port : cCONFIG_PORT;
-        networkConfiguration.m_retryDelayInSeconds = settings.m_reconnectWaitTimeInSeconds;
+        networkConfiguration.m_retryPolicy.m_maxDelayInSeconds = settings.m_reconnectWaitTimeInSeconds;
         networkConfiguration.m_checkAlivePeriodInSeconds = 0U;
 
         m_upAcceptor->StartListening(networkConfiguration);
@@ -198,7 +199,54 @@ struct HermesConfigurationService : IAcceptorCallback, IConfigurationServiceSess
 
 HermesConfigurationService* CreateHermesConfigurationService(const HermesConfigurationServiceCallbacks* pCallbacks)
 {
-    return new HermesConfigurationService(*pCallbacks);
+    return new HermesConfigurationService(*pCallbacks, nullptr);
+}
+
+HermesConfigurationService* CreateHermesConfigurationServiceOnService(HermesService* pService, const HermesConfigurationServiceCallbacks* pCallbacks)
+{
+    return new HermesConfigurationService(*pCallbacks, pService ? &pService->m_pool : nullptr);
+}
+
+void SetHermesConfigurationServiceThreadSettings(HermesConfigurationService* pConfigurationService, const HermesThreadSettings* pThreadSettings)
+{
+    const auto threadSettings = ToCpp(*pThreadSettings);
+    pConfigurationService->m_service.Log(0U, "SetHermesConfigurationServiceThreadSettings(", threadSettings, ')');
+    pConfigurationService->m_service.SetThreadSettings(threadSettings);
+}
+
+void SetHermesConfigurationServiceTraceMask(HermesConfigurationService* pConfigurationService, uint32_t traceMask)
+{
+    pConfigurationService->m_service.Log(0U, "SetHermesConfigurationServiceTraceMask(", traceMask, ')');
+    pConfigurationService->m_service.SetTraceMask(traceMask);
+}
+
+void UseHermesConfigurationServiceTraceFile(HermesConfigurationService* pConfigurationService, HermesStringView path, uint32_t ringCapacityInBytes, uint32_t maxFileSizeInBytes)
+{
+    const auto& pathString = std::string(path.m_pData, path.m_size);
+    pConfigurationService->m_service.Log(0U, "UseHermesConfigurationServiceTraceFile(", pathString, ',', ringCapacityInBytes, ',', maxFileSizeInBytes, ')');
+    pConfigurationService->m_service.UseTraceFile(pathString, ringCapacityInBytes, maxFileSizeInBytes);
+}
+
+void SetHermesConfigurationServiceTraceEventCallback(HermesConfigurationService* pConfigurationService, HermesTraceEventCallback callback)
+{
+    pConfigurationService->m_service.Log(0U, "SetHermesConfigurationServiceTraceEventCallback");
+    pConfigurationService->m_service.SetTraceEventCallback(callback);
+}
+
+void EnableHermesConfigurationServiceLatencyHistograms(HermesConfigurationService* pConfigurationService)
+{
+    pConfigurationService->m_service.Log(0U, "EnableHermesConfigurationServiceLatencyHistograms");
+    pConfigurationService->m_service.EnableLatencyHistograms();
+}
+
+uint32_t GetHermesConfigurationServiceLatencyHistograms(HermesConfigurationService* pConfigurationService, HermesLatencyHistogram* pHistograms, uint32_t maxCount)
+{
+    return CopyLatencyHistograms(pConfigurationService->m_service.GetLatencyHistogramSummaries(), pHistograms, maxCount);
+}
+
+uint32_t GetHermesConfigurationServiceThreadStatistics(HermesConfigurationService* pConfigurationService, HermesThreadStatistics* pStatistics, uint32_t maxCount)
+{
+    return CopyThreadStatistics(pConfigurationService->m_service.GetThreadStatistics(), pStatistics, maxCount);
 }
 
 void RunHermesConfigurationService(HermesConfigurationService* pConfigurationService)
@@ -208,6 +256,22 @@ void RunHermesConfigurationService(HermesConfigurationService* pConfigurationSer
     pConfigurationService->m_service.Run();
 }
 
+uint32_t PollHermesConfigurationService(HermesConfigurationService* pConfigurationService, uint32_t maxHandlers)
+{
+    return static_cast<uint32_t>(pConfigurationService->m_service.Poll(maxHandlers));
+}
+
+uint32_t RunHermesConfigurationServiceFor(HermesConfigurationService* pConfigurationService, uint32_t timeoutInMilliseconds)
+{
+    return static_cast<uint32_t>(pConfigurationService->m_service.RunFor(std::chrono::milliseconds(timeoutInMilliseconds)));
+}
+
+int32_t GetHermesConfigurationServicePollDescriptor(HermesConfigurationService* pConfigurationService)
+{
+    pConfigurationService->m_service.Log(0U, "GetHermesConfigurationServicePollDescriptor");
+    return pConfigurationService->m_service.PollDescriptor();
+}
+
 void PostHermesConfigurationService(HermesConfigurationService* pConfigurationService, HermesVoidCallback voidCallback)
 {
     pConfigurationService->m_service.Log(0U, "EnableHermesDownstream");
@@ -286,6 +350,5 @@ void DeleteHermesConfigurationService(HermesConfigurationService* pConfiguration
 {
     pConfigurationService->m_service.Log(0U, "DeleteHermesConfigurationService");
 
-    pConfigurationService->m_service.Stop();
-    delete pConfigurationService;
+    Service::Delete(pConfigurationService);
 }
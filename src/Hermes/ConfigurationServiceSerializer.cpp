@@ -49,6 +49,11 @@ namespace Hermes
                 m_pCallback->OnSocketConnected(connectionInfo);
             }
 
+            StringSpan ReceiveBuffer(std::size_t minSize) override
+            {
+                return m_dispatcher.ReceiveBuffer(minSize);
+            }
+
             void OnReceived(StringSpan xmlData) override
             {
                 auto error = m_dispatcher.Dispatch(xmlData);
@@ -80,7 +85,7 @@ namespace Hermes
                     return;
 
                 const auto& xmlString = Serialize(data);
-                m_socket.Send(xmlString);
+                m_socket.Send(xmlString, 0U);
             }
 
             void Signal(const NotificationData& data) override
@@ -89,7 +94,7 @@ namespace Hermes
                     return;
 
                 const auto& xmlString = Serialize(data);
-                m_socket.Send(xmlString);
+                m_socket.Send(xmlString, 0U);
             }
 
             void Disconnect(const NotificationData& data) override
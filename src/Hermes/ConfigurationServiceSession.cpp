@@ -37,7 +37,6 @@ namespace Hermes
 
         std::unique_ptr<IServerSocket> m_upSocket;
         std::unique_ptr<IConfigurationServiceSerializer> m_upSerializer;
-        ConnectionInfo m_peerConnectionInfo;
 
         IConfigurationServiceSessionCallback* m_pCallback = nullptr;
 
@@ -57,7 +56,6 @@ namespace Hermes
         //============= implementation of IConfigurationSessionSerializerCallback ============
         void OnSocketConnected(const ConnectionInfo& connectionInfo) override
         {
-            m_peerConnectionInfo = connectionInfo;
             if (!m_pCallback)
                 return;
             m_pCallback->OnSocketConnected(m_id, connectionInfo);
@@ -68,7 +66,7 @@ namespace Hermes
             if (!m_pCallback)
                 return;
 
-            m_pCallback->OnGet(m_id, m_peerConnectionInfo, data, *this);
+            m_pCallback->OnGet(m_id, m_upSocket->GetConnectionInfo(), data, *this);
         }
 
         void On(const SetConfigurationData& configuration) override
@@ -76,7 +74,7 @@ namespace Hermes
             if (!m_pCallback)
                 return;
 
-            m_pCallback->OnSet(m_id, m_peerConnectionInfo, configuration, *this);
+            m_pCallback->OnSet(m_id, m_upSocket->GetConnectionInfo(), configuration, *this);
         }
            
         void OnDisconnected(const Error& data) override
@@ -122,7 +120,7 @@ namespace Hermes
     }
 
     unsigned ConfigurationServiceSession::Id() const { return m_spImpl->m_id; }
-    const ConnectionInfo& ConfigurationServiceSession::PeerConnectionInfo() const { return m_spImpl->m_peerConnectionInfo; }
+    const ConnectionInfo& ConfigurationServiceSession::PeerConnectionInfo() const { return m_spImpl->m_upSocket->GetConnectionInfo(); }
 
 
     void ConfigurationServiceSession::Connect(IConfigurationServiceSessionCallback& callback)
@@ -19,6 +19,7 @@ limitations under the License.
 
 #include <HermesDataConversion.hpp>
 #include "ApiCallback.h"
+#include "CallbackQueue.h"
 #include "Network.h"
 #include "DownstreamSession.h"
 #include "MessageDispatcher.h"
@@ -35,7 +36,8 @@ using namespace Hermes::Downstream;
 struct HermesDownstream : IAcceptorCallback, ISessionCallback
 {
     unsigned m_laneId = 0U;
-    Service m_service;
+    std::shared_ptr<Service> m_spService;
+    Service& m_service{*m_spService};
     DownstreamSettings m_settings;
 
     std::unique_ptr<Session> m_upSession;
@@ -56,9 +58,12 @@ struct HermesDownstream : IAcceptorCallback, ISessionCallback
 
     bool m_enabled{false};
 
-    HermesDownstream(unsigned laneId, const HermesDownstreamCallbacks& callbacks) :
+    // optional, see UseHermesDownstreamCallbackQueue; last, so that its thread is done before anything else goes:
+    std::unique_ptr<CallbackQueue> m_upCallbackQueue;
+
+    HermesDownstream(unsigned laneId, const HermesDownstreamCallbacks& callbacks, ServicePool* pPool) :
         m_laneId(laneId),
-        m_service(callbacks.m_traceCallback),
+        m_spService(std::make_shared<Service>(callbacks.m_traceCallback, pPool)),
         m_connectedCallback(callbacks.m_connectedCallback),
         m_serviceDescriptionCallback(callbacks.m_serviceDescriptionCallback),
         m_machineReadyCallback(callbacks.m_machineReadyCallback),
@@ -98,13 +103,16 @@ struct HermesDownstream : IAcceptorCallback, ISessionCallback
         networkConfiguration.m_hostName = m_settings.m_optionalClientAddress.value_or("");
         networkConfiguration.m_port = m_settings.m_port;
         networkConfiguration.m_checkAlivePeriodInSeconds = m_settings.m_checkAlivePeriodInSeconds;
-        networkConfiguration.m_retryDelayInSeconds = m_settings.m_reconnectWaitTimeInSeconds;
+        networkConfiguration.m_retryPolicy.m_maxDelayInSeconds = m_settings.m_reconnectWaitTimeInSeconds;
+        networkConfiguration.m_reverseLookupMode = m_settings.m_reverseLookupMode;
+        networkConfiguration.m_receiveTimeoutInSeconds = m_settings.m_receiveTimeoutInSeconds;
+        networkConfiguration.m_socketSettings = m_settings.m_socketSettings;
         
         m_upAcceptor->StartListening(networkConfiguration);
     }
 
     template<class DataT>
-    void Signal(unsigned sessionId, const DataT& data, StringView rawXml)
+    void Signal(unsigned sessionId, const DataT& data, StringView rawXml, unsigned serializeTimeInMicroseconds = 0U)
     {
         m_service.Log(sessionId, "Signal(", data, ',', rawXml, ')');
 
@@ -112,7 +120,13 @@ struct HermesDownstream : IAcceptorCallback, ISessionCallback
         if (!pSession)
             return m_service.Log(sessionId, "No matching session");
 
-        pSession->Signal(data, rawXml);
+        pSession->Signal(data, rawXml, serializeTimeInMicroseconds);
+    }
+
+    template<class DataT>
+    void Signal(unsigned sessionId, const DataT& data, const SerializedMessage& message)
+    {
+        Signal(sessionId, data, message.m_xml, message.m_serializeTimeInMicroseconds);
     }
 
     void Disable(const NotificationData& notificationData)
@@ -153,12 +167,13 @@ struct HermesDownstream : IAcceptorCallback, ISessionCallback
 
             NotificationData notification(ENotificationCode::eCONNECTION_REFUSED_BECAUSE_OF_ESTABLISHED_CONNECTION, ESeverity::eERROR
                 , oss.str());
-            const auto& xmlString = Serialize(notification);
-            upSocket->Send(xmlString);
+            const auto& message = Serialize(m_service, notification);
+            upSocket->Send(message.m_xml, message.m_serializeTimeInMicroseconds);
 
             // send a check alive to the current connection to reduce time for timeout detection:
             CheckAliveData checkAliveData{};
-            m_upSession->Signal(checkAliveData, Serialize(checkAliveData));
+            const auto& checkAlive = Serialize(m_service, checkAliveData);
+            m_upSession->Signal(checkAliveData, checkAlive.m_xml, checkAlive.m_serializeTimeInMicroseconds);
             return;
         }
 
@@ -173,8 +188,7 @@ struct HermesDownstream : IAcceptorCallback, ISessionCallback
         if (!pSession)
             return;
 
-        const Converter2C<ConnectionInfo> converter(in_data);
-        m_connectedCallback(sessionId, ToC(state), converter.CPointer());
+        Deliver_(m_connectedCallback, sessionId, ToC(state), in_data);
     }
 
     void On(unsigned sessionId, EState state, const ServiceDescriptionData& in_data) override
@@ -183,8 +197,7 @@ struct HermesDownstream : IAcceptorCallback, ISessionCallback
         if (!pSession)
             return;
 
-        const Converter2C<ServiceDescriptionData> converter(in_data);
-        m_serviceDescriptionCallback(sessionId, ToC(state), converter.CPointer());
+        Deliver_(m_serviceDescriptionCallback, sessionId, ToC(state), in_data);
     }
 
     void On(unsigned sessionId, EState state, const MachineReadyData& in_data) override
@@ -193,8 +206,7 @@ struct HermesDownstream : IAcceptorCallback, ISessionCallback
         if (!pSession)
             return;
 
-        const Converter2C<MachineReadyData> converter(in_data);
-        m_machineReadyCallback(sessionId, ToC(state), converter.CPointer());
+        Deliver_(m_machineReadyCallback, sessionId, ToC(state), in_data);
     }
 
     void On(unsigned sessionId, EState state, const RevokeMachineReadyData& in_data) override
@@ -203,8 +215,7 @@ struct HermesDownstream : IAcceptorCallback, ISessionCallback
         if (!pSession)
             return;
 
-        const Converter2C<RevokeMachineReadyData> converter(in_data);
-        m_revokeMachineReadyCallback(sessionId, ToC(state), converter.CPointer());
+        Deliver_(m_revokeMachineReadyCallback, sessionId, ToC(state), in_data);
     }
 
     void On(unsigned sessionId, EState state, const StartTransportData& in_data) override
@@ -213,8 +224,7 @@ struct HermesDownstream : IAcceptorCallback, ISessionCallback
         if (!pSession)
             return;
 
-        const Converter2C<StartTransportData> converter(in_data);
-        m_startTransportCallback(sessionId, ToC(state), converter.CPointer());
+        Deliver_(m_startTransportCallback, sessionId, ToC(state), in_data);
     }
 
     void On(unsigned sessionId, EState state, const StopTransportData& in_data) override
@@ -223,8 +233,7 @@ struct HermesDownstream : IAcceptorCallback, ISessionCallback
         if (!pSession)
             return;
 
-        const Converter2C<StopTransportData> converter(in_data);
-        m_stopTransportCallback(sessionId, ToC(state), converter.CPointer());
+        Deliver_(m_stopTransportCallback, sessionId, ToC(state), in_data);
     }
 
     void On(unsigned sessionId, EState, const QueryBoardInfoData& in_data) override
@@ -233,8 +242,7 @@ struct HermesDownstream : IAcceptorCallback, ISessionCallback
         if (!pSession)
             return;
 
-        const Converter2C<QueryBoardInfoData> converter(in_data);
-        m_queryBoardInfoCallback(sessionId, converter.CPointer());
+        Deliver_(m_queryBoardInfoCallback, sessionId, in_data);
     }
 
     void On(unsigned sessionId, EState, const NotificationData& in_data) override
@@ -243,8 +251,7 @@ struct HermesDownstream : IAcceptorCallback, ISessionCallback
         if (!pSession)
             return;
 
-        const Converter2C<NotificationData> converter(in_data);
-        m_notificationCallback(sessionId, converter.CPointer());
+        Deliver_(m_notificationCallback, sessionId, in_data);
     }
 
     void On(unsigned sessionId, EState, const CommandData& in_data) override
@@ -253,8 +260,7 @@ struct HermesDownstream : IAcceptorCallback, ISessionCallback
         if (!pSession)
             return;
 
-        const Converter2C<CommandData> converter(in_data);
-        m_commandCallback(sessionId, converter.CPointer());
+        Deliver_(m_commandCallback, sessionId, in_data);
     }
 
     void On(unsigned sessionId, EState, const CheckAliveData& in_data) override
@@ -269,10 +275,9 @@ struct HermesDownstream : IAcceptorCallback, ISessionCallback
         {
             CheckAliveData data{in_data};
             data.m_optionalType = ECheckAliveType::ePONG;
-            m_service.Post([this, sessionId, data = std::move(data)]() { Signal(sessionId, data, Serialize(data)); });
+            m_service.Post([this, sessionId, data = std::move(data), postTime = m_service.LatencyStart()]() { Signal(sessionId, data, Serialize(m_service, data, postTime)); });
         }
-        const Converter2C<CheckAliveData> converter(in_data);
-        m_checkAliveCallback(sessionId, converter.CPointer());
+        Deliver_(m_checkAliveCallback, sessionId, in_data);
     }
 
     void OnState(unsigned sessionId, EState state) override
@@ -281,7 +286,7 @@ struct HermesDownstream : IAcceptorCallback, ISessionCallback
         if (!pSession)
             return;
 
-        m_stateCallback(sessionId, ToC(state));
+        Deliver_(m_stateCallback, sessionId, ToC(state));
     }
 
     void OnDisconnected(unsigned sessionId, EState, const Error& error) override
@@ -291,8 +296,7 @@ struct HermesDownstream : IAcceptorCallback, ISessionCallback
             return;
         
         m_upSession.reset();
-        const Converter2C<Error> converter(error);
-        m_disconnectedCallback(sessionId, eHERMES_STATE_DISCONNECTED, converter.CPointer());
+        DeliverFinalCallback(m_upCallbackQueue.get(), m_disconnectedCallback, sessionId, eHERMES_STATE_DISCONNECTED, error);
     }
 
     //=================== internal =========================
@@ -314,8 +318,7 @@ struct HermesDownstream : IAcceptorCallback, ISessionCallback
         m_service.Log(sessionId, "RemoveCurrentSession_()");
         m_upSession->Disconnect();
         const Error error;
-        const Converter2C<Error> converter(error);
-        m_disconnectedCallback(sessionId, eHERMES_STATE_DISCONNECTED, converter.CPointer());
+        DeliverFinalCallback(m_upCallbackQueue.get(), m_disconnectedCallback, sessionId, eHERMES_STATE_DISCONNECTED, error);
         m_upSession.reset();
     }
 
@@ -324,16 +327,95 @@ struct HermesDownstream : IAcceptorCallback, ISessionCallback
         if (!m_upSession)
             return;
 
-        m_upSession->Signal(data, Serialize(data));
+        const auto& message = Serialize(m_service, data);
+        m_upSession->Signal(data, message.m_xml, message.m_serializeTimeInMicroseconds);
         RemoveCurrentSession_();
     }
 
+    template<class F, class... Ts>
+    void Deliver_(const ApiCallback<F>& callback, unsigned sessionId, const Ts&... args)
+    {
+        if (DeliverCallback(m_upCallbackQueue.get(), callback, sessionId, args...))
+            return;
+
+        m_service.Warn(sessionId, "Callback queue full, disconnecting");
+        m_service.Post([this, sessionId]()
+        {
+            if (!m_upSession || m_upSession->Id() != sessionId)
+                return;
+
+            RemoveCurrentSession_(NotificationData(ENotificationCode::eUNSPECIFIC, ESeverity::eERROR,
+                "Application not keeping up with the messages received"));
+        });
+    }
+
 };
 
 //===================== implementation of public C functions ====================
 HermesDownstream* CreateHermesDownstream(uint32_t laneId, const HermesDownstreamCallbacks* pCallbacks)
 {
-    return new HermesDownstream(laneId, *pCallbacks);
+    return new HermesDownstream(laneId, *pCallbacks, nullptr);
+}
+
+HermesDownstream* CreateHermesDownstreamOnService(HermesService* pService, uint32_t laneId, const HermesDownstreamCallbacks* pCallbacks)
+{
+    return new HermesDownstream(laneId, *pCallbacks, pService ? &pService->m_pool : nullptr);
+}
+
+void UseHermesDownstreamTaskRing(HermesDownstream* pDownstream, uint32_t capacity)
+{
+    pDownstream->m_service.Log(0U, "UseHermesDownstreamTaskRing(", capacity, ')');
+    pDownstream->m_service.UseTaskRing(capacity);
+}
+
+void UseHermesDownstreamCallbackQueue(HermesDownstream* pDownstream, uint32_t capacity, EHermesCallbackQueueOverflow overflow)
+{
+    ECallbackQueueOverflow cppOverflow;
+    CToCpp(overflow, cppOverflow);
+    pDownstream->m_service.Log(0U, "UseHermesDownstreamCallbackQueue(", capacity, ',', cppOverflow, ')');
+    pDownstream->m_upCallbackQueue = CreateCallbackQueue(pDownstream->m_service, capacity, cppOverflow);
+}
+
+void SetHermesDownstreamThreadSettings(HermesDownstream* pDownstream, const HermesThreadSettings* pThreadSettings)
+{
+    const auto threadSettings = ToCpp(*pThreadSettings);
+    pDownstream->m_service.Log(0U, "SetHermesDownstreamThreadSettings(", threadSettings, ')');
+    pDownstream->m_service.SetThreadSettings(threadSettings);
+}
+
+void SetHermesDownstreamTraceMask(HermesDownstream* pDownstream, uint32_t traceMask)
+{
+    pDownstream->m_service.Log(0U, "SetHermesDownstreamTraceMask(", traceMask, ')');
+    pDownstream->m_service.SetTraceMask(traceMask);
+}
+
+void UseHermesDownstreamTraceFile(HermesDownstream* pDownstream, HermesStringView path, uint32_t ringCapacityInBytes, uint32_t maxFileSizeInBytes)
+{
+    const auto& pathString = std::string(path.m_pData, path.m_size);
+    pDownstream->m_service.Log(0U, "UseHermesDownstreamTraceFile(", pathString, ',', ringCapacityInBytes, ',', maxFileSizeInBytes, ')');
+    pDownstream->m_service.UseTraceFile(pathString, ringCapacityInBytes, maxFileSizeInBytes);
+}
+
+void SetHermesDownstreamTraceEventCallback(HermesDownstream* pDownstream, HermesTraceEventCallback callback)
+{
+    pDownstream->m_service.Log(0U, "SetHermesDownstreamTraceEventCallback");
+    pDownstream->m_service.SetTraceEventCallback(callback);
+}
+
+void EnableHermesDownstreamLatencyHistograms(HermesDownstream* pDownstream)
+{
+    pDownstream->m_service.Log(0U, "EnableHermesDownstreamLatencyHistograms");
+    pDownstream->m_service.EnableLatencyHistograms();
+}
+
+uint32_t GetHermesDownstreamLatencyHistograms(HermesDownstream* pDownstream, HermesLatencyHistogram* pHistograms, uint32_t maxCount)
+{
+    return CopyLatencyHistograms(pDownstream->m_service.GetLatencyHistogramSummaries(), pHistograms, maxCount);
+}
+
+uint32_t GetHermesDownstreamThreadStatistics(HermesDownstream* pDownstream, HermesThreadStatistics* pStatistics, uint32_t maxCount)
+{
+    return CopyThreadStatistics(pDownstream->m_service.GetThreadStatistics(), pStatistics, maxCount);
 }
 
 void RunHermesDownstream(HermesDownstream* pDownstream)
@@ -342,6 +424,22 @@ void RunHermesDownstream(HermesDownstream* pDownstream)
     pDownstream->m_service.Run();
 }
 
+uint32_t PollHermesDownstream(HermesDownstream* pDownstream, uint32_t maxHandlers)
+{
+    return static_cast<uint32_t>(pDownstream->m_service.Poll(maxHandlers));
+}
+
+uint32_t RunHermesDownstreamFor(HermesDownstream* pDownstream, uint32_t timeoutInMilliseconds)
+{
+    return static_cast<uint32_t>(pDownstream->m_service.RunFor(std::chrono::milliseconds(timeoutInMilliseconds)));
+}
+
+int32_t GetHermesDownstreamPollDescriptor(HermesDownstream* pDownstream)
+{
+    pDownstream->m_service.Log(0U, "GetHermesDownstreamPollDescriptor");
+    return pDownstream->m_service.PollDescriptor();
+}
+
 void EnableHermesDownstream(HermesDownstream* pDownstream, const HermesDownstreamSettings* pSettings)
 {
     pDownstream->m_service.Log(0U, "EnableHermesDownstream");
@@ -368,27 +466,27 @@ void PostHermesDownstream(HermesDownstream* pDownstream, HermesVoidCallback void
 void SignalHermesDownstreamServiceDescription(HermesDownstream* pDownstream, uint32_t sessionId, const HermesServiceDescriptionData* pData)
 {
     pDownstream->m_service.Log(sessionId, "SignalHermesDownstreamServiceDescription");
-    pDownstream->m_service.Post([pDownstream, sessionId, data = ToCpp(*pData)]()
+    pDownstream->m_service.Post([pDownstream, sessionId, data = ToCpp(*pData), postTime = pDownstream->m_service.LatencyStart()]()
     {
-        pDownstream->Signal(sessionId, data, Serialize(data));
+        pDownstream->Signal(sessionId, data, Serialize(pDownstream->m_service, data, postTime));
     });
 }
 
 void SignalHermesBoardAvailable(HermesDownstream* pDownstream, uint32_t sessionId, const HermesBoardAvailableData* pData)
 {
     pDownstream->m_service.Log(sessionId, "SignalHermesBoardAvailable");
-    pDownstream->m_service.Post([pDownstream, sessionId, data = ToCpp(*pData)]()
+    pDownstream->m_service.Post([pDownstream, sessionId, data = ToCpp(*pData), postTime = pDownstream->m_service.LatencyStart()]()
     {
-        pDownstream->Signal(sessionId, data, Serialize(data));
+        pDownstream->Signal(sessionId, data, Serialize(pDownstream->m_service, data, postTime));
     });
 }
 
 void SignalHermesRevokeBoardAvailable(HermesDownstream* pDownstream, uint32_t sessionId, const HermesRevokeBoardAvailableData* pData)
 {
     pDownstream->m_service.Log(sessionId, "SignalHermesRevokeBoardAvailable");
-    pDownstream->m_service.Post([pDownstream, sessionId, data = ToCpp(*pData)]()
+    pDownstream->m_service.Post([pDownstream, sessionId, data = ToCpp(*pData), postTime = pDownstream->m_service.LatencyStart()]()
     {
-        pDownstream->Signal(sessionId, data, Serialize(data));
+        pDownstream->Signal(sessionId, data, Serialize(pDownstream->m_service, data, postTime));
     });
 
 }
@@ -396,36 +494,36 @@ void SignalHermesRevokeBoardAvailable(HermesDownstream* pDownstream, uint32_t se
 void SignalHermesTransportFinished(HermesDownstream* pDownstream, uint32_t sessionId, const HermesTransportFinishedData* pData)
 {
     pDownstream->m_service.Log(sessionId, "SignalHermesTransportFinished");
-    pDownstream->m_service.Post([pDownstream, sessionId, data = ToCpp(*pData)]()
+    pDownstream->m_service.Post([pDownstream, sessionId, data = ToCpp(*pData), postTime = pDownstream->m_service.LatencyStart()]()
     {
-        pDownstream->Signal(sessionId, data, Serialize(data));
+        pDownstream->Signal(sessionId, data, Serialize(pDownstream->m_service, data, postTime));
     });
 }
 
 void SignalHermesBoardForecast(HermesDownstream* pDownstream, uint32_t sessionId, const HermesBoardForecastData* pData)
 {
     pDownstream->m_service.Log(sessionId, "SignalHermesBoardForecast");
-    pDownstream->m_service.Post([pDownstream, sessionId, data = ToCpp(*pData)]()
+    pDownstream->m_service.Post([pDownstream, sessionId, data = ToCpp(*pData), postTime = pDownstream->m_service.LatencyStart()]()
     {
-        pDownstream->Signal(sessionId, data, Serialize(data));
+        pDownstream->Signal(sessionId, data, Serialize(pDownstream->m_service, data, postTime));
     });
 }
 
 void SignalHermesSendBoardInfo(HermesDownstream* pDownstream, uint32_t sessionId, const HermesSendBoardInfoData* pData)
 {
     pDownstream->m_service.Log(sessionId, "SignalHermesSendBoardInfo");
-    pDownstream->m_service.Post([pDownstream, sessionId, data = ToCpp(*pData)]()
+    pDownstream->m_service.Post([pDownstream, sessionId, data = ToCpp(*pData), postTime = pDownstream->m_service.LatencyStart()]()
     {
-        pDownstream->Signal(sessionId, data, Serialize(data));
+        pDownstream->Signal(sessionId, data, Serialize(pDownstream->m_service, data, postTime));
     });
 }
 
 void SignalHermesDownstreamNotification(HermesDownstream* pDownstream, uint32_t sessionId, const HermesNotificationData* pData)
 {
     pDownstream->m_service.Log(0U, "SignalHermesDownstreamNotification");
-    pDownstream->m_service.Post([pDownstream, sessionId, data = ToCpp(*pData)]()
+    pDownstream->m_service.Post([pDownstream, sessionId, data = ToCpp(*pData), postTime = pDownstream->m_service.LatencyStart()]()
     {
-        pDownstream->Signal(sessionId, data, Serialize(data));
+        pDownstream->Signal(sessionId, data, Serialize(pDownstream->m_service, data, postTime));
     });
 }
 
@@ -433,18 +531,18 @@ void SignalHermesDownstreamCommand(HermesDownstream* pDownstream, uint32_t sessi
 {
     pDownstream->m_service.Log(0U, "SignalHermesDownstreamCommand");
 
-    pDownstream->m_service.Post([pDownstream, sessionId, data = ToCpp(*pData)]()
+    pDownstream->m_service.Post([pDownstream, sessionId, data = ToCpp(*pData), postTime = pDownstream->m_service.LatencyStart()]()
     {
-        pDownstream->Signal(sessionId, data, Serialize(data));
+        pDownstream->Signal(sessionId, data, Serialize(pDownstream->m_service, data, postTime));
     });
 }
 
 void SignalHermesDownstreamCheckAlive(HermesDownstream* pDownstream, uint32_t sessionId, const HermesCheckAliveData* pData)
 {
     pDownstream->m_service.Log(0U, "SignalHermesDownstreamCheckAlive");
-    pDownstream->m_service.Post([pDownstream, sessionId, data = ToCpp(*pData)]()
+    pDownstream->m_service.Post([pDownstream, sessionId, data = ToCpp(*pData), postTime = pDownstream->m_service.LatencyStart()]()
     {
-        pDownstream->Signal(sessionId, data, Serialize(data));
+        pDownstream->Signal(sessionId, data, Serialize(pDownstream->m_service, data, postTime));
     });
 }
 
@@ -490,7 +588,7 @@ void ResetHermesDownstreamRawXml(HermesDownstream* pDownstream, HermesStringView
     {
         if (!data.empty() && pDownstream->m_upSession)
         {
-            pDownstream->m_upSession->Signal(NotificationData(), data);
+            pDownstream->m_upSession->Signal(NotificationData(), data, 0U);
         }
         pDownstream->RemoveCurrentSession_();
     });
@@ -520,6 +618,9 @@ void DeleteHermesDownstream(HermesDownstream* pDownstream)
         return;
 
     pDownstream->m_service.Log(0U, "DeleteHermesDownstream");
-    pDownstream->m_service.Stop();
-    delete pDownstream;
+    if (pDownstream->m_upCallbackQueue)
+    {
+        pDownstream->m_upCallbackQueue->Stop();
+    }
+    Service::Delete(pDownstream);
 }
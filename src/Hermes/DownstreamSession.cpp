@@ -43,7 +43,6 @@ namespace Hermes
             std::unique_ptr<ISerializer> m_upSerializer;
             std::unique_ptr<IStateMachine> m_upStateMachine;
             Optional<ServiceDescriptionData> m_optionalPeerServiceDescriptionData;
-            ConnectionInfo m_peerConnectionInfo;
 
             ISessionCallback* m_pCallback{nullptr};
             bool m_hasServiceDescriptionData{false};
@@ -65,16 +64,15 @@ namespace Hermes
             //============= implementation of IStateMachineCallback ============
             void OnSocketConnected(EState state, const ConnectionInfo& connectionInfo) override 
             { 
-                m_peerConnectionInfo = connectionInfo;
                 if (!m_pCallback)
                     return;
 
                 m_pCallback->OnSocketConnected(m_id, state, connectionInfo);
             }
 
-            template<class DataT> void Signal_(const DataT& data, StringView rawXml)
+            template<class DataT> void Signal_(const DataT& data, StringView rawXml, unsigned serializeTimeInMicroseconds)
             {
-                m_upStateMachine->Signal(data, rawXml);
+                m_upStateMachine->Signal(data, rawXml, serializeTimeInMicroseconds);
             }
 
             template<class DataT> void On_(EState state, const DataT& data)
@@ -142,7 +140,8 @@ namespace Hermes
             return m_spImpl->m_optionalPeerServiceDescriptionData; 
         }
         
-        const ConnectionInfo& Session::PeerConnectionInfo() const { return m_spImpl->m_peerConnectionInfo; }
+        // the socket's connection info, as the host name may be filled in only after the connect:
+        const ConnectionInfo& Session::PeerConnectionInfo() const { return m_spImpl->m_upSocket->GetConnectionInfo(); }
 
         void Session::Connect(ISessionCallback& callback)
         {
@@ -150,15 +149,15 @@ namespace Hermes
             m_spImpl->m_upStateMachine->Connect(m_spImpl, *m_spImpl);
         }
 
-        void Session::Signal(const ServiceDescriptionData& data, StringView rawXml) { m_spImpl->Signal_(data, rawXml); }
-        void Session::Signal(const BoardAvailableData& data, StringView rawXml) { m_spImpl->Signal_(data, rawXml); }
-        void Session::Signal(const RevokeBoardAvailableData& data, StringView rawXml) { m_spImpl->Signal_(data, rawXml); }
-        void Session::Signal(const TransportFinishedData& data, StringView rawXml) { m_spImpl->Signal_(data, rawXml); }
-        void Session::Signal(const BoardForecastData& data, StringView rawXml) { m_spImpl->Signal_(data, rawXml); }
-        void Session::Signal(const SendBoardInfoData& data, StringView rawXml) { m_spImpl->Signal_(data, rawXml); }
-        void Session::Signal(const NotificationData&  data, StringView rawXml) { m_spImpl->Signal_(data, rawXml); }
-        void Session::Signal(const CommandData&  data, StringView rawXml) { m_spImpl->Signal_(data, rawXml); }
-        void Session::Signal(const CheckAliveData&  data, StringView rawXml) { m_spImpl->Signal_(data, rawXml); }
+        void Session::Signal(const ServiceDescriptionData& data, StringView rawXml, unsigned serializeTimeInMicroseconds) { m_spImpl->Signal_(data, rawXml, serializeTimeInMicroseconds); }
+        void Session::Signal(const BoardAvailableData& data, StringView rawXml, unsigned serializeTimeInMicroseconds) { m_spImpl->Signal_(data, rawXml, serializeTimeInMicroseconds); }
+        void Session::Signal(const RevokeBoardAvailableData& data, StringView rawXml, unsigned serializeTimeInMicroseconds) { m_spImpl->Signal_(data, rawXml, serializeTimeInMicroseconds); }
+        void Session::Signal(const TransportFinishedData& data, StringView rawXml, unsigned serializeTimeInMicroseconds) { m_spImpl->Signal_(data, rawXml, serializeTimeInMicroseconds); }
+        void Session::Signal(const BoardForecastData& data, StringView rawXml, unsigned serializeTimeInMicroseconds) { m_spImpl->Signal_(data, rawXml, serializeTimeInMicroseconds); }
+        void Session::Signal(const SendBoardInfoData& data, StringView rawXml, unsigned serializeTimeInMicroseconds) { m_spImpl->Signal_(data, rawXml, serializeTimeInMicroseconds); }
+        void Session::Signal(const NotificationData&  data, StringView rawXml, unsigned serializeTimeInMicroseconds) { m_spImpl->Signal_(data, rawXml, serializeTimeInMicroseconds); }
+        void Session::Signal(const CommandData&  data, StringView rawXml, unsigned serializeTimeInMicroseconds) { m_spImpl->Signal_(data, rawXml, serializeTimeInMicroseconds); }
+        void Session::Signal(const CheckAliveData&  data, StringView rawXml, unsigned serializeTimeInMicroseconds) { m_spImpl->Signal_(data, rawXml, serializeTimeInMicroseconds); }
 
         void Session::Disconnect()
         {
@@ -45,15 +45,15 @@ namespace Hermes
             const ConnectionInfo& PeerConnectionInfo() const;
 
             void Connect(ISessionCallback&);
-            void Signal(const ServiceDescriptionData&, StringView rawXml);
-            void Signal(const BoardAvailableData&, StringView rawXml);
-            void Signal(const RevokeBoardAvailableData&, StringView rawXml);
-            void Signal(const TransportFinishedData&, StringView rawXml);
-            void Signal(const BoardForecastData&, StringView rawXml);
-            void Signal(const SendBoardInfoData&, StringView rawXml);
-            void Signal(const NotificationData&, StringView rawXml);
-            void Signal(const CommandData&, StringView rawXml);
-            void Signal(const CheckAliveData&, StringView rawXml);
+            void Signal(const ServiceDescriptionData&, StringView rawXml, unsigned serializeTimeInMicroseconds);
+            void Signal(const BoardAvailableData&, StringView rawXml, unsigned serializeTimeInMicroseconds);
+            void Signal(const RevokeBoardAvailableData&, StringView rawXml, unsigned serializeTimeInMicroseconds);
+            void Signal(const TransportFinishedData&, StringView rawXml, unsigned serializeTimeInMicroseconds);
+            void Signal(const BoardForecastData&, StringView rawXml, unsigned serializeTimeInMicroseconds);
+            void Signal(const SendBoardInfoData&, StringView rawXml, unsigned serializeTimeInMicroseconds);
+            void Signal(const NotificationData&, StringView rawXml, unsigned serializeTimeInMicroseconds);
+            void Signal(const CommandData&, StringView rawXml, unsigned serializeTimeInMicroseconds);
+            void Signal(const CheckAliveData&, StringView rawXml, unsigned serializeTimeInMicroseconds);
             void Disconnect();
 
         private:
@@ -46,6 +46,12 @@ namespace Hermes
                 m_checkState(checkStateConsistency)
             {}
 
+            void SetState_(EState state)
+            {
+                m_service.OnStateChanged(m_sessionId, m_state, state);
+                m_state = state;
+            }
+
             bool DisconnectedDueToIllegalClientEvent_(StringView event)
             {
                 if (m_checkState != ECheckState::eSEND_AND_RECEIVE)
@@ -65,10 +71,10 @@ namespace Hermes
 
                 if (m_state != EState::eNOT_CONNECTED)
                 {
-                    m_forward.Signal(Serialize(NotificationData(ENotificationCode::eUNSPECIFIC, ESeverity::eFATAL, "SoftwareError")));
+                    m_forward.Signal(Serialize(NotificationData(ENotificationCode::eUNSPECIFIC, ESeverity::eFATAL, "SoftwareError")), 0U);
                 }
 
-                m_state = EState::eDISCONNECTED;
+                SetState_(EState::eDISCONNECTED);
                 m_pCallback->OnDisconnected(m_state, error);
                 m_forward.Disconnect();
                 return true;
@@ -82,9 +88,9 @@ namespace Hermes
                 if (m_state == EState::eDISCONNECTED)
                     return;
 
-                m_state = EState::eDISCONNECTED;
+                SetState_(EState::eDISCONNECTED);
                 m_pCallback->OnDisconnected(m_state, error);
-                m_forward.Signal(Serialize(NotificationData(ENotificationCode::ePROTOCOL_ERROR, ESeverity::eFATAL, error.m_text)));
+                m_forward.Signal(Serialize(NotificationData(ENotificationCode::ePROTOCOL_ERROR, ESeverity::eFATAL, error.m_text)), 0U);
                 m_forward.Disconnect();
             }
 
@@ -97,37 +103,37 @@ namespace Hermes
                 m_forward.Connect(std::move(wpOwner), *this);
             }
 
-            void Signal(const ServiceDescriptionData&, StringView rawXml) override
+            void Signal(const ServiceDescriptionData&, StringView rawXml, unsigned serializeTimeInMicroseconds) override
             {
                 switch (m_state)
                 {
                 case EState::eSERVICE_DESCRIPTION_DOWNSTREAM:
-                    m_state = EState::eNOT_AVAILABLE_NOT_READY;
+                    SetState_(EState::eNOT_AVAILABLE_NOT_READY);
                     m_pCallback->OnState(m_state);
-                    m_forward.Signal(rawXml);
+                    m_forward.Signal(rawXml, serializeTimeInMicroseconds);
                     return;
 
                 default:
                     if (DisconnectedDueToIllegalClientEvent_("ServiceDescription"))
                         return;
-                    m_forward.Signal(rawXml);
+                    m_forward.Signal(rawXml, serializeTimeInMicroseconds);
                 }
             }
 
-            void Signal(const BoardAvailableData&, StringView rawXml) override
+            void Signal(const BoardAvailableData&, StringView rawXml, unsigned serializeTimeInMicroseconds) override
             {
                 switch (m_state)
                 {
                 case EState::eNOT_AVAILABLE_NOT_READY:
-                    m_state = EState::eBOARD_AVAILABLE;
+                    SetState_(EState::eBOARD_AVAILABLE);
                     m_pCallback->OnState(m_state);
-                    m_forward.Signal(rawXml);
+                    m_forward.Signal(rawXml, serializeTimeInMicroseconds);
                     return;
 
                 case EState::eMACHINE_READY:
-                    m_state = EState::eAVAILABLE_AND_READY;
+                    SetState_(EState::eAVAILABLE_AND_READY);
                     m_pCallback->OnState(m_state);
-                    m_forward.Signal(rawXml);
+                    m_forward.Signal(rawXml, serializeTimeInMicroseconds);
                     return;
 
                 case EState::eTRANSPORTING:
@@ -137,24 +143,24 @@ namespace Hermes
                 default:
                     if (DisconnectedDueToIllegalClientEvent_("BoardAvailable"))
                         return;
-                    m_forward.Signal(rawXml);
+                    m_forward.Signal(rawXml, serializeTimeInMicroseconds);
                 }
             }
 
-            void Signal(const RevokeBoardAvailableData&, StringView rawXml) override
+            void Signal(const RevokeBoardAvailableData&, StringView rawXml, unsigned serializeTimeInMicroseconds) override
             {
                 switch (m_state)
                 {
                 case EState::eBOARD_AVAILABLE:
-                    m_state = EState::eNOT_AVAILABLE_NOT_READY;
+                    SetState_(EState::eNOT_AVAILABLE_NOT_READY);
                     m_pCallback->OnState(m_state);
-                    m_forward.Signal(rawXml);
+                    m_forward.Signal(rawXml, serializeTimeInMicroseconds);
                     return;
 
                 case EState::eAVAILABLE_AND_READY:
-                    m_state = EState::eMACHINE_READY;
+                    SetState_(EState::eMACHINE_READY);
                     m_pCallback->OnState(m_state);
-                    m_forward.Signal(rawXml);
+                    m_forward.Signal(rawXml, serializeTimeInMicroseconds);
                     return;
 
                 case EState::eTRANSPORTING:
@@ -164,53 +170,53 @@ namespace Hermes
                 default:
                     if (DisconnectedDueToIllegalClientEvent_("RevokeBoardAvailable"))
                         return;
-                    m_forward.Signal(rawXml);
+                    m_forward.Signal(rawXml, serializeTimeInMicroseconds);
                 }
             }
 
-            void Signal(const TransportFinishedData&, StringView rawXml) override
+            void Signal(const TransportFinishedData&, StringView rawXml, unsigned serializeTimeInMicroseconds) override
             {
                 switch (m_state)
                 {
                 case EState::eTRANSPORTING:
-                    m_state = EState::eTRANSPORT_FINISHED;
+                    SetState_(EState::eTRANSPORT_FINISHED);
                     m_pCallback->OnState(m_state);
-                    m_forward.Signal(rawXml);
+                    m_forward.Signal(rawXml, serializeTimeInMicroseconds);
                     return;
 
                 case EState::eTRANSPORT_STOPPED:
-                    m_state = EState::eNOT_AVAILABLE_NOT_READY;
+                    SetState_(EState::eNOT_AVAILABLE_NOT_READY);
                     m_pCallback->OnState(m_state);
-                    m_forward.Signal(rawXml);
+                    m_forward.Signal(rawXml, serializeTimeInMicroseconds);
                     return;
 
                 default:
                     if (DisconnectedDueToIllegalClientEvent_("TransportFinished"))
                         return;
-                    m_forward.Signal(rawXml);
+                    m_forward.Signal(rawXml, serializeTimeInMicroseconds);
                 }
             }
 
             // Board forecast is suppressed if we are not in a valid state for it.
             // This is different from other calls from client side in an illegal state
             // because from client perspective, it is very hand to handle it correctly.
-            void Signal(const BoardForecastData&, StringView rawXml) override
+            void Signal(const BoardForecastData&, StringView rawXml, unsigned serializeTimeInMicroseconds) override
             {
                 switch (m_state)
                 {
                 case EState::eNOT_AVAILABLE_NOT_READY:
                 case EState::eMACHINE_READY:
-                    m_forward.Signal(rawXml);
+                    m_forward.Signal(rawXml, serializeTimeInMicroseconds);
                     return;
 
                 default:
                     if (m_checkState == ECheckState::eSEND_AND_RECEIVE)
                         return;
-                    m_forward.Signal(rawXml);
+                    m_forward.Signal(rawXml, serializeTimeInMicroseconds);
                 }
             }
 
-            void Signal(const SendBoardInfoData&, StringView rawXml) override
+            void Signal(const SendBoardInfoData&, StringView rawXml, unsigned serializeTimeInMicroseconds) override
             {
                 switch (m_state)
                 {
@@ -219,12 +225,12 @@ namespace Hermes
                     return;
 
                 default:
-                    m_forward.Signal(rawXml);
+                    m_forward.Signal(rawXml, serializeTimeInMicroseconds);
                     return;
                 }
             }
 
-            void Signal(const NotificationData&, StringView rawXml) override
+            void Signal(const NotificationData&, StringView rawXml, unsigned serializeTimeInMicroseconds) override
             {
                 switch (m_state)
                 {
@@ -233,12 +239,12 @@ namespace Hermes
                     return;
 
                 default:
-                    m_forward.Signal(rawXml);
+                    m_forward.Signal(rawXml, serializeTimeInMicroseconds);
                     return;
                 }
             }
 
-            void Signal(const CommandData&, StringView rawXml) override
+            void Signal(const CommandData&, StringView rawXml, unsigned serializeTimeInMicroseconds) override
             {
                 switch (m_state)
                 {
@@ -247,12 +253,12 @@ namespace Hermes
                     return;
 
                 default:
-                    m_forward.Signal(rawXml);
+                    m_forward.Signal(rawXml, serializeTimeInMicroseconds);
                     return;
                 }
             }
 
-            void Signal(const CheckAliveData&, StringView rawXml) override
+            void Signal(const CheckAliveData&, StringView rawXml, unsigned serializeTimeInMicroseconds) override
             {
                 switch (m_state)
                 {
@@ -261,7 +267,7 @@ namespace Hermes
                     return;
 
                 default:
-                    m_forward.Signal(rawXml);
+                    m_forward.Signal(rawXml, serializeTimeInMicroseconds);
                     return;
                 }
             }
@@ -274,7 +280,7 @@ namespace Hermes
                     return;
 
                 default:
-                    m_state = EState::eDISCONNECTED;
+                    SetState_(EState::eDISCONNECTED);
                     m_pCallback->OnState(m_state);
                     m_forward.Disconnect();
                 }
@@ -286,7 +292,7 @@ namespace Hermes
                 switch (m_state)
                 {
                 case EState::eNOT_CONNECTED:
-                    m_state = EState::eSOCKET_CONNECTED;
+                    SetState_(EState::eSOCKET_CONNECTED);
                     m_pCallback->OnSocketConnected(m_state, connectionInfo);
                     return;
 
@@ -300,7 +306,7 @@ namespace Hermes
                 switch (m_state)
                 {
                 case EState::eSOCKET_CONNECTED:
-                    m_state = EState::eSERVICE_DESCRIPTION_DOWNSTREAM;
+                    SetState_(EState::eSERVICE_DESCRIPTION_DOWNSTREAM);
                     m_pCallback->On(m_state, data);
                     return;
 
@@ -314,12 +320,12 @@ namespace Hermes
                 switch (m_state)
                 {
                 case EState::eNOT_AVAILABLE_NOT_READY:
-                    m_state = EState::eMACHINE_READY;
+                    SetState_(EState::eMACHINE_READY);
                     m_pCallback->On(m_state, data);
                     return;
 
                 case EState::eBOARD_AVAILABLE:
-                    m_state = EState::eAVAILABLE_AND_READY;
+                    SetState_(EState::eAVAILABLE_AND_READY);
                     m_pCallback->On(m_state, data);
                     return;
 
@@ -333,12 +339,12 @@ namespace Hermes
                 switch (m_state)
                 {
                 case EState::eMACHINE_READY:
-                    m_state = EState::eNOT_AVAILABLE_NOT_READY;
+                    SetState_(EState::eNOT_AVAILABLE_NOT_READY);
                     m_pCallback->On(m_state, data);
                     return;
 
                 case EState::eAVAILABLE_AND_READY:
-                    m_state = EState::eBOARD_AVAILABLE;
+                    SetState_(EState::eBOARD_AVAILABLE);
                     m_pCallback->On(m_state, data);
                     return;
 
@@ -353,7 +359,7 @@ namespace Hermes
                 {
                 case EState::eAVAILABLE_AND_READY:
                 case EState::eMACHINE_READY:
-                    m_state = EState::eTRANSPORTING;
+                    SetState_(EState::eTRANSPORTING);
                     m_startTransportBoardId = data.m_boardId;
                     m_pCallback->On(m_state, data);
                     return;
@@ -377,14 +383,14 @@ namespace Hermes
                 case EState::eTRANSPORTING:
                     if (data.m_boardId != m_startTransportBoardId)
                         return StartAndStopBoardIdDoNotMatch_(m_startTransportBoardId, data.m_boardId);
-                    m_state = EState::eTRANSPORT_STOPPED;
+                    SetState_(EState::eTRANSPORT_STOPPED);
                     m_pCallback->On(m_state, data);
                     return;
 
                 case EState::eTRANSPORT_FINISHED:
                     if (data.m_boardId != m_startTransportBoardId)
                         return StartAndStopBoardIdDoNotMatch_(m_startTransportBoardId, data.m_boardId);
-                    m_state = EState::eNOT_AVAILABLE_NOT_READY;
+                    SetState_(EState::eNOT_AVAILABLE_NOT_READY);
                     m_pCallback->On(m_state, data);
                     return;
 
@@ -453,7 +459,7 @@ namespace Hermes
                     return;
 
                 default:
-                    m_state = EState::eDISCONNECTED;
+                    SetState_(EState::eDISCONNECTED);
                     m_pCallback->OnDisconnected(m_state, error);
                 }
             }
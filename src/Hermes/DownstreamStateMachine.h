@@ -32,15 +32,15 @@ namespace Hermes
         struct IStateMachine
         {
             virtual void Connect(std::weak_ptr<void> wpOwner, IStateMachineCallback&) = 0;
-            virtual void Signal(const ServiceDescriptionData&, StringView rawXml) = 0;
-            virtual void Signal(const BoardAvailableData&, StringView rawXml) = 0;
-            virtual void Signal(const RevokeBoardAvailableData&, StringView rawXml) = 0;
-            virtual void Signal(const TransportFinishedData&, StringView rawXml) = 0;
-            virtual void Signal(const BoardForecastData&, StringView rawXml) = 0;
-            virtual void Signal(const SendBoardInfoData&, StringView rawXml) = 0;
-            virtual void Signal(const NotificationData&, StringView rawXml) = 0;
-            virtual void Signal(const CommandData&, StringView rawXml) = 0;
-            virtual void Signal(const CheckAliveData&, StringView rawXml) = 0;
+            virtual void Signal(const ServiceDescriptionData&, StringView rawXml, unsigned serializeTimeInMicroseconds) = 0;
+            virtual void Signal(const BoardAvailableData&, StringView rawXml, unsigned serializeTimeInMicroseconds) = 0;
+            virtual void Signal(const RevokeBoardAvailableData&, StringView rawXml, unsigned serializeTimeInMicroseconds) = 0;
+            virtual void Signal(const TransportFinishedData&, StringView rawXml, unsigned serializeTimeInMicroseconds) = 0;
+            virtual void Signal(const BoardForecastData&, StringView rawXml, unsigned serializeTimeInMicroseconds) = 0;
+            virtual void Signal(const SendBoardInfoData&, StringView rawXml, unsigned serializeTimeInMicroseconds) = 0;
+            virtual void Signal(const NotificationData&, StringView rawXml, unsigned serializeTimeInMicroseconds) = 0;
+            virtual void Signal(const CommandData&, StringView rawXml, unsigned serializeTimeInMicroseconds) = 0;
+            virtual void Signal(const CheckAliveData&, StringView rawXml, unsigned serializeTimeInMicroseconds) = 0;
             virtual void Disconnect() = 0;
 
             virtual ~IStateMachine() = default;
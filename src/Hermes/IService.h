@@ -21,8 +21,15 @@ limitations under the License.
 #include <HermesStringView.hpp>
 
 #include "StringBuilder.h"
+#include "Task.h"
+#include "TimerWheel.h"
 
-#include <functional>
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstring>
+#include <limits>
 #include <memory>
 
 #include <boost/asio.hpp>
@@ -35,28 +42,74 @@ limitations under the License.
 
 namespace Hermes
 {
-    struct IAsioService
+    // all handlers of a Hermes instance are serialized through its strand, as several instances may share worker threads:
+    using AsioExecutor = boost::asio::strand<boost::asio::io_service::executor_type>;
+
+    struct IAsioService;
+    using IAsioServiceSp = std::shared_ptr<IAsioService>;
+    class LatencyHistograms;
+    class VirtualNetwork;
+    class WheelTimer;
+
+    struct IAsioService : std::enable_shared_from_this<IAsioService>
     {
-        virtual void Post(std::function<void()>&&) = 0;
+        virtual void Post(Task&&) = 0;
         virtual void Trace(ETraceType, unsigned sessionId, StringView trace) = 0;
+        // whether traces of that type are passed on at all, so the ones below are only formatted if so:
+        virtual bool IsTraced(ETraceType) const = 0;
         virtual boost::asio::io_service& GetUnderlyingService() = 0;
+        // sockets and timers are to be created with this executor:
+        virtual AsioExecutor GetExecutor() = 0;
+        // on a shared pool, handlers may still run after the instance has been deleted, so they keep its service alive with this;
+        // empty for a service with its own io_service, which drops the handlers when destroyed:
+        virtual IAsioServiceSp Lifetime() = 0;
+        // see WheelTimer:
+        virtual void ArmTimer(WheelTimer&, std::chrono::steady_clock::duration delay, Task&&) = 0;
+        virtual void CancelTimer(WheelTimer&) = 0;
+        // the clock of the timers above, a virtual one on a VirtualNetwork:
+        virtual std::chrono::steady_clock::time_point Now() = 0;
+        // if not null, sockets are to connect through this instead of TCP:
+        virtual VirtualNetwork* GetVirtualNetwork() = 0;
+        // structured trace events, only to be built if there is a callback for them:
+        virtual bool HasTraceEventCallback() const = 0;
+        virtual void SignalTraceEvent(const TraceEvent&) = 0;
+        // null unless enabled, to record the latencies of the receive and send stages in:
+        virtual LatencyHistograms* GetLatencyHistograms() = 0;
+
+        // the start of a latency to be recorded, only taken with latency histograms:
+        std::chrono::steady_clock::time_point LatencyStart()
+        {
+            return GetLatencyHistograms() ? std::chrono::steady_clock::now() : std::chrono::steady_clock::time_point{};
+        }
 
         template<class... Ts>
         void Log(unsigned sessionId, const Ts&... params)
         {
-            Trace(ETraceType::eDEBUG, sessionId, BuildString(params...));
+            if (!IsTraced(ETraceType::eDEBUG))
+                return;
+            StringWriter writer;
+            BuildString_(writer, params...);
+            Trace(ETraceType::eDEBUG, sessionId, writer.View());
         }
 
         template<class... Ts>
         void Inform(unsigned sessionId, const Ts&... params)
         {
-            Trace(ETraceType::eINFO, sessionId, BuildString(params...));
+            if (!IsTraced(ETraceType::eINFO))
+                return;
+            StringWriter writer;
+            BuildString_(writer, params...);
+            Trace(ETraceType::eINFO, sessionId, writer.View());
         }
 
         template<class... Ts>
         void Warn(unsigned sessionId, const Ts&... params)
         {
-            Trace(ETraceType::eWARNING, sessionId, BuildString(params...));
+            if (!IsTraced(ETraceType::eWARNING))
+                return;
+            StringWriter writer;
+            BuildString_(writer, params...);
+            Trace(ETraceType::eWARNING, sessionId, writer.View());
         }
 
         template<class... Ts>
@@ -64,17 +117,141 @@ namespace Hermes
         {
             Error error(errorCode, BuildString(params...));
             Trace(ETraceType::eERROR, sessionId, error.m_text);
+            if (HasTraceEventCallback())
+            {
+                TraceEvent event;
+                event.m_type = ETraceEventType::eERROR;
+                event.m_sessionId = sessionId;
+                event.m_errorCode = errorCode;
+                event.m_errorText = error.m_text;
+                SignalTraceEvent(event);
+            }
             return error;
         }
 
+        void OnSocketConnected(unsigned sessionId, unsigned acceptLatencyInMicroseconds = 0U)
+        {
+            if (!HasTraceEventCallback())
+                return;
+            TraceEvent event;
+            event.m_type = ETraceEventType::eSOCKET_CONNECTED;
+            event.m_sessionId = sessionId;
+            event.m_acceptLatencyInMicroseconds = acceptLatencyInMicroseconds;
+            SignalTraceEvent(event);
+        }
+
+        // the reverse lookup of an accepted peer has completed after OnSocketConnected():
+        void OnHostNameResolved(unsigned sessionId, StringView hostName)
+        {
+            if (!HasTraceEventCallback())
+                return;
+            TraceEvent event;
+            event.m_type = ETraceEventType::eHOST_NAME_RESOLVED;
+            event.m_sessionId = sessionId;
+            event.m_hostName = hostName;
+            SignalTraceEvent(event);
+        }
+
+        // the bytes queued for writing have exceeded the high watermark or, after that, fallen back to the low one:
+        void OnSendQueueWatermark(unsigned sessionId, bool high, std::size_t queuedBytes)
+        {
+            if (!HasTraceEventCallback())
+                return;
+            TraceEvent event;
+            event.m_type = high ? ETraceEventType::eSEND_QUEUE_HIGH_WATERMARK : ETraceEventType::eSEND_QUEUE_LOW_WATERMARK;
+            event.m_sessionId = sessionId;
+            event.m_sizeInBytes = static_cast<unsigned>(std::min<std::size_t>(queuedBytes, std::numeric_limits<unsigned>::max()));
+            SignalTraceEvent(event);
+        }
+
+        // the coalescing of the messages written so far, see SendStatistics:
+        void OnSendStatistics(unsigned sessionId, uint64_t writeCount, uint64_t messageCount, uint64_t byteCount,
+            std::size_t maxMessagesPerWrite)
+        {
+            if (!HasTraceEventCallback())
+                return;
+            TraceEvent event;
+            event.m_type = ETraceEventType::eSEND_STATISTICS;
+            event.m_sessionId = sessionId;
+            event.m_writeCount = writeCount;
+            event.m_messageCount = messageCount;
+            event.m_byteCount = byteCount;
+            event.m_maxMessagesPerWrite = static_cast<unsigned>(std::min<std::size_t>(maxMessagesPerWrite, std::numeric_limits<unsigned>::max()));
+            SignalTraceEvent(event);
+        }
+
+        // rawXml is about to be sent, serializeTimeInMicroseconds as returned by Serialize(IAsioService&, const DataT&):
+        void OnSending(unsigned sessionId, StringView rawXml, unsigned serializeTimeInMicroseconds)
+        {
+            if (!HasTraceEventCallback())
+                return;
+            TraceEvent event;
+            event.m_type = ETraceEventType::eMESSAGE_SENT;
+            event.m_sessionId = sessionId;
+            event.m_messageTag = MessageTag_(rawXml);
+            event.m_sizeInBytes = static_cast<unsigned>(rawXml.size());
+            event.m_serializeTimeInMicroseconds = serializeTimeInMicroseconds;
+            SignalTraceEvent(event);
+        }
+
+        // the name of the first element inside <Hermes>, empty if there is none:
+        static StringView MessageTag_(StringView rawXml)
+        {
+            auto begin = rawXml.find("<Hermes");
+            begin = begin == std::string::npos ? begin : rawXml.find('<', begin + 1U);
+            if (begin == std::string::npos)
+                return{};
+            ++begin;
+            auto end = begin;
+            while (end < rawXml.size() && !std::strchr(" \t\r\n/>", rawXml.data()[end]))
+            {
+                ++end;
+            }
+            return rawXml.substr(begin, end - begin);
+        }
+
+        void OnStateChanged(unsigned sessionId, EState oldState, EState newState)
+        {
+            if (oldState == newState || !HasTraceEventCallback())
+                return;
+            TraceEvent event;
+            event.m_type = ETraceEventType::eSTATE_CHANGED;
+            event.m_sessionId = sessionId;
+            event.m_oldState = oldState;
+            event.m_newState = newState;
+            SignalTraceEvent(event);
+        }
+
 
         virtual ~IAsioService() = default;
     };
-    using IAsioServiceSp = std::shared_ptr<IAsioService>;
-}
 
-struct HermesService
-{
-    Hermes::IAsioServiceSp m_spService;
-};
+    // A timer for check alive, timeouts and retries. Rather than each going into asio's timer queue, they all hang in
+    // the TimerWheel of their service, which takes constant time to (re-)arm and cancel them, at the service's tick resolution.
+    // As with an asio timer, the task keeps what it captures alive until it has run or been cancelled:
+    class WheelTimer : public TimerWheelEntry
+    {
+    public:
+        WheelTimer(IAsioService& service, const AsioExecutor& executor) :
+            m_executor(executor),
+            m_service(service)
+        {}
+
+        ~WheelTimer() { Cancel(); }
+
+        // replaces what is pending, the task then runs on m_executor:
+        void ExpiresFromNow(std::chrono::steady_clock::duration delay, Task&& task) { m_service.ArmTimer(*this, delay, std::move(task)); }
+        void Cancel() { m_service.CancelTimer(*this); }
+
+        // guarded by the service:
+        AsioExecutor m_executor;
+        Task m_task;
+        // bumped by each arming and cancelling, so that a due task already posted to m_executor can tell it is stale;
+        // shared with that task, which may outlive the timer:
+        std::shared_ptr<std::atomic<std::uint64_t>> m_spGeneration{std::make_shared<std::atomic<std::uint64_t>>(0U)};
+
+    private:
+        IAsioService& m_service;
+    };
+}
 
@@ -0,0 +1,177 @@
+/***********************************************************************
+Copyright 2018 ASM Assembly Systems GmbH & Co. KG
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+************************************************************************/
+
+
+// Copyright (c) ASM Assembly Systems GmbH & Co. KG
+#include "stdafx.h"
+
+#include "LatencyHistograms.h"
+
+#include "MessageSerialization.h"
+
+#include <algorithm>
+#include <memory>
+
+namespace Hermes
+{
+    namespace
+    {
+        template<class... DataTs>
+        constexpr std::array<StringView, sizeof...(DataTs) + 1U> Tags_()
+        {
+            return{SerializationTraits<DataTs>::cTAG_VIEW..., StringView{}};
+        }
+
+        // the last one standing in for any other tag:
+        constexpr auto cTAGS = Tags_<ServiceDescriptionData, BoardAvailableData, RevokeBoardAvailableData, MachineReadyData,
+            RevokeMachineReadyData, StartTransportData, TransportFinishedData, StopTransportData, NotificationData,
+            CheckAliveData, GetConfigurationData, SetConfigurationData, CurrentConfigurationData, BoardForecastData,
+            QueryBoardInfoData, SendBoardInfoData, SupervisoryServiceDescriptionData, BoardArrivedData, BoardDepartedData,
+            QueryWorkOrderInfoData, SendWorkOrderInfoData, ReplyWorkOrderInfoData, QueryHermesCapabilitiesData,
+            SendHermesCapabilitiesData, CommandData>();
+
+        constexpr std::size_t cSTAGE_COUNT = size(ELatencyStage());
+
+        std::size_t TagIndex_(StringView tag)
+        {
+            return static_cast<std::size_t>(std::find(cTAGS.begin(), cTAGS.end() - 1, tag) - cTAGS.begin());
+        }
+    }
+
+    //===================== LogLinearHistogram =====================
+    std::size_t LogLinearHistogram::BucketIndex(std::uint64_t valueInNanoseconds)
+    {
+        std::size_t shift = 0U;
+        while ((valueInNanoseconds >> shift) >= 2U * cSUB_BUCKET_COUNT)
+        {
+            if (shift == cMAX_SHIFT)
+                return cBUCKET_COUNT - 1U;
+            ++shift;
+        }
+        return shift * cSUB_BUCKET_COUNT + static_cast<std::size_t>(valueInNanoseconds >> shift);
+    }
+
+    std::uint64_t LogLinearHistogram::HighestEquivalentValue(std::size_t bucketIndex)
+    {
+        if (bucketIndex < 2U * cSUB_BUCKET_COUNT)
+            return bucketIndex;
+        const auto shift = bucketIndex / cSUB_BUCKET_COUNT - 1U;
+        const std::uint64_t subBucket = bucketIndex - shift * cSUB_BUCKET_COUNT;
+        return ((subBucket + 1U) << shift) - 1U;
+    }
+
+    void LogLinearHistogram::Record(std::uint64_t valueInNanoseconds)
+    {
+        m_buckets[BucketIndex(valueInNanoseconds)].fetch_add(1U, std::memory_order_relaxed);
+        m_sum.fetch_add(valueInNanoseconds, std::memory_order_relaxed);
+
+        auto min = m_min.load(std::memory_order_relaxed);
+        while (valueInNanoseconds < min && !m_min.compare_exchange_weak(min, valueInNanoseconds, std::memory_order_relaxed))
+        {
+        }
+        auto max = m_max.load(std::memory_order_relaxed);
+        while (valueInNanoseconds > max && !m_max.compare_exchange_weak(max, valueInNanoseconds, std::memory_order_relaxed))
+        {
+        }
+    }
+
+    HermesLatencyHistogram LogLinearHistogram::Summary(ELatencyStage stage) const
+    {
+        HermesLatencyHistogram result{};
+        CppToC(stage, result.m_stage);
+
+        // taken while recording may go on, so the count is the one of the buckets as copied:
+        std::array<std::uint64_t, cBUCKET_COUNT> buckets;
+        for (std::size_t i = 0U; i < cBUCKET_COUNT; ++i)
+        {
+            buckets[i] = m_buckets[i].load(std::memory_order_relaxed);
+            result.m_count += buckets[i];
+        }
+        if (!result.m_count)
+            return result;
+
+        result.m_minInNanoseconds = m_min.load(std::memory_order_relaxed);
+        result.m_maxInNanoseconds = std::max(m_max.load(std::memory_order_relaxed), result.m_minInNanoseconds);
+        result.m_meanInNanoseconds = m_sum.load(std::memory_order_relaxed) / result.m_count;
+
+        const auto percentile = [&](std::uint64_t perMille)
+        {
+            // the rank of the percentile, rounded up, at least the first value:
+            const auto rank = std::max<std::uint64_t>(1U, (result.m_count * perMille + 999U) / 1000U);
+            std::uint64_t count = 0U;
+            for (std::size_t i = 0U; i < cBUCKET_COUNT; ++i)
+            {
+                count += buckets[i];
+                if (count >= rank)
+                    return std::min(HighestEquivalentValue(i), result.m_maxInNanoseconds);
+            }
+            return result.m_maxInNanoseconds;
+        };
+        result.m_p50InNanoseconds = percentile(500U);
+        result.m_p90InNanoseconds = percentile(900U);
+        result.m_p99InNanoseconds = percentile(990U);
+        result.m_p999InNanoseconds = percentile(999U);
+        return result;
+    }
+
+    //===================== LatencyHistograms =====================
+    LatencyHistograms::LatencyHistograms() :
+        m_histograms(cTAGS.size() * cSTAGE_COUNT)
+    {}
+
+    LatencyHistograms::~LatencyHistograms()
+    {
+        for (auto& histogram : m_histograms)
+        {
+            delete histogram.load(std::memory_order_relaxed);
+        }
+    }
+
+    void LatencyHistograms::Record(StringView tag, ELatencyStage stage, LatencyClock::duration duration)
+    {
+        auto& histogram = m_histograms[TagIndex_(tag) * cSTAGE_COUNT + static_cast<std::size_t>(stage)];
+        auto* pHistogram = histogram.load(std::memory_order_acquire);
+        if (!pHistogram)
+        {
+            // several threads may get here at once for different sessions, only one of them gets to install its histogram:
+            auto upHistogram = std::make_unique<LogLinearHistogram>();
+            if (histogram.compare_exchange_strong(pHistogram, upHistogram.get(), std::memory_order_acq_rel))
+            {
+                pHistogram = upHistogram.release();
+            }
+        }
+
+        const auto nanoseconds = std::chrono::duration_cast<std::chrono::nanoseconds>(duration).count();
+        pHistogram->Record(nanoseconds > 0 ? static_cast<std::uint64_t>(nanoseconds) : 0U);
+    }
+
+    std::vector<HermesLatencyHistogram> LatencyHistograms::Summaries() const
+    {
+        std::vector<HermesLatencyHistogram> result;
+        for (std::size_t i = 0U; i < m_histograms.size(); ++i)
+        {
+            const auto* pHistogram = m_histograms[i].load(std::memory_order_acquire);
+            if (!pHistogram)
+                continue;
+            auto summary = pHistogram->Summary(static_cast<ELatencyStage>(i % cSTAGE_COUNT));
+            if (!summary.m_count)
+                continue;
+            summary.m_messageTag = ToC(cTAGS[i / cSTAGE_COUNT]);
+            result.push_back(summary);
+        }
+        return result;
+    }
+}
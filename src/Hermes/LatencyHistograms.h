@@ -0,0 +1,85 @@
+/***********************************************************************
+Copyright 2018 ASM Assembly Systems GmbH & Co. KG
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+************************************************************************/
+
+
+
+// Copyright (c) ASM Assembly Systems GmbH & Co. KG
+#pragma once
+
+#include <HermesDataConversion.hpp>
+#include <HermesStringView.hpp>
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <vector>
+
+namespace Hermes
+{
+    using LatencyClock = std::chrono::steady_clock;
+
+    // A log-linear histogram of latencies in nanoseconds, HDR style: below 64ns a bucket per value,
+    // above 32 buckets per power of two, so that a bucket is less than 1/32 of its values wide.
+    // Recording is lock-free, a summary may be taken from any thread meanwhile.
+    class LogLinearHistogram
+    {
+    public:
+        static constexpr std::size_t cSUB_BUCKET_COUNT = 32U;
+        static constexpr std::size_t cMAX_SHIFT = 35U; // values from 2^41ns (about 37 minutes) on share the last bucket
+        static constexpr std::size_t cBUCKET_COUNT = (cMAX_SHIFT + 2U) * cSUB_BUCKET_COUNT;
+
+        static std::size_t BucketIndex(std::uint64_t valueInNanoseconds);
+        // the largest value falling into that bucket:
+        static std::uint64_t HighestEquivalentValue(std::size_t bucketIndex);
+
+        void Record(std::uint64_t valueInNanoseconds);
+        // only the message tag is left to be set, the count is 0 if nothing has been recorded yet:
+        HermesLatencyHistogram Summary(ELatencyStage) const;
+
+    private:
+        std::array<std::atomic<std::uint64_t>, cBUCKET_COUNT> m_buckets{};
+        std::atomic<std::uint64_t> m_sum{0U};
+        std::atomic<std::uint64_t> m_min{UINT64_MAX};
+        std::atomic<std::uint64_t> m_max{0U};
+    };
+
+    // The latency histograms of a service, one per message tag and stage, each only allocated when first recorded into.
+    // Tags not part of The Hermes Standard (e.g. in raw xml) share the histograms of the empty tag.
+    class LatencyHistograms
+    {
+    public:
+        LatencyHistograms();
+        LatencyHistograms(const LatencyHistograms&) = delete;
+        LatencyHistograms& operator=(const LatencyHistograms&) = delete;
+        ~LatencyHistograms();
+
+        void Record(StringView tag, ELatencyStage, LatencyClock::duration);
+        // records the time since start and returns the current time, so that it can start the next stage:
+        LatencyClock::time_point Record(StringView tag, ELatencyStage stage, LatencyClock::time_point start)
+        {
+            const auto now = LatencyClock::now();
+            Record(tag, stage, now - start);
+            return now;
+        }
+
+        // those recorded into so far, ordered by tag and stage:
+        std::vector<HermesLatencyHistogram> Summaries() const;
+
+    private:
+        std::vector<std::atomic<LogLinearHistogram*>> m_histograms;
+    };
+}
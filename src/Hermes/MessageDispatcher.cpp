@@ -2,6 +2,8 @@
 
 #include "MessageDispatcher.h"
 
+#include <algorithm>
+
 namespace
 {
     const std::string cHERMES = "Hermes";
@@ -71,22 +73,89 @@ namespace Hermes
         m_map.emplace(tag, std::move(callback));
     }
 
-    Error MessageDispatcher::Dispatch(StringSpan xmlData)
+    void MessageDispatcher::OnParsed_(StringView tag)
+    {
+        if (!m_service.HasTraceEventCallback())
+            return;
+
+        TraceEvent event;
+        event.m_type = ETraceEventType::eMESSAGE_RECEIVED;
+        event.m_sessionId = m_sessionId;
+        event.m_messageTag = tag;
+        event.m_sizeInBytes = static_cast<unsigned>(m_messageSize);
+        event.m_parseTimeInMicroseconds = static_cast<unsigned>(std::chrono::duration_cast<std::chrono::microseconds>(
+            std::chrono::steady_clock::now() - m_parseStart).count());
+        m_service.SignalTraceEvent(event);
+    }
+
+    StringSpan MessageDispatcher::ReceiveBuffer(std::size_t minSize)
+    {
+        if (m_begin == m_end)
+        {
+            m_begin = 0U;
+            m_end = 0U;
+            // give back what a burst or a large message took, once it has been dispatched:
+            if (m_buffer.size() > 4U * minSize)
+            {
+                m_buffer.resize(minSize);
+                m_buffer.shrink_to_fit();
+            }
+        }
+
+        if (m_buffer.size() - m_end < minSize)
+        {
+            // compact only when the space at the end runs low, grow if that is not sufficient either:
+            std::size_t pendingSize = m_end - m_begin;
+            if (m_buffer.size() - pendingSize < minSize)
+            {
+                m_buffer.resize(std::max(pendingSize + minSize, 2U * m_buffer.size()));
+            }
+            std::copy(m_buffer.data() + m_begin, m_buffer.data() + m_end, m_buffer.data());
+            m_begin = 0U;
+            m_end = pendingSize;
+        }
+        return{m_buffer.data() + m_end, m_buffer.size() - m_end};
+    }
+
+    Error MessageDispatcher::Dispatch(StringSpan input)
     {
-        if (!m_buffer.empty())
+        // the messages taken from this input have waited for each other, so their total latencies start here:
+        m_pLatencyHistograms = m_service.GetLatencyHistograms();
+        if (m_pLatencyHistograms)
+        {
+            m_receiveTime = LatencyClock::now();
+        }
+
+        if (input.data() != m_buffer.data() + m_end)
         {
-            m_buffer.append(xmlData.data(), xmlData.size());
-            xmlData = m_buffer;
+            auto receiveBuffer = ReceiveBuffer(input.size());
+            std::copy(input.data(), input.data() + input.size(), receiveBuffer.data());
         }
+        m_end += input.size();
 
+        StringSpan xmlData{m_buffer.data() + m_begin, m_end - m_begin};
         for (StringSpan xmlMessage = TakeMessage_(xmlData); !xmlMessage.empty(); xmlMessage = TakeMessage_(xmlData))
         {
+            if (m_service.HasTraceEventCallback())
+            {
+                m_parseStart = std::chrono::steady_clock::now();
+                m_messageSize = xmlMessage.size();
+            }
+
+            const auto parseStart = m_pLatencyHistograms ? LatencyClock::now() : LatencyClock::time_point{};
             pugi::xml_document xmlDocument;
             pugi::xml_node dataNode;
             if (auto error = ParseXmlMessage_(xmlMessage, &xmlDocument, &dataNode))
+            {
+                m_begin = m_end;
                 return error;
+            }
 
             StringView tag = dataNode.name();
+            if (m_pLatencyHistograms)
+            {
+                m_pLatencyHistograms->Record(tag, ELatencyStage::eRECEIVE_PARSE, parseStart);
+            }
             auto itFound = m_map.find(tag.data());
             if (itFound == m_map.end())
             {
@@ -94,27 +163,19 @@ namespace Hermes
                 continue;
             }
             if (auto error = (itFound->second)(dataNode))
+            {
+                m_begin = m_end;
                 return error;
+            }
         }
 
+        // the remaining view is a suffix of the buffer, or empty if everything was consumed:
+        m_begin = xmlData.empty() ? m_end : static_cast<std::size_t>(xmlData.data() - m_buffer.data());
+
         if (xmlData.size() > cMAX_MESSAGE_SIZE)
             return{EErrorCode::ePEER_ERROR, ": Maximum message size exceeded"};
 
-        // do the housekeeping for the buffer and the view into it:
-        if (xmlData.empty())
-        {
-            m_buffer.clear();
-        }
-        else if (m_buffer.empty())
-        {
-            m_buffer.assign(xmlData.data(), xmlData.size());
-        }
-        else // view and buffer overlap
-        {
-            m_buffer.erase(0U, xmlData.data() - m_buffer.data());
-        }
         return{};
     }
 
 }
-
@@ -10,8 +10,10 @@
 #include "pugixml.hpp"
 #endif
 
+#include <chrono>
 #include <functional>
 #include <map>
+#include <vector>
 
 namespace Hermes
 {
@@ -34,6 +36,11 @@ namespace Hermes
         using Callback = std::function<Error(pugi::xml_node)>;
 
         void Add(StringView tag, Callback&& callback);
+
+        // Free space of at least minSize at the end of the internal buffer, so that the socket can receive into it.
+        // Dispatching exactly the received part of it does not copy anything, any other input gets appended.
+        // Once everything has been dispatched, a buffer much larger than minSize shrinks back to it.
+        StringSpan ReceiveBuffer(std::size_t minSize);
         Error Dispatch(StringSpan input);
 
         template<class DataT, class CallbackT>
@@ -43,21 +50,44 @@ namespace Hermes
                 [this, callback = std::forward<CallbackT>(callback)](pugi::xml_node xmlNode)->Error
             {
                 DataT data;
+                const auto deserializeStart = m_pLatencyHistograms ? LatencyClock::now() : LatencyClock::time_point{};
                 auto error = Deserialize(xmlNode, data);
                 if (error)
                     return error;
+                if (m_pLatencyHistograms)
+                {
+                    m_pLatencyHistograms->Record(SerializationTraits<DataT>::cTAG_VIEW, ELatencyStage::eRECEIVE_DESERIALIZE, deserializeStart);
+                }
+                // before logging, which is not part of the parse time:
+                OnParsed_(SerializationTraits<DataT>::cTAG_VIEW);
                 m_service.Log(m_sessionId, SerializationTraits<DataT>::cTAG_VIEW, ':', data);
+                const auto callbackStart = m_pLatencyHistograms ? LatencyClock::now() : LatencyClock::time_point{};
                 callback(data);
+                if (m_pLatencyHistograms)
+                {
+                    m_pLatencyHistograms->Record(SerializationTraits<DataT>::cTAG_VIEW, ELatencyStage::eRECEIVE_CALLBACK, callbackStart);
+                    m_pLatencyHistograms->Record(SerializationTraits<DataT>::cTAG_VIEW, ELatencyStage::eRECEIVE_TOTAL, m_receiveTime);
+                }
                 return{};
             });
         }
 
     private:
+        void OnParsed_(StringView tag);
 
-        std::string m_buffer;
+        // [m_begin, m_end) is the data received, but not yet dispatched:
+        std::vector<char> m_buffer;
+        std::size_t m_begin{0U};
+        std::size_t m_end{0U};
         std::map<std::string, std::function<Error(pugi::xml_node)>, std::less<>> m_map;
         unsigned m_sessionId;
         IAsioService& m_service;
+        // of the message being dispatched, only with a trace event callback:
+        std::chrono::steady_clock::time_point m_parseStart;
+        std::size_t m_messageSize{0U};
+        // only with latency histograms, set for each Dispatch():
+        LatencyHistograms* m_pLatencyHistograms{nullptr};
+        LatencyClock::time_point m_receiveTime;
     };
 
 }
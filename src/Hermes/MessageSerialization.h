@@ -1,6 +1,8 @@
 #pragma once
 
 #include <HermesData.hpp>
+#include "IService.h"
+#include "LatencyHistograms.h"
 
 #ifdef _WINDOWS
 #include "pugixml/pugixml.hpp"
@@ -8,6 +10,7 @@
 #include "pugixml.hpp"
 #endif
 
+#include <chrono>
 #include <string>
 
 
@@ -241,6 +244,45 @@ namespace Hermes
     std::string Serialize(const SendHermesCapabilitiesData&);
     std::string Serialize(const CommandData&);
 
+    struct SerializedMessage
+    {
+        std::string m_xml;
+        unsigned m_serializeTimeInMicroseconds{0U}; // only taken with a trace event callback, to go with the event of sending m_xml
+    };
+
+    // for a message about to be sent, the serialize time passed on to the socket's Send();
+    // with latency histograms, it is recorded, as is the time since postTime (see IAsioService::LatencyStart()) if given
+    template<class DataT>
+    SerializedMessage Serialize(IAsioService& service, const DataT& data,
+        std::chrono::steady_clock::time_point postTime = std::chrono::steady_clock::time_point{})
+    {
+        SerializedMessage message;
+        auto* pHistograms = service.GetLatencyHistograms();
+        if (!service.HasTraceEventCallback() && !pHistograms)
+        {
+            message.m_xml = Serialize(data);
+            return message;
+        }
+
+        const auto start = std::chrono::steady_clock::now();
+        message.m_xml = Serialize(data);
+        const auto end = std::chrono::steady_clock::now();
+        if (service.HasTraceEventCallback())
+        {
+            const auto time = std::chrono::duration_cast<std::chrono::microseconds>(end - start);
+            message.m_serializeTimeInMicroseconds = static_cast<unsigned>(time.count());
+        }
+        if (pHistograms)
+        {
+            if (postTime != std::chrono::steady_clock::time_point{})
+            {
+                pHistograms->Record(SerializationTraits<DataT>::cTAG_VIEW, ELatencyStage::eSEND_QUEUE, start - postTime);
+            }
+            pHistograms->Record(SerializationTraits<DataT>::cTAG_VIEW, ELatencyStage::eSEND_SERIALIZE, end - start);
+        }
+        return message;
+    }
+
     Error Deserialize(pugi::xml_node, ServiceDescriptionData&);
     Error Deserialize(pugi::xml_node, BoardAvailableData&);
     Error Deserialize(pugi::xml_node, RevokeBoardAvailableData&);
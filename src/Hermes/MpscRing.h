@@ -0,0 +1,113 @@
+/***********************************************************************
+Copyright 2018 ASM Assembly Systems GmbH & Co. KG
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+************************************************************************/
+
+
+// Copyright (c) ASM Assembly Systems GmbH & Co. KG
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <memory>
+#include <utility>
+
+namespace Hermes
+{
+    // A bounded lock-free queue for any number of producers and a single consumer (after D. Vyukov's bounded MPMC queue).
+    // Each cell carries a sequence number telling whether it is free for the producer at that position,
+    // or filled for the consumer. The capacity is rounded up to a power of two.
+    template<class T>
+    class MpscRing
+    {
+    public:
+        explicit MpscRing(std::size_t capacity) :
+            m_mask(RoundUp_(capacity) - 1U),
+            m_upCells(std::make_unique<Cell[]>(m_mask + 1U))
+        {
+            for (std::size_t i = 0U; i <= m_mask; ++i)
+            {
+                m_upCells[i].m_sequence.store(i, std::memory_order_relaxed);
+            }
+        }
+
+        MpscRing(const MpscRing&) = delete;
+        MpscRing& operator=(const MpscRing&) = delete;
+
+        std::size_t Capacity() const { return m_mask + 1U; }
+
+        // false if full, value is then left untouched:
+        bool TryPush(T& value)
+        {
+            auto position = m_enqueuePosition.load(std::memory_order_relaxed);
+            for (;;)
+            {
+                auto& cell = m_upCells[position & m_mask];
+                auto sequence = cell.m_sequence.load(std::memory_order_acquire);
+                auto difference = static_cast<std::ptrdiff_t>(sequence) - static_cast<std::ptrdiff_t>(position);
+                if (difference == 0)
+                {
+                    if (m_enqueuePosition.compare_exchange_weak(position, position + 1U, std::memory_order_relaxed))
+                    {
+                        cell.m_value = std::move(value);
+                        cell.m_sequence.store(position + 1U, std::memory_order_release);
+                        return true;
+                    }
+                }
+                else if (difference < 0)
+                    return false;
+                else
+                {
+                    position = m_enqueuePosition.load(std::memory_order_relaxed);
+                }
+            }
+        }
+
+        // only to be called by the consumer; false if empty, or if the next producer has not finished pushing yet:
+        bool TryPop(T& value)
+        {
+            auto& cell = m_upCells[m_dequeuePosition & m_mask];
+            if (cell.m_sequence.load(std::memory_order_acquire) != m_dequeuePosition + 1U)
+                return false;
+
+            value = std::move(cell.m_value);
+            cell.m_sequence.store(m_dequeuePosition + m_mask + 1U, std::memory_order_release);
+            ++m_dequeuePosition;
+            return true;
+        }
+
+    private:
+        struct Cell
+        {
+            std::atomic<std::size_t> m_sequence{0U};
+            T m_value;
+        };
+
+        static std::size_t RoundUp_(std::size_t capacity)
+        {
+            std::size_t result = 2U;
+            while (result < capacity)
+            {
+                result *= 2U;
+            }
+            return result;
+        }
+
+        const std::size_t m_mask;
+        std::unique_ptr<Cell[]> m_upCells;
+        // apart, as producers and consumer would otherwise contend for the cache line:
+        alignas(64) std::atomic<std::size_t> m_enqueuePosition{0U};
+        alignas(64) std::size_t m_dequeuePosition{0U};
+    };
+}
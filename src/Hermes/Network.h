@@ -17,8 +17,11 @@ limitations under the License.
 // Copyright (c) ASM Assembly Systems GmbH & Co. KG
 #pragma once
 
+#include <HermesData.hpp>
 #include <HermesStringView.hpp>
+#include "RetryPolicy.h"
 #include "StringSpan.h"
+#include "Task.h"
 
 #include <memory>
 #include <string>
@@ -42,7 +45,7 @@ namespace Hermes
         virtual const NetworkConfiguration& GetConfiguration() const = 0;
 
         virtual void Connect(std::weak_ptr<void> wpOwner, ISocketCallback&) = 0;
-        virtual void Send(StringView message) = 0;
+        virtual void Send(StringView message, unsigned serializeTimeInMicroseconds) = 0;
         virtual void Close() = 0;
 
         virtual ~ISocket() {}
@@ -51,6 +54,8 @@ namespace Hermes
     struct ISocketCallback
     {
         virtual void OnConnected(const ConnectionInfo&) = 0;
+        // the socket receives into the buffer provided here, OnReceived() is then called with the received part of it:
+        virtual StringSpan ReceiveBuffer(std::size_t minSize) = 0;
         virtual void OnReceived(StringSpan data) = 0;
         virtual void OnDisconnected(const Error&) = 0;
 
@@ -63,7 +68,11 @@ namespace Hermes
 
 
     struct IServerSocket : ISocket
-    {};
+    {
+        // to run f on the strand on which the socket calls back, which need not be the service's one:
+        virtual void Post(Task&& f) = 0;
+        virtual void Dispatch(Task&& f) = 0; // runs f right away if already on that strand
+    };
 
 
     struct IAcceptorCallback;
@@ -84,15 +93,34 @@ namespace Hermes
     {
         std::string m_hostName;
         uint16_t m_port = 0U;
-        double m_retryDelayInSeconds = 10.0;
+        RetryPolicy m_retryPolicy;
         double m_checkAlivePeriodInSeconds = 60.0;
+        // free space offered to each receive call: it starts at the minimum, doubles whenever a receive fills it
+        // and halves whenever one uses less than a quarter of it, so that idle connections hold little memory:
+        std::size_t m_minReceiveSize = 4U * 1024U;
+        std::size_t m_maxReceiveSize = 64U * 1024U;
+        // only relevant for accepted connections:
+        EReverseLookupMode m_reverseLookupMode = EReverseLookupMode::eASYNCHRONOUS;
+        // disconnect if nothing has been received for that long, 0 means never:
+        double m_receiveTimeoutInSeconds = 0.0;
+        // TCP options, including the keepalive probes of the operating system, and the watermarks of the send queue:
+        SocketSettings m_socketSettings;
+        // only relevant for accepted connections: whether each of them runs on a strand of its own,
+        // so that several threads running the service can serve independent peers in parallel:
+        bool m_strandPerSession = false;
 
         friend bool operator==(const NetworkConfiguration& lhs, const NetworkConfiguration& rhs)
         {
             return lhs.m_hostName == rhs.m_hostName
                 && lhs.m_port == rhs.m_port
-                && lhs.m_retryDelayInSeconds == rhs.m_retryDelayInSeconds
-                && lhs.m_checkAlivePeriodInSeconds == rhs.m_checkAlivePeriodInSeconds;
+                && lhs.m_retryPolicy == rhs.m_retryPolicy
+                && lhs.m_checkAlivePeriodInSeconds == rhs.m_checkAlivePeriodInSeconds
+                && lhs.m_minReceiveSize == rhs.m_minReceiveSize
+                && lhs.m_maxReceiveSize == rhs.m_maxReceiveSize
+                && lhs.m_reverseLookupMode == rhs.m_reverseLookupMode
+                && lhs.m_receiveTimeoutInSeconds == rhs.m_receiveTimeoutInSeconds
+                && lhs.m_socketSettings == rhs.m_socketSettings
+                && lhs.m_strandPerSession == rhs.m_strandPerSession;
         }
         friend bool operator!=(const NetworkConfiguration& lhs, const NetworkConfiguration& rhs)
         {
@@ -104,8 +132,14 @@ namespace Hermes
         {
             s << "{m_hostName=" << config.m_hostName
                 << ",m_port=" << config.m_port
-                << ",m_retryDelayInSeconds=" << config.m_retryDelayInSeconds
+                << ",m_retryPolicy=" << config.m_retryPolicy
                 << ",m_checkAlivePeriodInSeconds=" << config.m_checkAlivePeriodInSeconds
+                << ",m_minReceiveSize=" << config.m_minReceiveSize
+                << ",m_maxReceiveSize=" << config.m_maxReceiveSize
+                << ",m_reverseLookupMode=" << config.m_reverseLookupMode
+                << ",m_receiveTimeoutInSeconds=" << config.m_receiveTimeoutInSeconds
+                << ",m_socketSettings=" << config.m_socketSettings
+                << ",m_strandPerSession=" << config.m_strandPerSession
                 << '}';
             return s;
         }
@@ -0,0 +1,224 @@
+/***********************************************************************
+Copyright 2018 ASM Assembly Systems GmbH & Co. KG
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+************************************************************************/
+
+// Copyright (c) ASM Assembly Systems GmbH & Co. KG
+#include "stdafx.h"
+#include "Resolver.h"
+
+#include <chrono>
+#include <map>
+#include <mutex>
+
+namespace Hermes
+{
+    struct Resolver::Request : std::enable_shared_from_this<Resolver::Request>
+    {
+        AsioExecutor m_executor;
+        std::mutex m_mutex;
+        ResolveCallback m_callback; // empty once cancelled
+
+        Request(const AsioExecutor& executor, ResolveCallback&& callback) :
+            m_executor(executor),
+            m_callback(std::move(callback))
+        {}
+
+        // may be called from any thread, the callback is posted to our executor:
+        void Complete(const boost::system::error_code& ec, const ResolvedAddresses& addresses)
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            if (!m_callback)
+                return;
+
+            asio::post(m_executor, [spThis = shared_from_this(), ec, addresses]()
+            {
+                ResolveCallback callback;
+                {
+                    std::lock_guard<std::mutex> lock(spThis->m_mutex);
+                    callback.swap(spThis->m_callback);
+                }
+                if (callback)
+                {
+                    callback(ec, addresses);
+                }
+            });
+        }
+
+        void Cancel()
+        {
+            ResolveCallback callback;
+            std::lock_guard<std::mutex> lock(m_mutex);
+            callback.swap(m_callback);
+        }
+    };
+
+    namespace
+    {
+        using RequestSp = std::shared_ptr<Resolver::Request>;
+        using Clock = std::chrono::steady_clock;
+
+        const std::chrono::seconds cCACHE_TIME{60};
+        const std::chrono::seconds cNEGATIVE_CACHE_TIME{5};
+
+        struct CacheEntry
+        {
+            bool m_pending = false; // a query is on its way, requests are collected in m_waiting
+            Clock::time_point m_expiry;
+            boost::system::error_code m_ec;
+            ResolvedAddresses m_addresses;
+            std::vector<RequestSp> m_waiting;
+        };
+
+        struct Cache
+        {
+            std::mutex m_mutex;
+            std::map<std::string, CacheEntry, std::less<>> m_entries;
+        };
+
+        Cache& GetCache()
+        {
+            static Cache cache;
+            return cache;
+        }
+
+        // The query runs on the executor of the first requester. Should that one go away before the query completes,
+        // the waiting requests are completed with operation_aborted, which is not cached.
+        struct Query
+        {
+            std::string m_hostName;
+            asio::ip::tcp::resolver m_resolver;
+            bool m_completed = false;
+
+            Query(const std::string& hostName, const AsioExecutor& executor) :
+                m_hostName(hostName),
+                m_resolver(executor)
+            {}
+
+            ~Query()
+            {
+                if (!m_completed)
+                {
+                    Complete(asio::error::operation_aborted, ResolvedAddresses{});
+                }
+            }
+
+            void Complete(const boost::system::error_code& ec, const ResolvedAddresses& addresses)
+            {
+                m_completed = true;
+
+                std::vector<RequestSp> waiting;
+                {
+                    auto& cache = GetCache();
+                    std::lock_guard<std::mutex> lock(cache.m_mutex);
+                    auto itFound = cache.m_entries.find(m_hostName);
+                    if (itFound == cache.m_entries.end())
+                        return;
+
+                    auto& entry = itFound->second;
+                    waiting.swap(entry.m_waiting);
+                    if (ec == asio::error::operation_aborted)
+                    {
+                        cache.m_entries.erase(itFound);
+                    }
+                    else
+                    {
+                        entry.m_pending = false;
+                        entry.m_ec = ec;
+                        entry.m_addresses = addresses;
+                        entry.m_expiry = Clock::now() + (ec ? cNEGATIVE_CACHE_TIME : cCACHE_TIME);
+                    }
+                }
+
+                for (const auto& spRequest : waiting)
+                {
+                    spRequest->Complete(ec, addresses);
+                }
+            }
+        };
+    }
+
+    Resolver::Resolver(const AsioExecutor& executor) :
+        m_executor(executor)
+    {}
+
+    Resolver::~Resolver()
+    {
+        Cancel();
+    }
+
+    void Resolver::Cancel()
+    {
+        if (!m_spRequest)
+            return;
+
+        m_spRequest->Cancel();
+        m_spRequest.reset();
+    }
+
+    void Resolver::AsyncResolve(const std::string& hostName, ResolveCallback&& callback)
+    {
+        Cancel();
+        m_spRequest = std::make_shared<Request>(m_executor, std::move(callback));
+
+        boost::system::error_code ecAddress;
+        auto address = asio::ip::address_v4::from_string(hostName, ecAddress);
+        if (!ecAddress)
+        {
+            m_spRequest->Complete(boost::system::error_code{}, ResolvedAddresses{asio::ip::address{address}});
+            return;
+        }
+
+        {
+            auto& cache = GetCache();
+            std::unique_lock<std::mutex> lock(cache.m_mutex);
+            auto& entry = cache.m_entries[hostName];
+            if (entry.m_pending)
+            {
+                entry.m_waiting.push_back(m_spRequest);
+                return;
+            }
+
+            if (Clock::now() < entry.m_expiry)
+            {
+                auto ec = entry.m_ec;
+                auto addresses = entry.m_addresses;
+                lock.unlock();
+                m_spRequest->Complete(ec, addresses);
+                return;
+            }
+
+            entry.m_pending = true;
+            entry.m_waiting.push_back(m_spRequest);
+        }
+
+        auto spQuery = std::make_shared<Query>(hostName, m_executor);
+        asio::ip::tcp::resolver::query query(asio::ip::tcp::v4(), hostName, "");
+        spQuery->m_resolver.async_resolve(query, 
+            [spQuery](const boost::system::error_code& ec, asio::ip::tcp::resolver::iterator itEndpoint)
+        {
+            ResolvedAddresses addresses;
+            for (asio::ip::tcp::resolver::iterator itEnd; itEndpoint != itEnd; ++itEndpoint)
+            {
+                addresses.push_back(itEndpoint->endpoint().address());
+            }
+            if (!ec && addresses.empty())
+            {
+                spQuery->Complete(asio::error::host_not_found, addresses);
+                return;
+            }
+            spQuery->Complete(ec, addresses);
+        });
+    }
+}
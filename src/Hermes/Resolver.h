@@ -0,0 +1,62 @@
+/***********************************************************************
+Copyright 2018 ASM Assembly Systems GmbH & Co. KG
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+************************************************************************/
+
+// Copyright (c) ASM Assembly Systems GmbH & Co. KG
+#pragma once
+
+#include "IService.h"
+
+#include <boost/asio.hpp>
+
+#include <functional>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace asio = boost::asio;
+
+namespace Hermes
+{
+    using ResolvedAddresses = std::vector<asio::ip::address>;
+    using ResolveCallback = std::function<void(const boost::system::error_code&, const ResolvedAddresses&)>;
+
+    // Asynchronous IPv4 name resolution, backed by a process-wide cache:
+    // - ip address literals are not looked up at all
+    // - results are cached for a minute, failures for a few seconds
+    // - concurrent lookups of the same host name, also from different Hermes instances, share a single query
+    //
+    // The callback is called on the executor passed in the constructor, but never after Cancel()
+    // or the destruction of the Resolver. Hence the callback must not keep the owner of the Resolver alive.
+    class Resolver
+    {
+    public:
+        explicit Resolver(const AsioExecutor& executor);
+        ~Resolver();
+
+        Resolver(const Resolver&) = delete;
+        Resolver& operator=(const Resolver&) = delete;
+
+        // a pending resolve is cancelled by a new one:
+        void AsyncResolve(const std::string& hostName, ResolveCallback&& callback);
+        void Cancel();
+
+        struct Request;
+
+    private:
+        AsioExecutor m_executor;
+        std::shared_ptr<Request> m_spRequest;
+    };
+}
@@ -0,0 +1,99 @@
+/***********************************************************************
+Copyright 2018 ASM Assembly Systems GmbH & Co. KG
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+************************************************************************/
+
+
+// Copyright (c) ASM Assembly Systems GmbH & Co. KG
+#pragma once
+
+#include <algorithm>
+#include <random>
+
+namespace Hermes
+{
+    // delays between retries to connect or to listen:
+    // the first retry is immediate, then the delay grows exponentially up to the maximum.
+    // Each delay is shortened by a random fraction of up to m_jitter, so that peers restarting together
+    // (e.g. a whole line after a power failure) do not retry in lock-step.
+    struct RetryPolicy
+    {
+        double m_initialDelayInSeconds = 0.25;
+        double m_maxDelayInSeconds = 10.0;
+        double m_backoffFactor = 2.0;
+        double m_jitter = 0.5;
+
+        friend bool operator==(const RetryPolicy& lhs, const RetryPolicy& rhs)
+        {
+            return lhs.m_initialDelayInSeconds == rhs.m_initialDelayInSeconds
+                && lhs.m_maxDelayInSeconds == rhs.m_maxDelayInSeconds
+                && lhs.m_backoffFactor == rhs.m_backoffFactor
+                && lhs.m_jitter == rhs.m_jitter;
+        }
+        friend bool operator!=(const RetryPolicy& lhs, const RetryPolicy& rhs)
+        {
+            return !operator==(lhs, rhs);
+        }
+
+        template<class S>
+        friend S& operator<<(S& s, const RetryPolicy& policy)
+        {
+            s << "{m_initialDelayInSeconds=" << policy.m_initialDelayInSeconds
+                << ",m_maxDelayInSeconds=" << policy.m_maxDelayInSeconds
+                << ",m_backoffFactor=" << policy.m_backoffFactor
+                << ",m_jitter=" << policy.m_jitter
+                << '}';
+            return s;
+        }
+    };
+
+    // the state of consecutive retries according to a RetryPolicy, to be reset once successful:
+    class RetryBackoff
+    {
+    public:
+        RetryBackoff() :
+            m_random(std::random_device{}())
+        {}
+
+        // for reproducible delays, e.g. on a VirtualNetwork:
+        explicit RetryBackoff(unsigned seed) :
+            m_random(seed)
+        {}
+
+        double NextDelayInSeconds(const RetryPolicy& policy)
+        {
+            auto attempt = m_attempt++;
+            if (!attempt)
+                return 0.0;
+
+            auto delay = policy.m_initialDelayInSeconds;
+            for (unsigned i = 1U; i < attempt && delay < policy.m_maxDelayInSeconds; ++i)
+            {
+                delay *= policy.m_backoffFactor;
+            }
+            delay = std::min(delay, policy.m_maxDelayInSeconds);
+
+            auto jitter = std::min(std::max(policy.m_jitter, 0.0), 1.0);
+            std::uniform_real_distribution<double> distribution(1.0 - jitter, 1.0);
+            return delay * distribution(m_random);
+        }
+
+        void Reset() { m_attempt = 0U; }
+        unsigned Attempt() const { return m_attempt; }
+
+    private:
+        unsigned m_attempt{0U};
+        std::minstd_rand m_random;
+    };
+}
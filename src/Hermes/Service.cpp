@@ -0,0 +1,160 @@
+/***********************************************************************
+Copyright 2018 ASM Assembly Systems GmbH & Co. KG
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+************************************************************************/
+
+
+#include "stdafx.h"
+
+#include "Service.h"
+
+#include <Hermes.h>
+
+#include <algorithm>
+
+namespace Hermes
+{
+    namespace
+    {
+        thread_local const ServicePool* t_pRunningPool = nullptr;
+
+#if defined(BOOST_ASIO_HAS_EPOLL)
+        // asio keeps the descriptor of its reactor to itself, but an explicit instantiation may name a private member:
+        using EpollDescriptorMember = int asio::detail::epoll_reactor::*;
+        EpollDescriptorMember EpollDescriptor();
+
+        template<EpollDescriptorMember pMember>
+        struct EpollDescriptorAccess
+        {
+            friend EpollDescriptorMember EpollDescriptor() { return pMember; }
+        };
+        template struct EpollDescriptorAccess<&asio::detail::epoll_reactor::epoll_fd_>;
+#endif
+    }
+
+    int Service::PollDescriptor()
+    {
+#if defined(BOOST_ASIO_HAS_EPOLL)
+        if (m_pPool)
+            return -1;
+
+        auto& reactor = asio::use_service<asio::detail::epoll_reactor>(m_asioService);
+        reactor.init_task();
+        m_pollDescriptorUsed = true;
+        return reactor.*EpollDescriptor();
+#else
+        return -1;
+#endif
+    }
+
+    void Service::WakePoller_()
+    {
+#if defined(BOOST_ASIO_HAS_EPOLL)
+        asio::use_service<asio::detail::epoll_reactor>(m_asioService).interrupt();
+#endif
+    }
+
+    ServicePool::ServicePool(unsigned threadCount, const ThreadSettings* pThreadSettings)
+    {
+        if (pThreadSettings)
+        {
+            m_upThreadSettings = std::make_unique<ThreadSettings>(*pThreadSettings);
+        }
+
+        if (!threadCount)
+        {
+            threadCount = std::max(std::thread::hardware_concurrency(), 1U);
+        }
+
+        m_threads.reserve(threadCount);
+        for (unsigned i = 0U; i < threadCount; ++i)
+        {
+            m_threads.emplace_back([this, i]()
+            {
+                t_pRunningPool = this;
+                // without a trace callback, the failed settings just show in the statistics:
+                boost::system::error_code ec;
+                RunThread(m_asioService, m_threadRegistry, m_upThreadSettings.get(), i, ec, [](const std::string&) {});
+            });
+        }
+    }
+
+    ServicePool::ServicePool(VirtualNetworkTag) :
+        m_upVirtualNetwork(std::make_unique<VirtualNetwork>(m_asioService))
+    {}
+
+    bool ServicePool::IsPoolThread() const
+    {
+        return t_pRunningPool == this;
+    }
+
+    ServicePool::~ServicePool()
+    {
+        // all instances on the pool are deleted by now, so the threads return once the last pending handlers are done:
+        m_upAsioWork.reset();
+        for (auto& thread : m_threads)
+        {
+            thread.join();
+        }
+    }
+}
+
+//===================== implementation of public C functions =====================
+
+HermesService* CreateHermesService(uint32_t threadCount)
+{
+    return new HermesService(threadCount, nullptr);
+}
+
+HermesService* CreateHermesServiceWithThreadSettings(uint32_t threadCount, const HermesThreadSettings* pThreadSettings)
+{
+    const auto threadSettings = Hermes::ToCpp(*pThreadSettings);
+    return new HermesService(threadCount, &threadSettings);
+}
+
+HermesService* CreateHermesVirtualService()
+{
+    return new HermesService(Hermes::VirtualNetworkTag{});
+}
+
+uint32_t PollHermesVirtualService(HermesService* pService, uint32_t maxHandlers)
+{
+    auto* pVirtualNetwork = pService->m_pool.m_upVirtualNetwork.get();
+    if (!pVirtualNetwork)
+        return 0U;
+    return static_cast<uint32_t>(pVirtualNetwork->Poll(maxHandlers));
+}
+
+uint32_t AdvanceHermesVirtualService(HermesService* pService, uint32_t milliseconds)
+{
+    auto* pVirtualNetwork = pService->m_pool.m_upVirtualNetwork.get();
+    if (!pVirtualNetwork)
+        return 0U;
+    return static_cast<uint32_t>(pVirtualNetwork->Advance(std::chrono::milliseconds(milliseconds)));
+}
+
+uint32_t GetHermesServiceThreadStatistics(HermesService* pService, HermesThreadStatistics* pStatistics, uint32_t maxCount)
+{
+    return CopyThreadStatistics(pService->m_pool.m_threadRegistry.Statistics(), pStatistics, maxCount);
+}
+
+void DeleteHermesService(HermesService* pService)
+{
+    delete pService;
+}
+
+uint64_t GetHermesTaskAllocationCount()
+{
+    return Hermes::TaskAllocationCount();
+}
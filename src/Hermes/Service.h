@@ -19,32 +19,243 @@ limitations under the License.
 #include <HermesDataConversion.hpp>
 #include "ApiCallback.h"
 #include "IService.h"
+#include "LatencyHistograms.h"
+#include "MpscRing.h"
+#include "Threads.h"
+#include "TraceSink.h"
+#include "VirtualNetwork.h"
 
 #include <boost/asio.hpp>
 
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <future>
 #include <memory>
+#include <mutex>
+#include <thread>
+#include <type_traits>
+#include <vector>
 
 namespace asio = boost::asio;
 
 namespace Hermes
 {
-    struct Service : IAsioService
+    struct VirtualNetworkTag {};
+
+    // worker threads serving any number of Hermes instances, each of them on its own strand:
+    struct ServicePool
     {
         asio::io_service m_asioService;
-        asio::io_service::work m_asioWork{m_asioService};
+        std::unique_ptr<asio::io_service::work> m_upAsioWork{std::make_unique<asio::io_service::work>(m_asioService)};
+        std::unique_ptr<ThreadSettings> m_upThreadSettings;
+        ThreadRegistry m_threadRegistry;
+        std::vector<std::thread> m_threads;
+        // instead of threads, the application steps the pool through this; destroyed before m_asioService:
+        std::unique_ptr<VirtualNetwork> m_upVirtualNetwork;
+
+        ServicePool(unsigned threadCount, const ThreadSettings* pThreadSettings = nullptr);
+        explicit ServicePool(VirtualNetworkTag);
+        ~ServicePool();
+
+        ServicePool(const ServicePool&) = delete;
+        ServicePool& operator=(const ServicePool&) = delete;
+
+        // whether the calling thread is one of m_threads:
+        bool IsPoolThread() const;
+    };
+
+    // Posting from a thread not running the io_service, asio allocates its handler (and the strand's invoker) from the heap.
+    // Only one batch of tasks is pending at a time, so a service keeps the memory for that at hand:
+    class HandlerMemory
+    {
+    public:
+        void* Allocate(std::size_t size)
+        {
+            for (auto& slot : m_slots)
+            {
+                if (size <= sizeof(slot.m_storage) && !slot.m_inUse.exchange(true))
+                    return &slot.m_storage;
+            }
+            CountTaskAllocation();
+            return ::operator new(size);
+        }
+
+        void Deallocate(void* p)
+        {
+            for (auto& slot : m_slots)
+            {
+                if (p == &slot.m_storage)
+                {
+                    slot.m_inUse = false;
+                    return;
+                }
+            }
+            ::operator delete(p);
+        }
+
+    private:
+        struct Slot
+        {
+            std::aligned_storage_t<256U> m_storage;
+            std::atomic<bool> m_inUse{false};
+        };
+        std::array<Slot, 2U> m_slots;
+    };
+
+    template<class T>
+    struct HandlerAllocator
+    {
+        using value_type = T;
+        HandlerMemory* m_pMemory;
+
+        explicit HandlerAllocator(HandlerMemory& memory) : m_pMemory(&memory) {}
+        template<class U> HandlerAllocator(const HandlerAllocator<U>& rhs) : m_pMemory(rhs.m_pMemory) {}
+
+        T* allocate(std::size_t n) { return static_cast<T*>(m_pMemory->Allocate(sizeof(T) * n)); }
+        void deallocate(T* p, std::size_t) { m_pMemory->Deallocate(p); }
+
+        friend bool operator==(const HandlerAllocator& lhs, const HandlerAllocator& rhs) { return lhs.m_pMemory == rhs.m_pMemory; }
+        friend bool operator!=(const HandlerAllocator& lhs, const HandlerAllocator& rhs) { return lhs.m_pMemory != rhs.m_pMemory; }
+    };
+
+    struct Service : IAsioService
+    {
+        ServicePool* m_pPool; // if null, we run our own io_service in Run()
+        HandlerMemory m_handlerMemory; // to outlive the handlers of m_ownAsioService
+
+        // The WheelTimers of all sessions, advanced on m_strand when the first armed one is due.
+        // Declared before m_ownAsioService, as its handlers may still cancel timers when destroyed:
+        std::mutex m_timerMutex;
+        TimerWheel m_timerWheel;
+        const std::chrono::steady_clock::time_point m_timerWheelStart{Now()};
+        bool m_timerWheelTicking{false};
+        std::uint64_t m_timerWheelWakeTick{0U}; // see ScheduleTimerTick_()
+        unsigned m_timerWheelWakeId{0U}; // to ignore a wake superseded by an earlier one
+
+        asio::io_service m_ownAsioService;
+        asio::io_service::work m_asioWork{m_ownAsioService};
+        asio::io_service& m_asioService{m_pPool ? m_pPool->m_asioService : m_ownAsioService};
+        AsioExecutor m_strand{asio::make_strand(m_asioService)};
+        asio::steady_timer m_timerWheelTimer{m_strand};
+        struct DueTimer
+        {
+            AsioExecutor m_executor;
+            Task m_task;
+            std::shared_ptr<std::atomic<std::uint64_t>> m_spGeneration; // see WheelTimer
+            std::uint64_t m_generation;
+        };
+        std::vector<DueTimer> m_dueTimers; // only accessed on the strand
         ApiCallback<HermesTraceCallback> m_traceCallback;
+        std::atomic<unsigned> m_traceMask{m_traceCallback ? cALL_TRACE_TYPES : 0U}; // see SetTraceMask()
+        std::unique_ptr<TraceSink> m_upTraceSink; // if set, instead of m_traceCallback
+        ApiCallback<HermesTraceEventCallback> m_traceEventCallback;
+        std::unique_ptr<LatencyHistograms> m_upLatencyHistograms;
+
+        // for instances on a pool, Run() just waits for Stop():
+        std::mutex m_mutex;
+        std::condition_variable m_cv;
+        bool m_stopped{false};
+        std::atomic<bool> m_deleted{false}; // set by Delete(), read from any thread (e.g. by Trace())
+
+        // Posted tasks are queued here and run in batches, each posted as a single handler.
+        // The vectors are swapped rather than reallocated, so that posting does not allocate once warmed up.
+        // With a task ring, m_tasks only takes what the strand posts to itself while the ring is full:
+        std::unique_ptr<MpscRing<Task>> m_upTaskRing;
+        std::mutex m_taskMutex;
+        std::vector<Task> m_tasks;
+        std::atomic<bool> m_runTasksPosted{false};
+        std::vector<Task> m_runningTasks; // only accessed on the strand
+        std::atomic<bool> m_tasksOverflowed{false}; // some task went to m_tasks rather than the ring, set and reset with m_taskMutex
+        std::atomic<bool> m_pollDescriptorUsed{false}; // see PollDescriptor()
+
+        // for the threads in Run(), on a pool the pool's:
+        std::unique_ptr<ThreadSettings> m_upThreadSettings;
+        ThreadRegistry m_threadRegistry;
 
-        explicit Service(HermesTraceCallback traceCallback) :
+        explicit Service(HermesTraceCallback traceCallback, ServicePool* pPool = nullptr) :
+            m_pPool(pPool),
             m_traceCallback(traceCallback)
         {}
 
         ~Service()
-        {}
+        {
+            // what the tasks of timers still armed hold on to is released outside the lock:
+            std::vector<Task> tasks;
+            {
+                std::lock_guard<std::mutex> lock(m_timerMutex);
+                m_timerWheel.Clear([&](TimerWheelEntry& entry)
+                {
+                    tasks.push_back(std::move(static_cast<WheelTimer&>(entry).m_task));
+                });
+            }
+        }
+
+        // Further threads only help where the handlers are not all serialized through m_strand,
+        // see NetworkConfiguration::m_strandPerSession. They are joined before returning:
+        void Run(unsigned threadCount = 1U)
+        {
+            if (m_pPool)
+            {
+                std::unique_lock<std::mutex> lock(m_mutex);
+                m_cv.wait(lock, [this]() { return m_stopped; });
+                return;
+            }
+
+            std::vector<std::thread> threads;
+            for (unsigned i = 1U; i < threadCount; ++i)
+            {
+                threads.emplace_back([this, i]() { Run_(i); });
+            }
+            Run_(0U);
+            for (auto& thread : threads)
+            {
+                thread.join();
+            }
+        }
 
-        void Run()
+        // Instead of Run(), for driving the instance from the application's own event loop. The handlers,
+        // and with them the callbacks, run on the calling thread. Both return the number of handlers run,
+        // and neither does anything for instances on a pool, as the pool's threads run those:
+        std::size_t Poll(std::size_t maxHandlers) // 0: all that are ready
         {
+            if (m_pPool)
+                return 0U;
+
             boost::system::error_code ec;
-            m_asioService.run(ec);
+            if (!maxHandlers)
+                return m_asioService.poll(ec);
+
+            std::size_t count = 0U;
+            while (count < maxHandlers && m_asioService.poll_one(ec))
+            {
+                ++count;
+            }
+            return count;
+        }
+
+        std::size_t RunFor(std::chrono::milliseconds timeout)
+        {
+            if (m_pPool)
+                return 0U;
+            return m_asioService.run_for(timeout);
+        }
+
+        // For Poll(): the descriptor of the io_service's epoll reactor, readable while the sockets or timers have
+        // something for it to do. As asio does not wake its reactor for what is posted while nobody runs it, we do
+        // so from then on. -1 where there is no such descriptor: not on Linux, and on a pool:
+        int PollDescriptor();
+        void WakePoller_();
+
+        void Run_(unsigned threadIndex)
+        {
+            boost::system::error_code ec;
+            RunThread(m_asioService, m_threadRegistry, m_upThreadSettings.get(), threadIndex, ec, [this](const std::string& failure)
+            {
+                Warn(0U, "Thread settings not applied: ", failure);
+            });
             if (!ec)
                 return;
             Trace(ETraceType::eERROR, 0U, BuildString("m_asioService.Run: ", ec.message()));
@@ -52,23 +263,451 @@ namespace Hermes
 
         void Stop()
         {
+            if (m_pPool)
+            {
+                std::lock_guard<std::mutex> lock(m_mutex);
+                m_stopped = true;
+                m_cv.notify_all();
+                return;
+            }
+
             m_asioService.stop();
         }
 
+        // Deletes the Hermes instance owning this service. On a pool, no handler of the instance may run meanwhile,
+        // so the deletion happens on the strand. Handlers still queued afterwards find m_deleted set.
+        // Called from a thread of the pool (e.g. from a callback of another instance), the deletion is only posted:
+        // waiting for it could block the very thread that has to run it.
+        template<class InstanceT>
+        static void Delete(InstanceT* pInstance)
+        {
+            auto spService = pInstance->m_spService;
+            spService->Stop();
+            // a VirtualNetwork's handlers only run on the thread stepping it, so not meanwhile:
+            if (!spService->m_pPool || spService->GetVirtualNetwork() || spService->m_strand.running_in_this_thread())
+            {
+                delete pInstance;
+                spService->m_deleted = true;
+                return;
+            }
+
+            if (spService->m_pPool->IsPoolThread())
+            {
+                asio::post(spService->m_strand, [pInstance, spService]()
+                {
+                    delete pInstance;
+                    spService->m_deleted = true;
+                });
+                return;
+            }
+
+            std::promise<void> deleted;
+            asio::post(spService->m_strand, [&]()
+            {
+                delete pInstance;
+                spService->m_deleted = true;
+                deleted.set_value();
+            });
+            deleted.get_future().wait();
+        }
+
+        struct RunTasksHandler
+        {
+            Service* m_pService;
+            IAsioServiceSp m_spLifetime;
+
+            using allocator_type = HandlerAllocator<void>;
+            allocator_type get_allocator() const noexcept { return allocator_type(m_pService->m_handlerMemory); }
+
+            void operator()() { m_pService->RunTasks_(); }
+        };
+
+        // to be called before Run(); no effect on a pool, whose threads have been set up with the pool:
+        void SetThreadSettings(const ThreadSettings& settings)
+        {
+            m_upThreadSettings = std::make_unique<ThreadSettings>(settings);
+        }
+
+        // the threads currently in Run(), on a pool the pool's:
+        std::vector<ThreadStatistics> GetThreadStatistics() const
+        {
+            return m_pPool ? m_pPool->m_threadRegistry.Statistics() : m_threadRegistry.Statistics();
+        }
+
+        // May be called any time, from any thread. Without a trace callback or file, nothing is traced anyway:
+        void SetTraceMask(unsigned traceMask)
+        {
+            m_traceMask.store(m_traceCallback || m_upTraceSink ? (traceMask & cALL_TRACE_TYPES) : 0U, std::memory_order_relaxed);
+        }
+
+        // to be called before anything is posted:
+        void SetTraceEventCallback(const HermesTraceEventCallback& callback)
+        {
+            m_traceEventCallback = callback;
+        }
+
+        // To be called before anything is posted: from then on, the traces go to the file rather than the trace callback.
+        // If the file cannot be created, this is warned about and the trace callback stays in use:
+        void UseTraceFile(const std::string& path, std::size_t ringCapacityInBytes, std::size_t maxFileSizeInBytes)
+        {
+            auto upTraceSink = std::make_unique<TraceSink>(path, ringCapacityInBytes, maxFileSizeInBytes);
+            if (!upTraceSink->IsOpen())
+            {
+                Warn(0U, "Cannot create trace file ", path);
+                return;
+            }
+            if (!m_traceCallback)
+            {
+                m_traceMask.store(cALL_TRACE_TYPES, std::memory_order_relaxed);
+            }
+            m_upTraceSink = std::move(upTraceSink);
+        }
+
+        // to be called before anything is posted:
+        void EnableLatencyHistograms()
+        {
+            m_upLatencyHistograms = std::make_unique<LatencyHistograms>();
+        }
+
+        std::vector<HermesLatencyHistogram> GetLatencyHistogramSummaries() const
+        {
+            return m_upLatencyHistograms ? m_upLatencyHistograms->Summaries() : std::vector<HermesLatencyHistogram>{};
+        }
+
+        // To be called before anything is posted: application threads then hand over their tasks without locking
+        // (and without waking up the strand if it is still busy with the previous ones). Once the ring is full, they wait
+        // for room a while, then queue their tasks behind it with a lock, as the strand does.
+        void UseTaskRing(std::size_t capacity)
+        {
+            m_upTaskRing = std::make_unique<MpscRing<Task>>(capacity);
+        }
+
+        void PostRunTasks_()
+        {
+            // acq_rel, pairing with RunTasks_(), so that either the handler sees our task or we post another one:
+            if (m_runTasksPosted.exchange(true, std::memory_order_acq_rel))
+                return;
+            asio::post(m_strand, RunTasksHandler{this, Lifetime()});
+            if (m_pollDescriptorUsed.load(std::memory_order_relaxed))
+            {
+                WakePoller_();
+            }
+        }
+
+        void RunTasks_()
+        {
+            m_runTasksPosted.exchange(false, std::memory_order_acq_rel);
+            if (m_upTaskRing)
+            {
+                // at most one ring's worth, so that a busy producer does not starve the socket handlers:
+                Task task;
+                auto count = m_upTaskRing->Capacity();
+                for (; count && !m_deleted && m_upTaskRing->TryPop(task); --count)
+                {
+                    task();
+                }
+                task = Task();
+                // what went to m_tasks meanwhile has to wait until the ring is empty, to stay behind the tasks in there:
+                if (!count)
+                    return PostRunTasks_();
+            }
+
+            {
+                std::lock_guard<std::mutex> lock(m_taskMutex);
+                m_tasks.swap(m_runningTasks);
+                m_tasksOverflowed.store(false, std::memory_order_relaxed);
+            }
+            for (auto& task : m_runningTasks)
+            {
+                if (m_deleted)
+                    break;
+                task();
+            }
+            m_runningTasks.clear();
+        }
+
+        static constexpr unsigned cTASK_RING_ATTEMPTS = 1024U;
+
+        // false: to be queued in m_tasks instead
+        bool PushToTaskRing_(Task& task)
+        {
+            // once a task has gone to m_tasks, the following ones go there as well until it has run, keeping them in order:
+            if (m_tasksOverflowed.load(std::memory_order_acquire))
+                return false;
+
+            // The strand cannot wait for itself. Neither can a thread driving the instance (in Poll(), in a callback
+            // of another instance on the pool or in a callback queue waiting for room) wait for long, nobody else would make room:
+            auto attempts = m_strand.running_in_this_thread() ? 1U : cTASK_RING_ATTEMPTS;
+            for (;;)
+            {
+                if (m_upTaskRing->TryPush(task))
+                    return true;
+                if (!--attempts)
+                    return false;
+                std::this_thread::yield();
+            }
+        }
+
+        static constexpr std::chrono::milliseconds cTIMER_TICK{25};
+
+        static std::uint64_t TicksOf_(std::chrono::steady_clock::duration duration)
+        {
+            if (duration <= std::chrono::steady_clock::duration::zero())
+                return 0U;
+            return static_cast<std::uint64_t>(duration / cTIMER_TICK);
+        }
+
+        // on the strand: sleeps through the ticks before the first armed timer is due
+        void ScheduleTimerTick_()
+        {
+            std::uint64_t tick;
+            unsigned wakeId;
+            {
+                std::lock_guard<std::mutex> lock(m_timerMutex);
+                if (!m_timerWheel.Size())
+                {
+                    m_timerWheelTicking = false;
+                    return;
+                }
+                tick = m_timerWheelWakeTick = m_timerWheel.NextDueTick();
+                wakeId = ++m_timerWheelWakeId;
+            }
+            if (auto* pVirtualNetwork = GetVirtualNetwork())
+            {
+                pVirtualNetwork->Schedule(m_timerWheelStart + tick * cTIMER_TICK, [this, spLifetime = Lifetime(), wakeId]()
+                {
+                    asio::post(m_strand, [this, spLifetime, wakeId]()
+                    {
+                        if (m_deleted)
+                            return;
+                        OnTimerTick_(wakeId);
+                    });
+                });
+                return;
+            }
+            m_timerWheelTimer.expires_at(m_timerWheelStart + tick * cTIMER_TICK);
+            m_timerWheelTimer.async_wait([this, spLifetime = Lifetime(), wakeId](const boost::system::error_code& ec)
+            {
+                if (ec || m_deleted)
+                    return;
+                OnTimerTick_(wakeId);
+            });
+        }
+
+        void OnTimerTick_(unsigned wakeId)
+        {
+            bool ticking;
+            {
+                std::lock_guard<std::mutex> lock(m_timerMutex);
+                if (wakeId != m_timerWheelWakeId)
+                    return;
+                auto tick = TicksOf_(Now() - m_timerWheelStart);
+                while (m_timerWheel.Tick() < tick && m_timerWheel.Size())
+                {
+                    m_timerWheel.Advance([this](TimerWheelEntry& entry)
+                    {
+                        auto& timer = static_cast<WheelTimer&>(entry);
+                        m_dueTimers.push_back(DueTimer{timer.m_executor, std::move(timer.m_task), timer.m_spGeneration, timer.m_spGeneration->load()});
+                    });
+                }
+                if (!m_timerWheel.Size())
+                {
+                    m_timerWheel.FastForward(tick);
+                    m_timerWheelTicking = false;
+                }
+                ticking = m_timerWheelTicking;
+            }
+
+            // a timer cancelled or re-armed after falling due (e.g. by an earlier task here) must not fire any more;
+            // on another executor, the posted task can no longer be retracted, so it checks for that itself:
+            for (auto& dueTimer : m_dueTimers)
+            {
+                if (m_deleted)
+                    break;
+                if (*dueTimer.m_spGeneration != dueTimer.m_generation)
+                    continue;
+                if (dueTimer.m_executor == m_strand)
+                {
+                    dueTimer.m_task();
+                }
+                else
+                {
+                    asio::post(dueTimer.m_executor, [spGeneration = std::move(dueTimer.m_spGeneration),
+                        generation = dueTimer.m_generation, task = std::move(dueTimer.m_task)]() mutable
+                    {
+                        if (*spGeneration != generation)
+                            return;
+                        task();
+                    });
+                }
+            }
+            m_dueTimers.clear();
+
+            if (ticking)
+            {
+                ScheduleTimerTick_();
+            }
+        }
+
         //============== IAsioService ==========================
-        void Post(std::function<void()>&& f) override
+        void Post(Task&& task) override
         {
-            m_asioService.post(std::move(f));
+            if (!m_upTaskRing || !PushToTaskRing_(task))
+            {
+                std::lock_guard<std::mutex> lock(m_taskMutex);
+                m_tasks.push_back(std::move(task));
+                m_tasksOverflowed.store(static_cast<bool>(m_upTaskRing), std::memory_order_release);
+            }
+            PostRunTasks_();
         }
 
         void Trace(ETraceType type, unsigned sessionId, StringView trace) override
         {
+            if (m_deleted || !IsTraced(type))
+                return;
+            if (m_upTraceSink)
+            {
+                m_upTraceSink->Trace(sessionId, type, trace);
+                return;
+            }
             m_traceCallback(sessionId, ToC(type), ToC(trace));
         }
 
+        bool IsTraced(ETraceType type) const override
+        {
+            return (m_traceMask.load(std::memory_order_relaxed) & TraceMask(type)) != 0U;
+        }
+
+        bool HasTraceEventCallback() const override
+        {
+            return static_cast<bool>(m_traceEventCallback);
+        }
+
+        void SignalTraceEvent(const TraceEvent& event) override
+        {
+            if (m_deleted)
+                return;
+            HermesTraceEvent cEvent;
+            CppToC(event, cEvent);
+            m_traceEventCallback(&cEvent);
+        }
+
         boost::asio::io_service& GetUnderlyingService() override
         {
             return m_asioService;
         }
+
+        AsioExecutor GetExecutor() override
+        {
+            return m_strand;
+        }
+
+        IAsioServiceSp Lifetime() override
+        {
+            if (!m_pPool)
+                return{};
+            return shared_from_this();
+        }
+
+        void ArmTimer(WheelTimer& timer, std::chrono::steady_clock::duration delay, Task&& task) override
+        {
+            Task cancelledTask;
+            bool scheduleTick = false;
+            {
+                std::lock_guard<std::mutex> lock(m_timerMutex);
+                ++*timer.m_spGeneration;
+                if (m_timerWheel.Cancel(timer))
+                {
+                    cancelledTask = std::move(timer.m_task);
+                }
+
+                auto sinceStart = Now() - m_timerWheelStart;
+                if (!m_timerWheel.Size())
+                {
+                    m_timerWheel.FastForward(TicksOf_(sinceStart));
+                }
+                // rounded up, so as not to fire early:
+                auto dueTick = TicksOf_(sinceStart + delay + cTIMER_TICK - std::chrono::steady_clock::duration(1));
+                timer.m_task = std::move(task);
+                auto ticks = dueTick > m_timerWheel.Tick() ? dueTick - m_timerWheel.Tick() : 1U;
+                m_timerWheel.Arm(timer, ticks);
+
+                // due before the strand is to wake up, it is to wake up earlier:
+                if (!m_timerWheelTicking || m_timerWheel.Tick() + ticks < m_timerWheelWakeTick)
+                {
+                    m_timerWheelTicking = scheduleTick = true;
+                    m_timerWheelWakeTick = m_timerWheel.Tick() + ticks;
+                }
+            }
+
+            if (!scheduleTick)
+                return;
+            asio::post(m_strand, [this, spLifetime = Lifetime()]()
+            {
+                if (m_deleted)
+                    return;
+                ScheduleTimerTick_();
+            });
+        }
+
+        void CancelTimer(WheelTimer& timer) override
+        {
+            Task cancelledTask;
+            std::lock_guard<std::mutex> lock(m_timerMutex);
+            // also when no longer armed, its task may already be due:
+            ++*timer.m_spGeneration;
+            if (!m_timerWheel.Cancel(timer))
+                return;
+            cancelledTask = std::move(timer.m_task);
+        }
+
+        std::chrono::steady_clock::time_point Now() override
+        {
+            auto* pVirtualNetwork = GetVirtualNetwork();
+            return pVirtualNetwork ? pVirtualNetwork->Now() : std::chrono::steady_clock::now();
+        }
+
+        VirtualNetwork* GetVirtualNetwork() override
+        {
+            return m_pPool ? m_pPool->m_upVirtualNetwork.get() : nullptr;
+        }
+
+        LatencyHistograms* GetLatencyHistograms() override
+        {
+            return m_upLatencyHistograms.get();
+        }
     };
 }
+
+// the C API's handle to a pool of worker threads shared by several Hermes instances:
+struct HermesService
+{
+    Hermes::ServicePool m_pool;
+
+    HermesService(unsigned threadCount, const Hermes::ThreadSettings* pThreadSettings) :
+        m_pool(threadCount, pThreadSettings)
+    {}
+
+    explicit HermesService(Hermes::VirtualNetworkTag tag) :
+        m_pool(tag)
+    {}
+};
+
+// for the C API: copies up to maxCount, returns how many there are
+inline uint32_t CopyThreadStatistics(const std::vector<Hermes::ThreadStatistics>& statistics,
+    HermesThreadStatistics* pStatistics, uint32_t maxCount)
+{
+    for (std::size_t i = 0U; i < statistics.size() && i < maxCount; ++i)
+    {
+        Hermes::CppToC(statistics[i], pStatistics[i]);
+    }
+    return static_cast<uint32_t>(statistics.size());
+}
+
+// likewise:
+inline uint32_t CopyLatencyHistograms(const std::vector<HermesLatencyHistogram>& histograms,
+    HermesLatencyHistogram* pHistograms, uint32_t maxCount)
+{
+    std::copy_n(histograms.begin(), std::min<std::size_t>(histograms.size(), maxCount), pHistograms);
+    return static_cast<uint32_t>(histograms.size());
+}
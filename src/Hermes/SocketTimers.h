@@ -0,0 +1,145 @@
+/***********************************************************************
+Copyright 2018 ASM Assembly Systems GmbH & Co. KG
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+************************************************************************/
+
+
+// Copyright (c) ASM Assembly Systems GmbH & Co. KG
+#pragma once
+
+#include "IService.h"
+#include "MessageSerialization.h"
+#include "Network.h"
+
+#include <HermesData.hpp>
+
+#include <chrono>
+
+namespace Hermes
+{
+    // Check alive and receive timeout of a connection, for AsioSocket and VirtualSocket alike, on the clock of their service.
+    // Sending does not touch the check alive timer, it just records the time of the last send;
+    // the timer then only fires when the connection may have been idle for a whole period.
+    // Same scheme for the receive side: a silent peer (e.g. after a cable pull) is disconnected without waiting for a write to fail.
+    // SocketT provides shared_from_this(), Closed(), Send(StringView, unsigned) and OnReceiveTimeout();
+    // the pending timers keep their socket alive:
+    class SocketTimers
+    {
+    public:
+        using Duration = std::chrono::steady_clock::duration;
+
+        SocketTimers(IAsioService& service, const AsioExecutor& executor, const NetworkConfiguration& configuration) :
+            m_service(service),
+            m_checkAlivePeriod(ToDuration_(configuration.m_checkAlivePeriodInSeconds)),
+            m_receiveTimeout(ToDuration_(configuration.m_receiveTimeoutInSeconds)),
+            m_checkAliveTimer(service, executor),
+            m_receiveTimer(service, executor)
+        {}
+
+        SocketTimers(const SocketTimers&) = delete;
+        SocketTimers& operator=(const SocketTimers&) = delete;
+
+        template<class SocketT>
+        void Start(SocketT& socket)
+        {
+            auto now = m_service.Now();
+            if (m_receiveTimeout > Duration::zero())
+            {
+                m_lastReceiveTime = now;
+                AsyncWaitReceiveTimeout_(socket, m_receiveTimeout);
+            }
+
+            if (m_checkAlivePeriod > Duration::zero())
+            {
+                m_lastSendTime = now;
+                AsyncWaitCheckAlive_(socket, m_checkAlivePeriod);
+            }
+        }
+
+        void OnSent() { m_lastSendTime = m_service.Now(); }
+        void OnReceived() { m_lastReceiveTime = m_service.Now(); }
+
+        void Cancel()
+        {
+            m_checkAliveTimer.Cancel();
+            m_receiveTimer.Cancel();
+        }
+
+    private:
+        IAsioService& m_service;
+        Duration m_checkAlivePeriod;
+        Duration m_receiveTimeout;
+        WheelTimer m_checkAliveTimer;
+        std::chrono::steady_clock::time_point m_lastSendTime;
+        WheelTimer m_receiveTimer;
+        std::chrono::steady_clock::time_point m_lastReceiveTime;
+
+        static Duration ToDuration_(double seconds)
+        {
+            return std::chrono::duration_cast<Duration>(std::chrono::duration<double>(seconds));
+        }
+
+        template<class SocketT>
+        void AsyncWaitCheckAlive_(SocketT& socket, Duration delay)
+        {
+            if (socket.Closed())
+                return;
+
+            m_checkAliveTimer.ExpiresFromNow(delay, [this, spSocket = socket.shared_from_this()]()
+            {
+                OnCheckAliveTrigger_(*spSocket);
+            });
+        }
+
+        template<class SocketT>
+        void OnCheckAliveTrigger_(SocketT& socket)
+        {
+            if (socket.Closed())
+                return;
+
+            auto idle = m_service.Now() - m_lastSendTime;
+            if (idle < m_checkAlivePeriod)
+                return AsyncWaitCheckAlive_(socket, m_checkAlivePeriod - idle);
+
+            const auto& checkAlive = Serialize(m_service, CheckAliveData());
+            socket.Send(checkAlive.m_xml, checkAlive.m_serializeTimeInMicroseconds);
+            AsyncWaitCheckAlive_(socket, m_checkAlivePeriod);
+        }
+
+        template<class SocketT>
+        void AsyncWaitReceiveTimeout_(SocketT& socket, Duration delay)
+        {
+            if (socket.Closed())
+                return;
+
+            m_receiveTimer.ExpiresFromNow(delay, [this, spSocket = socket.shared_from_this()]()
+            {
+                OnReceiveTimeout_(*spSocket);
+            });
+        }
+
+        template<class SocketT>
+        void OnReceiveTimeout_(SocketT& socket)
+        {
+            if (socket.Closed())
+                return;
+
+            auto idle = m_service.Now() - m_lastReceiveTime;
+            if (idle < m_receiveTimeout)
+                return AsyncWaitReceiveTimeout_(socket, m_receiveTimeout - idle);
+
+            socket.OnReceiveTimeout();
+        }
+    };
+}
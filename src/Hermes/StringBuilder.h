@@ -16,26 +16,151 @@ limitations under the License.
 
 #pragma once
 
+#include <HermesStringView.hpp>
+
+#include <algorithm>
+#include <charconv>
+#include <cstdio>
+#include <cstring>
 #include <sstream>
+#include <string>
+#include <type_traits>
 
-// Build a string from a variadic parameter list:
 namespace Hermes
 {
-    inline void BuildString_(std::ostringstream&) {}
+    // A stream-like text buffer that formats into an array on the stack, and only moves to the heap for longer texts.
+    // It has operator<< for the basic types, which is all the operator<< templates in HermesData.hpp need.
+    // Other types with an operator<< for std::ostream go through a std::ostringstream, and produce the same text:
+    class StringWriter
+    {
+    public:
+        StringWriter() = default;
+        StringWriter(const StringWriter&) = delete;
+        StringWriter& operator=(const StringWriter&) = delete;
+
+        const char* data() const { return m_onHeap ? m_heapBuffer.data() : m_stackBuffer; }
+        std::size_t size() const { return m_size; }
+        StringView View() const { return StringView(data(), m_size); }
+        std::string Str() const { return std::string(data(), m_size); }
+
+        StringWriter& Write(const char* pData, std::size_t size)
+        {
+            if (!m_onHeap && m_size + size <= cSTACK_CAPACITY)
+            {
+                std::memcpy(m_stackBuffer + m_size, pData, size);
+            }
+            else
+            {
+                if (!m_onHeap)
+                {
+                    m_heapBuffer.assign(m_stackBuffer, m_size);
+                    m_onHeap = true;
+                }
+                m_heapBuffer.append(pData, size);
+            }
+            m_size += size;
+            return *this;
+        }
+
+        // anything else std::ostream can stream; kept apart from the types above by needing a conversion:
+        class Streamable
+        {
+        public:
+            template<class T, class = std::enable_if_t<!std::is_arithmetic<T>::value && !std::is_convertible<const T&, StringView>::value>>
+            Streamable(const T& value) :
+                m_pValue(&value),
+                m_pWrite([](std::ostream& os, const void* pValue) { os << *static_cast<const T*>(pValue); })
+            {}
+
+            void WriteTo(std::ostream& os) const { m_pWrite(os, m_pValue); }
+
+        private:
+            const void* m_pValue;
+            void(*m_pWrite)(std::ostream&, const void*);
+        };
+
+        StringWriter& operator<<(StringView value) { return Write(value.data(), value.size()); }
+        StringWriter& operator<<(const std::string& value) { return Write(value.data(), value.size()); }
+        StringWriter& operator<<(const char* pValue) { return pValue ? Write(pValue, std::strlen(pValue)) : *this; }
+        StringWriter& operator<<(char value) { return Write(&value, 1U); }
+        StringWriter& operator<<(signed char value) { return operator<<(static_cast<char>(value)); }
+        StringWriter& operator<<(unsigned char value) { return operator<<(static_cast<char>(value)); }
+        StringWriter& operator<<(bool value) { return operator<<(value ? '1' : '0'); } // like std::ostream without std::boolalpha
+        StringWriter& operator<<(short value) { return WriteInteger_(value); }
+        StringWriter& operator<<(unsigned short value) { return WriteInteger_(value); }
+        StringWriter& operator<<(int value) { return WriteInteger_(value); }
+        StringWriter& operator<<(unsigned value) { return WriteInteger_(value); }
+        StringWriter& operator<<(long value) { return WriteInteger_(value); }
+        StringWriter& operator<<(unsigned long value) { return WriteInteger_(value); }
+        StringWriter& operator<<(long long value) { return WriteInteger_(value); }
+        StringWriter& operator<<(unsigned long long value) { return WriteInteger_(value); }
+        StringWriter& operator<<(float value) { return operator<<(static_cast<double>(value)); }
+        StringWriter& operator<<(double value) { return WriteFormatted_("%g", value); }
+        StringWriter& operator<<(long double value) { return WriteFormatted_("%Lg", value); }
+        StringWriter& operator<<(const void* pValue)
+        {
+            // "%p" may not give what std::ostream does for null (e.g. "(nil)" rather than "0"):
+            if (!pValue)
+                return WriteStreamed_(pValue);
+            return WriteFormatted_("%p", pValue);
+        }
+
+        StringWriter& operator<<(const Streamable& value)
+        {
+            std::ostringstream oss;
+            value.WriteTo(oss);
+            return operator<<(oss.str());
+        }
+
+    private:
+        static constexpr std::size_t cSTACK_CAPACITY = 256U;
+
+        template<class T>
+        StringWriter& WriteInteger_(T value)
+        {
+            char buffer[24];
+            const auto result = std::to_chars(buffer, buffer + sizeof(buffer), value);
+            return Write(buffer, static_cast<std::size_t>(result.ptr - buffer));
+        }
+
+        template<class T>
+        StringWriter& WriteStreamed_(const T& value)
+        {
+            std::ostringstream oss;
+            oss << value;
+            return operator<<(oss.str());
+        }
+
+        template<class T>
+        StringWriter& WriteFormatted_(const char* pFormat, T value)
+        {
+            char buffer[64];
+            const int size = std::snprintf(buffer, sizeof(buffer), pFormat, value);
+            return size > 0 ? Write(buffer, std::min(static_cast<std::size_t>(size), sizeof(buffer) - 1U)) : *this;
+        }
+
+        char m_stackBuffer[cSTACK_CAPACITY];
+        std::string m_heapBuffer;
+        std::size_t m_size{0U};
+        bool m_onHeap{false};
+    };
+
+    // Build a string from a variadic parameter list:
+    inline void BuildString_(StringWriter&) {}
 
     template<class T, class... Ts>
-    void BuildString_(std::ostringstream& oss, const T& head, const Ts&... tail)
+    void BuildString_(StringWriter& writer, const T& head, const Ts&... tail)
     {
-        oss << head;
-        BuildString_(oss, tail...);
+        writer << head;
+        BuildString_(writer, tail...);
     }
 
     template<class... Ts>
     std::string BuildString(const Ts&... params)
     {
-        std::ostringstream oss;
-        BuildString_(oss, params...);
-        return oss.str();
+        StringWriter writer;
+        BuildString_(writer, params...);
+        return writer.Str();
     }
 
 }
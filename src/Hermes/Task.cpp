@@ -0,0 +1,134 @@
+/***********************************************************************
+Copyright 2018 ASM Assembly Systems GmbH & Co. KG
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+************************************************************************/
+
+
+
+#include "stdafx.h"
+
+#include "Task.h"
+
+#include <atomic>
+#include <mutex>
+
+namespace
+{
+    std::atomic<std::uint64_t> s_taskAllocationCount{0U};
+
+    struct FreeBlock
+    {
+        FreeBlock* m_pNext;
+    };
+
+    // blocks of one size, released ones kept in a free list:
+    struct BlockList
+    {
+        const std::size_t m_blockSize;
+        std::mutex m_mutex;
+        FreeBlock* m_pFree = nullptr;
+
+        explicit BlockList(std::size_t blockSize) :
+            m_blockSize(blockSize)
+        {}
+
+        ~BlockList()
+        {
+            while (m_pFree)
+            {
+                auto* pBlock = m_pFree;
+                m_pFree = pBlock->m_pNext;
+                ::operator delete(pBlock);
+            }
+        }
+
+        void* Allocate()
+        {
+            {
+                std::lock_guard<std::mutex> lock(m_mutex);
+                if (m_pFree)
+                {
+                    auto* pBlock = m_pFree;
+                    m_pFree = pBlock->m_pNext;
+                    return pBlock;
+                }
+            }
+            Hermes::CountTaskAllocation();
+            return ::operator new(m_blockSize);
+        }
+
+        void Deallocate(void* p)
+        {
+            auto* pBlock = static_cast<FreeBlock*>(p);
+            std::lock_guard<std::mutex> lock(m_mutex);
+            pBlock->m_pNext = m_pFree;
+            m_pFree = pBlock;
+        }
+    };
+
+    // sizes chosen such that the usual Hermes data structures fit, larger tasks are simply allocated:
+    struct BlockPool
+    {
+        BlockList m_lists[3]{BlockList(256U), BlockList(1024U), BlockList(4096U)};
+
+        BlockList* ListFor(std::size_t size)
+        {
+            for (auto& list : m_lists)
+            {
+                if (size <= list.m_blockSize)
+                    return &list;
+            }
+            return nullptr;
+        }
+    };
+
+    BlockPool& GetBlockPool()
+    {
+        static BlockPool s_pool;
+        return s_pool;
+    }
+}
+
+namespace Hermes
+{
+    std::uint64_t TaskAllocationCount()
+    {
+        return s_taskAllocationCount.load(std::memory_order_relaxed);
+    }
+
+    void CountTaskAllocation()
+    {
+        s_taskAllocationCount.fetch_add(1U, std::memory_order_relaxed);
+    }
+
+    namespace TaskPool
+    {
+        void* Allocate(std::size_t size)
+        {
+            if (auto* pList = GetBlockPool().ListFor(size))
+                return pList->Allocate();
+
+            CountTaskAllocation();
+            return ::operator new(size);
+        }
+
+        void Deallocate(void* p, std::size_t size)
+        {
+            if (auto* pList = GetBlockPool().ListFor(size))
+                return pList->Deallocate(p);
+
+            ::operator delete(p);
+        }
+    }
+}
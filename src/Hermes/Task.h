@@ -0,0 +1,171 @@
+/***********************************************************************
+Copyright 2018 ASM Assembly Systems GmbH & Co. KG
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+************************************************************************/
+
+
+// Copyright (c) ASM Assembly Systems GmbH & Co. KG
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <new>
+#include <type_traits>
+#include <utility>
+
+namespace Hermes
+{
+    // Heap allocations made for posting work: oversized tasks, growing the TaskPool and handler memory beyond
+    // what a service keeps at hand. Once warmed up, posting should not add to it:
+    std::uint64_t TaskAllocationCount();
+    void CountTaskAllocation();
+
+    // blocks for the tasks too large to be stored inline, kept for reuse rather than freed:
+    namespace TaskPool
+    {
+        void* Allocate(std::size_t size);
+        void Deallocate(void* p, std::size_t size);
+    }
+
+    // A move-only std::function<void()> as posted to a service, without allocating for small callables.
+    // Larger ones (e.g. capturing a whole BoardAvailableData) go into a block from the TaskPool.
+    class Task
+    {
+    public:
+        static constexpr std::size_t cINLINE_SIZE = 64U;
+
+        Task() = default;
+
+        template<class F, class = std::enable_if_t<!std::is_same<std::decay_t<F>, Task>::value>>
+        Task(F&& f)
+        {
+            using FunctionT = std::decay_t<F>;
+            if constexpr (IsInline_<FunctionT>())
+            {
+                ::new (m_storage) FunctionT(std::forward<F>(f));
+                m_pOps = &cOPS<InlineOps_<FunctionT>>;
+            }
+            else
+            {
+                void* p = TaskPool::Allocate(sizeof(FunctionT));
+                try
+                {
+                    ::new (m_storage) FunctionT*(::new (p) FunctionT(std::forward<F>(f)));
+                }
+                catch (...)
+                {
+                    TaskPool::Deallocate(p, sizeof(FunctionT));
+                    throw;
+                }
+                m_pOps = &cOPS<PooledOps_<FunctionT>>;
+            }
+        }
+
+        Task(Task&& rhs) noexcept
+        {
+            MoveFrom_(rhs);
+        }
+
+        Task& operator=(Task&& rhs) noexcept
+        {
+            if (this != &rhs)
+            {
+                Reset_();
+                MoveFrom_(rhs);
+            }
+            return *this;
+        }
+
+        Task(const Task&) = delete;
+        Task& operator=(const Task&) = delete;
+
+        ~Task()
+        {
+            Reset_();
+        }
+
+        explicit operator bool() const { return m_pOps != nullptr; }
+
+        void operator()()
+        {
+            m_pOps->m_pCall(m_storage);
+        }
+
+    private:
+        struct Ops
+        {
+            void(*m_pCall)(void* pStorage);
+            void(*m_pMove)(void* pTo, void* pFrom); // pFrom is left destroyed
+            void(*m_pDestroy)(void* pStorage);
+        };
+
+        template<class FunctionT>
+        static constexpr bool IsInline_()
+        {
+            return sizeof(FunctionT) <= cINLINE_SIZE
+                && alignof(FunctionT) <= alignof(std::max_align_t)
+                && std::is_nothrow_move_constructible<FunctionT>::value;
+        }
+
+        template<class FunctionT>
+        struct InlineOps_
+        {
+            static FunctionT& Get(void* pStorage) { return *std::launder(static_cast<FunctionT*>(pStorage)); }
+            static void Call(void* pStorage) { Get(pStorage)(); }
+            static void Move(void* pTo, void* pFrom)
+            {
+                ::new (pTo) FunctionT(std::move(Get(pFrom)));
+                Get(pFrom).~FunctionT();
+            }
+            static void Destroy(void* pStorage) { Get(pStorage).~FunctionT(); }
+        };
+
+        template<class FunctionT>
+        struct PooledOps_
+        {
+            static FunctionT* Get(void* pStorage) { return *std::launder(static_cast<FunctionT**>(pStorage)); }
+            static void Call(void* pStorage) { (*Get(pStorage))(); }
+            static void Move(void* pTo, void* pFrom) { ::new (pTo) FunctionT*(Get(pFrom)); }
+            static void Destroy(void* pStorage)
+            {
+                auto* pFunction = Get(pStorage);
+                pFunction->~FunctionT();
+                TaskPool::Deallocate(pFunction, sizeof(FunctionT));
+            }
+        };
+
+        template<class OpsT>
+        static constexpr Ops cOPS{&OpsT::Call, &OpsT::Move, &OpsT::Destroy};
+
+        void MoveFrom_(Task& rhs) noexcept
+        {
+            m_pOps = rhs.m_pOps;
+            if (!m_pOps)
+                return;
+            m_pOps->m_pMove(m_storage, rhs.m_storage);
+            rhs.m_pOps = nullptr;
+        }
+
+        void Reset_() noexcept
+        {
+            if (!m_pOps)
+                return;
+            m_pOps->m_pDestroy(m_storage);
+            m_pOps = nullptr;
+        }
+
+        alignas(std::max_align_t) unsigned char m_storage[cINLINE_SIZE];
+        const Ops* m_pOps = nullptr;
+    };
+}
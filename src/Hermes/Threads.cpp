@@ -0,0 +1,182 @@
+/***********************************************************************
+Copyright 2018 ASM Assembly Systems GmbH & Co. KG
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+************************************************************************/
+
+
+// Copyright (c) ASM Assembly Systems GmbH & Co. KG
+#include "stdafx.h"
+
+#include "Threads.h"
+
+#ifdef _WINDOWS
+#include <windows.h>
+#else
+#include <pthread.h>
+#include <sched.h>
+#include <sys/syscall.h>
+#include <time.h>
+#include <unistd.h>
+
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#endif
+
+namespace Hermes
+{
+    namespace
+    {
+        std::string ThreadName_(const std::string& name, unsigned threadIndex)
+        {
+            // Linux allows for 15 characters, so rather shorten the name than lose the index:
+            const auto index = std::to_string(threadIndex);
+            const std::size_t cMAX_SIZE = 15U;
+            return name.substr(0U, cMAX_SIZE > index.size() ? cMAX_SIZE - index.size() : 0U) + index;
+        }
+    }
+
+#ifdef _WINDOWS
+    struct ThreadUsage::NativeThread
+    {
+        HANDLE m_handle{::OpenThread(THREAD_QUERY_LIMITED_INFORMATION, FALSE, ::GetCurrentThreadId())};
+        ~NativeThread() { if (m_handle) ::CloseHandle(m_handle); }
+    };
+
+    std::vector<std::string> ApplyThreadSettings(const ThreadSettings& settings, unsigned threadIndex)
+    {
+        std::vector<std::string> failures;
+        auto thread = ::GetCurrentThread();
+        if (!settings.m_name.empty())
+        {
+            const auto name = ThreadName_(settings.m_name, threadIndex);
+            if (FAILED(::SetThreadDescription(thread, std::wstring(name.begin(), name.end()).c_str())))
+            {
+                failures.push_back("SetThreadDescription failed");
+            }
+        }
+        if (settings.m_cpuMask && !::SetThreadAffinityMask(thread, static_cast<DWORD_PTR>(settings.m_cpuMask)))
+        {
+            failures.push_back("SetThreadAffinityMask: error " + std::to_string(::GetLastError()));
+        }
+        if (settings.m_scheduling != EThreadScheduling::eINHERITED)
+        {
+            // the nearest Windows has to SCHED_FIFO within the process's priority class:
+            const int priority = settings.m_scheduling == EThreadScheduling::eFIFO ? THREAD_PRIORITY_TIME_CRITICAL : THREAD_PRIORITY_NORMAL;
+            if (!::SetThreadPriority(thread, priority))
+            {
+                failures.push_back("SetThreadPriority: error " + std::to_string(::GetLastError()));
+            }
+        }
+        return failures;
+    }
+#else
+    struct ThreadUsage::NativeThread
+    {
+        pthread_t m_thread{::pthread_self()};
+        long m_tid{::syscall(SYS_gettid)};
+    };
+
+    std::vector<std::string> ApplyThreadSettings(const ThreadSettings& settings, unsigned threadIndex)
+    {
+        std::vector<std::string> failures;
+        auto thread = ::pthread_self();
+        if (!settings.m_name.empty())
+        {
+            if (int error = ::pthread_setname_np(thread, ThreadName_(settings.m_name, threadIndex).c_str()))
+            {
+                failures.push_back(std::string("pthread_setname_np: ") + std::strerror(error));
+            }
+        }
+        if (settings.m_cpuMask)
+        {
+            cpu_set_t cpuSet;
+            CPU_ZERO(&cpuSet);
+            for (unsigned cpu = 0U; cpu < 64U; ++cpu)
+            {
+                if (settings.m_cpuMask & (uint64_t{1U} << cpu))
+                {
+                    CPU_SET(cpu, &cpuSet);
+                }
+            }
+            if (int error = ::pthread_setaffinity_np(thread, sizeof(cpuSet), &cpuSet))
+            {
+                failures.push_back(std::string("pthread_setaffinity_np: ") + std::strerror(error));
+            }
+        }
+        if (settings.m_scheduling != EThreadScheduling::eINHERITED)
+        {
+            const int policy = settings.m_scheduling == EThreadScheduling::eFIFO ? SCHED_FIFO : SCHED_OTHER;
+            sched_param param{};
+            if (policy == SCHED_FIFO)
+            {
+                param.sched_priority = std::min(std::max(settings.m_priority, ::sched_get_priority_min(policy)),
+                    ::sched_get_priority_max(policy));
+            }
+            if (int error = ::pthread_setschedparam(thread, policy, &param))
+            {
+                failures.push_back(std::string("pthread_setschedparam: ") + std::strerror(error));
+            }
+        }
+        return failures;
+    }
+#endif
+
+    ThreadUsage::ThreadUsage(unsigned threadIndex, unsigned failedSettingCount) :
+        m_threadIndex(threadIndex),
+        m_failedSettingCount(failedSettingCount),
+        m_upNativeThread(std::make_unique<NativeThread>())
+    {}
+
+    ThreadUsage::~ThreadUsage() = default;
+
+    ThreadStatistics ThreadUsage::Statistics() const
+    {
+        ThreadStatistics statistics;
+        statistics.m_threadIndex = m_threadIndex;
+        statistics.m_failedSettingCount = m_failedSettingCount;
+        statistics.m_handlerCount = m_handlerCount.load(std::memory_order_relaxed);
+        statistics.m_runTimeInMicroseconds = static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::microseconds>(
+            std::chrono::steady_clock::now() - m_start).count());
+
+#ifdef _WINDOWS
+        FILETIME creationTime, exitTime, kernelTime, userTime;
+        if (m_upNativeThread->m_handle && ::GetThreadTimes(m_upNativeThread->m_handle, &creationTime, &exitTime, &kernelTime, &userTime))
+        {
+            auto toTicks = [](const FILETIME& time) { return (uint64_t{time.dwHighDateTime} << 32U) | time.dwLowDateTime; };
+            statistics.m_cpuTimeInMicroseconds = (toTicks(kernelTime) + toTicks(userTime)) / 10U; // in units of 100ns
+        }
+#else
+        clockid_t clockId;
+        timespec cpuTime;
+        if (!::pthread_getcpuclockid(m_upNativeThread->m_thread, &clockId) && !::clock_gettime(clockId, &cpuTime))
+        {
+            statistics.m_cpuTimeInMicroseconds = static_cast<uint64_t>(cpuTime.tv_sec) * 1000000U
+                + static_cast<uint64_t>(cpuTime.tv_nsec) / 1000U;
+        }
+
+        std::ifstream status("/proc/self/task/" + std::to_string(m_upNativeThread->m_tid) + "/status");
+        const std::string cKEY("nonvoluntary_ctxt_switches:");
+        for (std::string line; std::getline(status, line);)
+        {
+            if (line.compare(0U, cKEY.size(), cKEY) == 0)
+            {
+                statistics.m_involuntaryContextSwitchCount = std::strtoull(line.c_str() + cKEY.size(), nullptr, 10);
+                break;
+            }
+        }
+#endif
+        return statistics;
+    }
+}
@@ -0,0 +1,137 @@
+/***********************************************************************
+Copyright 2018 ASM Assembly Systems GmbH & Co. KG
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+************************************************************************/
+
+
+// Copyright (c) ASM Assembly Systems GmbH & Co. KG
+#pragma once
+
+#include <HermesData.hpp>
+
+#include <boost/asio.hpp>
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+namespace Hermes
+{
+    // Applies the settings to the calling thread, named after its index.
+    // Returns a description of each setting the OS refused (e.g. SCHED_FIFO without the privilege):
+    std::vector<std::string> ApplyThreadSettings(const ThreadSettings& settings, unsigned threadIndex);
+
+    // The counters of a thread running an io_service, to be read from any thread while it runs:
+    class ThreadUsage
+    {
+    public:
+        ThreadUsage(unsigned threadIndex, unsigned failedSettingCount); // on the thread itself
+        ~ThreadUsage();
+
+        ThreadUsage(const ThreadUsage&) = delete;
+        ThreadUsage& operator=(const ThreadUsage&) = delete;
+
+        // as io_service::run(), counting the handlers:
+        void Run(boost::asio::io_service& asioService, boost::system::error_code& ec)
+        {
+            while (asioService.run_one(ec))
+            {
+                // only this thread writes, so no read-modify-write needed:
+                m_handlerCount.store(m_handlerCount.load(std::memory_order_relaxed) + 1U, std::memory_order_relaxed);
+            }
+        }
+
+        ThreadStatistics Statistics() const;
+
+    private:
+        struct NativeThread;
+
+        const unsigned m_threadIndex;
+        const unsigned m_failedSettingCount;
+        const std::chrono::steady_clock::time_point m_start{std::chrono::steady_clock::now()};
+        std::atomic<std::uint64_t> m_handlerCount{0U};
+        std::unique_ptr<NativeThread> m_upNativeThread;
+    };
+
+    // the threads currently running an instance or a pool:
+    class ThreadRegistry
+    {
+    public:
+        void Add(const ThreadUsage& usage)
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            m_usages.push_back(&usage);
+        }
+
+        void Remove(const ThreadUsage& usage)
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            m_usages.erase(std::remove(m_usages.begin(), m_usages.end(), &usage), m_usages.end());
+        }
+
+        std::vector<ThreadStatistics> Statistics() const
+        {
+            std::vector<ThreadStatistics> result;
+            std::lock_guard<std::mutex> lock(m_mutex);
+            result.reserve(m_usages.size());
+            for (const auto* pUsage : m_usages)
+            {
+                result.push_back(pUsage->Statistics());
+            }
+            return result;
+        }
+
+    private:
+        mutable std::mutex m_mutex;
+        std::vector<const ThreadUsage*> m_usages;
+    };
+
+    // Runs the io_service on the calling thread with the settings (if any) applied, registered while it runs.
+    // The settings that could not be applied are passed to onSettingsFailed:
+    template<class OnSettingsFailedF>
+    void RunThread(boost::asio::io_service& asioService, ThreadRegistry& registry, const ThreadSettings* pSettings,
+        unsigned threadIndex, boost::system::error_code& ec, OnSettingsFailedF onSettingsFailed)
+    {
+        std::vector<std::string> failures;
+        if (pSettings)
+        {
+            failures = ApplyThreadSettings(*pSettings, threadIndex);
+            for (const auto& failure : failures)
+            {
+                onSettingsFailed(failure);
+            }
+        }
+
+        struct Registration
+        {
+            ThreadRegistry& m_registry;
+            ThreadUsage m_usage;
+
+            Registration(ThreadRegistry& registry, unsigned threadIndex, unsigned failedSettingCount) :
+                m_registry(registry),
+                m_usage(threadIndex, failedSettingCount)
+            {
+                m_registry.Add(m_usage);
+            }
+            ~Registration() { m_registry.Remove(m_usage); }
+        } registration(registry, threadIndex, static_cast<unsigned>(failures.size()));
+
+        registration.m_usage.Run(asioService, ec);
+    }
+}
@@ -0,0 +1,167 @@
+/***********************************************************************
+Copyright 2018 ASM Assembly Systems GmbH & Co. KG
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+************************************************************************/
+
+
+// Copyright (c) ASM Assembly Systems GmbH & Co. KG
+#pragma once
+
+#include <algorithm>
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <vector>
+
+namespace Hermes
+{
+    // An entry of the TimerWheel below, to be embedded into whatever is to be timed:
+    struct TimerWheelEntry
+    {
+        TimerWheelEntry* m_pPrev{nullptr};
+        TimerWheelEntry* m_pNext{nullptr};
+        std::uint64_t m_rounds{0U}; // full turns of the wheel still to go
+
+        TimerWheelEntry() = default;
+        TimerWheelEntry(const TimerWheelEntry&) = delete;
+        TimerWheelEntry& operator=(const TimerWheelEntry&) = delete;
+
+        bool Linked() const { return m_pNext != nullptr; }
+    };
+
+    // A hashed timer wheel (Varghese & Lauck): the entries due in t ticks hang in slot (now + t) % slotCount,
+    // each in a doubly linked list, so arming and cancelling take constant time whatever the number of timers.
+    // Each tick walks a single slot. Not thread safe, the owner locks.
+    class TimerWheel
+    {
+    public:
+        explicit TimerWheel(std::size_t slotCountPowerOfTwo = 1024U) :
+            m_slots(slotCountPowerOfTwo),
+            m_mask(slotCountPowerOfTwo - 1U)
+        {
+            assert(slotCountPowerOfTwo && !(slotCountPowerOfTwo & m_mask));
+            for (auto& slot : m_slots)
+            {
+                slot.m_pPrev = slot.m_pNext = &slot;
+            }
+        }
+
+        TimerWheel(const TimerWheel&) = delete;
+        TimerWheel& operator=(const TimerWheel&) = delete;
+
+        std::uint64_t Tick() const { return m_tick; }
+        std::size_t Size() const { return m_size; }
+
+        // due after the given number of ticks (at least one); the entry must not be linked yet:
+        void Arm(TimerWheelEntry& entry, std::uint64_t ticks)
+        {
+            assert(!entry.Linked());
+            if (!ticks)
+            {
+                ticks = 1U;
+            }
+            entry.m_rounds = (ticks - 1U) / m_slots.size();
+            auto& slot = m_slots[(m_tick + ticks) & m_mask];
+            entry.m_pPrev = slot.m_pPrev;
+            entry.m_pNext = &slot;
+            slot.m_pPrev->m_pNext = &entry;
+            slot.m_pPrev = &entry;
+            ++m_size;
+        }
+
+        bool Cancel(TimerWheelEntry& entry)
+        {
+            if (!entry.Linked())
+                return false;
+            Unlink_(entry);
+            return true;
+        }
+
+        // advances by one tick, the entries due are unlinked before being handed to onDue:
+        template<class F>
+        void Advance(F&& onDue)
+        {
+            auto& slot = m_slots[++m_tick & m_mask];
+            for (auto* pEntry = slot.m_pNext; pEntry != &slot;)
+            {
+                auto* pNext = pEntry->m_pNext;
+                if (pEntry->m_rounds)
+                {
+                    --pEntry->m_rounds;
+                }
+                else
+                {
+                    Unlink_(*pEntry);
+                    onDue(*pEntry);
+                }
+                pEntry = pNext;
+            }
+        }
+
+        // the earliest tick at which Advance() hands out an entry, so that the ticks before can be slept through;
+        // walks the slots up to that tick at most once round the wheel:
+        std::uint64_t NextDueTick() const
+        {
+            auto nextDueTick = std::numeric_limits<std::uint64_t>::max();
+            for (std::uint64_t ticks = 1U; ticks <= m_slots.size() && m_tick + ticks < nextDueTick; ++ticks)
+            {
+                const auto& slot = m_slots[(m_tick + ticks) & m_mask];
+                for (const auto* pEntry = slot.m_pNext; pEntry != &slot; pEntry = pEntry->m_pNext)
+                {
+                    nextDueTick = std::min<std::uint64_t>(nextDueTick, m_tick + ticks + pEntry->m_rounds * m_slots.size());
+                }
+            }
+            return nextDueTick;
+        }
+
+        // only while empty, e.g. to skip the ticks of an idle period:
+        void FastForward(std::uint64_t tick)
+        {
+            assert(!m_size);
+            if (tick > m_tick)
+            {
+                m_tick = tick;
+            }
+        }
+
+        template<class F>
+        void Clear(F&& onCleared)
+        {
+            for (auto& slot : m_slots)
+            {
+                while (slot.m_pNext != &slot)
+                {
+                    auto& entry = *slot.m_pNext;
+                    Unlink_(entry);
+                    onCleared(entry);
+                }
+            }
+        }
+
+    private:
+        void Unlink_(TimerWheelEntry& entry)
+        {
+            entry.m_pPrev->m_pNext = entry.m_pNext;
+            entry.m_pNext->m_pPrev = entry.m_pPrev;
+            entry.m_pPrev = entry.m_pNext = nullptr;
+            --m_size;
+        }
+
+        std::vector<TimerWheelEntry> m_slots; // the list heads
+        std::size_t m_mask;
+        std::uint64_t m_tick{0U};
+        std::size_t m_size{0U};
+    };
+}
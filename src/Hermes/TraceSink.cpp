@@ -0,0 +1,400 @@
+/***********************************************************************
+Copyright 2018 ASM Assembly Systems GmbH & Co. KG
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+************************************************************************/
+
+
+// Copyright (c) ASM Assembly Systems GmbH & Co. KG
+#include "stdafx.h"
+
+#include "TraceSink.h"
+
+#include "StringBuilder.h"
+
+#include <Hermes.h>
+#include <HermesDataConversion.hpp>
+
+#ifdef _WINDOWS
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <ctime>
+#include <fstream>
+#include <iomanip>
+#include <sstream>
+
+namespace Hermes
+{
+    //===================== TraceRecord =====================
+    std::size_t TraceRecord::Parse(const std::uint64_t* pWords, std::size_t availableWords)
+    {
+        if (availableWords < cHEADER_WORDS)
+            return 0U;
+
+        const auto wordCount = static_cast<std::size_t>(pWords[0] & 0xFFFFFFFFU);
+        const auto type = static_cast<std::size_t>(pWords[0] >> 32);
+        const auto traceSize = static_cast<std::size_t>(pWords[2] >> 32);
+        if (wordCount > availableWords || wordCount != WordCount(traceSize) || type >= size(ETraceType()))
+            return 0U;
+
+        m_timeInMicroseconds = pWords[1];
+        m_sessionId = static_cast<unsigned>(pWords[2] & 0xFFFFFFFFU);
+        m_type = static_cast<ETraceType>(type);
+        m_trace = StringView(reinterpret_cast<const char*>(pWords + cHEADER_WORDS), traceSize);
+        return wordCount;
+    }
+
+    void TraceRecord::AppendTo(std::vector<std::uint64_t>& words) const
+    {
+        const auto wordCount = WordCount(m_trace.size());
+        words.push_back(static_cast<std::uint64_t>(wordCount) | (static_cast<std::uint64_t>(m_type) << 32));
+        words.push_back(m_timeInMicroseconds);
+        words.push_back(static_cast<std::uint64_t>(m_sessionId) | (static_cast<std::uint64_t>(m_trace.size()) << 32));
+        const auto position = words.size();
+        words.resize(position + wordCount - cHEADER_WORDS, 0U);
+        std::memcpy(words.data() + position, m_trace.data(), m_trace.size());
+    }
+
+    //===================== TraceRing =====================
+    TraceRing::TraceRing(std::size_t capacityInBytes) :
+        m_mask(RoundUp_(capacityInBytes / 8U) - 1U),
+        m_upWords(std::make_unique<std::atomic<std::uint64_t>[]>(m_mask + 1U))
+    {
+        for (std::size_t i = 0U; i <= m_mask; ++i)
+        {
+            m_upWords[i].store(0U, std::memory_order_relaxed);
+        }
+    }
+
+    std::size_t TraceRing::RoundUp_(std::size_t capacity)
+    {
+        std::size_t result = 64U;
+        while (result < capacity)
+        {
+            result <<= 1U;
+        }
+        return result;
+    }
+
+    bool TraceRing::TryPush(std::uint64_t timeInMicroseconds, unsigned sessionId, ETraceType type, StringView trace)
+    {
+        const auto wordCount = TraceRecord::WordCount(trace.size());
+        auto position = m_reserved.load(std::memory_order_relaxed);
+        do
+        {
+            // acquire, pairing with TryPop(), so that the words are zeroed before we write them:
+            if (position + wordCount - m_released.load(std::memory_order_acquire) > CapacityInWords())
+            {
+                m_droppedCount.fetch_add(1U, std::memory_order_relaxed);
+                return false;
+            }
+        } while (!m_reserved.compare_exchange_weak(position, position + wordCount, std::memory_order_relaxed));
+
+        m_upWords[(position + 1U) & m_mask].store(timeInMicroseconds, std::memory_order_relaxed);
+        m_upWords[(position + 2U) & m_mask].store(static_cast<std::uint64_t>(sessionId)
+            | (static_cast<std::uint64_t>(trace.size()) << 32), std::memory_order_relaxed);
+        for (std::size_t i = 0U; i < wordCount - TraceRecord::cHEADER_WORDS; ++i)
+        {
+            std::uint64_t word = 0U;
+            std::memcpy(&word, trace.data() + 8U * i, std::min<std::size_t>(8U, trace.size() - 8U * i));
+            m_upWords[(position + TraceRecord::cHEADER_WORDS + i) & m_mask].store(word, std::memory_order_relaxed);
+        }
+        m_upWords[position & m_mask].store(static_cast<std::uint64_t>(wordCount) | (static_cast<std::uint64_t>(type) << 32),
+            std::memory_order_release);
+        return true;
+    }
+
+    bool TraceRing::TryPop(std::vector<std::uint64_t>& words)
+    {
+        const auto position = m_released.load(std::memory_order_relaxed);
+        const auto header = m_upWords[position & m_mask].load(std::memory_order_acquire);
+        if (!header)
+            return false;
+
+        const auto wordCount = static_cast<std::size_t>(header & 0xFFFFFFFFU);
+        words.push_back(header);
+        m_upWords[position & m_mask].store(0U, std::memory_order_relaxed);
+        for (std::size_t i = 1U; i < wordCount; ++i)
+        {
+            auto& word = m_upWords[(position + i) & m_mask];
+            words.push_back(word.load(std::memory_order_relaxed));
+            word.store(0U, std::memory_order_relaxed);
+        }
+        m_released.store(position + wordCount, std::memory_order_release);
+        return true;
+    }
+
+    //===================== TraceFile =====================
+#ifdef _WINDOWS
+    struct TraceFile::NativeMapping
+    {
+        HANDLE m_file{INVALID_HANDLE_VALUE};
+        HANDLE m_mapping{nullptr};
+
+        void* Open(const std::string& path, std::size_t size)
+        {
+            m_file = ::CreateFileA(path.c_str(), GENERIC_READ | GENERIC_WRITE, FILE_SHARE_READ, nullptr,
+                CREATE_ALWAYS, FILE_ATTRIBUTE_NORMAL, nullptr);
+            if (m_file == INVALID_HANDLE_VALUE)
+                return nullptr;
+            const auto size64 = static_cast<std::uint64_t>(size);
+            m_mapping = ::CreateFileMappingA(m_file, nullptr, PAGE_READWRITE,
+                static_cast<DWORD>(size64 >> 32), static_cast<DWORD>(size64 & 0xFFFFFFFFU), nullptr);
+            if (!m_mapping)
+                return nullptr;
+            return ::MapViewOfFile(m_mapping, FILE_MAP_WRITE, 0, 0, size);
+        }
+
+        void Close(void* pData, std::size_t usedSize)
+        {
+            if (pData)
+            {
+                ::UnmapViewOfFile(pData);
+            }
+            if (m_mapping)
+            {
+                ::CloseHandle(m_mapping);
+            }
+            if (m_file == INVALID_HANDLE_VALUE)
+                return;
+            LARGE_INTEGER position;
+            position.QuadPart = static_cast<LONGLONG>(usedSize);
+            if (::SetFilePointerEx(m_file, position, nullptr, FILE_BEGIN))
+            {
+                ::SetEndOfFile(m_file);
+            }
+            ::CloseHandle(m_file);
+        }
+    };
+#else
+    struct TraceFile::NativeMapping
+    {
+        int m_fd{-1};
+        std::size_t m_size{0U};
+
+        void* Open(const std::string& path, std::size_t size)
+        {
+            m_fd = ::open(path.c_str(), O_RDWR | O_CREAT | O_TRUNC, 0644);
+            if (m_fd < 0 || ::ftruncate(m_fd, static_cast<off_t>(size)))
+                return nullptr;
+            auto* pData = ::mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, m_fd, 0);
+            if (pData == MAP_FAILED)
+                return nullptr;
+            m_size = size;
+            return pData;
+        }
+
+        void Close(void* pData, std::size_t usedSize)
+        {
+            if (pData)
+            {
+                ::munmap(pData, m_size);
+            }
+            if (m_fd < 0)
+                return;
+            if (::ftruncate(m_fd, static_cast<off_t>(usedSize))) {}
+            ::close(m_fd);
+        }
+    };
+#endif
+
+    TraceFile::TraceFile(const std::string& path, std::size_t sizeInBytes) :
+        m_upMapping(std::make_unique<NativeMapping>())
+    {
+        const auto capacityInWords = std::max<std::size_t>(sizeInBytes / 8U, cHEADER_WORDS + TraceRecord::cHEADER_WORDS);
+        m_pWords = static_cast<std::uint64_t*>(m_upMapping->Open(path, capacityInWords * 8U));
+        if (!m_pWords)
+            return;
+        m_capacityInWords = capacityInWords;
+        m_pWords[0] = cMAGIC;
+        m_pWords[1] = 0U;
+    }
+
+    TraceFile::~TraceFile()
+    {
+        const std::size_t usedWords = m_pWords ? cHEADER_WORDS + static_cast<std::size_t>(m_pWords[1]) : 0U;
+        m_upMapping->Close(m_pWords, usedWords * 8U);
+    }
+
+    bool TraceFile::IsOpen() const
+    {
+        return m_pWords != nullptr;
+    }
+
+    bool TraceFile::Append(const std::uint64_t* pWords, std::size_t wordCount)
+    {
+        if (!m_pWords)
+            return false;
+        const auto usedWords = static_cast<std::size_t>(m_pWords[1]);
+        if (cHEADER_WORDS + usedWords + wordCount > m_capacityInWords)
+            return false;
+        std::memcpy(m_pWords + cHEADER_WORDS + usedWords, pWords, wordCount * 8U);
+        m_pWords[1] = usedWords + wordCount;
+        return true;
+    }
+
+    //===================== TraceSink =====================
+    // how often the writer looks into the ring when nobody wakes it up:
+    constexpr std::chrono::milliseconds cTRACE_FLUSH_PERIOD{50};
+
+    TraceSink::TraceSink(const std::string& path, std::size_t ringCapacityInBytes, std::size_t maxFileSizeInBytes) :
+        m_path(path),
+        m_maxFileSize(maxFileSizeInBytes),
+        m_ring(ringCapacityInBytes),
+        m_upFile(std::make_unique<TraceFile>(path, maxFileSizeInBytes))
+    {
+        if (!m_upFile->IsOpen())
+            return;
+        m_thread = std::thread([this]() { Run_(); });
+    }
+
+    TraceSink::~TraceSink()
+    {
+        if (!m_thread.joinable())
+            return;
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            m_stopped = true;
+        }
+        m_cv.notify_one();
+        m_thread.join();
+    }
+
+    void TraceSink::Run_()
+    {
+        std::vector<std::uint64_t> words;
+        std::unique_lock<std::mutex> lock(m_mutex);
+        while (!m_stopped)
+        {
+            m_cv.wait_for(lock, cTRACE_FLUSH_PERIOD, [this]()
+            {
+                return m_stopped || m_flushRequested.load(std::memory_order_relaxed);
+            });
+            m_flushRequested.store(false, std::memory_order_relaxed);
+            lock.unlock();
+            Flush_(words);
+            lock.lock();
+        }
+        lock.unlock();
+        Flush_(words);
+    }
+
+    void TraceSink::Flush_(std::vector<std::uint64_t>& words)
+    {
+        words.clear();
+        while (m_ring.TryPop(words))
+        {
+        }
+
+        const auto droppedCount = m_ring.DroppedCount();
+        if (droppedCount != m_reportedDroppedCount)
+        {
+            const auto& text = BuildString("Trace ring full, ", droppedCount - m_reportedDroppedCount, " traces dropped");
+            TraceRecord record;
+            record.m_timeInMicroseconds = static_cast<std::uint64_t>(std::chrono::duration_cast<std::chrono::microseconds>(
+                std::chrono::system_clock::now().time_since_epoch()).count());
+            record.m_type = ETraceType::eWARNING;
+            record.m_trace = text;
+            record.AppendTo(words);
+            m_reportedDroppedCount = droppedCount;
+        }
+
+        Write_(words.data(), words.size());
+    }
+
+    void TraceSink::Write_(const std::uint64_t* pWords, std::size_t wordCount)
+    {
+        TraceRecord record;
+        for (std::size_t position = 0U; position < wordCount;)
+        {
+            const auto recordWordCount = record.Parse(pWords + position, wordCount - position);
+            if (!recordWordCount)
+                return;
+
+            if (!m_upFile->Append(pWords + position, recordWordCount))
+            {
+                m_upFile.reset();
+                const auto& backupPath = m_path + ".1";
+                std::remove(backupPath.c_str());
+                std::rename(m_path.c_str(), backupPath.c_str());
+                m_upFile = std::make_unique<TraceFile>(m_path, m_maxFileSize);
+                if (!m_upFile->IsOpen())
+                    return;
+                // a record larger than a whole file is dropped:
+                m_upFile->Append(pWords + position, recordWordCount);
+            }
+            position += recordWordCount;
+        }
+    }
+
+    static std::string FormatTraceTime_(std::uint64_t timeInMicroseconds)
+    {
+        const auto seconds = static_cast<std::time_t>(timeInMicroseconds / 1000000U);
+        std::tm utc{};
+#ifdef _WINDOWS
+        ::gmtime_s(&utc, &seconds);
+#else
+        ::gmtime_r(&seconds, &utc);
+#endif
+        std::ostringstream oss;
+        oss << std::put_time(&utc, "%Y-%m-%dT%H:%M:%S") << '.'
+            << std::setw(6) << std::setfill('0') << timeInMicroseconds % 1000000U << 'Z';
+        return oss.str();
+    }
+}
+
+//===================== implementation of public C functions =====================
+
+uint32_t DecodeHermesTraceFile(HermesStringView tracePath, HermesStringView textPath)
+{
+    using namespace Hermes;
+
+    std::ifstream input(std::string(tracePath.m_pData, tracePath.m_size), std::ios::binary | std::ios::ate);
+    if (!input)
+        return 0U;
+    const auto fileSize = static_cast<std::size_t>(input.tellg());
+    std::vector<std::uint64_t> words(fileSize / 8U);
+    input.seekg(0);
+    input.read(reinterpret_cast<char*>(words.data()), static_cast<std::streamsize>(words.size() * 8U));
+    if (words.size() < TraceFile::cHEADER_WORDS || words[0] != TraceFile::cMAGIC)
+        return 0U;
+
+    std::ofstream output(std::string(textPath.m_pData, textPath.m_size));
+    if (!output)
+        return 0U;
+
+    // a file still being written (or left by a crash) is decoded as far as its records are complete:
+    const auto usedWords = std::min<std::size_t>(static_cast<std::size_t>(words[1]), words.size() - TraceFile::cHEADER_WORDS);
+    const auto* pWords = words.data() + TraceFile::cHEADER_WORDS;
+    uint32_t count = 0U;
+    TraceRecord record;
+    for (std::size_t position = 0U; position < usedWords; ++count)
+    {
+        const auto wordCount = record.Parse(pWords + position, usedWords - position);
+        if (!wordCount)
+            break;
+        output << FormatTraceTime_(record.m_timeInMicroseconds) << ' ' << record.m_type
+            << " sessionId=" << record.m_sessionId << ": " << record.m_trace << '\n';
+        position += wordCount;
+    }
+    return count;
+}
@@ -0,0 +1,157 @@
+/***********************************************************************
+Copyright 2018 ASM Assembly Systems GmbH & Co. KG
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+************************************************************************/
+
+
+
+// Copyright (c) ASM Assembly Systems GmbH & Co. KG
+#pragma once
+
+#include <HermesData.hpp>
+#include <HermesStringView.hpp>
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace Hermes
+{
+    // A trace record, as held in a TraceRing and written to trace files, in 64 bit words:
+    // a header word (word count | type << 32), the time in microseconds since 1970, the session id | text size << 32,
+    // then the text, padded with zeros.
+    struct TraceRecord
+    {
+        static constexpr std::size_t cHEADER_WORDS = 3U;
+
+        std::uint64_t m_timeInMicroseconds = 0U;
+        unsigned m_sessionId = 0U;
+        ETraceType m_type = ETraceType::eDEBUG;
+        StringView m_trace;
+
+        static std::size_t WordCount(std::size_t traceSize) { return cHEADER_WORDS + (traceSize + 7U) / 8U; }
+
+        // the record starting at pWords, returns its word count, or 0 if there is no complete record:
+        std::size_t Parse(const std::uint64_t* pWords, std::size_t availableWords);
+        void AppendTo(std::vector<std::uint64_t>& words) const;
+    };
+
+    // A bounded lock-free ring of trace records for any number of producers and a single consumer.
+    // Producers reserve the words of a record by advancing m_reserved, and publish it by a release store of its header word.
+    // The consumer zeroes the words it has taken before handing them back through m_released,
+    // so a header word still zero tells it that the record at its position is not complete yet.
+    class TraceRing
+    {
+    public:
+        explicit TraceRing(std::size_t capacityInBytes);
+
+        TraceRing(const TraceRing&) = delete;
+        TraceRing& operator=(const TraceRing&) = delete;
+
+        std::size_t CapacityInWords() const { return m_mask + 1U; }
+        std::size_t SizeInWords() const
+        {
+            return static_cast<std::size_t>(m_reserved.load(std::memory_order_relaxed) - m_released.load(std::memory_order_relaxed));
+        }
+        std::uint64_t DroppedCount() const { return m_droppedCount.load(std::memory_order_relaxed); }
+
+        // false if there is no room, the record is then counted as dropped:
+        bool TryPush(std::uint64_t timeInMicroseconds, unsigned sessionId, ETraceType type, StringView trace);
+
+        // only to be called by the consumer; appends the words of the next record, false if there is none (yet):
+        bool TryPop(std::vector<std::uint64_t>& words);
+
+    private:
+        static std::size_t RoundUp_(std::size_t capacity);
+
+        std::size_t m_mask;
+        std::unique_ptr<std::atomic<std::uint64_t>[]> m_upWords;
+        alignas(64) std::atomic<std::uint64_t> m_reserved{0U};
+        alignas(64) std::atomic<std::uint64_t> m_released{0U};
+        std::atomic<std::uint64_t> m_droppedCount{0U};
+    };
+
+    // A memory mapped trace file of fixed size: a magic word, the number of record words used, then the records.
+    // When closed, the file is cut down to what is used:
+    class TraceFile
+    {
+    public:
+        TraceFile(const std::string& path, std::size_t sizeInBytes);
+        ~TraceFile();
+
+        TraceFile(const TraceFile&) = delete;
+        TraceFile& operator=(const TraceFile&) = delete;
+
+        bool IsOpen() const;
+        bool Append(const std::uint64_t* pWords, std::size_t wordCount); // false if full
+
+        static constexpr std::uint64_t cMAGIC = 0x3143525453524548ULL; // "HERSTRC1"
+        static constexpr std::size_t cHEADER_WORDS = 2U;
+
+    private:
+        struct NativeMapping;
+
+        std::unique_ptr<NativeMapping> m_upMapping;
+        std::uint64_t* m_pWords{nullptr};
+        std::size_t m_capacityInWords{0U};
+    };
+
+    // Instead of the trace callback: the traces go into a TraceRing, a thread of its own takes them from there
+    // and writes them to a TraceFile. Once that is full, it is renamed to <path>.1 (replacing an older one)
+    // and a new one is started:
+    class TraceSink
+    {
+    public:
+        TraceSink(const std::string& path, std::size_t ringCapacityInBytes, std::size_t maxFileSizeInBytes);
+        ~TraceSink(); // writes what is left
+
+        TraceSink(const TraceSink&) = delete;
+        TraceSink& operator=(const TraceSink&) = delete;
+
+        bool IsOpen() const { return m_upFile && m_upFile->IsOpen(); }
+
+        void Trace(unsigned sessionId, ETraceType type, StringView trace)
+        {
+            auto now = std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::system_clock::now().time_since_epoch());
+            m_ring.TryPush(static_cast<std::uint64_t>(now.count()), sessionId, type, trace);
+            // the writer wakes up periodically anyway, so only a filling ring is worth waking it up for:
+            if (m_ring.SizeInWords() < m_ring.CapacityInWords() / 2U || m_flushRequested.exchange(true, std::memory_order_relaxed))
+                return;
+            m_cv.notify_one();
+        }
+
+    private:
+        void Run_();
+        void Flush_(std::vector<std::uint64_t>& words);
+        void Write_(const std::uint64_t* pWords, std::size_t wordCount);
+
+        const std::string m_path;
+        const std::size_t m_maxFileSize;
+        TraceRing m_ring;
+        std::unique_ptr<TraceFile> m_upFile;
+        std::uint64_t m_reportedDroppedCount{0U}; // only accessed by m_thread
+
+        std::mutex m_mutex;
+        std::condition_variable m_cv;
+        std::atomic<bool> m_flushRequested{false};
+        bool m_stopped{false};
+        std::thread m_thread;
+    };
+}
@@ -18,6 +18,7 @@ limitations under the License.
 
 #include <HermesDataConversion.hpp>
 #include "ApiCallback.h"
+#include "CallbackQueue.h"
 #include "MessageDispatcher.h"
 #include "Service.h"
 #include "UpstreamSession.h"
@@ -31,12 +32,15 @@ using namespace Hermes::Upstream;
 struct HermesUpstream : ISessionCallback
 {
     unsigned m_laneId = 0U;
-    Service m_service;
-    asio::deadline_timer m_timer{m_service.GetUnderlyingService()};
+    std::shared_ptr<Service> m_spService;
+    Service& m_service{*m_spService};
+    WheelTimer m_timer{m_service, m_service.GetExecutor()};
     UpstreamSettings m_settings;
 
     unsigned m_sessionId{0U};
     unsigned m_connectedSessionId{0U};
+    // delays between the sessions, reset once the peer has sent its service description:
+    RetryBackoff m_reconnectBackoff{m_service.GetVirtualNetwork() ? RetryBackoff(m_laneId) : RetryBackoff()};
 
     ApiCallback<HermesConnectedCallback> m_connectedCallback;
     ApiCallback<HermesServiceDescriptionCallback> m_serviceDescriptionCallback;
@@ -55,9 +59,12 @@ struct HermesUpstream : ISessionCallback
 
     bool m_enabled{false};
 
-    HermesUpstream(unsigned laneId, const HermesUpstreamCallbacks& callbacks) :
+    // optional, see UseHermesDownstreamCallbackQueue; last, so that its thread is done before anything else goes:
+    std::unique_ptr<CallbackQueue> m_upCallbackQueue;
+
+    HermesUpstream(unsigned laneId, const HermesUpstreamCallbacks& callbacks, ServicePool* pPool) :
         m_laneId(laneId),
-        m_service(callbacks.m_traceCallback),
+        m_spService(std::make_shared<Service>(callbacks.m_traceCallback, pPool)),
         m_connectedCallback(callbacks.m_connectedCallback),
         m_serviceDescriptionCallback(callbacks.m_serviceDescriptionCallback),
         m_boardAvailableCallback(callbacks.m_boardAvailableCallback),
@@ -106,7 +113,7 @@ struct HermesUpstream : ISessionCallback
     }
 
     template<class DataT>
-    void Signal(unsigned sessionId, const DataT& data, StringView rawXml)
+    void Signal(unsigned sessionId, const DataT& data, StringView rawXml, unsigned serializeTimeInMicroseconds = 0U)
     {
         m_service.Log(sessionId, "Signal(", data, ',', rawXml, ')');
 
@@ -114,7 +121,13 @@ struct HermesUpstream : ISessionCallback
         if (!pSession)
             return;
 
-        pSession->Signal(data, rawXml);
+        pSession->Signal(data, rawXml, serializeTimeInMicroseconds);
+    }
+
+    template<class DataT>
+    void Signal(unsigned sessionId, const DataT& data, const SerializedMessage& message)
+    {
+        Signal(sessionId, data, message.m_xml, message.m_serializeTimeInMicroseconds);
     }
 
     void Stop()
@@ -134,8 +147,7 @@ struct HermesUpstream : ISessionCallback
             return;
 
         m_connectedSessionId = pSession->Id();
-        const Converter2C<ConnectionInfo> converter(in_data);
-        m_connectedCallback(pSession->Id(), ToC(state), converter.CPointer());
+        Deliver_(m_connectedCallback, pSession->Id(), ToC(state), in_data);
     }
 
     void On(unsigned sessionId, EState state, const ServiceDescriptionData& in_data) override
@@ -144,8 +156,8 @@ struct HermesUpstream : ISessionCallback
         if (!pSession)
             return;
 
-        const Converter2C<ServiceDescriptionData> converter(in_data);
-        m_serviceDescriptionCallback(pSession->Id(), ToC(state), converter.CPointer());
+        m_reconnectBackoff.Reset();
+        Deliver_(m_serviceDescriptionCallback, pSession->Id(), ToC(state), in_data);
     }
 
     void On(unsigned sessionId, EState state, const BoardAvailableData& in_data) override
@@ -154,8 +166,7 @@ struct HermesUpstream : ISessionCallback
         if (!pSession)
             return;
 
-        const Converter2C<BoardAvailableData> converter(in_data);
-        m_boardAvailableCallback(sessionId, ToC(state), converter.CPointer());
+        Deliver_(m_boardAvailableCallback, sessionId, ToC(state), in_data);
     }
 
     void On(unsigned sessionId, EState state, const RevokeBoardAvailableData& in_data) override
@@ -164,8 +175,7 @@ struct HermesUpstream : ISessionCallback
         if (!pSession)
             return;
 
-        const Converter2C<RevokeBoardAvailableData> converter(in_data);
-        m_revokeBoardAvailableCallback(sessionId, ToC(state), converter.CPointer());
+        Deliver_(m_revokeBoardAvailableCallback, sessionId, ToC(state), in_data);
     }
 
     void On(unsigned sessionId, EState state, const TransportFinishedData& in_data) override
@@ -174,8 +184,7 @@ struct HermesUpstream : ISessionCallback
         if (!pSession)
             return;
 
-        const Converter2C<TransportFinishedData> converter(in_data);
-        m_transportFinishedCallback(sessionId, ToC(state), converter.CPointer());
+        Deliver_(m_transportFinishedCallback, sessionId, ToC(state), in_data);
     }
 
     void On(unsigned sessionId, EState state, const BoardForecastData& in_data) override
@@ -184,8 +193,7 @@ struct HermesUpstream : ISessionCallback
         if (!pSession)
             return;
 
-        const Converter2C<BoardForecastData> converter(in_data);
-        m_boardForecastCallback(sessionId, ToC(state), converter.CPointer());
+        Deliver_(m_boardForecastCallback, sessionId, ToC(state), in_data);
     }
 
     void On(unsigned sessionId, EState, const SendBoardInfoData& in_data) override
@@ -194,8 +202,7 @@ struct HermesUpstream : ISessionCallback
         if (!pSession)
             return;
 
-        const Converter2C<SendBoardInfoData> converter(in_data);
-        m_sendBoardInfoCallback(sessionId, converter.CPointer());
+        Deliver_(m_sendBoardInfoCallback, sessionId, in_data);
     }
 
     void On(unsigned sessionId, EState, const NotificationData& in_data) override
@@ -204,8 +211,7 @@ struct HermesUpstream : ISessionCallback
         if (!pSession)
             return;
 
-        const Converter2C<NotificationData> converter(in_data);
-        m_notificationCallback(sessionId, converter.CPointer());
+        Deliver_(m_notificationCallback, sessionId, in_data);
     }
 
     void On(unsigned sessionId, EState, const CommandData& in_data) override
@@ -214,8 +220,7 @@ struct HermesUpstream : ISessionCallback
         if (!pSession)
             return;
 
-        const Converter2C<CommandData> converter(in_data);
-        m_commandCallback(sessionId, converter.CPointer());
+        Deliver_(m_commandCallback, sessionId, in_data);
     }
 
     void On(unsigned sessionId, EState, const CheckAliveData& in_data) override
@@ -230,10 +235,9 @@ struct HermesUpstream : ISessionCallback
         {
             CheckAliveData data{in_data};
             data.m_optionalType = ECheckAliveType::ePONG;
-            m_service.Post([this, sessionId, data = std::move(data)]() { Signal(sessionId, data, Serialize(data)); });
+            m_service.Post([this, sessionId, data = std::move(data), postTime = m_service.LatencyStart()]() { Signal(sessionId, data, Serialize(m_service, data, postTime)); });
         }
-        const Converter2C<CheckAliveData> converter(in_data);
-        m_checkAliveCallback(sessionId, converter.CPointer());
+        Deliver_(m_checkAliveCallback, sessionId, in_data);
     }
 
     void OnState(unsigned sessionId, EState state) override
@@ -242,7 +246,7 @@ struct HermesUpstream : ISessionCallback
         if (!pSession)
             return;
 
-        m_stateCallback(sessionId, ToC(state));
+        Deliver_(m_stateCallback, sessionId, ToC(state));
     }
 
     void OnDisconnected(unsigned sessionId, EState state, const Error& in_data) override
@@ -251,18 +255,10 @@ struct HermesUpstream : ISessionCallback
         if (!pSession)
             return;
 
-        if (pSession->OptionalPeerServiceDescriptionData())
-        {
-            DelayCreateNewSession_(1.0);
-        }
-        else
-        {
-            DelayCreateNewSession_(m_settings.m_reconnectWaitTimeInSeconds);
-        }
+        DelayCreateNewSession_(NextReconnectDelay_());
 
         m_upSession.reset();
-        const Converter2C<Error> converter(in_data);
-        m_disconnectedCallback(sessionId, ToC(state), converter.CPointer());
+        DeliverFinalCallback(m_upCallbackQueue.get(), m_disconnectedCallback, sessionId, ToC(state), in_data);
     }
 
     //============ internal impplementation ==============
@@ -291,8 +287,7 @@ struct HermesUpstream : ISessionCallback
 
         m_connectedSessionId = 0U;
         Error error;
-        const Converter2C<Error> converter(error);
-        m_disconnectedCallback(sessionId, eHERMES_STATE_DISCONNECTED, converter.CPointer());
+        DeliverFinalCallback(m_upCallbackQueue.get(), m_disconnectedCallback, sessionId, eHERMES_STATE_DISCONNECTED, error);
     }
 
     void RemoveSession_(const NotificationData& data)
@@ -300,10 +295,29 @@ struct HermesUpstream : ISessionCallback
         if (!m_upSession)
             return;
 
-        m_upSession->Signal(data, Serialize(data));
+        const auto& message = Serialize(m_service, data);
+        m_upSession->Signal(data, message.m_xml, message.m_serializeTimeInMicroseconds);
         RemoveSession_();
     }
 
+    template<class F, class... Ts>
+    void Deliver_(const ApiCallback<F>& callback, unsigned sessionId, const Ts&... args)
+    {
+        if (DeliverCallback(m_upCallbackQueue.get(), callback, sessionId, args...))
+            return;
+
+        m_service.Warn(sessionId, "Callback queue full, disconnecting");
+        m_service.Post([this, sessionId]()
+        {
+            if (!m_upSession || m_upSession->Id() != sessionId)
+                return;
+
+            RemoveSession_(NotificationData(ENotificationCode::eUNSPECIFIC, ESeverity::eERROR,
+                "Application not keeping up with the messages received"));
+            DelayCreateNewSession_(NextReconnectDelay_());
+        });
+    }
+
     void CreateNewSession_()
     {
         if (m_upSession)
@@ -321,15 +335,19 @@ struct HermesUpstream : ISessionCallback
         m_upSession->Connect(*this);
     }
 
+    double NextReconnectDelay_()
+    {
+        RetryPolicy policy;
+        policy.m_maxDelayInSeconds = m_settings.m_reconnectWaitTimeInSeconds;
+        return m_reconnectBackoff.NextDelayInSeconds(policy);
+    }
+
     void DelayCreateNewSession_(double delay)
     {
         m_service.Log(0U, "DelayCreateNewSession_");
 
-        m_timer.expires_from_now(boost::posix_time::millisec(static_cast<int>(1000.0 * delay)));
-        m_timer.async_wait([this](const boost::system::error_code& ec)
+        m_timer.ExpiresFromNow(std::chrono::milliseconds(static_cast<int>(1000.0 * delay)), [this]()
         {
-            if (ec) // timer cancelled or whatever
-                return;
             CreateNewSession_();
         });
     }
@@ -339,7 +357,68 @@ struct HermesUpstream : ISessionCallback
 
 HermesUpstream* CreateHermesUpstream(uint32_t laneId, const HermesUpstreamCallbacks* pCallbacks)
 {
-    return new HermesUpstream(laneId, *pCallbacks);
+    return new HermesUpstream(laneId, *pCallbacks, nullptr);
+}
+
+HermesUpstream* CreateHermesUpstreamOnService(HermesService* pService, uint32_t laneId, const HermesUpstreamCallbacks* pCallbacks)
+{
+    return new HermesUpstream(laneId, *pCallbacks, pService ? &pService->m_pool : nullptr);
+}
+
+void UseHermesUpstreamTaskRing(HermesUpstream* pUpstream, uint32_t capacity)
+{
+    pUpstream->m_service.Log(0U, "UseHermesUpstreamTaskRing(", capacity, ')');
+    pUpstream->m_service.UseTaskRing(capacity);
+}
+
+void UseHermesUpstreamCallbackQueue(HermesUpstream* pUpstream, uint32_t capacity, EHermesCallbackQueueOverflow overflow)
+{
+    ECallbackQueueOverflow cppOverflow;
+    CToCpp(overflow, cppOverflow);
+    pUpstream->m_service.Log(0U, "UseHermesUpstreamCallbackQueue(", capacity, ',', cppOverflow, ')');
+    pUpstream->m_upCallbackQueue = CreateCallbackQueue(pUpstream->m_service, capacity, cppOverflow);
+}
+
+void SetHermesUpstreamThreadSettings(HermesUpstream* pUpstream, const HermesThreadSettings* pThreadSettings)
+{
+    const auto threadSettings = ToCpp(*pThreadSettings);
+    pUpstream->m_service.Log(0U, "SetHermesUpstreamThreadSettings(", threadSettings, ')');
+    pUpstream->m_service.SetThreadSettings(threadSettings);
+}
+
+void SetHermesUpstreamTraceMask(HermesUpstream* pUpstream, uint32_t traceMask)
+{
+    pUpstream->m_service.Log(0U, "SetHermesUpstreamTraceMask(", traceMask, ')');
+    pUpstream->m_service.SetTraceMask(traceMask);
+}
+
+void UseHermesUpstreamTraceFile(HermesUpstream* pUpstream, HermesStringView path, uint32_t ringCapacityInBytes, uint32_t maxFileSizeInBytes)
+{
+    const auto& pathString = std::string(path.m_pData, path.m_size);
+    pUpstream->m_service.Log(0U, "UseHermesUpstreamTraceFile(", pathString, ',', ringCapacityInBytes, ',', maxFileSizeInBytes, ')');
+    pUpstream->m_service.UseTraceFile(pathString, ringCapacityInBytes, maxFileSizeInBytes);
+}
+
+void SetHermesUpstreamTraceEventCallback(HermesUpstream* pUpstream, HermesTraceEventCallback callback)
+{
+    pUpstream->m_service.Log(0U, "SetHermesUpstreamTraceEventCallback");
+    pUpstream->m_service.SetTraceEventCallback(callback);
+}
+
+void EnableHermesUpstreamLatencyHistograms(HermesUpstream* pUpstream)
+{
+    pUpstream->m_service.Log(0U, "EnableHermesUpstreamLatencyHistograms");
+    pUpstream->m_service.EnableLatencyHistograms();
+}
+
+uint32_t GetHermesUpstreamLatencyHistograms(HermesUpstream* pUpstream, HermesLatencyHistogram* pHistograms, uint32_t maxCount)
+{
+    return CopyLatencyHistograms(pUpstream->m_service.GetLatencyHistogramSummaries(), pHistograms, maxCount);
+}
+
+uint32_t GetHermesUpstreamThreadStatistics(HermesUpstream* pUpstream, HermesThreadStatistics* pStatistics, uint32_t maxCount)
+{
+    return CopyThreadStatistics(pUpstream->m_service.GetThreadStatistics(), pStatistics, maxCount);
 }
 
 void RunHermesUpstream(HermesUpstream* pUpstream)
@@ -349,6 +428,22 @@ void RunHermesUpstream(HermesUpstream* pUpstream)
     pUpstream->m_service.Run();
 }
 
+uint32_t PollHermesUpstream(HermesUpstream* pUpstream, uint32_t maxHandlers)
+{
+    return static_cast<uint32_t>(pUpstream->m_service.Poll(maxHandlers));
+}
+
+uint32_t RunHermesUpstreamFor(HermesUpstream* pUpstream, uint32_t timeoutInMilliseconds)
+{
+    return static_cast<uint32_t>(pUpstream->m_service.RunFor(std::chrono::milliseconds(timeoutInMilliseconds)));
+}
+
+int32_t GetHermesUpstreamPollDescriptor(HermesUpstream* pUpstream)
+{
+    pUpstream->m_service.Log(0U, "GetHermesUpstreamPollDescriptor");
+    return pUpstream->m_service.PollDescriptor();
+}
+
 void PostHermesUpstream(HermesUpstream* pUpstream, HermesVoidCallback voidCallback)
 {
     pUpstream->m_service.Log(0U, "PostHermesUpstream");
@@ -377,27 +472,27 @@ void EnableHermesUpstream(HermesUpstream* pUpstream, const HermesUpstreamSetting
 void SignalHermesUpstreamServiceDescription(HermesUpstream* pUpstream, uint32_t sessionId, const HermesServiceDescriptionData* pData)
 {
     pUpstream->m_service.Log(sessionId, "SignalHermesUpstreamServiceDescription");
-    pUpstream->m_service.Post([pUpstream, sessionId, data = ToCpp(*pData)]()
+    pUpstream->m_service.Post([pUpstream, sessionId, data = ToCpp(*pData), postTime = pUpstream->m_service.LatencyStart()]()
     {
-        pUpstream->Signal(sessionId, data, Serialize(data));
+        pUpstream->Signal(sessionId, data, Serialize(pUpstream->m_service, data, postTime));
     });
 }
 
 void SignalHermesMachineReady(HermesUpstream* pUpstream, uint32_t sessionId, const HermesMachineReadyData* pData)
 {
     pUpstream->m_service.Log(sessionId, "SignalHermesMachineReady");
-    pUpstream->m_service.Post([pUpstream, sessionId, data = ToCpp(*pData)]()
+    pUpstream->m_service.Post([pUpstream, sessionId, data = ToCpp(*pData), postTime = pUpstream->m_service.LatencyStart()]()
     {
-        pUpstream->Signal(sessionId, data, Serialize(data));
+        pUpstream->Signal(sessionId, data, Serialize(pUpstream->m_service, data, postTime));
     });
 }
 
 void SignalHermesRevokeMachineReady(HermesUpstream* pUpstream, uint32_t sessionId, const HermesRevokeMachineReadyData* pData)
 {
     pUpstream->m_service.Log(sessionId, "SignalHermesRevokeMachineReady");
-    pUpstream->m_service.Post([pUpstream, sessionId, data = ToCpp(*pData)]()
+    pUpstream->m_service.Post([pUpstream, sessionId, data = ToCpp(*pData), postTime = pUpstream->m_service.LatencyStart()]()
     {
-        pUpstream->Signal(sessionId, data, Serialize(data));
+        pUpstream->Signal(sessionId, data, Serialize(pUpstream->m_service, data, postTime));
     });
 }
 
@@ -405,9 +500,9 @@ void SignalHermesStartTransport(HermesUpstream* pUpstream, uint32_t sessionId, c
 {
     pUpstream->m_service.Log(sessionId, "SignalHermesStartTransport");
 
-    pUpstream->m_service.Post([pUpstream, sessionId, data = ToCpp(*pData)]()
+    pUpstream->m_service.Post([pUpstream, sessionId, data = ToCpp(*pData), postTime = pUpstream->m_service.LatencyStart()]()
     {
-        pUpstream->Signal(sessionId, data, Serialize(data));
+        pUpstream->Signal(sessionId, data, Serialize(pUpstream->m_service, data, postTime));
     });
 }
 
@@ -415,9 +510,9 @@ void SignalHermesQueryBoardInfo(HermesUpstream* pUpstream, uint32_t sessionId, c
 {
     pUpstream->m_service.Log(sessionId, "SignalHermesQueryBoardInfo");
 
-    pUpstream->m_service.Post([pUpstream, sessionId, data = ToCpp(*pData)]()
+    pUpstream->m_service.Post([pUpstream, sessionId, data = ToCpp(*pData), postTime = pUpstream->m_service.LatencyStart()]()
     {
-        pUpstream->Signal(sessionId, data, Serialize(data));
+        pUpstream->Signal(sessionId, data, Serialize(pUpstream->m_service, data, postTime));
     });
 }
 
@@ -425,9 +520,9 @@ void SignalHermesStopTransport(HermesUpstream* pUpstream, uint32_t sessionId, co
 {
     pUpstream->m_service.Log(sessionId, "SignalHermesStopTransport");
 
-    pUpstream->m_service.Post([pUpstream, sessionId, data = ToCpp(*pData)]()
+    pUpstream->m_service.Post([pUpstream, sessionId, data = ToCpp(*pData), postTime = pUpstream->m_service.LatencyStart()]()
     {
-        pUpstream->Signal(sessionId, data, Serialize(data));
+        pUpstream->Signal(sessionId, data, Serialize(pUpstream->m_service, data, postTime));
     });
 }
 
@@ -435,9 +530,9 @@ void SignalHermesUpstreamNotification(HermesUpstream* pUpstream, uint32_t sessio
 {
     pUpstream->m_service.Log(0U, "SignalHermesUpstreamNotification");
 
-    pUpstream->m_service.Post([pUpstream, sessionId, data = ToCpp(*pData)]()
+    pUpstream->m_service.Post([pUpstream, sessionId, data = ToCpp(*pData), postTime = pUpstream->m_service.LatencyStart()]()
     {
-        pUpstream->Signal(sessionId, data, Serialize(data));
+        pUpstream->Signal(sessionId, data, Serialize(pUpstream->m_service, data, postTime));
     });
 }
 
@@ -445,9 +540,9 @@ void SignalHermesUpstreamCommand(HermesUpstream* pUpstream, uint32_t sessionId,
 {
     pUpstream->m_service.Log(0U, "SignalHermesUpstreamCommand");
 
-    pUpstream->m_service.Post([pUpstream, sessionId, data = ToCpp(*pData)]()
+    pUpstream->m_service.Post([pUpstream, sessionId, data = ToCpp(*pData), postTime = pUpstream->m_service.LatencyStart()]()
     {
-        pUpstream->Signal(sessionId, data, Serialize(data));
+        pUpstream->Signal(sessionId, data, Serialize(pUpstream->m_service, data, postTime));
     });
 }
 
@@ -455,9 +550,9 @@ void SignalHermesUpstreamCheckAlive(HermesUpstream* pUpstream, uint32_t sessionI
 {
     pUpstream->m_service.Log(0U, "SignalHermesUpstreamCheckAlive");
 
-    pUpstream->m_service.Post([pUpstream, sessionId, data = ToCpp(*pData)]()
+    pUpstream->m_service.Post([pUpstream, sessionId, data = ToCpp(*pData), postTime = pUpstream->m_service.LatencyStart()]()
     {
-        pUpstream->Signal(sessionId, data, Serialize(data));
+        pUpstream->Signal(sessionId, data, Serialize(pUpstream->m_service, data, postTime));
     });
 }
 
@@ -505,7 +600,7 @@ void ResetHermesUpstreamRawXml(HermesUpstream* pUpstream, HermesStringView rawXm
     {
         if (!data.empty() && pUpstream->m_upSession)
         {
-            pUpstream->m_upSession->Signal(NotificationData(), data);
+            pUpstream->m_upSession->Signal(NotificationData(), data, 0U);
         }
         pUpstream->RemoveSession_();
         pUpstream->DelayCreateNewSession_(1.0);
@@ -537,7 +632,9 @@ void DeleteHermesUpstream(HermesUpstream* pUpstream)
         return;
 
     pUpstream->m_service.Log(0U, "DeleteHermesUpstream");
-
-    pUpstream->m_service.Stop();
-    delete pUpstream;
+    if (pUpstream->m_upCallbackQueue)
+    {
+        pUpstream->m_upCallbackQueue->Stop();
+    }
+    Service::Delete(pUpstream);
 }
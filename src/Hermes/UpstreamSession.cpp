@@ -68,9 +68,9 @@ namespace Hermes
                 m_pCallback->OnSocketConnected(m_id, state, connectionInfo);
             }
 
-            template<class DataT> void Signal_(const DataT& data, StringView rawXml)
+            template<class DataT> void Signal_(const DataT& data, StringView rawXml, unsigned serializeTimeInMicroseconds)
             {
-                m_upStateMachine->Signal(data, rawXml);
+                m_upStateMachine->Signal(data, rawXml, serializeTimeInMicroseconds);
             }
 
             template<class DataT> void On_(EState state, const DataT& data)
@@ -121,8 +121,10 @@ namespace Hermes
             NetworkConfiguration socketConfig;
             socketConfig.m_hostName = configuration.m_hostAddress;
             socketConfig.m_port = configuration.m_port;
-            socketConfig.m_retryDelayInSeconds = configuration.m_reconnectWaitTimeInSeconds;
+            socketConfig.m_retryPolicy.m_maxDelayInSeconds = configuration.m_reconnectWaitTimeInSeconds;
             socketConfig.m_checkAlivePeriodInSeconds = configuration.m_checkAlivePeriodInSeconds;
+            socketConfig.m_receiveTimeoutInSeconds = configuration.m_receiveTimeoutInSeconds;
+            socketConfig.m_socketSettings = configuration.m_socketSettings;
             
             m_spImpl->m_upSocket = CreateClientSocket(id, socketConfig, service);
             m_spImpl->m_upSerializer = CreateSerializer(id, service, *m_spImpl->m_upSocket);
@@ -147,15 +149,15 @@ namespace Hermes
             m_spImpl->m_upStateMachine->Connect(m_spImpl, *m_spImpl);
         }
 
-        void Session::Signal(const ServiceDescriptionData& data, StringView rawXml) { m_spImpl->Signal_(data, rawXml); }
-        void Session::Signal(const MachineReadyData& data, StringView rawXml) { m_spImpl->Signal_(data, rawXml); }
-        void Session::Signal(const RevokeMachineReadyData& data, StringView rawXml) { m_spImpl->Signal_(data, rawXml); }
-        void Session::Signal(const StartTransportData& data, StringView rawXml) { m_spImpl->Signal_(data, rawXml); }
-        void Session::Signal(const StopTransportData& data, StringView rawXml) { m_spImpl->Signal_(data, rawXml); }
-        void Session::Signal(const QueryBoardInfoData& data, StringView rawXml) { m_spImpl->Signal_(data, rawXml); }
-        void Session::Signal(const NotificationData&  data, StringView rawXml) { m_spImpl->Signal_(data, rawXml); }
-        void Session::Signal(const CommandData&  data, StringView rawXml) { m_spImpl->Signal_(data, rawXml); }
-        void Session::Signal(const CheckAliveData&  data, StringView rawXml) { m_spImpl->Signal_(data, rawXml); }
+        void Session::Signal(const ServiceDescriptionData& data, StringView rawXml, unsigned serializeTimeInMicroseconds) { m_spImpl->Signal_(data, rawXml, serializeTimeInMicroseconds); }
+        void Session::Signal(const MachineReadyData& data, StringView rawXml, unsigned serializeTimeInMicroseconds) { m_spImpl->Signal_(data, rawXml, serializeTimeInMicroseconds); }
+        void Session::Signal(const RevokeMachineReadyData& data, StringView rawXml, unsigned serializeTimeInMicroseconds) { m_spImpl->Signal_(data, rawXml, serializeTimeInMicroseconds); }
+        void Session::Signal(const StartTransportData& data, StringView rawXml, unsigned serializeTimeInMicroseconds) { m_spImpl->Signal_(data, rawXml, serializeTimeInMicroseconds); }
+        void Session::Signal(const StopTransportData& data, StringView rawXml, unsigned serializeTimeInMicroseconds) { m_spImpl->Signal_(data, rawXml, serializeTimeInMicroseconds); }
+        void Session::Signal(const QueryBoardInfoData& data, StringView rawXml, unsigned serializeTimeInMicroseconds) { m_spImpl->Signal_(data, rawXml, serializeTimeInMicroseconds); }
+        void Session::Signal(const NotificationData&  data, StringView rawXml, unsigned serializeTimeInMicroseconds) { m_spImpl->Signal_(data, rawXml, serializeTimeInMicroseconds); }
+        void Session::Signal(const CommandData&  data, StringView rawXml, unsigned serializeTimeInMicroseconds) { m_spImpl->Signal_(data, rawXml, serializeTimeInMicroseconds); }
+        void Session::Signal(const CheckAliveData&  data, StringView rawXml, unsigned serializeTimeInMicroseconds) { m_spImpl->Signal_(data, rawXml, serializeTimeInMicroseconds); }
 
         void Session::Disconnect()
         {
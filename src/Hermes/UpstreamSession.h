@@ -43,15 +43,15 @@ namespace Hermes
             const ConnectionInfo& PeerConnectionInfo() const;
 
             void Connect(ISessionCallback&);
-            void Signal(const ServiceDescriptionData&, StringView rawXml);
-            void Signal(const MachineReadyData&, StringView rawXml);
-            void Signal(const RevokeMachineReadyData&, StringView rawXml);
-            void Signal(const StartTransportData&, StringView rawXml);
-            void Signal(const StopTransportData&, StringView rawXml);
-            void Signal(const QueryBoardInfoData&, StringView rawXml);
-            void Signal(const NotificationData&, StringView rawXml);
-            void Signal(const CommandData&, StringView rawXml);
-            void Signal(const CheckAliveData&, StringView rawXml);
+            void Signal(const ServiceDescriptionData&, StringView rawXml, unsigned serializeTimeInMicroseconds);
+            void Signal(const MachineReadyData&, StringView rawXml, unsigned serializeTimeInMicroseconds);
+            void Signal(const RevokeMachineReadyData&, StringView rawXml, unsigned serializeTimeInMicroseconds);
+            void Signal(const StartTransportData&, StringView rawXml, unsigned serializeTimeInMicroseconds);
+            void Signal(const StopTransportData&, StringView rawXml, unsigned serializeTimeInMicroseconds);
+            void Signal(const QueryBoardInfoData&, StringView rawXml, unsigned serializeTimeInMicroseconds);
+            void Signal(const NotificationData&, StringView rawXml, unsigned serializeTimeInMicroseconds);
+            void Signal(const CommandData&, StringView rawXml, unsigned serializeTimeInMicroseconds);
+            void Signal(const CheckAliveData&, StringView rawXml, unsigned serializeTimeInMicroseconds);
             void Disconnect();
 
         private:
@@ -43,6 +43,12 @@ namespace Hermes
                 m_checkState(checkStateConsistency)
             {}
 
+            void SetState_(EState state)
+            {
+                m_service.OnStateChanged(m_sessionId, m_state, state);
+                m_state = state;
+            }
+
             bool DisconnectedDueToIllegalClientEvent_(StringView event)
             {
                 if (m_checkState != ECheckState::eSEND_AND_RECEIVE)
@@ -62,10 +68,10 @@ namespace Hermes
 
                 if (m_state != EState::eNOT_CONNECTED)
                 {
-                    m_forward.Signal(Serialize(NotificationData(ENotificationCode::eUNSPECIFIC, ESeverity::eFATAL, "SoftwareError")));
+                    m_forward.Signal(Serialize(NotificationData(ENotificationCode::eUNSPECIFIC, ESeverity::eFATAL, "SoftwareError")), 0U);
                 }
 
-                m_state = EState::eDISCONNECTED;
+                SetState_(EState::eDISCONNECTED);
                 m_pCallback->OnDisconnected(m_state, error);
                 m_forward.Disconnect();
                 return true;
@@ -79,9 +85,9 @@ namespace Hermes
                 if (m_state == EState::eDISCONNECTED)
                     return;
 
-                m_state = EState::eDISCONNECTED;
+                SetState_(EState::eDISCONNECTED);
                 m_pCallback->OnDisconnected(m_state, error);
-                m_forward.Signal(Serialize(NotificationData(ENotificationCode::ePROTOCOL_ERROR, ESeverity::eFATAL, error.m_text)));
+                m_forward.Signal(Serialize(NotificationData(ENotificationCode::ePROTOCOL_ERROR, ESeverity::eFATAL, error.m_text)), 0U);
                 m_forward.Disconnect();
             }
 
@@ -94,119 +100,119 @@ namespace Hermes
                 m_forward.Connect(std::move(wpOwner), *this);
             }
 
-            void Signal(const ServiceDescriptionData&, StringView rawXml) override
+            void Signal(const ServiceDescriptionData&, StringView rawXml, unsigned serializeTimeInMicroseconds) override
             {
                 switch (m_state)
                 {
                 case EState::eSOCKET_CONNECTED:
-                    m_state = EState::eSERVICE_DESCRIPTION_DOWNSTREAM;
+                    SetState_(EState::eSERVICE_DESCRIPTION_DOWNSTREAM);
                     m_pCallback->OnState(m_state);
-                    m_forward.Signal(rawXml);
+                    m_forward.Signal(rawXml, serializeTimeInMicroseconds);
                     return;
 
                 default:
                     if (DisconnectedDueToIllegalClientEvent_("ServiceDescription"))
                         return;
-                    m_forward.Signal(rawXml);
+                    m_forward.Signal(rawXml, serializeTimeInMicroseconds);
                 }
             }
 
-            void Signal(const MachineReadyData&, StringView rawXml) override
+            void Signal(const MachineReadyData&, StringView rawXml, unsigned serializeTimeInMicroseconds) override
             {
                 switch (m_state)
                 {
                 case EState::eNOT_AVAILABLE_NOT_READY:
-                    m_state = EState::eMACHINE_READY;
+                    SetState_(EState::eMACHINE_READY);
                     m_pCallback->OnState(m_state);
-                    m_forward.Signal(rawXml);
+                    m_forward.Signal(rawXml, serializeTimeInMicroseconds);
                     return;
 
                 case EState::eBOARD_AVAILABLE:
-                    m_state = EState::eAVAILABLE_AND_READY;
+                    SetState_(EState::eAVAILABLE_AND_READY);
                     m_pCallback->OnState(m_state);
-                    m_forward.Signal(rawXml);
+                    m_forward.Signal(rawXml, serializeTimeInMicroseconds);
                     return;
 
                 default:
                     if (DisconnectedDueToIllegalClientEvent_("MachineReady"))
                         return;
-                    m_forward.Signal(rawXml);
+                    m_forward.Signal(rawXml, serializeTimeInMicroseconds);
                 }
             }
 
-            void Signal(const RevokeMachineReadyData&, StringView rawXml) override
+            void Signal(const RevokeMachineReadyData&, StringView rawXml, unsigned serializeTimeInMicroseconds) override
             {
                 switch (m_state)
                 {
                 case EState::eMACHINE_READY:
-                    m_state = EState::eNOT_AVAILABLE_NOT_READY;
+                    SetState_(EState::eNOT_AVAILABLE_NOT_READY);
                     m_pCallback->OnState(m_state);
-                    m_forward.Signal(rawXml);
+                    m_forward.Signal(rawXml, serializeTimeInMicroseconds);
                     return;
 
                 case EState::eAVAILABLE_AND_READY:
-                    m_state = EState::eBOARD_AVAILABLE;
+                    SetState_(EState::eBOARD_AVAILABLE);
                     m_pCallback->OnState(m_state);
-                    m_forward.Signal(rawXml);
+                    m_forward.Signal(rawXml, serializeTimeInMicroseconds);
                     return;
 
                 default:
                     if (DisconnectedDueToIllegalClientEvent_("RevokeMachineReady"))
                         return;
-                    m_forward.Signal(rawXml);
+                    m_forward.Signal(rawXml, serializeTimeInMicroseconds);
                 }
             }
 
-            void Signal(const StartTransportData& data, StringView rawXml) override
+            void Signal(const StartTransportData& data, StringView rawXml, unsigned serializeTimeInMicroseconds) override
             {
                 switch (m_state)
                 {
                 case EState::eAVAILABLE_AND_READY:
-                    m_state = EState::eTRANSPORTING;
+                    SetState_(EState::eTRANSPORTING);
                     m_startTransportBoardId = rawXml.empty() ? data.m_boardId : std::string();
                     m_pCallback->OnState(m_state);
-                    m_forward.Signal(rawXml);
+                    m_forward.Signal(rawXml, serializeTimeInMicroseconds);
                     return;
 
                 case EState::eMACHINE_READY:
-                    m_state = EState::eTRANSPORTING;
+                    SetState_(EState::eTRANSPORTING);
                     m_startTransportBoardId = rawXml.empty() ? data.m_boardId : std::string();
                     m_pCallback->OnState(m_state);
-                    m_forward.Signal(rawXml);
+                    m_forward.Signal(rawXml, serializeTimeInMicroseconds);
                     return;
 
                 default:
                     if (DisconnectedDueToIllegalClientEvent_("StartTransport"))
                         return;
                     m_startTransportBoardId.clear();
-                    m_forward.Signal(rawXml);
+                    m_forward.Signal(rawXml, serializeTimeInMicroseconds);
                 }
             }
 
-            void Signal(const StopTransportData&, StringView rawXml) override
+            void Signal(const StopTransportData&, StringView rawXml, unsigned serializeTimeInMicroseconds) override
             {
                 switch (m_state)
                 {
                 case EState::eTRANSPORTING:
-                    m_state = EState::eTRANSPORT_STOPPED;
+                    SetState_(EState::eTRANSPORT_STOPPED);
                     m_pCallback->OnState(m_state);
-                    m_forward.Signal(rawXml);
+                    m_forward.Signal(rawXml, serializeTimeInMicroseconds);
                     return;
 
                 case EState::eTRANSPORT_FINISHED:
-                    m_state = EState::eNOT_AVAILABLE_NOT_READY;
+                    SetState_(EState::eNOT_AVAILABLE_NOT_READY);
                     m_pCallback->OnState(m_state);
-                    m_forward.Signal(rawXml);
+                    m_forward.Signal(rawXml, serializeTimeInMicroseconds);
                     return;
 
                 default:
                     if (DisconnectedDueToIllegalClientEvent_("StopTransport"))
                         return;
-                    m_forward.Signal(rawXml);
+                    m_forward.Signal(rawXml, serializeTimeInMicroseconds);
                 }
             }
 
-            void Signal(const QueryBoardInfoData&, StringView rawXml) override
+            void Signal(const QueryBoardInfoData&, StringView rawXml, unsigned serializeTimeInMicroseconds) override
             {
                 switch (m_state)
                 {
@@ -215,12 +221,12 @@ namespace Hermes
                     return;
 
                 default:
-                    m_forward.Signal(rawXml);
+                    m_forward.Signal(rawXml, serializeTimeInMicroseconds);
                     return;
                 }
             }
 
-            void Signal(const NotificationData&, StringView rawXml) override
+            void Signal(const NotificationData&, StringView rawXml, unsigned serializeTimeInMicroseconds) override
             {
                 switch (m_state)
                 {
@@ -229,12 +235,12 @@ namespace Hermes
                     return;
 
                 default:
-                    m_forward.Signal(rawXml);
+                    m_forward.Signal(rawXml, serializeTimeInMicroseconds);
                     return;
                 }
             }
 
-            void Signal(const CommandData&, StringView rawXml) override
+            void Signal(const CommandData&, StringView rawXml, unsigned serializeTimeInMicroseconds) override
             {
                 switch (m_state)
                 {
@@ -243,12 +249,12 @@ namespace Hermes
                     return;
 
                 default:
-                    m_forward.Signal(rawXml);
+                    m_forward.Signal(rawXml, serializeTimeInMicroseconds);
                     return;
                 }
             }
 
-            void Signal(const CheckAliveData&, StringView rawXml) override
+            void Signal(const CheckAliveData&, StringView rawXml, unsigned serializeTimeInMicroseconds) override
             {
                 switch (m_state)
                 {
@@ -257,7 +263,7 @@ namespace Hermes
                     return;
 
                 default:
-                    m_forward.Signal(rawXml);
+                    m_forward.Signal(rawXml, serializeTimeInMicroseconds);
                     return;
                 }
             }
@@ -270,7 +276,7 @@ namespace Hermes
                     return;
 
                 default:
-                    m_state = EState::eDISCONNECTED;
+                    SetState_(EState::eDISCONNECTED);
                     m_pCallback->OnState(m_state);
                     m_forward.Disconnect();
 
@@ -283,7 +289,7 @@ namespace Hermes
                 switch (m_state)
                 {
                 case EState::eNOT_CONNECTED:
-                    m_state = EState::eSOCKET_CONNECTED;
+                    SetState_(EState::eSOCKET_CONNECTED);
                     m_pCallback->OnSocketConnected(m_state, connectionInfo);
                     return;
 
@@ -298,7 +304,7 @@ namespace Hermes
                 {
                 case EState::eSERVICE_DESCRIPTION_DOWNSTREAM:
                 {
-                    m_state = EState::eNOT_AVAILABLE_NOT_READY;
+                    SetState_(EState::eNOT_AVAILABLE_NOT_READY);
                     m_pCallback->On(m_state, data);
                     return;
                 }
@@ -313,13 +319,13 @@ namespace Hermes
                 {
                 case EState::eNOT_AVAILABLE_NOT_READY:
                 {
-                    m_state = EState::eBOARD_AVAILABLE;
+                    SetState_(EState::eBOARD_AVAILABLE);
                     m_pCallback->On(m_state, data);
                     return;
                 }
                 case EState::eMACHINE_READY:
                 {
-                    m_state = EState::eAVAILABLE_AND_READY;
+                    SetState_(EState::eAVAILABLE_AND_READY);
                     m_pCallback->On(m_state, data);
                     return;
                 }
@@ -338,13 +344,13 @@ namespace Hermes
                 {
                 case EState::eBOARD_AVAILABLE:
                 {
-                    m_state = EState::eNOT_AVAILABLE_NOT_READY;
+                    SetState_(EState::eNOT_AVAILABLE_NOT_READY);
                     m_pCallback->On(m_state, data);
                     return;
                 }
                 case EState::eAVAILABLE_AND_READY:
                 {
-                    m_state = EState::eMACHINE_READY;
+                    SetState_(EState::eMACHINE_READY);
                     m_pCallback->On(m_state, data);
                     return;
                 }
@@ -372,7 +378,7 @@ namespace Hermes
                 {
                     if (data.m_boardId != m_startTransportBoardId && !m_startTransportBoardId.empty())
                         return StartAndStopBoardIdDoNotMatch_(m_startTransportBoardId, data.m_boardId);
-                    m_state = EState::eNOT_AVAILABLE_NOT_READY;
+                    SetState_(EState::eNOT_AVAILABLE_NOT_READY);
                     m_pCallback->On(m_state, data);
                     return;
                 }
@@ -380,7 +386,7 @@ namespace Hermes
                 {
                     if (data.m_boardId != m_startTransportBoardId && !m_startTransportBoardId.empty())
                         return StartAndStopBoardIdDoNotMatch_(m_startTransportBoardId, data.m_boardId);
-                    m_state = EState::eTRANSPORT_FINISHED;
+                    SetState_(EState::eTRANSPORT_FINISHED);
                     m_pCallback->On(m_state, data);
                     return;
                 }
@@ -472,7 +478,7 @@ namespace Hermes
                     return;
 
                 default:
-                    m_state = EState::eDISCONNECTED;
+                    SetState_(EState::eDISCONNECTED);
                     m_pCallback->OnDisconnected(m_state, error);
                 }
             }
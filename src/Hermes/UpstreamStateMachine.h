@@ -31,15 +31,15 @@ namespace Hermes
         struct IStateMachine
         {
             virtual void Connect(std::weak_ptr<void> wpOwner, IStateMachineCallback&) = 0;
-            virtual void Signal(const ServiceDescriptionData&, StringView rawXml) = 0;
-            virtual void Signal(const MachineReadyData&, StringView rawXml) = 0;
-            virtual void Signal(const RevokeMachineReadyData&, StringView rawXml) = 0;
-            virtual void Signal(const StartTransportData&, StringView rawXml) = 0;
-            virtual void Signal(const StopTransportData&, StringView rawXml) = 0;
-            virtual void Signal(const QueryBoardInfoData&, StringView rawXml) = 0;
-            virtual void Signal(const NotificationData&, StringView rawXml) = 0;
-            virtual void Signal(const CommandData&, StringView rawXml) = 0;
-            virtual void Signal(const CheckAliveData&, StringView rawXml) = 0;
+            virtual void Signal(const ServiceDescriptionData&, StringView rawXml, unsigned serializeTimeInMicroseconds) = 0;
+            virtual void Signal(const MachineReadyData&, StringView rawXml, unsigned serializeTimeInMicroseconds) = 0;
+            virtual void Signal(const RevokeMachineReadyData&, StringView rawXml, unsigned serializeTimeInMicroseconds) = 0;
+            virtual void Signal(const StartTransportData&, StringView rawXml, unsigned serializeTimeInMicroseconds) = 0;
+            virtual void Signal(const StopTransportData&, StringView rawXml, unsigned serializeTimeInMicroseconds) = 0;
+            virtual void Signal(const QueryBoardInfoData&, StringView rawXml, unsigned serializeTimeInMicroseconds) = 0;
+            virtual void Signal(const NotificationData&, StringView rawXml, unsigned serializeTimeInMicroseconds) = 0;
+            virtual void Signal(const CommandData&, StringView rawXml, unsigned serializeTimeInMicroseconds) = 0;
+            virtual void Signal(const CheckAliveData&, StringView rawXml, unsigned serializeTimeInMicroseconds) = 0;
             virtual void Disconnect() = 0;
 
             virtual ~IStateMachine() = default;
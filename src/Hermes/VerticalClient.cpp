@@ -30,12 +30,15 @@ using namespace Hermes::VerticalClient;
 
 struct HermesVerticalClient : ISessionCallback
 {
-    Service m_service;
-    asio::deadline_timer m_timer{ m_service.GetUnderlyingService() };
+    std::shared_ptr<Service> m_spService;
+    Service& m_service{*m_spService};
+    WheelTimer m_timer{m_service, m_service.GetExecutor()};
     VerticalClientSettings m_settings;
 
     unsigned m_sessionId{ 0U };
     unsigned m_connectedSessionId{ 0U };
+    // delays between the sessions, reset once the peer has sent its service description:
+    RetryBackoff m_reconnectBackoff{m_service.GetVirtualNetwork() ? RetryBackoff(0U) : RetryBackoff()};
 
     ApiCallback<HermesVerticalConnectedCallback> m_connectedCallback;
     ApiCallback<HermesSupervisoryServiceDescriptionCallback> m_serviceDescriptionCallback;
@@ -53,8 +56,8 @@ struct HermesVerticalClient : ISessionCallback
 
     bool m_enabled{ false };
 
-    HermesVerticalClient(const HermesVerticalClientCallbacks& callbacks) :
-        m_service(callbacks.m_traceCallback),
+    HermesVerticalClient(const HermesVerticalClientCallbacks& callbacks, ServicePool* pPool) :
+        m_spService(std::make_shared<Service>(callbacks.m_traceCallback, pPool)),
         m_connectedCallback(callbacks.m_connectedCallback),
         m_serviceDescriptionCallback(callbacks.m_serviceDescriptionCallback),
         m_boardArrivedCallback(callbacks.m_boardArrivedCallback),
@@ -102,7 +105,7 @@ struct HermesVerticalClient : ISessionCallback
     }
 
     template<class DataT>
-    void Signal(unsigned sessionId, const DataT& data, StringView rawXml)
+    void Signal(unsigned sessionId, const DataT& data, StringView rawXml, unsigned serializeTimeInMicroseconds = 0U)
     {
         m_service.Log(sessionId, "Signal(", data, ',', rawXml, ')');
 
@@ -110,7 +113,13 @@ struct HermesVerticalClient : ISessionCallback
         if (!pSession)
             return;
 
-        pSession->Signal(data, rawXml);
+        pSession->Signal(data, rawXml, serializeTimeInMicroseconds);
+    }
+
+    template<class DataT>
+    void Signal(unsigned sessionId, const DataT& data, const SerializedMessage& message)
+    {
+        Signal(sessionId, data, message.m_xml, message.m_serializeTimeInMicroseconds);
     }
 
     void Stop()
@@ -140,6 +149,7 @@ struct HermesVerticalClient : ISessionCallback
         if (!pSession)
             return;
 
+        m_reconnectBackoff.Reset();
         const Converter2C<SupervisoryServiceDescriptionData> converter(in_data);
         m_serviceDescriptionCallback(pSession->Id(), ToC(state), converter.CPointer());
     }
@@ -227,7 +237,7 @@ struct HermesVerticalClient : ISessionCallback
         {
             CheckAliveData data{ in_data };
             data.m_optionalType = ECheckAliveType::ePONG;
-            m_service.Post([this, sessionId, data = std::move(data)]() { Signal(sessionId, data, Serialize(data)); });
+            m_service.Post([this, sessionId, data = std::move(data), postTime = m_service.LatencyStart()]() { Signal(sessionId, data, Serialize(m_service, data, postTime)); });
         }
         const Converter2C<CheckAliveData> converter(in_data);
         m_checkAliveCallback(sessionId, converter.CPointer());
@@ -239,14 +249,7 @@ struct HermesVerticalClient : ISessionCallback
         if (!pSession)
             return;
 
-        if (pSession->OptionalPeerServiceDescriptionData())
-        {
-            DelayCreateNewSession_(1.0);
-        }
-        else
-        {
-            DelayCreateNewSession_(m_settings.m_reconnectWaitTimeInSeconds);
-        }
+        DelayCreateNewSession_(NextReconnectDelay_());
 
         m_upSession.reset();
         const Converter2C<Error> converter(error);
@@ -288,7 +291,8 @@ struct HermesVerticalClient : ISessionCallback
         if (!m_upSession)
             return;
 
-        m_upSession->Signal(data, Serialize(data));
+        const auto& message = Serialize(m_service, data);
+        m_upSession->Signal(data, message.m_xml, message.m_serializeTimeInMicroseconds);
         RemoveSession_();
     }
 
@@ -309,15 +313,19 @@ struct HermesVerticalClient : ISessionCallback
         m_upSession->Connect(*this);
     }
 
+    double NextReconnectDelay_()
+    {
+        RetryPolicy policy;
+        policy.m_maxDelayInSeconds = m_settings.m_reconnectWaitTimeInSeconds;
+        return m_reconnectBackoff.NextDelayInSeconds(policy);
+    }
+
     void DelayCreateNewSession_(double delay)
     {
         m_service.Log(0U, "DelayCreateNewSession_");
 
-        m_timer.expires_from_now(boost::posix_time::millisec(static_cast<int>(1000.0 * delay)));
-        m_timer.async_wait([this](const boost::system::error_code& ec)
+        m_timer.ExpiresFromNow(std::chrono::milliseconds(static_cast<int>(1000.0 * delay)), [this]()
         {
-            if (ec) // timer cancelled or whatever
-                return;
             CreateNewSession_();
         });
     }
@@ -327,7 +335,54 @@ struct HermesVerticalClient : ISessionCallback
 
 HermesVerticalClient* CreateHermesVerticalClient(const HermesVerticalClientCallbacks* pCallbacks)
 {
-    return new HermesVerticalClient(*pCallbacks);
+    return new HermesVerticalClient(*pCallbacks, nullptr);
+}
+
+HermesVerticalClient* CreateHermesVerticalClientOnService(HermesService* pService, const HermesVerticalClientCallbacks* pCallbacks)
+{
+    return new HermesVerticalClient(*pCallbacks, pService ? &pService->m_pool : nullptr);
+}
+
+void SetHermesVerticalClientThreadSettings(HermesVerticalClient* pVerticalClient, const HermesThreadSettings* pThreadSettings)
+{
+    const auto threadSettings = ToCpp(*pThreadSettings);
+    pVerticalClient->m_service.Log(0U, "SetHermesVerticalClientThreadSettings(", threadSettings, ')');
+    pVerticalClient->m_service.SetThreadSettings(threadSettings);
+}
+
+void SetHermesVerticalClientTraceMask(HermesVerticalClient* pVerticalClient, uint32_t traceMask)
+{
+    pVerticalClient->m_service.Log(0U, "SetHermesVerticalClientTraceMask(", traceMask, ')');
+    pVerticalClient->m_service.SetTraceMask(traceMask);
+}
+
+void UseHermesVerticalClientTraceFile(HermesVerticalClient* pVerticalClient, HermesStringView path, uint32_t ringCapacityInBytes, uint32_t maxFileSizeInBytes)
+{
+    const auto& pathString = std::string(path.m_pData, path.m_size);
+    pVerticalClient->m_service.Log(0U, "UseHermesVerticalClientTraceFile(", pathString, ',', ringCapacityInBytes, ',', maxFileSizeInBytes, ')');
+    pVerticalClient->m_service.UseTraceFile(pathString, ringCapacityInBytes, maxFileSizeInBytes);
+}
+
+void SetHermesVerticalClientTraceEventCallback(HermesVerticalClient* pVerticalClient, HermesTraceEventCallback callback)
+{
+    pVerticalClient->m_service.Log(0U, "SetHermesVerticalClientTraceEventCallback");
+    pVerticalClient->m_service.SetTraceEventCallback(callback);
+}
+
+void EnableHermesVerticalClientLatencyHistograms(HermesVerticalClient* pVerticalClient)
+{
+    pVerticalClient->m_service.Log(0U, "EnableHermesVerticalClientLatencyHistograms");
+    pVerticalClient->m_service.EnableLatencyHistograms();
+}
+
+uint32_t GetHermesVerticalClientLatencyHistograms(HermesVerticalClient* pVerticalClient, HermesLatencyHistogram* pHistograms, uint32_t maxCount)
+{
+    return CopyLatencyHistograms(pVerticalClient->m_service.GetLatencyHistogramSummaries(), pHistograms, maxCount);
+}
+
+uint32_t GetHermesVerticalClientThreadStatistics(HermesVerticalClient* pVerticalClient, HermesThreadStatistics* pStatistics, uint32_t maxCount)
+{
+    return CopyThreadStatistics(pVerticalClient->m_service.GetThreadStatistics(), pStatistics, maxCount);
 }
 
 void RunHermesVerticalClient(HermesVerticalClient* pVerticalClient)
@@ -337,6 +392,22 @@ void RunHermesVerticalClient(HermesVerticalClient* pVerticalClient)
     pVerticalClient->m_service.Run();
 }
 
+uint32_t PollHermesVerticalClient(HermesVerticalClient* pVerticalClient, uint32_t maxHandlers)
+{
+    return static_cast<uint32_t>(pVerticalClient->m_service.Poll(maxHandlers));
+}
+
+uint32_t RunHermesVerticalClientFor(HermesVerticalClient* pVerticalClient, uint32_t timeoutInMilliseconds)
+{
+    return static_cast<uint32_t>(pVerticalClient->m_service.RunFor(std::chrono::milliseconds(timeoutInMilliseconds)));
+}
+
+int32_t GetHermesVerticalClientPollDescriptor(HermesVerticalClient* pVerticalClient)
+{
+    pVerticalClient->m_service.Log(0U, "GetHermesVerticalClientPollDescriptor");
+    return pVerticalClient->m_service.PollDescriptor();
+}
+
 void PostHermesVerticalClient(HermesVerticalClient* pVerticalClient, HermesVoidCallback voidCallback)
 {
     pVerticalClient->m_service.Log(0U, "PostHermesVerticalClient");
@@ -365,45 +436,45 @@ void EnableHermesVerticalClient(HermesVerticalClient* pVerticalClient, const Her
 void SignalHermesVerticalClientDescription(HermesVerticalClient* pVerticalClient, uint32_t sessionId, const HermesSupervisoryServiceDescriptionData* pData)
 {
     pVerticalClient->m_service.Log(sessionId, "SignalHermesVerticalClientDescription");
-    pVerticalClient->m_service.Post([pVerticalClient, sessionId, data = ToCpp(*pData)]()
+    pVerticalClient->m_service.Post([pVerticalClient, sessionId, data = ToCpp(*pData), postTime = pVerticalClient->m_service.LatencyStart()]()
     {
-        pVerticalClient->Signal(sessionId, data, Serialize(data));
+        pVerticalClient->Signal(sessionId, data, Serialize(pVerticalClient->m_service, data, postTime));
     });
 }
 
 void SignalHermesSendWorkOrderInfo(HermesVerticalClient* pVerticalClient, uint32_t sessionId, const HermesSendWorkOrderInfoData* pData)
 {
     pVerticalClient->m_service.Log(sessionId, "SignalHermesSendWorkOrderInfo");
-    pVerticalClient->m_service.Post([pVerticalClient, sessionId, data = ToCpp(*pData)]()
+    pVerticalClient->m_service.Post([pVerticalClient, sessionId, data = ToCpp(*pData), postTime = pVerticalClient->m_service.LatencyStart()]()
     {
-        pVerticalClient->Signal(sessionId, data, Serialize(data));
+        pVerticalClient->Signal(sessionId, data, Serialize(pVerticalClient->m_service, data, postTime));
     });
 }
 
 void SignalHermesVerticalGetConfiguration(HermesVerticalClient* pVerticalClient, uint32_t sessionId, const HermesGetConfigurationData* pData)
 {
     pVerticalClient->m_service.Log(sessionId, "SignalHermesVerticalGetConfiguration");
-    pVerticalClient->m_service.Post([pVerticalClient, sessionId, data = ToCpp(*pData)]()
+    pVerticalClient->m_service.Post([pVerticalClient, sessionId, data = ToCpp(*pData), postTime = pVerticalClient->m_service.LatencyStart()]()
     {
-        pVerticalClient->Signal(sessionId, data, Serialize(data));
+        pVerticalClient->Signal(sessionId, data, Serialize(pVerticalClient->m_service, data, postTime));
     });
 }
 
 void SignalHermesVerticalSetConfiguration(HermesVerticalClient* pVerticalClient, uint32_t sessionId, const HermesSetConfigurationData* pData)
 {
     pVerticalClient->m_service.Log(sessionId, "SignalHermesVerticalSetConfiguration");
-    pVerticalClient->m_service.Post([pVerticalClient, sessionId, data = ToCpp(*pData)]()
+    pVerticalClient->m_service.Post([pVerticalClient, sessionId, data = ToCpp(*pData), postTime = pVerticalClient->m_service.LatencyStart()]()
     {
-        pVerticalClient->Signal(sessionId, data, Serialize(data));
+        pVerticalClient->Signal(sessionId, data, Serialize(pVerticalClient->m_service, data, postTime));
     });
 }
 
 void SignalHermesVerticalQueryHermesCapabilities(HermesVerticalClient* pVerticalClient, uint32_t sessionId, const HermesQueryHermesCapabilitiesData* pData)
 {
     pVerticalClient->m_service.Log(sessionId, "SignalHermesQueryHermesCapabilities");
-    pVerticalClient->m_service.Post([pVerticalClient, sessionId, data = ToCpp(*pData)]()
+    pVerticalClient->m_service.Post([pVerticalClient, sessionId, data = ToCpp(*pData), postTime = pVerticalClient->m_service.LatencyStart()]()
         {
-            pVerticalClient->Signal(sessionId, data, Serialize(data));
+            pVerticalClient->Signal(sessionId, data, Serialize(pVerticalClient->m_service, data, postTime));
         });
 }
 
@@ -411,9 +482,9 @@ void SignalHermesVerticalClientNotification(HermesVerticalClient* pVerticalClien
 {
     pVerticalClient->m_service.Log(0U, "SignalHermesVerticalClientNotification");
 
-    pVerticalClient->m_service.Post([pVerticalClient, sessionId, data = ToCpp(*pData)]()
+    pVerticalClient->m_service.Post([pVerticalClient, sessionId, data = ToCpp(*pData), postTime = pVerticalClient->m_service.LatencyStart()]()
     {
-        pVerticalClient->Signal(sessionId, data, Serialize(data));
+        pVerticalClient->Signal(sessionId, data, Serialize(pVerticalClient->m_service, data, postTime));
     });
 }
 
@@ -421,9 +492,9 @@ void SignalHermesVerticalClientCheckAlive(HermesVerticalClient* pVerticalClient,
 {
     pVerticalClient->m_service.Log(0U, "SignalHermesVerticalClientCheckAlive");
 
-    pVerticalClient->m_service.Post([pVerticalClient, sessionId, data = ToCpp(*pData)]()
+    pVerticalClient->m_service.Post([pVerticalClient, sessionId, data = ToCpp(*pData), postTime = pVerticalClient->m_service.LatencyStart()]()
     {
-        pVerticalClient->Signal(sessionId, data, Serialize(data));
+        pVerticalClient->Signal(sessionId, data, Serialize(pVerticalClient->m_service, data, postTime));
     });
 }
 
@@ -465,8 +536,7 @@ void DeleteHermesVerticalClient(HermesVerticalClient* pVerticalClient)
 
     pVerticalClient->m_service.Log(0U, "DeleteHermesVerticalClient");
 
-    pVerticalClient->m_service.Stop();
-    delete pVerticalClient;
+    Service::Delete(pVerticalClient);
 }
 
 void SignalHermesVerticalClientRawXml(HermesVerticalClient* pVerticalClient, uint32_t sessionId, HermesStringView rawXml)
@@ -500,7 +570,7 @@ void ResetHermesVerticalClientRawXml(HermesVerticalClient* pVerticalClient, Herm
     {
         if (!data.empty() && pVerticalClient->m_upSession)
         {
-            pVerticalClient->m_upSession->Signal(NotificationData(), data);
+            pVerticalClient->m_upSession->Signal(NotificationData(), data, 0U);
         }
         pVerticalClient->RemoveSession_();
         pVerticalClient->DelayCreateNewSession_(1.0);
@@ -74,7 +74,7 @@ namespace Hermes
 
                 if (m_state != EVerticalState::eNOT_CONNECTED)
                 {
-                    m_upSerializer->Signal(Serialize(NotificationData(ENotificationCode::eUNSPECIFIC, ESeverity::eFATAL, "SoftwareError")));
+                    m_upSerializer->Signal(Serialize(NotificationData(ENotificationCode::eUNSPECIFIC, ESeverity::eFATAL, "SoftwareError")), 0U);
                 }
 
                 m_state = EVerticalState::eDISCONNECTED;
@@ -93,7 +93,7 @@ namespace Hermes
 
                 m_state = EVerticalState::eDISCONNECTED;
                 m_pCallback->OnDisconnected(m_id, m_state, error);
-                m_upSerializer->Signal(Serialize(NotificationData(ENotificationCode::ePROTOCOL_ERROR, ESeverity::eFATAL, error.m_text)));
+                m_upSerializer->Signal(Serialize(NotificationData(ENotificationCode::ePROTOCOL_ERROR, ESeverity::eFATAL, error.m_text)), 0U);
                 m_upSerializer->Disconnect();
             }
 
@@ -153,7 +153,7 @@ namespace Hermes
             void On(const CheckAliveData& data) override { On_(data, "CheckAlive"); }
             void On(const SendHermesCapabilitiesData& data) override { On_(data, "SendHermesCapabilities"); }
 
-            void Signal_(StringView rawXml)
+            void Signal_(StringView rawXml, unsigned serializeTimeInMicroseconds)
             {
                 switch (m_state)
                 {
@@ -162,7 +162,7 @@ namespace Hermes
                     return;
 
                 default:
-                    m_upSerializer->Signal(rawXml);
+                    m_upSerializer->Signal(rawXml, serializeTimeInMicroseconds);
                     return;
                 }
             }
@@ -190,7 +190,7 @@ namespace Hermes
             NetworkConfiguration socketConfig;
             socketConfig.m_hostName = configuration.m_hostAddress;
             socketConfig.m_port = configuration.m_port;
-            socketConfig.m_retryDelayInSeconds = configuration.m_reconnectWaitTimeInSeconds;
+            socketConfig.m_retryPolicy.m_maxDelayInSeconds = configuration.m_reconnectWaitTimeInSeconds;
             socketConfig.m_checkAlivePeriodInSeconds = configuration.m_checkAlivePeriodInSeconds;
 
             m_spImpl->m_upSocket = CreateClientSocket(id, socketConfig, service);
@@ -219,28 +219,28 @@ namespace Hermes
             m_spImpl->m_upSerializer->Connect(m_spImpl, *m_spImpl);
         }
 
-        void Session::Signal(const SupervisoryServiceDescriptionData&, StringView rawXml)
+        void Session::Signal(const SupervisoryServiceDescriptionData&, StringView rawXml, unsigned serializeTimeInMicroseconds)
         {
             switch (m_spImpl->m_state)
             {
             case EVerticalState::eSOCKET_CONNECTED:
                 m_spImpl->m_state = EVerticalState::eSUPERVISORY_SERVICE_DESCRIPTION;
-                m_spImpl->m_upSerializer->Signal(rawXml);
+                m_spImpl->m_upSerializer->Signal(rawXml, serializeTimeInMicroseconds);
                 return;
 
             default:
                 if (m_spImpl->DisconnectedDueToIllegalClientEvent_("ServiceDescription"))
                     return;
-                m_spImpl->m_upSerializer->Signal(rawXml);
+                m_spImpl->m_upSerializer->Signal(rawXml, serializeTimeInMicroseconds);
             }
         }
 
-        void Session::Signal(const SendWorkOrderInfoData&, StringView rawXml) { m_spImpl->Signal_(rawXml); }
-        void Session::Signal(const SetConfigurationData&, StringView rawXml) { m_spImpl->Signal_(rawXml); }
-        void Session::Signal(const GetConfigurationData&, StringView rawXml) { m_spImpl->Signal_(rawXml); }
-        void Session::Signal(const NotificationData&, StringView rawXml) { m_spImpl->Signal_(rawXml); }
-        void Session::Signal(const CheckAliveData&, StringView rawXml) { m_spImpl->Signal_(rawXml); }
-        void Session::Signal(const QueryHermesCapabilitiesData&, StringView rawXml) { m_spImpl->Signal_(rawXml); }
+        void Session::Signal(const SendWorkOrderInfoData&, StringView rawXml, unsigned serializeTimeInMicroseconds) { m_spImpl->Signal_(rawXml, serializeTimeInMicroseconds); }
+        void Session::Signal(const SetConfigurationData&, StringView rawXml, unsigned serializeTimeInMicroseconds) { m_spImpl->Signal_(rawXml, serializeTimeInMicroseconds); }
+        void Session::Signal(const GetConfigurationData&, StringView rawXml, unsigned serializeTimeInMicroseconds) { m_spImpl->Signal_(rawXml, serializeTimeInMicroseconds); }
+        void Session::Signal(const NotificationData&, StringView rawXml, unsigned serializeTimeInMicroseconds) { m_spImpl->Signal_(rawXml, serializeTimeInMicroseconds); }
+        void Session::Signal(const CheckAliveData&, StringView rawXml, unsigned serializeTimeInMicroseconds) { m_spImpl->Signal_(rawXml, serializeTimeInMicroseconds); }
+        void Session::Signal(const QueryHermesCapabilitiesData&, StringView rawXml, unsigned serializeTimeInMicroseconds) { m_spImpl->Signal_(rawXml, serializeTimeInMicroseconds); }
 
         void Session::Disconnect()
         {
@@ -45,13 +45,13 @@ namespace Hermes
             const ConnectionInfo& PeerConnectionInfo() const;
 
             void Connect(ISessionCallback&);
-            void Signal(const SupervisoryServiceDescriptionData&, StringView rawXml);
-            void Signal(const SendWorkOrderInfoData&, StringView rawXml);
-            void Signal(const GetConfigurationData&, StringView rawXml);
-            void Signal(const SetConfigurationData&, StringView rawXml);
-            void Signal(const NotificationData&, StringView rawXml);
-            void Signal(const CheckAliveData&, StringView rawXml);
-            void Signal(const QueryHermesCapabilitiesData&, StringView rawXml);
+            void Signal(const SupervisoryServiceDescriptionData&, StringView rawXml, unsigned serializeTimeInMicroseconds);
+            void Signal(const SendWorkOrderInfoData&, StringView rawXml, unsigned serializeTimeInMicroseconds);
+            void Signal(const GetConfigurationData&, StringView rawXml, unsigned serializeTimeInMicroseconds);
+            void Signal(const SetConfigurationData&, StringView rawXml, unsigned serializeTimeInMicroseconds);
+            void Signal(const NotificationData&, StringView rawXml, unsigned serializeTimeInMicroseconds);
+            void Signal(const CheckAliveData&, StringView rawXml, unsigned serializeTimeInMicroseconds);
+            void Signal(const QueryHermesCapabilitiesData&, StringView rawXml, unsigned serializeTimeInMicroseconds);
             void Disconnect();
 
         private:
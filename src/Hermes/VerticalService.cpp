@@ -19,6 +19,7 @@ limitations under the License.
 #include <HermesData.hpp>
 
 #include "ApiCallback.h"
+#include "CallbackQueue.h"
 #include "VerticalServiceSession.h"
 #include "Network.h"
 #include "Service.h"
@@ -34,11 +35,16 @@ using namespace Hermes::VerticalService;
 
 struct HermesVerticalService : IAcceptorCallback, ISessionCallback
 {
-    Service m_service;
+    std::shared_ptr<Service> m_spService;
+    Service& m_service{*m_spService};
     VerticalServiceSettings m_settings;;
 
     // we only hold on to the accepting session
     std::unique_ptr<IAcceptor> m_upAcceptor{ CreateAcceptor(m_service, *this) };
+
+    // Unless on a shared pool, each session runs on a strand of its own, so that the threads running the service
+    // can serve several clients at once. The map and the settings are guarded, but no callback is made while locked:
+    std::mutex m_sessionMutex;
     std::map<unsigned, Session> m_sessionMap;
 
     ApiCallback<HermesVerticalConnectedCallback> m_connectedCallback;
@@ -53,8 +59,11 @@ struct HermesVerticalService : IAcceptorCallback, ISessionCallback
 
     bool m_enabled{ false };
 
-    HermesVerticalService(const HermesVerticalServiceCallbacks& callbacks) :
-        m_service(callbacks.m_traceCallback),
+    // optional, see UseHermesDownstreamCallbackQueue; last, so that its thread is done before anything else goes:
+    std::unique_ptr<CallbackQueue> m_upCallbackQueue;
+
+    HermesVerticalService(const HermesVerticalServiceCallbacks& callbacks, ServicePool* pPool) :
+        m_spService(std::make_shared<Service>(callbacks.m_traceCallback, pPool)),
         m_connectedCallback(callbacks.m_connectedCallback),
         m_serviceDescriptionCallback(callbacks.m_serviceDescriptionCallback),
         m_sendWorkOrderInfoCallback(callbacks.m_sendWorkOrderInfoCallback),
@@ -85,12 +94,16 @@ struct HermesVerticalService : IAcceptorCallback, ISessionCallback
             ESeverity::eINFO, "ConfigurationChanged"));
 
         m_enabled = true;
-        m_settings = settings;
+        {
+            std::lock_guard<std::mutex> lock(m_sessionMutex);
+            m_settings = settings;
+        }
 
         NetworkConfiguration networkConfiguration;
         networkConfiguration.m_port = settings.m_port ? settings.m_port : cCONFIG_PORT;
-        networkConfiguration.m_retryDelayInSeconds = settings.m_reconnectWaitTimeInSeconds;
+        networkConfiguration.m_retryPolicy.m_maxDelayInSeconds = settings.m_reconnectWaitTimeInSeconds;
         networkConfiguration.m_checkAlivePeriodInSeconds = settings.m_checkAlivePeriodInSeconds;
+        networkConfiguration.m_strandPerSession = !m_service.m_pPool;
 
         m_upAcceptor->StartListening(networkConfiguration);
     }
@@ -109,80 +122,133 @@ struct HermesVerticalService : IAcceptorCallback, ISessionCallback
 
     void Stop()
     {
-        m_service.Log(0U, "Stop(), sessionCount=", m_sessionMap.size());
+        m_service.Log(0U, "Stop(), sessionCount=", SessionCount_());
 
+        // only once the sessions have delivered their disconnected callbacks, which the token's last owner does:
+        std::shared_ptr<void> spStopToken(nullptr, [wpService = std::weak_ptr<Service>(m_spService)](void*)
+        {
+            if (auto spService = wpService.lock())
+            {
+                spService->Stop();
+            }
+        });
         const NotificationData notificationData(ENotificationCode::eMACHINE_SHUTDOWN, ESeverity::eINFO, "Vertical service stopped by application");
-        RemoveSessions_(notificationData);
-        m_service.Stop();
+        RemoveSessions_(notificationData, spStopToken);
     }
 
-    void RemoveSessions_(const NotificationData& data)
+    std::size_t SessionCount_()
     {
-        auto sessionMap = std::move(m_sessionMap);
-        m_sessionMap.clear();
+        std::lock_guard<std::mutex> lock(m_sessionMutex);
+        return m_sessionMap.size();
+    }
+
+    // The disconnected callback goes to the strand of the session, so that it comes after any callback
+    // of the session which has passed HasSession_() already. spToken is held until then:
+    void RemoveSessions_(const NotificationData& data, const std::shared_ptr<void>& spToken = {})
+    {
+        std::map<unsigned, Session> sessionMap;
+        {
+            std::lock_guard<std::mutex> lock(m_sessionMutex);
+            sessionMap = std::move(m_sessionMap);
+            m_sessionMap.clear();
+        }
 
-        const Error error{};
-        const Converter2C<Error> converter(error);
         for (auto& entry : sessionMap)
         {
             entry.second.Signal(data);
-            entry.second.Disconnect();
-            m_disconnectedCallback(entry.second.Id(), eHERMES_VERTICAL_STATE_DISCONNECTED, converter.CPointer());
+            DisconnectSession_(entry.second, spToken);
         }
     }
 
+    void DisconnectSession_(Session& session, const std::shared_ptr<void>& spToken = {})
+    {
+        // on a pool, the instance may have been deleted meanwhile, its service is kept alive for checking that:
+        session.Disconnect([this, pService = &m_service, spLifetime = m_service.Lifetime(), sessionId = session.Id(), spToken]()
+        {
+            if (pService->m_deleted)
+                return;
+            const Error error{};
+            DeliverFinalCallback(m_upCallbackQueue.get(), m_disconnectedCallback, sessionId, eHERMES_VERTICAL_STATE_DISCONNECTED, error);
+        });
+    }
+
     void RemoveSession_(unsigned sessionId, const NotificationData& data)
     {
-        auto itFound = m_sessionMap.find(sessionId);
-        if (itFound == m_sessionMap.end())
+        decltype(m_sessionMap)::node_type node;
+        {
+            std::lock_guard<std::mutex> lock(m_sessionMutex);
+            node = m_sessionMap.extract(sessionId);
+        }
+        if (!node)
             return;
 
-        auto session = std::move(itFound->second);
-        m_sessionMap.erase(itFound);
+        auto& session = node.mapped();
 
         session.Signal(data);
-        session.Disconnect();
-        const Error error{};
-        const Converter2C<Error> converter(error);
-        m_disconnectedCallback(session.Id(), eHERMES_VERTICAL_STATE_DISCONNECTED, converter.CPointer());
+        DisconnectSession_(session);
     }
 
-    Session* Session_(unsigned id)
+    template<class F, class... Ts>
+    void Deliver_(const ApiCallback<F>& callback, unsigned sessionId, const Ts&... args)
     {
-        auto itFound = m_sessionMap.find(id);
-        if (itFound == m_sessionMap.end())
+        if (DeliverCallback(m_upCallbackQueue.get(), callback, sessionId, args...))
+            return;
+
+        m_service.Warn(sessionId, "Callback queue full, disconnecting");
+        m_service.Post([this, sessionId]()
         {
-            m_service.Warn(id, "Session ID no longer valid");
-            return nullptr;
-        }
+            RemoveSession_(sessionId, NotificationData(ENotificationCode::eUNSPECIFIC, ESeverity::eERROR,
+                "Application not keeping up with the messages received"));
+        });
+    }
 
-        return &itFound->second;
+    // for the callbacks from a session, which have nothing to do if it has been removed meanwhile:
+    bool HasSession_(unsigned id, ConnectionInfo* pPeerConnectionInfo = nullptr)
+    {
+        {
+            std::lock_guard<std::mutex> lock(m_sessionMutex);
+            auto itFound = m_sessionMap.find(id);
+            if (itFound != m_sessionMap.end())
+            {
+                if (pPeerConnectionInfo)
+                {
+                    *pPeerConnectionInfo = itFound->second.PeerConnectionInfo();
+                }
+                return true;
+            }
+        }
+        m_service.Warn(id, "Session ID no longer valid");
+        return false;
     }
 
+    // the session only posts the data to its strand, so it may well be signalled while locked:
     template<class DataT>
     void Signal_(unsigned sessionId, const DataT& data)
     {
         m_service.Log(sessionId, "Signal(", data, ')');
 
-        auto* pSession = Session_(sessionId);
-        if (!pSession)
-            return m_service.Log(sessionId, "No matching session to signal to");
-
-        pSession->Signal(data);
+        {
+            std::lock_guard<std::mutex> lock(m_sessionMutex);
+            auto itFound = m_sessionMap.find(sessionId);
+            if (itFound != m_sessionMap.end())
+            {
+                itFound->second.Signal(data);
+                return;
+            }
+        }
+        m_service.Log(sessionId, "No matching session to signal to");
     }
 
+    // the sessions themselves know whether their peer supports board tracking:
     template<class DataT>
     void SignalTrackingData_(const DataT& data)
     {
         m_service.Log(0U, "Signal(", data, ')');
 
+        std::lock_guard<std::mutex> lock(m_sessionMutex);
         for (auto& entry : m_sessionMap)
         {
-            auto& session = entry.second;
-            if (!session.OptionalPeerServiceDescriptionData() ||
-                !session.OptionalPeerServiceDescriptionData()->m_supportedFeatures.m_optionalFeatureBoardTracking)
-                continue;
-            session.Signal(data);
+            entry.second.Signal(data);
         }
     }
 
@@ -191,125 +257,173 @@ struct HermesVerticalService : IAcceptorCallback, ISessionCallback
     {
         auto sessionId = upSocket->SessionId();
         m_service.Inform(sessionId, "OnAccepted: ", upSocket->GetConnectionInfo());
-#ifdef _WINDOWS
-        auto result = m_sessionMap.try_emplace(sessionId, std::move(upSocket), m_service, m_settings);
-#else
-        auto result = m_sessionMap.emplace(sessionId, VerticalService::Session(std::move(upSocket), m_service, m_settings));
-#endif
-        if (!result.second)
+        VerticalService::Session session(std::move(upSocket), m_service, m_settings);
         {
-            // should not really happen, unless someone launches a Denial of Service attack
-            m_service.Warn(sessionId, "Duplicate session ID");
-            return;
+            std::lock_guard<std::mutex> lock(m_sessionMutex);
+            auto result = m_sessionMap.emplace(sessionId, std::move(session));
+            if (result.second)
+            {
+                result.first->second.Connect(*this);
+                return;
+            }
         }
-        result.first->second.Connect(*this);
+        // should not really happen, unless someone launches a Denial of Service attack
+        m_service.Warn(sessionId, "Duplicate session ID");
     }
 
     //================= VerticalService::ISessionCallback =========================
     void OnSocketConnected(unsigned sessionId, EVerticalState state, const ConnectionInfo& in_data) override
     {
-        const auto* pSession = Session_(sessionId);
-        if (!pSession)
+        if (!HasSession_(sessionId))
             return;
 
-        const Converter2C<ConnectionInfo> converter(in_data);
-        m_connectedCallback(sessionId, ToC(state), converter.CPointer());
+        Deliver_(m_connectedCallback, sessionId, ToC(state), in_data);
     }
 
     void On(unsigned sessionId, EVerticalState state, const SupervisoryServiceDescriptionData& in_data) override
     {
-        const auto* pSession = Session_(sessionId);
-        if (!pSession)
+        if (!HasSession_(sessionId))
             return;
 
-        const Converter2C<SupervisoryServiceDescriptionData> converter(in_data);
-        m_serviceDescriptionCallback(sessionId, ToC(state), converter.CPointer());
+        Deliver_(m_serviceDescriptionCallback, sessionId, ToC(state), in_data);
     }
 
     void On(unsigned sessionId, EVerticalState, const GetConfigurationData& in_data) override
     {
-        const auto* pSession = Session_(sessionId);
-        if (!pSession)
+        ConnectionInfo peerConnectionInfo;
+        if (!HasSession_(sessionId, &peerConnectionInfo))
             return;
 
-        const Converter2C<GetConfigurationData> configurationConverter(in_data);
-        const Converter2C<ConnectionInfo> connectionConverter(pSession->PeerConnectionInfo());
-        m_getConfigurationCallback(sessionId, configurationConverter.CPointer(), connectionConverter.CPointer());
+        Deliver_(m_getConfigurationCallback, sessionId, in_data, peerConnectionInfo);
     }
 
     void On(unsigned sessionId, EVerticalState, const SetConfigurationData& in_data) override
     {
-        const auto* pSession = Session_(sessionId);
-        if (!pSession)
+        ConnectionInfo peerConnectionInfo;
+        if (!HasSession_(sessionId, &peerConnectionInfo))
             return;
 
-        const Converter2C<SetConfigurationData> configurationConverter(in_data);
-        const Converter2C<ConnectionInfo> connectionConverter(pSession->PeerConnectionInfo());
-        m_setConfigurationCallback(sessionId, configurationConverter.CPointer(), connectionConverter.CPointer());
+        Deliver_(m_setConfigurationCallback, sessionId, in_data, peerConnectionInfo);
     }
 
     void On(unsigned sessionId, EVerticalState, const SendWorkOrderInfoData& in_data) override
     {
-        const auto* pSession = Session_(sessionId);
-        if (!pSession)
+        if (!HasSession_(sessionId))
             return;
 
-        const Converter2C<SendWorkOrderInfoData> converter(in_data);
-        m_sendWorkOrderInfoCallback(sessionId, converter.CPointer());
+        Deliver_(m_sendWorkOrderInfoCallback, sessionId, in_data);
     }
 
     void On(unsigned sessionId, EVerticalState, const QueryHermesCapabilitiesData& in_data) override
     {
-        const auto* pSession = Session_(sessionId);
-        if (!pSession)
+        if (!HasSession_(sessionId))
             return;
 
-        const Converter2C<QueryHermesCapabilitiesData> converter(in_data);
-        m_queryHermesCapabilitiesCallback(sessionId, converter.CPointer());
+        Deliver_(m_queryHermesCapabilitiesCallback, sessionId, in_data);
     }
 
     void On(unsigned sessionId, EVerticalState, const NotificationData& in_data) override
     {
-        const auto* pSession = Session_(sessionId);
-        if (!pSession)
+        if (!HasSession_(sessionId))
             return;
 
-        const Converter2C<NotificationData> converter(in_data);
-        m_notificationCallback(sessionId, converter.CPointer());
+        Deliver_(m_notificationCallback, sessionId, in_data);
     }
 
     void On(unsigned sessionId, EVerticalState, const CheckAliveData& in_data) override
     {
-        const auto* pSession = Session_(sessionId);
-        if (!pSession)
+        if (!HasSession_(sessionId))
             return;
 
+        ECheckAliveResponseMode checkAliveResponseMode;
+        {
+            std::lock_guard<std::mutex> lock(m_sessionMutex);
+            checkAliveResponseMode = m_settings.m_checkAliveResponseMode;
+        }
         if (in_data.m_optionalType
             && *in_data.m_optionalType == ECheckAliveType::ePING
-            && m_settings.m_checkAliveResponseMode == ECheckAliveResponseMode::eAUTO)
+            && checkAliveResponseMode == ECheckAliveResponseMode::eAUTO)
         {
             CheckAliveData data{ in_data };
             data.m_optionalType = ECheckAliveType::ePONG;
             m_service.Post([this, sessionId, data = std::move(data)]() { Signal_(sessionId, data); });
         }
-        const Converter2C<CheckAliveData> converter(in_data);
-        m_checkAliveCallback(sessionId, converter.CPointer());
+        Deliver_(m_checkAliveCallback, sessionId, in_data);
     }
 
     void OnDisconnected(unsigned sessionId, EVerticalState state, const Error& error) override
     {
+        decltype(m_sessionMap)::node_type node;
+        {
+            std::lock_guard<std::mutex> lock(m_sessionMutex);
+            node = m_sessionMap.extract(sessionId);
+        }
         // only notify if this was signalled as connected:
-        if (!m_sessionMap.erase(sessionId))
+        if (!node)
             return;
 
-        const Converter2C<Error> converter(error);
-        m_disconnectedCallback(sessionId, ToC(state), converter.CPointer());
+        DeliverFinalCallback(m_upCallbackQueue.get(), m_disconnectedCallback, sessionId, ToC(state), error);
     }
 };
 
 HermesVerticalService* CreateHermesVerticalService(const HermesVerticalServiceCallbacks* pCallbacks)
 {
-    return new HermesVerticalService(*pCallbacks);
+    return new HermesVerticalService(*pCallbacks, nullptr);
+}
+
+HermesVerticalService* CreateHermesVerticalServiceOnService(HermesService* pService, const HermesVerticalServiceCallbacks* pCallbacks)
+{
+    return new HermesVerticalService(*pCallbacks, pService ? &pService->m_pool : nullptr);
+}
+
+void UseHermesVerticalServiceCallbackQueue(HermesVerticalService* pVerticalService, uint32_t capacity, EHermesCallbackQueueOverflow overflow)
+{
+    ECallbackQueueOverflow cppOverflow;
+    CToCpp(overflow, cppOverflow);
+    pVerticalService->m_service.Log(0U, "UseHermesVerticalServiceCallbackQueue(", capacity, ',', cppOverflow, ')');
+    pVerticalService->m_upCallbackQueue = CreateCallbackQueue(pVerticalService->m_service, capacity, cppOverflow);
+}
+
+void SetHermesVerticalServiceThreadSettings(HermesVerticalService* pVerticalService, const HermesThreadSettings* pThreadSettings)
+{
+    const auto threadSettings = ToCpp(*pThreadSettings);
+    pVerticalService->m_service.Log(0U, "SetHermesVerticalServiceThreadSettings(", threadSettings, ')');
+    pVerticalService->m_service.SetThreadSettings(threadSettings);
+}
+
+void SetHermesVerticalServiceTraceMask(HermesVerticalService* pVerticalService, uint32_t traceMask)
+{
+    pVerticalService->m_service.Log(0U, "SetHermesVerticalServiceTraceMask(", traceMask, ')');
+    pVerticalService->m_service.SetTraceMask(traceMask);
+}
+
+void UseHermesVerticalServiceTraceFile(HermesVerticalService* pVerticalService, HermesStringView path, uint32_t ringCapacityInBytes, uint32_t maxFileSizeInBytes)
+{
+    const auto& pathString = std::string(path.m_pData, path.m_size);
+    pVerticalService->m_service.Log(0U, "UseHermesVerticalServiceTraceFile(", pathString, ',', ringCapacityInBytes, ',', maxFileSizeInBytes, ')');
+    pVerticalService->m_service.UseTraceFile(pathString, ringCapacityInBytes, maxFileSizeInBytes);
+}
+
+void SetHermesVerticalServiceTraceEventCallback(HermesVerticalService* pVerticalService, HermesTraceEventCallback callback)
+{
+    pVerticalService->m_service.Log(0U, "SetHermesVerticalServiceTraceEventCallback");
+    pVerticalService->m_service.SetTraceEventCallback(callback);
+}
+
+void EnableHermesVerticalServiceLatencyHistograms(HermesVerticalService* pVerticalService)
+{
+    pVerticalService->m_service.Log(0U, "EnableHermesVerticalServiceLatencyHistograms");
+    pVerticalService->m_service.EnableLatencyHistograms();
+}
+
+uint32_t GetHermesVerticalServiceLatencyHistograms(HermesVerticalService* pVerticalService, HermesLatencyHistogram* pHistograms, uint32_t maxCount)
+{
+    return CopyLatencyHistograms(pVerticalService->m_service.GetLatencyHistogramSummaries(), pHistograms, maxCount);
+}
+
+uint32_t GetHermesVerticalServiceThreadStatistics(HermesVerticalService* pVerticalService, HermesThreadStatistics* pStatistics, uint32_t maxCount)
+{
+    return CopyThreadStatistics(pVerticalService->m_service.GetThreadStatistics(), pStatistics, maxCount);
 }
 
 void RunHermesVerticalService(HermesVerticalService* pVerticalService)
@@ -319,6 +433,29 @@ void RunHermesVerticalService(HermesVerticalService* pVerticalService)
     pVerticalService->m_service.Run();
 }
 
+void RunHermesVerticalServiceOnThreads(HermesVerticalService* pVerticalService, uint32_t threadCount)
+{
+    pVerticalService->m_service.Log(0U, "RunHermesVerticalServiceOnThreads(", threadCount, ')');
+
+    pVerticalService->m_service.Run(threadCount);
+}
+
+uint32_t PollHermesVerticalService(HermesVerticalService* pVerticalService, uint32_t maxHandlers)
+{
+    return static_cast<uint32_t>(pVerticalService->m_service.Poll(maxHandlers));
+}
+
+uint32_t RunHermesVerticalServiceFor(HermesVerticalService* pVerticalService, uint32_t timeoutInMilliseconds)
+{
+    return static_cast<uint32_t>(pVerticalService->m_service.RunFor(std::chrono::milliseconds(timeoutInMilliseconds)));
+}
+
+int32_t GetHermesVerticalServicePollDescriptor(HermesVerticalService* pVerticalService)
+{
+    pVerticalService->m_service.Log(0U, "GetHermesVerticalServicePollDescriptor");
+    return pVerticalService->m_service.PollDescriptor();
+}
+
 void PostHermesVerticalService(HermesVerticalService* pVerticalService, HermesVoidCallback voidCallback)
 {
     pVerticalService->m_service.Log(0U, "EnableHermesDownstream");
@@ -498,7 +635,9 @@ void StopHermesVerticalService(HermesVerticalService* pVerticalService)
 void DeleteHermesVerticalService(HermesVerticalService* pVerticalService)
 {
     pVerticalService->m_service.Log(0U, "DeleteHermesVerticalService");
-
-    pVerticalService->m_service.Stop();
-    delete pVerticalService;
+    if (pVerticalService->m_upCallbackQueue)
+    {
+        pVerticalService->m_upCallbackQueue->Stop();
+    }
+    Service::Delete(pVerticalService);
 }
@@ -53,6 +53,11 @@ namespace Hermes
                 m_pCallback->OnSocketConnected(connectionInfo);
             }
 
+            StringSpan ReceiveBuffer(std::size_t minSize) override
+            {
+                return m_dispatcher.ReceiveBuffer(minSize);
+            }
+
             void OnReceived(StringSpan xmlData) override
             {
                 auto error = m_dispatcher.Dispatch(xmlData);
@@ -60,7 +65,7 @@ namespace Hermes
                     return;
 
                 error = m_service.Alarm(m_sessionId, EErrorCode::ePEER_ERROR, error.m_text);
-                Signal(Serialize(NotificationData(ENotificationCode::ePROTOCOL_ERROR, ESeverity::eFATAL, error.m_text)));
+                Signal(Serialize(NotificationData(ENotificationCode::ePROTOCOL_ERROR, ESeverity::eFATAL, error.m_text)), 0U);
                 m_socket.Close();
                 m_pCallback->OnDisconnected(error);
             }
@@ -79,9 +84,9 @@ namespace Hermes
                 m_socket.Connect(wpOwner, *this);
             }
 
-            void Signal(StringView rawXml)
+            void Signal(StringView rawXml, unsigned serializeTimeInMicroseconds)
             {
-                m_socket.Send(rawXml);
+                m_socket.Send(rawXml, serializeTimeInMicroseconds);
             }
 
             void Disconnect() override
@@ -34,7 +34,7 @@ namespace Hermes
 
     namespace VerticalService
     {
-        struct Session::Impl : ISerializerCallback
+        struct Session::Impl : ISerializerCallback, std::enable_shared_from_this<Session::Impl>
         {
             unsigned m_id;
             EVerticalState m_state{ EVerticalState::eNOT_CONNECTED };
@@ -44,7 +44,6 @@ namespace Hermes
             std::unique_ptr<IServerSocket> m_upSocket;
             std::unique_ptr<ISerializer> m_upSerializer;
             Optional<SupervisoryServiceDescriptionData> m_optionalPeerServiceDescriptionData;
-            ConnectionInfo m_peerConnectionInfo;
 
             ISessionCallback* m_pCallback{ nullptr };
 
@@ -75,7 +74,7 @@ namespace Hermes
 
                 if (m_state != EVerticalState::eNOT_CONNECTED)
                 {
-                    m_upSerializer->Signal(Serialize(NotificationData(ENotificationCode::eUNSPECIFIC, ESeverity::eFATAL, "SoftwareError")));
+                    m_upSerializer->Signal(Serialize(NotificationData(ENotificationCode::eUNSPECIFIC, ESeverity::eFATAL, "SoftwareError")), 0U);
                 }
 
                 m_state = EVerticalState::eDISCONNECTED;
@@ -93,19 +92,75 @@ namespace Hermes
                     return;
 
                 m_state = EVerticalState::eDISCONNECTED;
-                m_pCallback->OnDisconnected(m_id, m_state, error);
-                m_upSerializer->Signal(Serialize(NotificationData(ENotificationCode::ePROTOCOL_ERROR, ESeverity::eFATAL, error.m_text)));
+                if (m_pCallback)
+                {
+                    m_pCallback->OnDisconnected(m_id, m_state, error);
+                }
+                m_upSerializer->Signal(Serialize(NotificationData(ENotificationCode::ePROTOCOL_ERROR, ESeverity::eFATAL, error.m_text)), 0U);
                 m_upSerializer->Disconnect();
             }
 
+            template<class F>
+            void Post_(F&& f)
+            {
+                m_upSocket->Post([spThis = shared_from_this(), f = std::forward<F>(f)]() mutable { f(*spThis); });
+            }
+
+            // serialized right away, so that the data need not be copied:
+            template<class DataT>
+            void PostSignal_(const DataT& data)
+            {
+                Post_([rawXml = Serialize(data)](Impl& impl) { impl.Signal_(rawXml); });
+            }
+
+            void SignalTrackingData_(StringView rawXml)
+            {
+                if (!m_optionalPeerServiceDescriptionData ||
+                    !m_optionalPeerServiceDescriptionData->m_supportedFeatures.m_optionalFeatureBoardTracking)
+                    return;
+                Signal_(rawXml);
+            }
+
+            void SignalServiceDescription_(StringView rawXml)
+            {
+                switch (m_state)
+                {
+                case EVerticalState::eSUPERVISORY_SERVICE_DESCRIPTION:
+                    m_state = EVerticalState::eCONNECTED;
+                    m_upSerializer->Signal(rawXml, 0U);
+                    return;
+
+                default:
+                    if (DisconnectedDueToIllegalClientEvent_("ServiceDescription"))
+                        return;
+                    m_upSerializer->Signal(rawXml, 0U);
+                }
+            }
+
+            void Disconnect_()
+            {
+                switch (m_state)
+                {
+                case EVerticalState::eDISCONNECTED:
+                    return;
+
+                default:
+                    m_state = EVerticalState::eDISCONNECTED;
+                    m_upSerializer->Disconnect();
+                }
+            }
+
             //============= implementation of ISerializerCallback ============
+            // the session may have been dropped meanwhile, so check for the callback:
             void OnSocketConnected(const ConnectionInfo& connectionInfo) override
             {
+                if (!m_pCallback)
+                    return;
+
                 switch (m_state)
                 {
                 case EVerticalState::eNOT_CONNECTED:
                     m_state = EVerticalState::eSOCKET_CONNECTED;
-                    m_peerConnectionInfo = connectionInfo;
                     m_pCallback->OnSocketConnected(m_id, m_state, connectionInfo);
                     return;
 
@@ -116,6 +171,9 @@ namespace Hermes
 
             void On(const SupervisoryServiceDescriptionData& data) override
             {
+                if (!m_pCallback)
+                    return;
+
                 switch (m_state)
                 {
                 case EVerticalState::eSOCKET_CONNECTED:
@@ -132,6 +190,9 @@ namespace Hermes
             template<class DataT>
             void On_(const DataT& data, const char* name)
             {
+                if (!m_pCallback)
+                    return;
+
                 switch (m_state)
                 {
                 case EVerticalState::eNOT_CONNECTED:
@@ -160,7 +221,7 @@ namespace Hermes
                     return;
 
                 default:
-                    m_upSerializer->Signal(rawXml);
+                    m_upSerializer->Signal(rawXml, 0U);
                     return;
                 }
             }
@@ -174,6 +235,8 @@ namespace Hermes
 
                 default:
                     m_state = EVerticalState::eDISCONNECTED;
+                    if (!m_pCallback)
+                        return;
                     m_pCallback->OnDisconnected(m_id, m_state, error);
                 }
             }
@@ -193,59 +256,58 @@ namespace Hermes
             if (!m_spImpl)
                 return;
 
-            m_spImpl->m_pCallback = nullptr;
+            // right away if on the session's strand, which is the case when called back from it:
+            m_spImpl->m_upSocket->Dispatch([spImpl = m_spImpl]() { spImpl->m_pCallback = nullptr; });
         }
 
         unsigned Session::Id() const { return m_spImpl->m_id; }
-        const Optional<SupervisoryServiceDescriptionData>& Session::OptionalPeerServiceDescriptionData() const
-        {
-            return m_spImpl->m_optionalPeerServiceDescriptionData;
-        }
 
-        const ConnectionInfo& Session::PeerConnectionInfo() const { return m_spImpl->m_peerConnectionInfo; }
+        // the socket's connection info, as the host name may be filled in only after the connect:
+        const ConnectionInfo& Session::PeerConnectionInfo() const { return m_spImpl->m_upSocket->GetConnectionInfo(); }
 
         void Session::Connect(ISessionCallback& callback)
         {
-            m_spImpl->m_pCallback = &callback;
-            m_spImpl->m_upSerializer->Connect(m_spImpl, *m_spImpl);
+            m_spImpl->Post_([pCallback = &callback](Impl& impl)
+            {
+                impl.m_pCallback = pCallback;
+                impl.m_upSerializer->Connect(impl.shared_from_this(), impl);
+            });
         }
 
         void Session::Signal(const SupervisoryServiceDescriptionData& data) 
         {
-            switch (m_spImpl->m_state)
-            {
-            case EVerticalState::eSUPERVISORY_SERVICE_DESCRIPTION:
-                m_spImpl->m_state = EVerticalState::eCONNECTED;
-                m_spImpl->m_upSerializer->Signal(Serialize(data));
-                return;
+            m_spImpl->Post_([rawXml = Serialize(data)](Impl& impl) { impl.SignalServiceDescription_(rawXml); });
+        }
 
-            default:
-                if (m_spImpl->DisconnectedDueToIllegalClientEvent_("ServiceDescription"))
-                    return;
-                m_spImpl->m_upSerializer->Signal(Serialize(data));
-            }        
+        void Session::Signal(const BoardArrivedData& data)
+        {
+            m_spImpl->Post_([rawXml = Serialize(data)](Impl& impl) { impl.SignalTrackingData_(rawXml); });
+        }
+
+        void Session::Signal(const BoardDepartedData& data)
+        {
+            m_spImpl->Post_([rawXml = Serialize(data)](Impl& impl) { impl.SignalTrackingData_(rawXml); });
         }
-        
-        void Session::Signal(const BoardArrivedData& data) { m_spImpl->Signal_(Serialize(data)); }
-        void Session::Signal(const BoardDepartedData& data) { m_spImpl->Signal_(Serialize(data)); }
-        void Session::Signal(const QueryWorkOrderInfoData& data) { m_spImpl->Signal_(Serialize(data)); }
-        void Session::Signal(const ReplyWorkOrderInfoData& data) { m_spImpl->Signal_(Serialize(data)); }
-        void Session::Signal(const CurrentConfigurationData& data) { m_spImpl->Signal_(Serialize(data)); }
-        void Session::Signal(const NotificationData& data) { m_spImpl->Signal_(Serialize(data)); }
-        void Session::Signal(const CheckAliveData& data) { m_spImpl->Signal_(Serialize(data)); }
-        void Session::Signal(const SendHermesCapabilitiesData& data) { m_spImpl->Signal_(Serialize(data)); }
+
+        void Session::Signal(const QueryWorkOrderInfoData& data) { m_spImpl->PostSignal_(data); }
+        void Session::Signal(const ReplyWorkOrderInfoData& data) { m_spImpl->PostSignal_(data); }
+        void Session::Signal(const CurrentConfigurationData& data) { m_spImpl->PostSignal_(data); }
+        void Session::Signal(const NotificationData& data) { m_spImpl->PostSignal_(data); }
+        void Session::Signal(const CheckAliveData& data) { m_spImpl->PostSignal_(data); }
+        void Session::Signal(const SendHermesCapabilitiesData& data) { m_spImpl->PostSignal_(data); }
 
         void Session::Disconnect()
         {
-            switch (m_spImpl->m_state)
-            {
-            case EVerticalState::eDISCONNECTED:
-                return;
+            m_spImpl->Post_([](Impl& impl) { impl.Disconnect_(); });
+        }
 
-            default:
-                m_spImpl->m_state = EVerticalState::eDISCONNECTED;
-                m_spImpl->m_upSerializer->Disconnect();
-            }
+        void Session::Disconnect(Task&& f)
+        {
+            m_spImpl->Post_([f = std::move(f)](Impl& impl) mutable
+            {
+                impl.Disconnect_();
+                f();
+            });
         }
     }
 }
\ No newline at end of file
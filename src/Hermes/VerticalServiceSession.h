@@ -17,6 +17,7 @@ limitations under the License.
 #pragma once
 
 #include <HermesData.hpp>
+#include "Task.h"
 
 #include <memory>
 
@@ -41,9 +42,11 @@ namespace Hermes
 
             explicit operator bool() const { return bool(m_spImpl); }
             unsigned Id() const;
-            const Optional<SupervisoryServiceDescriptionData>& OptionalPeerServiceDescriptionData() const;
             const ConnectionInfo& PeerConnectionInfo() const;
 
+            // The calls below are carried out on the strand of the session, where its callbacks arrive as well.
+            // BoardArrived and BoardDeparted only go to peers supporting board tracking.
+
             void Connect(ISessionCallback&);
             void Signal(const SupervisoryServiceDescriptionData&);
             void Signal(const BoardArrivedData&);
@@ -55,6 +58,8 @@ namespace Hermes
             void Signal(const CheckAliveData&);
             void Signal(const SendHermesCapabilitiesData&);
             void Disconnect();
+            // then runs f on the strand, i.e. after a callback of the session that is under way:
+            void Disconnect(Task&& f);
 
         private:
             struct Impl;
@@ -0,0 +1,545 @@
+/***********************************************************************
+Copyright 2018 ASM Assembly Systems GmbH & Co. KG
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+************************************************************************/
+
+
+// Copyright (c) ASM Assembly Systems GmbH & Co. KG
+#include "stdafx.h"
+#include "VirtualNetwork.h"
+
+#include "IService.h"
+#include "MessageSerialization.h"
+#include "SocketTimers.h"
+
+#include <HermesData.hpp>
+
+#include <algorithm>
+#include <deque>
+#include <limits>
+#include <string>
+
+namespace asio = boost::asio;
+
+namespace Hermes
+{
+    // what the connections on a VirtualNetwork report as address (and, for accepted ones, as host name):
+    constexpr const char* cVIRTUAL_ADDRESS = "virtual";
+
+    //===================== VirtualNetwork =====================
+    std::chrono::steady_clock::time_point VirtualNetwork::Now() const
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        return m_now;
+    }
+
+    void VirtualNetwork::Schedule(std::chrono::steady_clock::time_point due, Task&& task)
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_scheduled.emplace(due, std::move(task));
+    }
+
+    std::size_t VirtualNetwork::Poll(std::size_t maxHandlers)
+    {
+        boost::system::error_code ec;
+        if (!maxHandlers)
+            return m_asioService.poll(ec);
+
+        std::size_t count = 0U;
+        while (count < maxHandlers && m_asioService.poll_one(ec))
+        {
+            ++count;
+        }
+        return count;
+    }
+
+    std::size_t VirtualNetwork::Advance(std::chrono::steady_clock::duration duration)
+    {
+        auto count = Poll(0U);
+        const auto until = Now() + std::max(duration, std::chrono::steady_clock::duration::zero());
+        for (;;)
+        {
+            Task task;
+            {
+                std::lock_guard<std::mutex> lock(m_mutex);
+                auto itFirst = m_scheduled.begin();
+                if (itFirst == m_scheduled.end() || itFirst->first > until)
+                {
+                    m_now = until;
+                    return count;
+                }
+                m_now = std::max(m_now, itFirst->first);
+                task = std::move(itFirst->second);
+                m_scheduled.erase(itFirst);
+            }
+            task();
+            count += Poll(0U);
+        }
+    }
+
+    bool VirtualNetwork::Listen(std::uint16_t port, const VirtualListenerWp& wpListener)
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        auto& wpEntry = m_listeners[port];
+        if (!wpEntry.expired())
+            return false;
+        wpEntry = wpListener;
+        return true;
+    }
+
+    void VirtualNetwork::StopListening(std::uint16_t port, const VirtualListener& listener)
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        auto itListener = m_listeners.find(port);
+        if (itListener == m_listeners.end())
+            return;
+        auto spEntry = itListener->second.lock();
+        if (spEntry && spEntry.get() != &listener)
+            return;
+        m_listeners.erase(itListener);
+    }
+
+    VirtualListenerWp VirtualNetwork::Listener(std::uint16_t port) const
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        auto itListener = m_listeners.find(port);
+        return itListener == m_listeners.end() ? VirtualListenerWp() : itListener->second;
+    }
+
+    //===================== VirtualSocket =====================
+    // One end of an in-memory connection. What is sent is posted as a whole to the peer's strand,
+    // and closing one end disconnects the other one, as a TCP connection would. Check alive and
+    // the receive timeout are the SocketTimers of AsioSocket, just on the virtual clock:
+    struct VirtualSocket : std::enable_shared_from_this<VirtualSocket>
+    {
+        unsigned m_sessionId;
+        IAsioService& m_service;
+        VirtualNetwork& m_network;
+        IAsioServiceSp m_spServiceLifetime{m_service.Lifetime()};
+        AsioExecutor m_executor{m_service.GetExecutor()};
+        WheelTimer m_timer{m_service, m_executor};
+        std::weak_ptr<void> m_wpOwner;
+        ISocketCallback* m_pCallback{nullptr};
+        NetworkConfiguration m_configuration;
+        SocketTimers m_timers{m_service, m_executor, m_configuration};
+        ConnectionInfo m_connectionInfo;
+        std::weak_ptr<VirtualSocket> m_wpPeer;
+        std::deque<std::string> m_pendingData; // received before StartReceiving()
+        bool m_receiving{false};
+        bool m_closed{false};
+        RetryBackoff m_retryBackoff{m_sessionId}; // only for connecting sockets
+
+        VirtualSocket(unsigned sessionId, const NetworkConfiguration& configuration, IAsioService& service, VirtualNetwork& network) :
+            m_sessionId(sessionId),
+            m_service(service),
+            m_network(network),
+            m_configuration(configuration)
+        {}
+
+        VirtualSocket(const VirtualSocket&) = delete;
+        VirtualSocket& operator=(const VirtualSocket&) = delete;
+
+        ~VirtualSocket()
+        {
+            Close_();
+        }
+
+        void Connect(std::weak_ptr<void> wpOwner, ISocketCallback& callback)
+        {
+            m_wpOwner = std::move(wpOwner);
+            m_pCallback = &callback;
+        }
+
+        void StartReceiving()
+        {
+            m_receiving = true;
+            // after what has been posted so far, e.g. OnConnected:
+            asio::post(m_executor, [spThis = shared_from_this()]()
+            {
+                spThis->ReceivePending_();
+            });
+            m_timers.Start(*this);
+        }
+
+        void Send(StringView message, unsigned serializeTimeInMicroseconds)
+        {
+            if (m_closed)
+                return m_service.Log(m_sessionId, "Already closed on Send: ", message);
+
+            m_service.Trace(ETraceType::eSENT, m_sessionId, message);
+            m_service.OnSending(m_sessionId, message, serializeTimeInMicroseconds);
+            m_timers.OnSent();
+            auto spPeer = m_wpPeer.lock();
+            if (!spPeer)
+                return;
+            asio::post(spPeer->m_executor, [spPeer, data = std::string(message.data(), message.size())]()
+            {
+                spPeer->OnReceived_(data);
+            });
+        }
+
+        void Close()
+        {
+            Close_();
+        }
+
+        bool Closed() const
+        {
+            return m_closed;
+        }
+
+        // see SocketTimers:
+        void OnReceiveTimeout()
+        {
+            Disconnect_(m_service.Alarm(m_sessionId, EErrorCode::eNETWORK_ERROR,
+                "Nothing received for ", m_configuration.m_receiveTimeoutInSeconds, " seconds"));
+        }
+
+        //================ connecting, on the strand of the connecting socket =====================
+        void AsyncConnect_()
+        {
+            if (m_closed)
+                return;
+
+            m_service.Log(m_sessionId, "AsyncConnect_ to host=", m_configuration.m_hostName, " on port=", m_configuration.m_port);
+            m_connectionInfo.m_address = cVIRTUAL_ADDRESS;
+            m_connectionInfo.m_port = m_configuration.m_port;
+            m_connectionInfo.m_hostName = m_configuration.m_hostName;
+
+            auto spListener = m_network.Listener(m_configuration.m_port).lock();
+            if (!spListener)
+                return OnRefused_();
+
+            AcceptOn_(spListener);
+        }
+
+        void AcceptOn_(const std::shared_ptr<VirtualListener>& spListener);
+
+        void OnAccepted_(const std::shared_ptr<VirtualSocket>& spPeer)
+        {
+            if (m_closed)
+            {
+                asio::post(spPeer->m_executor, [spPeer]() { spPeer->OnPeerClosed_(); });
+                return;
+            }
+
+            m_wpPeer = spPeer;
+            m_retryBackoff.Reset();
+            auto spOwner = m_wpOwner.lock();
+            if (!spOwner || !m_pCallback)
+                return;
+
+            m_service.Inform(m_sessionId, "OnConnected ", m_connectionInfo);
+            m_service.OnSocketConnected(m_sessionId);
+            m_pCallback->OnConnected(m_connectionInfo);
+            StartReceiving();
+        }
+
+        void OnRefused_()
+        {
+            if (m_closed)
+                return;
+
+            m_service.Alarm(m_sessionId, EErrorCode::eNETWORK_ERROR, "Unable to connect to ", m_connectionInfo, ": nothing listening");
+            auto delayInSeconds = m_retryBackoff.NextDelayInSeconds(m_configuration.m_retryPolicy);
+            m_service.Log(m_sessionId, "Retry connecting in ", delayInSeconds, "s, attempt=", m_retryBackoff.Attempt());
+            m_timer.ExpiresFromNow(std::chrono::milliseconds(static_cast<int>(1000.0 * delayInSeconds)),
+                [spThis = shared_from_this()]()
+            {
+                spThis->AsyncConnect_();
+            });
+        }
+
+    private:
+        ISocketCallback* Close_()
+        {
+            if (m_closed)
+                return nullptr;
+            m_closed = true;
+            m_service.Log(m_sessionId, "Close socket");
+
+            m_timer.Cancel();
+            m_timers.Cancel();
+            m_pendingData.clear();
+            if (auto spPeer = m_wpPeer.lock())
+            {
+                asio::post(spPeer->m_executor, [spPeer]() { spPeer->OnPeerClosed_(); });
+            }
+            m_wpPeer.reset();
+
+            auto* pCallback = m_pCallback;
+            m_pCallback = nullptr;
+            return pCallback;
+        }
+
+        void Disconnect_(const Error& error)
+        {
+            auto spOwner = m_wpOwner.lock();
+            auto* pCallback = Close_();
+            if (!spOwner || !pCallback)
+                return;
+
+            m_service.Inform(m_sessionId, "Disconnected");
+            pCallback->OnDisconnected(error);
+        }
+
+        void OnPeerClosed_()
+        {
+            if (m_closed)
+                return;
+
+            m_service.Inform(m_sessionId, "Connection closed by peer");
+            m_wpPeer.reset();
+            Disconnect_(Error{});
+        }
+
+        void OnReceived_(const std::string& data)
+        {
+            if (m_closed)
+                return m_service.Log(m_sessionId, "Received data, but already closed");
+
+            if (!m_receiving || !m_pendingData.empty())
+            {
+                m_pendingData.push_back(data);
+                return;
+            }
+            Receive_(data);
+        }
+
+        void ReceivePending_()
+        {
+            while (!m_closed && !m_pendingData.empty())
+            {
+                auto data = std::move(m_pendingData.front());
+                m_pendingData.pop_front();
+                Receive_(data);
+            }
+        }
+
+        void Receive_(const std::string& data)
+        {
+            auto spOwner = m_wpOwner.lock();
+            if (!spOwner || !m_pCallback)
+            {
+                m_service.Alarm(m_sessionId, Hermes::EErrorCode::eIMPLEMENTATION_ERROR, "Received data, but no callback");
+                return;
+            }
+
+            m_service.Trace(ETraceType::eRECEIVED, m_sessionId, data);
+            m_timers.OnReceived();
+            auto receiveBuffer = m_pCallback->ReceiveBuffer(std::max<std::size_t>(data.size(), 1U));
+            std::copy(data.begin(), data.end(), receiveBuffer.data());
+            m_pCallback->OnReceived(StringSpan(receiveBuffer.data(), data.size()));
+        }
+    };
+    using VirtualSocketSp = std::shared_ptr<VirtualSocket>;
+
+    //===================== accepting =====================
+    // shared by a VirtualAcceptor with the network and with the connection attempts on their way to it:
+    struct VirtualListener
+    {
+        IAsioService& m_service;
+        IAsioServiceSp m_spServiceLifetime{m_service.Lifetime()};
+        AsioExecutor m_executor{m_service.GetExecutor()};
+        VirtualNetwork& m_network;
+        IAcceptorCallback& m_callback;
+        NetworkConfiguration m_configuration;
+        unsigned m_sessionId = 1U;
+        bool m_listening = false;
+        bool m_closed = false; // once the acceptor is gone
+
+        VirtualListener(IAsioService& service, VirtualNetwork& network, IAcceptorCallback& callback) :
+            m_service(service),
+            m_network(network),
+            m_callback(callback)
+        {}
+
+        void Accept_(const VirtualSocketSp& spClient);
+    };
+
+    struct VirtualServerSocket : IServerSocket
+    {
+        VirtualSocketSp m_spSocket;
+
+        explicit VirtualServerSocket(VirtualSocketSp&& spSocket) :
+            m_spSocket(std::move(spSocket))
+        {}
+
+        ~VirtualServerSocket()
+        {
+            m_spSocket->Close();
+        }
+
+        unsigned SessionId() const override { return m_spSocket->m_sessionId; }
+        const ConnectionInfo& GetConnectionInfo() const override { return m_spSocket->m_connectionInfo; }
+        const NetworkConfiguration& GetConfiguration() const override { return m_spSocket->m_configuration; }
+
+        void Connect(std::weak_ptr<void> wpOwner, ISocketCallback& callback) override
+        {
+            m_spSocket->Connect(std::move(wpOwner), callback);
+            asio::post(m_spSocket->m_executor, [spSocket = m_spSocket, wpOwner = m_spSocket->m_wpOwner]()
+            {
+                auto spOwner = wpOwner.lock();
+                if (!spOwner || spSocket->m_closed || !spSocket->m_pCallback)
+                    return;
+                spSocket->m_service.OnSocketConnected(spSocket->m_sessionId);
+                spSocket->m_pCallback->OnConnected(spSocket->m_connectionInfo);
+            });
+            m_spSocket->StartReceiving();
+        }
+
+        void Send(StringView message, unsigned serializeTimeInMicroseconds) override { m_spSocket->Send(message, serializeTimeInMicroseconds); }
+        void Close() override { m_spSocket->Close(); }
+        void Post(Task&& f) override { asio::post(m_spSocket->m_executor, std::move(f)); }
+        void Dispatch(Task&& f) override { asio::dispatch(m_spSocket->m_executor, std::move(f)); }
+    };
+
+    void VirtualSocket::AcceptOn_(const std::shared_ptr<VirtualListener>& spListener)
+    {
+        asio::post(spListener->m_executor, [spListener, spThis = shared_from_this()]()
+        {
+            spListener->Accept_(spThis);
+        });
+    }
+
+    void VirtualListener::Accept_(const VirtualSocketSp& spClient)
+    {
+        if (!m_listening)
+        {
+            asio::post(spClient->m_executor, [spClient]() { spClient->OnRefused_(); });
+            return;
+        }
+
+        auto spSocket = std::make_shared<VirtualSocket>(m_sessionId, m_configuration, m_service, m_network);
+        m_sessionId = m_sessionId == std::numeric_limits<unsigned>::max() ? 1U : m_sessionId + 1U;
+        spSocket->m_connectionInfo.m_address = cVIRTUAL_ADDRESS;
+        spSocket->m_connectionInfo.m_port = m_configuration.m_port;
+        spSocket->m_connectionInfo.m_hostName = cVIRTUAL_ADDRESS;
+        spSocket->m_wpPeer = spClient;
+        asio::post(spClient->m_executor, [spClient, spSocket]() { spClient->OnAccepted_(spSocket); });
+
+        m_service.Inform(spSocket->m_sessionId, "OnAccepted ", spSocket->m_connectionInfo);
+        m_callback.OnAccepted(std::make_unique<VirtualServerSocket>(std::move(spSocket)));
+    }
+
+    // Accepts whoever connects to its port: the peers have no addresses on the virtual network,
+    // so the allowed host names of the configuration cannot be checked (see CreateHermesVirtualService):
+    struct VirtualAcceptor : IAcceptor
+    {
+        IAsioService& m_service;
+        VirtualNetwork& m_network;
+        std::shared_ptr<VirtualListener> m_spListener;
+        WheelTimer m_timer{m_service, m_service.GetExecutor()};
+        RetryBackoff m_retryBackoff{0U};
+
+        VirtualAcceptor(IAsioService& service, IAcceptorCallback& callback, VirtualNetwork& network) :
+            m_service(service),
+            m_network(network),
+            m_spListener(std::make_shared<VirtualListener>(service, network, callback))
+        {}
+
+        ~VirtualAcceptor()
+        {
+            StopListening();
+            m_spListener->m_closed = true;
+        }
+
+        void StartListening(const NetworkConfiguration& configuration) override
+        {
+            m_service.Log(m_spListener->m_sessionId, "Start Listening(", configuration, ") on virtual network");
+            if (m_spListener->m_listening && m_spListener->m_configuration == configuration)
+                return;
+
+            StopListening();
+            m_spListener->m_configuration = configuration;
+            if (!configuration.m_hostName.empty())
+            {
+                m_service.Warn(m_spListener->m_sessionId, "Allowed peers ", configuration.m_hostName, " are not checked on the virtual network");
+            }
+            m_retryBackoff.Reset();
+            Listen_();
+        }
+
+        void StopListening() override
+        {
+            m_timer.Cancel();
+            if (!m_spListener->m_listening)
+                return;
+            m_spListener->m_listening = false;
+            m_network.StopListening(m_spListener->m_configuration.m_port, *m_spListener);
+        }
+
+        void Listen_()
+        {
+            const auto port = m_spListener->m_configuration.m_port;
+            if (m_network.Listen(port, m_spListener))
+            {
+                m_spListener->m_listening = true;
+                m_retryBackoff.Reset();
+                return;
+            }
+
+            m_service.Alarm(m_spListener->m_sessionId, EErrorCode::eNETWORK_ERROR, "Unable to listen on accept port ", port, ": already in use");
+            auto delayInSeconds = m_retryBackoff.NextDelayInSeconds(m_spListener->m_configuration.m_retryPolicy);
+            m_service.Log(m_spListener->m_sessionId, "Retry listening in ", delayInSeconds, "s, attempt=", m_retryBackoff.Attempt());
+            m_timer.ExpiresFromNow(std::chrono::milliseconds(static_cast<int>(1000.0 * delayInSeconds)),
+                [this, spListener = m_spListener]()
+            {
+                if (spListener->m_closed)
+                    return;
+
+                Listen_();
+            });
+        }
+    };
+
+    //===================== connecting =====================
+    struct VirtualClientSocket : IClientSocket
+    {
+        VirtualSocketSp m_spSocket;
+
+        explicit VirtualClientSocket(VirtualSocketSp&& spSocket) :
+            m_spSocket(std::move(spSocket))
+        {}
+
+        ~VirtualClientSocket()
+        {
+            m_spSocket->Close();
+        }
+
+        unsigned SessionId() const override { return m_spSocket->m_sessionId; }
+        const ConnectionInfo& GetConnectionInfo() const override { return m_spSocket->m_connectionInfo; }
+        const NetworkConfiguration& GetConfiguration() const override { return m_spSocket->m_configuration; }
+
+        void Connect(std::weak_ptr<void> wpOwner, ISocketCallback& callback) override
+        {
+            m_spSocket->Connect(std::move(wpOwner), callback);
+            m_spSocket->AsyncConnect_();
+        }
+
+        void Send(StringView message, unsigned serializeTimeInMicroseconds) override { m_spSocket->Send(message, serializeTimeInMicroseconds); }
+        void Close() override { m_spSocket->Close(); }
+    };
+}
+
+std::unique_ptr<Hermes::IClientSocket> Hermes::CreateVirtualClientSocket(unsigned sessionId,
+    const NetworkConfiguration& configuration, IAsioService& service, VirtualNetwork& network)
+{
+    return std::make_unique<VirtualClientSocket>(std::make_shared<VirtualSocket>(sessionId, configuration, service, network));
+}
+
+std::unique_ptr<Hermes::IAcceptor> Hermes::CreateVirtualAcceptor(IAsioService& service, IAcceptorCallback& callback, VirtualNetwork& network)
+{
+    return std::make_unique<VirtualAcceptor>(service, callback, network);
+}
@@ -0,0 +1,74 @@
+/***********************************************************************
+Copyright 2018 ASM Assembly Systems GmbH & Co. KG
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+************************************************************************/
+
+
+
+// Copyright (c) ASM Assembly Systems GmbH & Co. KG
+#pragma once
+
+#include "Network.h"
+#include "Task.h"
+
+#include <boost/asio.hpp>
+
+#include <chrono>
+#include <cstdint>
+#include <map>
+#include <memory>
+#include <mutex>
+
+namespace Hermes
+{
+    struct VirtualListener;
+    using VirtualListenerWp = std::weak_ptr<VirtualListener>;
+
+    // For tests and benchmarks: a clock which only moves when told to, and an in-memory network between the instances
+    // of a service, connecting by port number. Only the thread stepping the service runs the handlers, so the same steps
+    // give the same results, without waiting for sockets or timers in real time:
+    class VirtualNetwork
+    {
+    public:
+        explicit VirtualNetwork(boost::asio::io_service& asioService) :
+            m_asioService(asioService)
+        {}
+
+        std::chrono::steady_clock::time_point Now() const;
+
+        // the task runs once the clock has reached due, on the stepping thread, so it is to post onto its strand:
+        void Schedule(std::chrono::steady_clock::time_point due, Task&&);
+
+        // both return the number of handlers run:
+        std::size_t Poll(std::size_t maxHandlers); // 0: all that are ready
+        std::size_t Advance(std::chrono::steady_clock::duration); // in order of due time, polling after each
+
+        bool Listen(std::uint16_t port, const VirtualListenerWp&); // false if the port is taken
+        void StopListening(std::uint16_t port, const VirtualListener&);
+        VirtualListenerWp Listener(std::uint16_t port) const;
+
+    private:
+        boost::asio::io_service& m_asioService;
+        mutable std::mutex m_mutex;
+        std::chrono::steady_clock::time_point m_now;
+        // equal due times keep their order of scheduling:
+        std::multimap<std::chrono::steady_clock::time_point, Task> m_scheduled;
+        std::map<std::uint16_t, VirtualListenerWp> m_listeners;
+    };
+
+    std::unique_ptr<IClientSocket> CreateVirtualClientSocket(unsigned sessionId,
+        const NetworkConfiguration&, IAsioService& service, VirtualNetwork&);
+
+    std::unique_ptr<IAcceptor> CreateVirtualAcceptor(IAsioService& service, IAcceptorCallback&, VirtualNetwork&);
+}
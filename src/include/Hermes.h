@@ -179,6 +179,45 @@ extern "C" {
         void *m_pData;
     };
 
+    // Structured trace events, see HermesTraceEvent. As for the traces, their handling must be thread-safe:
+    struct HermesTraceEventCallback
+    {
+        void(*m_pCall)(void* /*m_pData*/, const HermesTraceEvent*);
+        void* m_pData;
+    };
+
+    // Converts a binary trace file (see UseHermesDownstreamTraceFile) into text, one line per trace.
+    // Returns the number of traces written, 0 if the trace file cannot be read or the text file not be written:
+    HERMESPROTOCOL_API uint32_t DecodeHermesTraceFile(HermesStringView tracePath, HermesStringView textPath);
+
+    // Optionally, several of the instances below can share a pool of worker threads, instead of each one needing
+    // a thread of its own calling Run...(). Each instance is served by one thread at a time, so there are no concurrent callbacks.
+    // For an instance created on a HermesService, calling Run...() is not needed, it would just block until Stop...() is called.
+    // Deleting such an instance waits until none of its handlers runs, except on a thread of the pool (e.g. in a callback
+    // of another instance): there, the deletion completes later on, and callbacks already pending may still be made.
+    struct HermesService; // the opaque handle to the shared pool
+    HERMESPROTOCOL_API HermesService* CreateHermesService(uint32_t threadCount); // threadCount 0: one per hardware thread
+    // As CreateHermesService, with each of the threads set up as given (name, CPUs, scheduling):
+    HERMESPROTOCOL_API HermesService* CreateHermesServiceWithThreadSettings(uint32_t threadCount, const HermesThreadSettings*);
+    HERMESPROTOCOL_API void DeleteHermesService(HermesService*); // delete the instances created on it first
+    // One entry per thread of the service, for up to maxCount of them. Returns the number of threads:
+    HERMESPROTOCOL_API uint32_t GetHermesServiceThreadStatistics(HermesService*, HermesThreadStatistics*, uint32_t maxCount);
+
+    // A HermesService without threads, for tests and benchmarks. Its instances connect to each other in memory instead of through TCP
+    // (by port, whatever the host name), and their timers run on a virtual clock, which only moves in AdvanceHermesVirtualService.
+    // As the peers have no addresses there, the allowed client address of a downstream or vertical service is not checked.
+    // The handlers only run in these two calls, on the calling thread, so the same calls give the same results.
+    HERMESPROTOCOL_API HermesService* CreateHermesVirtualService(void); // to be deleted with DeleteHermesService
+    // Both return the number of handlers run. Poll runs up to maxHandlers (0: all) ready ones, Advance also runs the timers
+    // falling due on the way, in the order of their due time:
+    HERMESPROTOCOL_API uint32_t PollHermesVirtualService(HermesService*, uint32_t maxHandlers);
+    HERMESPROTOCOL_API uint32_t AdvanceHermesVirtualService(HermesService*, uint32_t milliseconds);
+
+    // Diagnostics: the heap allocations the library made so far for handing the calls below over to its threads.
+    // Once warmed up, e.g. signalling data should not add to it. Not counted: copying the data itself
+    // (e.g. a board id too long for the small string optimization), nor serializing it on those threads:
+    HERMESPROTOCOL_API uint64_t GetHermesTaskAllocationCount(void);
+
     // The interface for the connection to the downstream machine.
 
     // These are the callbacks to deal with:
@@ -209,7 +248,55 @@ extern "C" {
     // The calling API
     struct HermesDownstream; // the opaque handle to the downstream service
     HERMESPROTOCOL_API HermesDownstream* CreateHermesDownstream(uint32_t laneId, const HermesDownstreamCallbacks*);
+    HERMESPROTOCOL_API HermesDownstream* CreateHermesDownstreamOnService(HermesService*, uint32_t laneId, const HermesDownstreamCallbacks*);
+    // Optional, right after creation: calls from application threads are then handed over through a lock-free ring of capacity entries.
+    // When it is full, the calling thread waits for the service to catch up:
+    HERMESPROTOCOL_API void UseHermesDownstreamTaskRing(HermesDownstream*, uint32_t capacity);
+    // Optional, right after creation: the callbacks (except for the trace) are then made in order on a thread of their own,
+    // through a queue of up to capacity callbacks, so that a slow application does not delay check alive and the like.
+    // When the queue is full, the service either waits or drops the connection, as given by the overflow policy.
+    // Waiting is not supported on a HermesService shared with other instances, which would all be held up; it drops the connection there:
+    HERMESPROTOCOL_API void UseHermesDownstreamCallbackQueue(HermesDownstream*, uint32_t capacity, EHermesCallbackQueueOverflow);
+    // Optional, before RunHermesDownstream: sets up the threads running the downstream (name, CPUs, scheduling).
+    // Settings the OS refuses are traced. No effect on a HermesService, see CreateHermesServiceWithThreadSettings:
+    HERMESPROTOCOL_API void SetHermesDownstreamThreadSettings(HermesDownstream*, const HermesThreadSettings*);
+    // One entry per thread currently in RunHermesDownstream (on a HermesService: per thread of the service),
+    // for up to maxCount of them. Returns the number of threads:
+    HERMESPROTOCOL_API uint32_t GetHermesDownstreamThreadStatistics(HermesDownstream*, HermesThreadStatistics*, uint32_t maxCount);
+    // Only the trace types whose bit (1U << EHermesTraceType) is set in traceMask reach the trace callback; by default all of them.
+    // The others are not even formatted, which saves most of the cost of tracing on busy connections. May be called any time:
+    HERMESPROTOCOL_API void SetHermesDownstreamTraceMask(HermesDownstream*, uint32_t traceMask);
+    // Optional, right after creation: instead of the trace callback, the traces are written as compact binary records
+    // to a memory mapped file, by a thread of its own, so that tracing hardly delays the connections.
+    // The records are buffered in a ring of ringCapacityInBytes; when it is full, traces are dropped (and this is traced).
+    // A full file is renamed to <path>.1 and a new one is started. See DecodeHermesTraceFile:
+    HERMESPROTOCOL_API void UseHermesDownstreamTraceFile(HermesDownstream*, HermesStringView path,
+        uint32_t ringCapacityInBytes, uint32_t maxFileSizeInBytes);
+    // Optional, right after creation: structured events for connected sockets (accepted ones with the latency from accepting
+    // to reporting them), messages received and sent (with their sizes and the time taken to parse or serialize them),
+    // state changes, errors, host names of accepted peers resolved later on and send queues crossing their watermarks
+    // (see HermesSocketSettings, e.g. a peer not reading), in addition to the traces.
+    // Without such a callback, the events are not even built:
+    HERMESPROTOCOL_API void SetHermesDownstreamTraceEventCallback(HermesDownstream*, HermesTraceEventCallback);
+    // Optional, right after creation: log-linear histograms of how long the messages take, per message type and stage
+    // of receiving (parse, deserialize, callback, total) and sending (queue, serialize, write), see EHermesLatencyStage.
+    // Without them, nothing is measured:
+    HERMESPROTOCOL_API void EnableHermesDownstreamLatencyHistograms(HermesDownstream*);
+    // A summary of each histogram recorded into so far, for up to maxCount of them. Returns the number of histograms.
+    // May be called any time, from any thread:
+    HERMESPROTOCOL_API uint32_t GetHermesDownstreamLatencyHistograms(HermesDownstream*, HermesLatencyHistogram*, uint32_t maxCount);
     HERMESPROTOCOL_API void RunHermesDownstream(HermesDownstream*); // blocks until ::StopHermesDownstream is called
+    // Instead of RunHermesDownstream, to drive the downstream from the application's own event loop, with the callbacks on the calling thread.
+    // Poll does not block and runs up to maxHandlers (0: all) ready handlers, RunFor blocks for up to the timeout.
+    // Both return the number of handlers run; they are no-ops on a HermesService, whose threads run the handlers:
+    HERMESPROTOCOL_API uint32_t PollHermesDownstream(HermesDownstream*, uint32_t maxHandlers);
+    HERMESPROTOCOL_API uint32_t RunHermesDownstreamFor(HermesDownstream*, uint32_t timeoutInMilliseconds);
+    // For waiting in the application's epoll (or poll, select) loop: a descriptor that becomes readable when Poll has
+    // something to do, be it on the sockets, a timer due or anything posted, e.g. by the Signal calls. Level-triggered, so
+    // it stays readable until Poll has run the handlers; if Poll has run maxHandlers, call it again rather than waiting.
+    // The descriptor belongs to the downstream: do not read from or close it. -1 if not available: not on Linux,
+    // nor on a HermesService, whose threads wait for it:
+    HERMESPROTOCOL_API int32_t GetHermesDownstreamPollDescriptor(HermesDownstream*);
     HERMESPROTOCOL_API void PostHermesDownstream(HermesDownstream*, HermesVoidCallback);
     HERMESPROTOCOL_API void EnableHermesDownstream(HermesDownstream*, const HermesDownstreamSettings*);
 
@@ -255,7 +342,21 @@ extern "C" {
     // The calling API:
     struct HermesUpstream; // the opaque handle to the upstream service
     HERMESPROTOCOL_API HermesUpstream* CreateHermesUpstream(uint32_t laneId, const HermesUpstreamCallbacks*);
+    HERMESPROTOCOL_API HermesUpstream* CreateHermesUpstreamOnService(HermesService*, uint32_t laneId, const HermesUpstreamCallbacks*);
+    HERMESPROTOCOL_API void UseHermesUpstreamTaskRing(HermesUpstream*, uint32_t capacity); // see UseHermesDownstreamTaskRing
+    HERMESPROTOCOL_API void UseHermesUpstreamCallbackQueue(HermesUpstream*, uint32_t capacity, EHermesCallbackQueueOverflow); // see UseHermesDownstreamCallbackQueue
+    HERMESPROTOCOL_API void SetHermesUpstreamThreadSettings(HermesUpstream*, const HermesThreadSettings*); // see SetHermesDownstreamThreadSettings
+    HERMESPROTOCOL_API uint32_t GetHermesUpstreamThreadStatistics(HermesUpstream*, HermesThreadStatistics*, uint32_t maxCount);
+    HERMESPROTOCOL_API void SetHermesUpstreamTraceMask(HermesUpstream*, uint32_t traceMask); // see SetHermesDownstreamTraceMask
+    HERMESPROTOCOL_API void UseHermesUpstreamTraceFile(HermesUpstream*, HermesStringView path,
+        uint32_t ringCapacityInBytes, uint32_t maxFileSizeInBytes); // see UseHermesDownstreamTraceFile
+    HERMESPROTOCOL_API void SetHermesUpstreamTraceEventCallback(HermesUpstream*, HermesTraceEventCallback); // see SetHermesDownstreamTraceEventCallback
+    HERMESPROTOCOL_API void EnableHermesUpstreamLatencyHistograms(HermesUpstream*); // see EnableHermesDownstreamLatencyHistograms
+    HERMESPROTOCOL_API uint32_t GetHermesUpstreamLatencyHistograms(HermesUpstream*, HermesLatencyHistogram*, uint32_t maxCount); // see GetHermesDownstreamLatencyHistograms
     HERMESPROTOCOL_API void RunHermesUpstream(HermesUpstream*);
+    HERMESPROTOCOL_API uint32_t PollHermesUpstream(HermesUpstream*, uint32_t maxHandlers); // see PollHermesDownstream
+    HERMESPROTOCOL_API uint32_t RunHermesUpstreamFor(HermesUpstream*, uint32_t timeoutInMilliseconds);
+    HERMESPROTOCOL_API int32_t GetHermesUpstreamPollDescriptor(HermesUpstream*); // see GetHermesDownstreamPollDescriptor
     HERMESPROTOCOL_API void PostHermesUpstream(HermesUpstream*, HermesVoidCallback);
     HERMESPROTOCOL_API void EnableHermesUpstream(HermesUpstream*, const HermesUpstreamSettings*);
 
@@ -340,7 +441,19 @@ extern "C" {
 
     struct HermesConfigurationService; // the opaque handle to the configuration service
     HERMESPROTOCOL_API HermesConfigurationService* CreateHermesConfigurationService(const HermesConfigurationServiceCallbacks*);
+    HERMESPROTOCOL_API HermesConfigurationService* CreateHermesConfigurationServiceOnService(HermesService*, const HermesConfigurationServiceCallbacks*);
+    HERMESPROTOCOL_API void SetHermesConfigurationServiceThreadSettings(HermesConfigurationService*, const HermesThreadSettings*); // see SetHermesDownstreamThreadSettings
+    HERMESPROTOCOL_API uint32_t GetHermesConfigurationServiceThreadStatistics(HermesConfigurationService*, HermesThreadStatistics*, uint32_t maxCount);
+    HERMESPROTOCOL_API void SetHermesConfigurationServiceTraceMask(HermesConfigurationService*, uint32_t traceMask); // see SetHermesDownstreamTraceMask
+    HERMESPROTOCOL_API void UseHermesConfigurationServiceTraceFile(HermesConfigurationService*, HermesStringView path,
+        uint32_t ringCapacityInBytes, uint32_t maxFileSizeInBytes); // see UseHermesDownstreamTraceFile
+    HERMESPROTOCOL_API void SetHermesConfigurationServiceTraceEventCallback(HermesConfigurationService*, HermesTraceEventCallback); // see SetHermesDownstreamTraceEventCallback
+    HERMESPROTOCOL_API void EnableHermesConfigurationServiceLatencyHistograms(HermesConfigurationService*); // see EnableHermesDownstreamLatencyHistograms
+    HERMESPROTOCOL_API uint32_t GetHermesConfigurationServiceLatencyHistograms(HermesConfigurationService*, HermesLatencyHistogram*, uint32_t maxCount); // see GetHermesDownstreamLatencyHistograms
     HERMESPROTOCOL_API void RunHermesConfigurationService(HermesConfigurationService*); // blocks until StopHermesConfigurationService is called
+    HERMESPROTOCOL_API uint32_t PollHermesConfigurationService(HermesConfigurationService*, uint32_t maxHandlers); // see PollHermesDownstream
+    HERMESPROTOCOL_API uint32_t RunHermesConfigurationServiceFor(HermesConfigurationService*, uint32_t timeoutInMilliseconds);
+    HERMESPROTOCOL_API int32_t GetHermesConfigurationServicePollDescriptor(HermesConfigurationService*); // see GetHermesDownstreamPollDescriptor
     HERMESPROTOCOL_API void PostHermesConfigurationService(HermesConfigurationService*, HermesVoidCallback);
     HERMESPROTOCOL_API void EnableHermesConfigurationService(HermesConfigurationService*, const HermesConfigurationServiceSettings*);
 
@@ -400,7 +513,24 @@ extern "C" {
     // The calling API
     struct HermesVerticalService; // the opaque handle to the supervisor service
     HERMESPROTOCOL_API HermesVerticalService* CreateHermesVerticalService(const HermesVerticalServiceCallbacks*);
+    HERMESPROTOCOL_API HermesVerticalService* CreateHermesVerticalServiceOnService(HermesService*, const HermesVerticalServiceCallbacks*);
+    // see UseHermesDownstreamCallbackQueue; the callbacks for all clients then arrive in order on the one thread:
+    HERMESPROTOCOL_API void UseHermesVerticalServiceCallbackQueue(HermesVerticalService*, uint32_t capacity, EHermesCallbackQueueOverflow);
+    HERMESPROTOCOL_API void SetHermesVerticalServiceThreadSettings(HermesVerticalService*, const HermesThreadSettings*); // see SetHermesDownstreamThreadSettings
+    HERMESPROTOCOL_API uint32_t GetHermesVerticalServiceThreadStatistics(HermesVerticalService*, HermesThreadStatistics*, uint32_t maxCount);
+    HERMESPROTOCOL_API void SetHermesVerticalServiceTraceMask(HermesVerticalService*, uint32_t traceMask); // see SetHermesDownstreamTraceMask
+    HERMESPROTOCOL_API void UseHermesVerticalServiceTraceFile(HermesVerticalService*, HermesStringView path,
+        uint32_t ringCapacityInBytes, uint32_t maxFileSizeInBytes); // see UseHermesDownstreamTraceFile
+    HERMESPROTOCOL_API void SetHermesVerticalServiceTraceEventCallback(HermesVerticalService*, HermesTraceEventCallback); // see SetHermesDownstreamTraceEventCallback
+    HERMESPROTOCOL_API void EnableHermesVerticalServiceLatencyHistograms(HermesVerticalService*); // see EnableHermesDownstreamLatencyHistograms
+    HERMESPROTOCOL_API uint32_t GetHermesVerticalServiceLatencyHistograms(HermesVerticalService*, HermesLatencyHistogram*, uint32_t maxCount); // see GetHermesDownstreamLatencyHistograms
     HERMESPROTOCOL_API void RunHermesVerticalService(HermesVerticalService*); // blocks until ::StopHermesDownstream is called
+    // As RunHermesVerticalService, but serving the clients on threadCount threads, with the callbacks for one client still in order.
+    // The callbacks for different clients then arrive concurrently. No effect for an instance on a HermesService:
+    HERMESPROTOCOL_API void RunHermesVerticalServiceOnThreads(HermesVerticalService*, uint32_t threadCount);
+    HERMESPROTOCOL_API uint32_t PollHermesVerticalService(HermesVerticalService*, uint32_t maxHandlers); // see PollHermesDownstream
+    HERMESPROTOCOL_API uint32_t RunHermesVerticalServiceFor(HermesVerticalService*, uint32_t timeoutInMilliseconds);
+    HERMESPROTOCOL_API int32_t GetHermesVerticalServicePollDescriptor(HermesVerticalService*); // see GetHermesDownstreamPollDescriptor
     HERMESPROTOCOL_API void PostHermesVerticalService(HermesVerticalService*, HermesVoidCallback);
     HERMESPROTOCOL_API void EnableHermesVerticalService(HermesVerticalService*, const HermesVerticalServiceSettings*);
 
@@ -472,7 +602,19 @@ extern "C" {
     // The calling API
     struct HermesVerticalClient; // the opaque handle to the supervisor service
     HERMESPROTOCOL_API HermesVerticalClient* CreateHermesVerticalClient(const HermesVerticalClientCallbacks*);
+    HERMESPROTOCOL_API HermesVerticalClient* CreateHermesVerticalClientOnService(HermesService*, const HermesVerticalClientCallbacks*);
+    HERMESPROTOCOL_API void SetHermesVerticalClientThreadSettings(HermesVerticalClient*, const HermesThreadSettings*); // see SetHermesDownstreamThreadSettings
+    HERMESPROTOCOL_API uint32_t GetHermesVerticalClientThreadStatistics(HermesVerticalClient*, HermesThreadStatistics*, uint32_t maxCount);
+    HERMESPROTOCOL_API void SetHermesVerticalClientTraceMask(HermesVerticalClient*, uint32_t traceMask); // see SetHermesDownstreamTraceMask
+    HERMESPROTOCOL_API void UseHermesVerticalClientTraceFile(HermesVerticalClient*, HermesStringView path,
+        uint32_t ringCapacityInBytes, uint32_t maxFileSizeInBytes); // see UseHermesDownstreamTraceFile
+    HERMESPROTOCOL_API void SetHermesVerticalClientTraceEventCallback(HermesVerticalClient*, HermesTraceEventCallback); // see SetHermesDownstreamTraceEventCallback
+    HERMESPROTOCOL_API void EnableHermesVerticalClientLatencyHistograms(HermesVerticalClient*); // see EnableHermesDownstreamLatencyHistograms
+    HERMESPROTOCOL_API uint32_t GetHermesVerticalClientLatencyHistograms(HermesVerticalClient*, HermesLatencyHistogram*, uint32_t maxCount); // see GetHermesDownstreamLatencyHistograms
     HERMESPROTOCOL_API void RunHermesVerticalClient(HermesVerticalClient*); // blocks until ::StopHermesDownstream is called
+    HERMESPROTOCOL_API uint32_t PollHermesVerticalClient(HermesVerticalClient*, uint32_t maxHandlers); // see PollHermesDownstream
+    HERMESPROTOCOL_API uint32_t RunHermesVerticalClientFor(HermesVerticalClient*, uint32_t timeoutInMilliseconds);
+    HERMESPROTOCOL_API int32_t GetHermesVerticalClientPollDescriptor(HermesVerticalClient*); // see GetHermesDownstreamPollDescriptor
     HERMESPROTOCOL_API void PostHermesVerticalClient(HermesVerticalClient*, HermesVoidCallback);
     HERMESPROTOCOL_API void EnableHermesVerticalClient(HermesVerticalClient*, const HermesVerticalClientSettings*);
 
@@ -28,17 +28,135 @@ namespace Hermes
 {
     enum class EState;
 
+    // collects what one of the ::GetHermes...ThreadStatistics functions returns:
+    template<class HandleT>
+    std::vector<ThreadStatistics> GetThreadStatistics_(HandleT* pHandle, uint32_t(*pGetStatistics)(HandleT*, HermesThreadStatistics*, uint32_t))
+    {
+        std::vector<HermesThreadStatistics> cStatistics(8U);
+        for (;;)
+        {
+            const auto count = pGetStatistics(pHandle, cStatistics.data(), static_cast<uint32_t>(cStatistics.size()));
+            const bool complete = count <= cStatistics.size();
+            cStatistics.resize(count);
+            if (complete)
+                break;
+        }
+
+        std::vector<ThreadStatistics> result(cStatistics.size());
+        for (std::size_t i = 0U; i < cStatistics.size(); ++i)
+        {
+            CToCpp(cStatistics[i], result[i]);
+        }
+        return result;
+    }
+
+    // likewise for the ::GetHermes...LatencyHistograms functions:
+    template<class HandleT>
+    std::vector<LatencyHistogram> GetLatencyHistograms_(HandleT* pHandle, uint32_t(*pGetHistograms)(HandleT*, HermesLatencyHistogram*, uint32_t))
+    {
+        std::vector<HermesLatencyHistogram> cHistograms(32U);
+        for (;;)
+        {
+            const auto count = pGetHistograms(pHandle, cHistograms.data(), static_cast<uint32_t>(cHistograms.size()));
+            const bool complete = count <= cHistograms.size();
+            cHistograms.resize(count);
+            if (complete)
+                break;
+        }
+
+        std::vector<LatencyHistogram> result(cHistograms.size());
+        for (std::size_t i = 0U; i < cHistograms.size(); ++i)
+        {
+            CToCpp(cHistograms[i], result[i]);
+        }
+        return result;
+    }
+
+    // converts a file written through UseTraceFile() into text, returns the number of traces, see ::DecodeHermesTraceFile
+    inline unsigned DecodeTraceFile(StringView tracePath, StringView textPath)
+    {
+        return ::DecodeHermesTraceFile(ToC(tracePath), ToC(textPath));
+    }
+
+    // see SetTraceEventCallback() below; the callback must outlive the instance it is set on
+    struct ITraceEventCallback
+    {
+        virtual void OnTraceEvent(const TraceEvent&) = 0;
+
+    protected:
+        ~ITraceEventCallback() {}
+    };
+
+    inline HermesTraceEventCallback TraceEventCallback_(ITraceEventCallback& callback)
+    {
+        HermesTraceEventCallback result;
+        result.m_pData = &callback;
+        result.m_pCall = [](void* pCallback, const HermesTraceEvent* pEvent)
+        {
+            TraceEvent event;
+            CToCpp(*pEvent, event);
+            static_cast<ITraceEventCallback*>(pCallback)->OnTraceEvent(event);
+        };
+        return result;
+    }
+
+    //======================= SharedService interface =====================================
+    // a pool of worker threads to run several of the instances below; it must outlive them
+    class SharedService
+    {
+    public:
+        explicit SharedService(unsigned threadCount = 0U) : m_pImpl(::CreateHermesService(threadCount)) {}
+        SharedService(unsigned threadCount, const ThreadSettings& settings) :
+            m_pImpl(::CreateHermesServiceWithThreadSettings(threadCount, Converter2C<ThreadSettings>(settings).CPointer())) {}
+        SharedService(const SharedService&) = delete;
+        SharedService& operator=(const SharedService&) = delete;
+        ~SharedService() { ::DeleteHermesService(m_pImpl); }
+
+        HermesService* Handle() const { return m_pImpl; }
+        std::vector<ThreadStatistics> GetThreadStatistics() const { return GetThreadStatistics_(m_pImpl, &::GetHermesServiceThreadStatistics); }
+
+    protected:
+        struct AdoptTag {};
+        SharedService(AdoptTag, HermesService* pImpl) : m_pImpl(pImpl) {}
+
+    private:
+        HermesService* m_pImpl = nullptr;
+    };
+
+    // a SharedService without threads, on an in-memory network and a virtual clock, see CreateHermesVirtualService:
+    class VirtualService : public SharedService
+    {
+    public:
+        VirtualService() : SharedService(AdoptTag{}, ::CreateHermesVirtualService()) {}
+
+        unsigned Poll(unsigned maxHandlers = 0U) { return ::PollHermesVirtualService(Handle(), maxHandlers); }
+        unsigned Advance(unsigned milliseconds) { return ::AdvanceHermesVirtualService(Handle(), milliseconds); }
+    };
+
     //======================= Downstream interface =====================================
     struct IDownstreamCallback;
     class Downstream
     {
     public:
-        explicit Downstream(unsigned laneId, IDownstreamCallback&);
+        explicit Downstream(unsigned laneId, IDownstreamCallback& callback) : Downstream(nullptr, laneId, callback) {}
+        Downstream(SharedService& service, unsigned laneId, IDownstreamCallback& callback) : Downstream(service.Handle(), laneId, callback) {}
         Downstream(const Downstream&) = delete;
         Downstream& operator=(const Downstream&) = delete;
         ~Downstream() { ::DeleteHermesDownstream(m_pImpl); }
 
+        void UseTaskRing(unsigned capacity); // optional, before anything else, see UseHermesDownstreamTaskRing
+        void UseCallbackQueue(unsigned capacity, ECallbackQueueOverflow); // optional, before anything else, see UseHermesDownstreamCallbackQueue
+        void SetThreadSettings(const ThreadSettings&); // optional, before Run(), see SetHermesDownstreamThreadSettings
+        std::vector<ThreadStatistics> GetThreadStatistics() const;
+        void SetTraceMask(unsigned traceMask); // bits TraceMask(ETraceType), see SetHermesDownstreamTraceMask
+        void UseTraceFile(StringView path, unsigned ringCapacityInBytes, unsigned maxFileSizeInBytes); // see UseHermesDownstreamTraceFile
+        void SetTraceEventCallback(ITraceEventCallback&); // see SetHermesDownstreamTraceEventCallback
+        void EnableLatencyHistograms(); // see EnableHermesDownstreamLatencyHistograms
+        std::vector<LatencyHistogram> GetLatencyHistograms() const; // see GetHermesDownstreamLatencyHistograms
         void Run();
+        unsigned Poll(unsigned maxHandlers = 0U); // instead of Run(), see PollHermesDownstream
+        unsigned RunFor(unsigned timeoutInMilliseconds);
+        int PollDescriptor(); // for waiting until Poll() has something to do, see GetHermesDownstreamPollDescriptor
         template<class F> void Post(F&&);
         void Enable(const DownstreamSettings&);
 
@@ -61,6 +179,8 @@ namespace Hermes
         void Stop();
 
     private:
+        Downstream(HermesService*, unsigned laneId, IDownstreamCallback&);
+
         HermesDownstream* m_pImpl = nullptr;
     };
 
@@ -97,12 +217,25 @@ namespace Hermes
     class Upstream
     {
     public:
-        explicit Upstream(unsigned laneId, IUpstreamCallback&);
+        explicit Upstream(unsigned laneId, IUpstreamCallback& callback) : Upstream(nullptr, laneId, callback) {}
+        Upstream(SharedService& service, unsigned laneId, IUpstreamCallback& callback) : Upstream(service.Handle(), laneId, callback) {}
         Upstream(const Upstream&) = delete;
         Upstream& operator=(const Upstream&) = delete;
         ~Upstream() { ::DeleteHermesUpstream(m_pImpl); }
 
+        void UseTaskRing(unsigned capacity); // optional, before anything else, see UseHermesDownstreamTaskRing
+        void UseCallbackQueue(unsigned capacity, ECallbackQueueOverflow); // optional, before anything else, see UseHermesDownstreamCallbackQueue
+        void SetThreadSettings(const ThreadSettings&); // optional, before Run(), see SetHermesDownstreamThreadSettings
+        std::vector<ThreadStatistics> GetThreadStatistics() const;
+        void SetTraceMask(unsigned traceMask); // bits TraceMask(ETraceType), see SetHermesDownstreamTraceMask
+        void UseTraceFile(StringView path, unsigned ringCapacityInBytes, unsigned maxFileSizeInBytes); // see UseHermesDownstreamTraceFile
+        void SetTraceEventCallback(ITraceEventCallback&); // see SetHermesDownstreamTraceEventCallback
+        void EnableLatencyHistograms(); // see EnableHermesDownstreamLatencyHistograms
+        std::vector<LatencyHistogram> GetLatencyHistograms() const; // see GetHermesDownstreamLatencyHistograms
         void Run();
+        unsigned Poll(unsigned maxHandlers = 0U); // instead of Run(), see PollHermesDownstream
+        unsigned RunFor(unsigned timeoutInMilliseconds);
+        int PollDescriptor(); // for waiting until Poll() has something to do, see GetHermesDownstreamPollDescriptor
         template<class F> void Post(F&&);
         void Enable(const UpstreamSettings&);
 
@@ -125,6 +258,8 @@ namespace Hermes
         void Stop();
 
     private:
+        Upstream(HermesService*, unsigned laneId, IUpstreamCallback&);
+
         HermesUpstream* m_pImpl = nullptr;
     };
 
@@ -161,18 +296,31 @@ namespace Hermes
     class ConfigurationService
     {
     public:
-        explicit ConfigurationService(IConfigurationServiceCallback& callback);
+        explicit ConfigurationService(IConfigurationServiceCallback& callback) : ConfigurationService(nullptr, callback) {}
+        ConfigurationService(SharedService& service, IConfigurationServiceCallback& callback) : ConfigurationService(service.Handle(), callback) {}
         ConfigurationService(const ConfigurationService&) = delete;
         ConfigurationService& operator=(const ConfigurationService&) = delete;
         ~ConfigurationService() { ::DeleteHermesConfigurationService(m_pImpl); }
 
+        void SetThreadSettings(const ThreadSettings&); // optional, before Run(), see SetHermesDownstreamThreadSettings
+        std::vector<ThreadStatistics> GetThreadStatistics() const;
+        void SetTraceMask(unsigned traceMask); // bits TraceMask(ETraceType), see SetHermesDownstreamTraceMask
+        void UseTraceFile(StringView path, unsigned ringCapacityInBytes, unsigned maxFileSizeInBytes); // see UseHermesDownstreamTraceFile
+        void SetTraceEventCallback(ITraceEventCallback&); // see SetHermesDownstreamTraceEventCallback
+        void EnableLatencyHistograms(); // see EnableHermesDownstreamLatencyHistograms
+        std::vector<LatencyHistogram> GetLatencyHistograms() const; // see GetHermesDownstreamLatencyHistograms
         void Run();
+        unsigned Poll(unsigned maxHandlers = 0U); // instead of Run(), see PollHermesDownstream
+        unsigned RunFor(unsigned timeoutInMilliseconds);
+        int PollDescriptor(); // for waiting until Poll() has something to do, see GetHermesDownstreamPollDescriptor
         template<class F> void Post(F&&);
         void Enable(const ConfigurationServiceSettings&);
         void Disable(const NotificationData&);
         void Stop();
 
     private:
+        ConfigurationService(HermesService*, IConfigurationServiceCallback&);
+
         HermesConfigurationService* m_pImpl = nullptr;
         IConfigurationServiceCallback& m_callback;
     };
@@ -223,12 +371,24 @@ namespace Hermes
     class VerticalService
     {
     public:
-        explicit VerticalService(IVerticalServiceCallback&);
+        explicit VerticalService(IVerticalServiceCallback& callback) : VerticalService(nullptr, callback) {}
+        VerticalService(SharedService& service, IVerticalServiceCallback& callback) : VerticalService(service.Handle(), callback) {}
         VerticalService(const VerticalService&) = delete;
         VerticalService& operator=(const VerticalService&) = delete;
         ~VerticalService() { ::DeleteHermesVerticalService(m_pImpl); }
 
-        void Run();
+        void UseCallbackQueue(unsigned capacity, ECallbackQueueOverflow); // optional, before anything else, see UseHermesDownstreamCallbackQueue
+        void SetThreadSettings(const ThreadSettings&); // optional, before Run(), see SetHermesDownstreamThreadSettings
+        std::vector<ThreadStatistics> GetThreadStatistics() const;
+        void SetTraceMask(unsigned traceMask); // bits TraceMask(ETraceType), see SetHermesDownstreamTraceMask
+        void UseTraceFile(StringView path, unsigned ringCapacityInBytes, unsigned maxFileSizeInBytes); // see UseHermesDownstreamTraceFile
+        void SetTraceEventCallback(ITraceEventCallback&); // see SetHermesDownstreamTraceEventCallback
+        void EnableLatencyHistograms(); // see EnableHermesDownstreamLatencyHistograms
+        std::vector<LatencyHistogram> GetLatencyHistograms() const; // see GetHermesDownstreamLatencyHistograms
+        void Run(unsigned threadCount = 1U); // further threads serve the clients in parallel, see RunHermesVerticalServiceOnThreads
+        unsigned Poll(unsigned maxHandlers = 0U); // instead of Run(), see PollHermesDownstream
+        unsigned RunFor(unsigned timeoutInMilliseconds);
+        int PollDescriptor(); // for waiting until Poll() has something to do, see GetHermesDownstreamPollDescriptor
         template<class F> void Post(F&&);
         void Enable(const VerticalServiceSettings&);
 
@@ -250,6 +410,8 @@ namespace Hermes
         void Stop();
 
     private:
+        VerticalService(HermesService*, IVerticalServiceCallback&);
+
         HermesVerticalService* m_pImpl = nullptr;
     };
 
@@ -282,12 +444,23 @@ namespace Hermes
     class VerticalClient
     {
     public:
-        explicit VerticalClient(IVerticalClientCallback&);
+        explicit VerticalClient(IVerticalClientCallback& callback) : VerticalClient(nullptr, callback) {}
+        VerticalClient(SharedService& service, IVerticalClientCallback& callback) : VerticalClient(service.Handle(), callback) {}
         VerticalClient(const VerticalClient&) = delete;
         VerticalClient& operator=(const VerticalClient&) = delete;
         ~VerticalClient() { ::DeleteHermesVerticalClient(m_pImpl); }
 
+        void SetThreadSettings(const ThreadSettings&); // optional, before Run(), see SetHermesDownstreamThreadSettings
+        std::vector<ThreadStatistics> GetThreadStatistics() const;
+        void SetTraceMask(unsigned traceMask); // bits TraceMask(ETraceType), see SetHermesDownstreamTraceMask
+        void UseTraceFile(StringView path, unsigned ringCapacityInBytes, unsigned maxFileSizeInBytes); // see UseHermesDownstreamTraceFile
+        void SetTraceEventCallback(ITraceEventCallback&); // see SetHermesDownstreamTraceEventCallback
+        void EnableLatencyHistograms(); // see EnableHermesDownstreamLatencyHistograms
+        std::vector<LatencyHistogram> GetLatencyHistograms() const; // see GetHermesDownstreamLatencyHistograms
         void Run();
+        unsigned Poll(unsigned maxHandlers = 0U); // instead of Run(), see PollHermesDownstream
+        unsigned RunFor(unsigned timeoutInMilliseconds);
+        int PollDescriptor(); // for waiting until Poll() has something to do, see GetHermesDownstreamPollDescriptor
         template<class F> void Post(F&&);
         void Enable(const VerticalClientSettings&);
 
@@ -308,6 +481,8 @@ namespace Hermes
         void Stop();
 
     private:
+        VerticalClient(HermesService*, IVerticalClientCallback&);
+
         HermesVerticalClient* m_pImpl = nullptr;
     };
 
@@ -390,7 +565,7 @@ namespace Hermes
     };
 
     //======================== Downstream implementation =================================
-    inline Downstream::Downstream(unsigned laneId, IDownstreamCallback& callback)
+    inline Downstream::Downstream(HermesService* pService, unsigned laneId, IDownstreamCallback& callback)
     {
         HermesDownstreamCallbacks callbacks{};
 
@@ -485,7 +660,55 @@ namespace Hermes
             static_cast<IDownstreamCallback*>(pCallback)->OnTrace(sessionId, ToCpp(type), ToCpp(trace));
         };
 
-        m_pImpl = ::CreateHermesDownstream(laneId, &callbacks);
+        m_pImpl = ::CreateHermesDownstreamOnService(pService, laneId, &callbacks);
+    }
+
+    inline void Downstream::UseTaskRing(unsigned capacity)
+    {
+        ::UseHermesDownstreamTaskRing(m_pImpl, capacity);
+    }
+
+    inline void Downstream::UseCallbackQueue(unsigned capacity, ECallbackQueueOverflow overflow)
+    {
+        EHermesCallbackQueueOverflow cOverflow;
+        CppToC(overflow, cOverflow);
+        ::UseHermesDownstreamCallbackQueue(m_pImpl, capacity, cOverflow);
+    }
+
+    inline void Downstream::SetThreadSettings(const ThreadSettings& settings)
+    {
+        const Converter2C<ThreadSettings> converter(settings);
+        ::SetHermesDownstreamThreadSettings(m_pImpl, converter.CPointer());
+    }
+
+    inline std::vector<ThreadStatistics> Downstream::GetThreadStatistics() const
+    {
+        return GetThreadStatistics_(m_pImpl, &::GetHermesDownstreamThreadStatistics);
+    }
+
+    inline void Downstream::SetTraceMask(unsigned traceMask)
+    {
+        ::SetHermesDownstreamTraceMask(m_pImpl, traceMask);
+    }
+
+    inline void Downstream::UseTraceFile(StringView path, unsigned ringCapacityInBytes, unsigned maxFileSizeInBytes)
+    {
+        ::UseHermesDownstreamTraceFile(m_pImpl, ToC(path), ringCapacityInBytes, maxFileSizeInBytes);
+    }
+
+    inline void Downstream::SetTraceEventCallback(ITraceEventCallback& callback)
+    {
+        ::SetHermesDownstreamTraceEventCallback(m_pImpl, TraceEventCallback_(callback));
+    }
+
+    inline void Downstream::EnableLatencyHistograms()
+    {
+        ::EnableHermesDownstreamLatencyHistograms(m_pImpl);
+    }
+
+    inline std::vector<LatencyHistogram> Downstream::GetLatencyHistograms() const
+    {
+        return GetLatencyHistograms_(m_pImpl, &::GetHermesDownstreamLatencyHistograms);
     }
 
     inline void Downstream::Run()
@@ -493,6 +716,21 @@ namespace Hermes
         ::RunHermesDownstream(m_pImpl);
     }
 
+    inline unsigned Downstream::Poll(unsigned maxHandlers)
+    {
+        return ::PollHermesDownstream(m_pImpl, maxHandlers);
+    }
+
+    inline unsigned Downstream::RunFor(unsigned timeoutInMilliseconds)
+    {
+        return ::RunHermesDownstreamFor(m_pImpl, timeoutInMilliseconds);
+    }
+
+    inline int Downstream::PollDescriptor()
+    {
+        return ::GetHermesDownstreamPollDescriptor(m_pImpl);
+    }
+
     template<class F> void Downstream::Post(F&& f)
     {
         HermesVoidCallback callback;
@@ -593,7 +831,7 @@ namespace Hermes
     }
 
     //======================== Upstream implementation =================================
-    inline Upstream::Upstream(unsigned laneId, IUpstreamCallback& callback)
+    inline Upstream::Upstream(HermesService* pService, unsigned laneId, IUpstreamCallback& callback)
     {
         HermesUpstreamCallbacks callbacks{};
 
@@ -688,7 +926,55 @@ namespace Hermes
             static_cast<IUpstreamCallback*>(pCallback)->OnTrace(sessionId, ToCpp(type), ToCpp(trace));
         };
 
-        m_pImpl = ::CreateHermesUpstream(laneId, &callbacks);
+        m_pImpl = ::CreateHermesUpstreamOnService(pService, laneId, &callbacks);
+    }
+
+    inline void Upstream::UseTaskRing(unsigned capacity)
+    {
+        ::UseHermesUpstreamTaskRing(m_pImpl, capacity);
+    }
+
+    inline void Upstream::UseCallbackQueue(unsigned capacity, ECallbackQueueOverflow overflow)
+    {
+        EHermesCallbackQueueOverflow cOverflow;
+        CppToC(overflow, cOverflow);
+        ::UseHermesUpstreamCallbackQueue(m_pImpl, capacity, cOverflow);
+    }
+
+    inline void Upstream::SetThreadSettings(const ThreadSettings& settings)
+    {
+        const Converter2C<ThreadSettings> converter(settings);
+        ::SetHermesUpstreamThreadSettings(m_pImpl, converter.CPointer());
+    }
+
+    inline std::vector<ThreadStatistics> Upstream::GetThreadStatistics() const
+    {
+        return GetThreadStatistics_(m_pImpl, &::GetHermesUpstreamThreadStatistics);
+    }
+
+    inline void Upstream::SetTraceMask(unsigned traceMask)
+    {
+        ::SetHermesUpstreamTraceMask(m_pImpl, traceMask);
+    }
+
+    inline void Upstream::UseTraceFile(StringView path, unsigned ringCapacityInBytes, unsigned maxFileSizeInBytes)
+    {
+        ::UseHermesUpstreamTraceFile(m_pImpl, ToC(path), ringCapacityInBytes, maxFileSizeInBytes);
+    }
+
+    inline void Upstream::SetTraceEventCallback(ITraceEventCallback& callback)
+    {
+        ::SetHermesUpstreamTraceEventCallback(m_pImpl, TraceEventCallback_(callback));
+    }
+
+    inline void Upstream::EnableLatencyHistograms()
+    {
+        ::EnableHermesUpstreamLatencyHistograms(m_pImpl);
+    }
+
+    inline std::vector<LatencyHistogram> Upstream::GetLatencyHistograms() const
+    {
+        return GetLatencyHistograms_(m_pImpl, &::GetHermesUpstreamLatencyHistograms);
     }
 
     inline void Upstream::Run()
@@ -696,6 +982,21 @@ namespace Hermes
         ::RunHermesUpstream(m_pImpl);
     }
 
+    inline unsigned Upstream::Poll(unsigned maxHandlers)
+    {
+        return ::PollHermesUpstream(m_pImpl, maxHandlers);
+    }
+
+    inline unsigned Upstream::RunFor(unsigned timeoutInMilliseconds)
+    {
+        return ::RunHermesUpstreamFor(m_pImpl, timeoutInMilliseconds);
+    }
+
+    inline int Upstream::PollDescriptor()
+    {
+        return ::GetHermesUpstreamPollDescriptor(m_pImpl);
+    }
+
     inline void Upstream::Enable(const UpstreamSettings& data)
     {
         const Converter2C<UpstreamSettings> converter(data);
@@ -796,7 +1097,7 @@ namespace Hermes
     }
 
     //======================== ConfigurationService implementation =================================
-    inline ConfigurationService::ConfigurationService(IConfigurationServiceCallback& callback):
+    inline ConfigurationService::ConfigurationService(HermesService* pService, IConfigurationServiceCallback& callback):
         m_callback(callback)
     {
         HermesConfigurationServiceCallbacks callbacks{};
@@ -843,7 +1144,43 @@ namespace Hermes
             static_cast<ConfigurationService*>(pVoid)->m_callback.OnTrace(sessionId, ToCpp(type), ToCpp(trace));
         };
 
-        m_pImpl = ::CreateHermesConfigurationService(&callbacks);
+        m_pImpl = ::CreateHermesConfigurationServiceOnService(pService, &callbacks);
+    }
+
+    inline void ConfigurationService::SetThreadSettings(const ThreadSettings& settings)
+    {
+        const Converter2C<ThreadSettings> converter(settings);
+        ::SetHermesConfigurationServiceThreadSettings(m_pImpl, converter.CPointer());
+    }
+
+    inline std::vector<ThreadStatistics> ConfigurationService::GetThreadStatistics() const
+    {
+        return GetThreadStatistics_(m_pImpl, &::GetHermesConfigurationServiceThreadStatistics);
+    }
+
+    inline void ConfigurationService::SetTraceMask(unsigned traceMask)
+    {
+        ::SetHermesConfigurationServiceTraceMask(m_pImpl, traceMask);
+    }
+
+    inline void ConfigurationService::UseTraceFile(StringView path, unsigned ringCapacityInBytes, unsigned maxFileSizeInBytes)
+    {
+        ::UseHermesConfigurationServiceTraceFile(m_pImpl, ToC(path), ringCapacityInBytes, maxFileSizeInBytes);
+    }
+
+    inline void ConfigurationService::SetTraceEventCallback(ITraceEventCallback& callback)
+    {
+        ::SetHermesConfigurationServiceTraceEventCallback(m_pImpl, TraceEventCallback_(callback));
+    }
+
+    inline void ConfigurationService::EnableLatencyHistograms()
+    {
+        ::EnableHermesConfigurationServiceLatencyHistograms(m_pImpl);
+    }
+
+    inline std::vector<LatencyHistogram> ConfigurationService::GetLatencyHistograms() const
+    {
+        return GetLatencyHistograms_(m_pImpl, &::GetHermesConfigurationServiceLatencyHistograms);
     }
 
     inline void ConfigurationService::Run()
@@ -851,6 +1188,21 @@ namespace Hermes
         ::RunHermesConfigurationService(m_pImpl);
     }
 
+    inline unsigned ConfigurationService::Poll(unsigned maxHandlers)
+    {
+        return ::PollHermesConfigurationService(m_pImpl, maxHandlers);
+    }
+
+    inline unsigned ConfigurationService::RunFor(unsigned timeoutInMilliseconds)
+    {
+        return ::RunHermesConfigurationServiceFor(m_pImpl, timeoutInMilliseconds);
+    }
+
+    inline int ConfigurationService::PollDescriptor()
+    {
+        return ::GetHermesConfigurationServicePollDescriptor(m_pImpl);
+    }
+
     template<class F> void ConfigurationService::Post(F&& f)
     {
         HermesVoidCallback callback;
@@ -916,7 +1268,7 @@ namespace Hermes
         return{configuration, error};
     }
 
-    inline Error Hermes::SetConfiguration(StringView hostName, const SetConfigurationData& configuration,
+    inline Error SetConfiguration(StringView hostName, const SetConfigurationData& configuration,
         unsigned timeoutInSeconds,
         Hermes::CurrentConfigurationData* out_pConfiguration, // resulting configuration
         std::vector<NotificationData>* out_pNotifications, // out: notification data
@@ -972,7 +1324,7 @@ namespace Hermes
         return error;
     }
 
-    inline  VerticalService::VerticalService(IVerticalServiceCallback& callback)
+    inline  VerticalService::VerticalService(HermesService* pService, IVerticalServiceCallback& callback)
     {
         HermesVerticalServiceCallbacks callbacks{};
 
@@ -1047,12 +1399,70 @@ namespace Hermes
             static_cast<IVerticalServiceCallback*>(pCallback)->OnTrace(sessionId, ToCpp(type), ToCpp(trace));
         };
 
-        m_pImpl = ::CreateHermesVerticalService(&callbacks);
+        m_pImpl = ::CreateHermesVerticalServiceOnService(pService, &callbacks);
+    }
+
+    inline void VerticalService::UseCallbackQueue(unsigned capacity, ECallbackQueueOverflow overflow)
+    {
+        EHermesCallbackQueueOverflow cOverflow;
+        CppToC(overflow, cOverflow);
+        ::UseHermesVerticalServiceCallbackQueue(m_pImpl, capacity, cOverflow);
+    }
+
+    inline void VerticalService::SetThreadSettings(const ThreadSettings& settings)
+    {
+        const Converter2C<ThreadSettings> converter(settings);
+        ::SetHermesVerticalServiceThreadSettings(m_pImpl, converter.CPointer());
+    }
+
+    inline std::vector<ThreadStatistics> VerticalService::GetThreadStatistics() const
+    {
+        return GetThreadStatistics_(m_pImpl, &::GetHermesVerticalServiceThreadStatistics);
+    }
+
+    inline void VerticalService::SetTraceMask(unsigned traceMask)
+    {
+        ::SetHermesVerticalServiceTraceMask(m_pImpl, traceMask);
+    }
+
+    inline void VerticalService::UseTraceFile(StringView path, unsigned ringCapacityInBytes, unsigned maxFileSizeInBytes)
+    {
+        ::UseHermesVerticalServiceTraceFile(m_pImpl, ToC(path), ringCapacityInBytes, maxFileSizeInBytes);
+    }
+
+    inline void VerticalService::SetTraceEventCallback(ITraceEventCallback& callback)
+    {
+        ::SetHermesVerticalServiceTraceEventCallback(m_pImpl, TraceEventCallback_(callback));
+    }
+
+    inline void VerticalService::EnableLatencyHistograms()
+    {
+        ::EnableHermesVerticalServiceLatencyHistograms(m_pImpl);
+    }
+
+    inline std::vector<LatencyHistogram> VerticalService::GetLatencyHistograms() const
+    {
+        return GetLatencyHistograms_(m_pImpl, &::GetHermesVerticalServiceLatencyHistograms);
     }
 
-    inline void VerticalService::Run()
+    inline void VerticalService::Run(unsigned threadCount)
     {
-        ::RunHermesVerticalService(m_pImpl);
+        ::RunHermesVerticalServiceOnThreads(m_pImpl, threadCount);
+    }
+
+    inline unsigned VerticalService::Poll(unsigned maxHandlers)
+    {
+        return ::PollHermesVerticalService(m_pImpl, maxHandlers);
+    }
+
+    inline unsigned VerticalService::RunFor(unsigned timeoutInMilliseconds)
+    {
+        return ::RunHermesVerticalServiceFor(m_pImpl, timeoutInMilliseconds);
+    }
+
+    inline int VerticalService::PollDescriptor()
+    {
+        return ::GetHermesVerticalServicePollDescriptor(m_pImpl);
     }
 
     template<class F> void VerticalService::Post(F&& f)
@@ -1159,7 +1569,7 @@ namespace Hermes
     }
 
     //======================== VerticalClient implementation =================================
-    inline VerticalClient::VerticalClient(IVerticalClientCallback& callback)
+    inline VerticalClient::VerticalClient(HermesService* pService, IVerticalClientCallback& callback)
     {
         HermesVerticalClientCallbacks callbacks{};
 
@@ -1248,7 +1658,43 @@ namespace Hermes
             static_cast<IVerticalClientCallback*>(pCallback)->On(sessionId, ToCpp(*pData));
         };
 
-        m_pImpl = ::CreateHermesVerticalClient(&callbacks);
+        m_pImpl = ::CreateHermesVerticalClientOnService(pService, &callbacks);
+    }
+
+    inline void VerticalClient::SetThreadSettings(const ThreadSettings& settings)
+    {
+        const Converter2C<ThreadSettings> converter(settings);
+        ::SetHermesVerticalClientThreadSettings(m_pImpl, converter.CPointer());
+    }
+
+    inline std::vector<ThreadStatistics> VerticalClient::GetThreadStatistics() const
+    {
+        return GetThreadStatistics_(m_pImpl, &::GetHermesVerticalClientThreadStatistics);
+    }
+
+    inline void VerticalClient::SetTraceMask(unsigned traceMask)
+    {
+        ::SetHermesVerticalClientTraceMask(m_pImpl, traceMask);
+    }
+
+    inline void VerticalClient::UseTraceFile(StringView path, unsigned ringCapacityInBytes, unsigned maxFileSizeInBytes)
+    {
+        ::UseHermesVerticalClientTraceFile(m_pImpl, ToC(path), ringCapacityInBytes, maxFileSizeInBytes);
+    }
+
+    inline void VerticalClient::SetTraceEventCallback(ITraceEventCallback& callback)
+    {
+        ::SetHermesVerticalClientTraceEventCallback(m_pImpl, TraceEventCallback_(callback));
+    }
+
+    inline void VerticalClient::EnableLatencyHistograms()
+    {
+        ::EnableHermesVerticalClientLatencyHistograms(m_pImpl);
+    }
+
+    inline std::vector<LatencyHistogram> VerticalClient::GetLatencyHistograms() const
+    {
+        return GetLatencyHistograms_(m_pImpl, &::GetHermesVerticalClientLatencyHistograms);
     }
 
     inline void VerticalClient::Run()
@@ -1256,6 +1702,21 @@ namespace Hermes
         ::RunHermesVerticalClient(m_pImpl);
     }
 
+    inline unsigned VerticalClient::Poll(unsigned maxHandlers)
+    {
+        return ::PollHermesVerticalClient(m_pImpl, maxHandlers);
+    }
+
+    inline unsigned VerticalClient::RunFor(unsigned timeoutInMilliseconds)
+    {
+        return ::RunHermesVerticalClientFor(m_pImpl, timeoutInMilliseconds);
+    }
+
+    inline int VerticalClient::PollDescriptor()
+    {
+        return ::GetHermesVerticalClientPollDescriptor(m_pImpl);
+    }
+
     template<class F> void VerticalClient::Post(F&& f)
     {
         HermesVoidCallback callback;
@@ -0,0 +1,358 @@
+/***********************************************************************
+Copyright 2018 ASM Assembly Systems GmbH & Co. KG
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+************************************************************************/
+
+// Copyright (c) ASM Assembly Systems GmbH & Co. KG
+#pragma once
+
+// An awaitable layer over the Downstream and Upstream of Hermes.hpp, for C++20 compilers.
+// Instead of spreading a transfer over callbacks, it is written as a coroutine:
+//
+//    Hermes::Coroutine Transfer(Hermes::AwaitingDownstream& downstream, unsigned sessionId)
+//    {
+//        if (!co_await downstream.WaitFor<Hermes::MachineReadyData>(sessionId))
+//            co_return; // disconnected
+//        downstream.Signal(sessionId, Hermes::BoardAvailableData(...));
+//        const auto* pStartTransport = co_await downstream.WaitFor<Hermes::StartTransportData>(sessionId);
+//        ...
+//        const auto* pStopTransport = co_await downstream.TransportFinished(sessionId, Hermes::TransportFinishedData(...));
+//    }
+//
+// The coroutines are resumed from within the callbacks, i.e. on the thread running the instance, without further locking.
+// Hence they must be started on that thread as well, e.g. with Post() or from a callback.
+#include "Hermes.hpp"
+
+#if defined(__cpp_impl_coroutine)
+
+#include <coroutine>
+#include <exception>
+#include <tuple>
+#include <utility>
+#include <vector>
+
+namespace Hermes
+{
+    // The return type of the coroutines: they start right away and clean up after themselves.
+    struct Coroutine
+    {
+        struct promise_type
+        {
+            Coroutine get_return_object() { return {}; }
+            std::suspend_never initial_suspend() noexcept { return {}; }
+            std::suspend_never final_suspend() noexcept { return {}; }
+            void return_void() {}
+            void unhandled_exception() { std::terminate(); }
+        };
+    };
+
+    // The messages of type T, handed to whoever awaits them for the session, or else kept until someone does.
+    // Only the latest one per session is kept: awaiting after two NotificationData have arrived just gets the second one.
+    // What a later message has outdated (e.g. a MachineReady after its RevokeMachineReady) is dropped with Forget().
+    // Awaiting does not allocate: the waiting awaiters are linked in place, within their coroutine frames.
+    // As with the callbacks, the message is not copied: the pointer awaited stays valid until the coroutine awaits again.
+    // It is null if the session has been disconnected meanwhile, see Disconnect().
+    template<class T>
+    class Inbox
+    {
+    public:
+        class Awaiter
+        {
+        public:
+            Awaiter(Inbox& inbox, unsigned sessionId) : m_inbox(inbox), m_sessionId(sessionId) {}
+
+            bool await_ready() { return m_inbox.TakeUnclaimed_(*this); }
+            void await_suspend(std::coroutine_handle<> handle) { m_handle = handle; m_inbox.Enqueue_(*this); }
+            const T* await_resume() { return m_pData; }
+
+        protected:
+            friend class Inbox;
+            Inbox& m_inbox;
+            unsigned m_sessionId; // 0: any session, then set to the session the message came from
+            std::coroutine_handle<> m_handle;
+            const T* m_pData{nullptr};
+            Awaiter* m_pNext{nullptr};
+        };
+
+        Inbox() = default;
+        Inbox(const Inbox&) = delete;
+        Inbox& operator=(const Inbox&) = delete;
+
+        // the coroutines still waiting are destroyed along with the inbox:
+        ~Inbox()
+        {
+            std::vector<std::coroutine_handle<>> handles;
+            for (auto* pWaiter = m_pFirst; pWaiter; pWaiter = pWaiter->m_pNext)
+            {
+                handles.push_back(pWaiter->m_handle);
+            }
+            for (auto handle : handles)
+            {
+                handle.destroy();
+            }
+        }
+
+        Awaiter WaitFor(unsigned sessionId) { return Awaiter(*this, sessionId); }
+
+        void Deliver(unsigned sessionId, const T& data)
+        {
+            for (auto** ppWaiter = &m_pFirst; *ppWaiter; ppWaiter = &(*ppWaiter)->m_pNext)
+            {
+                auto& waiter = **ppWaiter;
+                if (waiter.m_sessionId && waiter.m_sessionId != sessionId)
+                    continue;
+
+                if (m_ppLast == &waiter.m_pNext)
+                {
+                    m_ppLast = ppWaiter;
+                }
+                *ppWaiter = waiter.m_pNext;
+                waiter.m_sessionId = sessionId;
+                waiter.m_pData = &data;
+                waiter.m_handle.resume();
+                return;
+            }
+
+            // nobody waiting yet, so keep it, replacing anything older from the same session:
+            for (auto& entry : m_unclaimed)
+            {
+                if (entry.first != sessionId)
+                    continue;
+                entry.second = data;
+                return;
+            }
+            m_unclaimed.emplace_back(sessionId, data);
+        }
+
+        // drops the unclaimed message of the session, if any:
+        void Forget(unsigned sessionId)
+        {
+            for (auto it = m_unclaimed.begin(); it != m_unclaimed.end(); ++it)
+            {
+                if (it->first != sessionId)
+                    continue;
+                m_unclaimed.erase(it);
+                return;
+            }
+        }
+
+        // forgets the session, resuming whoever awaits it in particular with a null message:
+        void Disconnect(unsigned sessionId)
+        {
+            Forget(sessionId);
+
+            // unlinked first, as the resumed coroutines may well await again:
+            std::vector<std::coroutine_handle<>> handles;
+            for (auto** ppWaiter = &m_pFirst; *ppWaiter;)
+            {
+                auto& waiter = **ppWaiter;
+                if (waiter.m_sessionId != sessionId)
+                {
+                    ppWaiter = &waiter.m_pNext;
+                    continue;
+                }
+
+                if (m_ppLast == &waiter.m_pNext)
+                {
+                    m_ppLast = ppWaiter;
+                }
+                *ppWaiter = waiter.m_pNext;
+                waiter.m_pData = nullptr;
+                handles.push_back(waiter.m_handle);
+            }
+            for (auto handle : handles)
+            {
+                handle.resume();
+            }
+        }
+
+    private:
+        bool TakeUnclaimed_(Awaiter& waiter)
+        {
+            for (auto it = m_unclaimed.begin(); it != m_unclaimed.end(); ++it)
+            {
+                if (waiter.m_sessionId && waiter.m_sessionId != it->first)
+                    continue;
+                waiter.m_sessionId = it->first;
+                m_optionalTaken = std::move(it->second);
+                waiter.m_pData = &*m_optionalTaken;
+                m_unclaimed.erase(it);
+                return true;
+            }
+            return false;
+        }
+
+        void Enqueue_(Awaiter& waiter)
+        {
+            waiter.m_pNext = nullptr;
+            *m_ppLast = &waiter;
+            m_ppLast = &waiter.m_pNext;
+        }
+
+        Awaiter* m_pFirst{nullptr};
+        Awaiter** m_ppLast{&m_pFirst};
+        std::vector<std::pair<unsigned, T>> m_unclaimed;
+        Optional<T> m_optionalTaken; // the last one taken from m_unclaimed
+    };
+
+    template<class... Ts>
+    class Inboxes
+    {
+    public:
+        template<class T>
+        typename Inbox<T>::Awaiter WaitFor(unsigned sessionId) { return std::get<Inbox<T>>(m_inboxes).WaitFor(sessionId); }
+
+        template<class T>
+        void Deliver(unsigned sessionId, const T& data) { std::get<Inbox<T>>(m_inboxes).Deliver(sessionId, data); }
+
+        template<class T>
+        void Forget(unsigned sessionId) { std::get<Inbox<T>>(m_inboxes).Forget(sessionId); }
+
+        void Disconnect(unsigned sessionId) { std::apply([sessionId](auto&... inbox) { (inbox.Disconnect(sessionId), ...); }, m_inboxes); }
+
+    private:
+        std::tuple<Inbox<Ts>...> m_inboxes;
+    };
+
+    // awaits a new connection, resulting in its session id:
+    class ConnectionAwaiter : public Inbox<ConnectionInfo>::Awaiter
+    {
+    public:
+        explicit ConnectionAwaiter(const Inbox<ConnectionInfo>::Awaiter& awaiter) : Inbox<ConnectionInfo>::Awaiter(awaiter) {}
+        unsigned await_resume() { return m_sessionId; }
+    };
+
+    //======================= Downstream =====================================
+    // A Downstream calling back into the awaiting coroutines. Derive to handle OnTrace or anything else as well,
+    // but call the base class, or the coroutines waiting for it never resume:
+    class AwaitingDownstream : public IDownstreamCallback
+    {
+    public:
+        explicit AwaitingDownstream(unsigned laneId) : m_downstream(laneId, *this) {}
+        AwaitingDownstream(SharedService& service, unsigned laneId) : m_downstream(service, laneId, *this) {}
+
+        Downstream& Instance() { return m_downstream; }
+
+        // sessionId 0 takes whichever session comes first:
+        template<class T>
+        typename Inbox<T>::Awaiter WaitFor(unsigned sessionId) { return m_inboxes.WaitFor<T>(sessionId); }
+        ConnectionAwaiter WaitForConnection() { return ConnectionAwaiter(m_inboxes.WaitFor<ConnectionInfo>(0U)); }
+
+        template<class T>
+        void Signal(unsigned sessionId, const T& data) { m_downstream.Signal(sessionId, data); }
+
+        // signals the data and awaits the upstream's StopTransport:
+        typename Inbox<StopTransportData>::Awaiter TransportFinished(unsigned sessionId, const TransportFinishedData& data)
+        {
+            m_downstream.Signal(sessionId, data);
+            return WaitFor<StopTransportData>(sessionId);
+        }
+
+        void OnConnected(unsigned sessionId, EState, const ConnectionInfo& data) override { m_inboxes.Deliver(sessionId, data); }
+        void On(unsigned sessionId, const NotificationData& data) override { m_inboxes.Deliver(sessionId, data); }
+        void On(unsigned sessionId, const CheckAliveData& data) override { m_inboxes.Deliver(sessionId, data); }
+        void On(unsigned sessionId, const CommandData& data) override { m_inboxes.Deliver(sessionId, data); }
+        void OnState(unsigned sessionId, EState state) override { m_inboxes.Deliver(sessionId, state); }
+        void OnDisconnected(unsigned sessionId, EState, const Error& data) override
+        {
+            m_inboxes.Deliver(sessionId, data);
+            m_inboxes.Disconnect(sessionId);
+        }
+
+        void On(unsigned sessionId, EState, const ServiceDescriptionData& data) override { m_inboxes.Deliver(sessionId, data); }
+        // each of these outdates an unclaimed one of the other:
+        void On(unsigned sessionId, EState, const MachineReadyData& data) override
+        {
+            m_inboxes.Forget<RevokeMachineReadyData>(sessionId);
+            m_inboxes.Deliver(sessionId, data);
+        }
+        void On(unsigned sessionId, EState, const RevokeMachineReadyData& data) override
+        {
+            m_inboxes.Forget<MachineReadyData>(sessionId);
+            m_inboxes.Deliver(sessionId, data);
+        }
+        void On(unsigned sessionId, EState, const StartTransportData& data) override { m_inboxes.Deliver(sessionId, data); }
+        void On(unsigned sessionId, EState, const StopTransportData& data) override { m_inboxes.Deliver(sessionId, data); }
+        void On(unsigned sessionId, const QueryBoardInfoData& data) override { m_inboxes.Deliver(sessionId, data); }
+
+        void OnTrace(unsigned, ETraceType, StringView) override {}
+
+    private:
+        // declared first, so that the downstream is gone before any coroutine still waiting is destroyed:
+        Inboxes<ConnectionInfo, NotificationData, CheckAliveData, CommandData, EState, Error, ServiceDescriptionData,
+            MachineReadyData, RevokeMachineReadyData, StartTransportData, StopTransportData, QueryBoardInfoData> m_inboxes;
+        Downstream m_downstream;
+    };
+
+    //======================= Upstream =====================================
+    // see AwaitingDownstream
+    class AwaitingUpstream : public IUpstreamCallback
+    {
+    public:
+        explicit AwaitingUpstream(unsigned laneId) : m_upstream(laneId, *this) {}
+        AwaitingUpstream(SharedService& service, unsigned laneId) : m_upstream(service, laneId, *this) {}
+
+        Upstream& Instance() { return m_upstream; }
+
+        template<class T>
+        typename Inbox<T>::Awaiter WaitFor(unsigned sessionId) { return m_inboxes.WaitFor<T>(sessionId); }
+        ConnectionAwaiter WaitForConnection() { return ConnectionAwaiter(m_inboxes.WaitFor<ConnectionInfo>(0U)); }
+
+        template<class T>
+        void Signal(unsigned sessionId, const T& data) { m_upstream.Signal(sessionId, data); }
+
+        // signals the data and awaits the downstream's TransportFinished:
+        typename Inbox<TransportFinishedData>::Awaiter StartTransport(unsigned sessionId, const StartTransportData& data)
+        {
+            m_upstream.Signal(sessionId, data);
+            return WaitFor<TransportFinishedData>(sessionId);
+        }
+
+        void OnConnected(unsigned sessionId, EState, const ConnectionInfo& data) override { m_inboxes.Deliver(sessionId, data); }
+        void On(unsigned sessionId, const NotificationData& data) override { m_inboxes.Deliver(sessionId, data); }
+        void On(unsigned sessionId, const CheckAliveData& data) override { m_inboxes.Deliver(sessionId, data); }
+        void On(unsigned sessionId, const CommandData& data) override { m_inboxes.Deliver(sessionId, data); }
+        void OnState(unsigned sessionId, EState state) override { m_inboxes.Deliver(sessionId, state); }
+        void OnDisconnected(unsigned sessionId, EState, const Error& data) override
+        {
+            m_inboxes.Deliver(sessionId, data);
+            m_inboxes.Disconnect(sessionId);
+        }
+
+        void On(unsigned sessionId, EState, const ServiceDescriptionData& data) override { m_inboxes.Deliver(sessionId, data); }
+        // each of these outdates an unclaimed one of the other:
+        void On(unsigned sessionId, EState, const BoardAvailableData& data) override
+        {
+            m_inboxes.Forget<RevokeBoardAvailableData>(sessionId);
+            m_inboxes.Deliver(sessionId, data);
+        }
+        void On(unsigned sessionId, EState, const RevokeBoardAvailableData& data) override
+        {
+            m_inboxes.Forget<BoardAvailableData>(sessionId);
+            m_inboxes.Deliver(sessionId, data);
+        }
+        void On(unsigned sessionId, EState, const TransportFinishedData& data) override { m_inboxes.Deliver(sessionId, data); }
+        void On(unsigned sessionId, EState, const BoardForecastData& data) override { m_inboxes.Deliver(sessionId, data); }
+        void On(unsigned sessionId, const SendBoardInfoData& data) override { m_inboxes.Deliver(sessionId, data); }
+
+        void OnTrace(unsigned, ETraceType, StringView) override {}
+
+    private:
+        Inboxes<ConnectionInfo, NotificationData, CheckAliveData, CommandData, EState, Error, ServiceDescriptionData,
+            BoardAvailableData, RevokeBoardAvailableData, TransportFinishedData, BoardForecastData, SendBoardInfoData> m_inboxes;
+        Upstream m_upstream;
+    };
+}
+
+#endif
@@ -168,6 +168,67 @@ enum EHermesCheckAliveResponseMode
     cHERMES_CHECK_ALIVE_RESPONSE_MODE_ENUM_SIZE = 2
 };
 
+/* How to look up the host name of an accepted connection (not part of The Hermes Standard) */
+enum EHermesReverseLookupMode
+{
+    eHERMES_REVERSE_LOOKUP_MODE_ASYNCHRONOUS,
+    eHERMES_REVERSE_LOOKUP_MODE_SKIP,
+    cHERMES_REVERSE_LOOKUP_MODE_ENUM_SIZE = 2
+};
+
+/* Socket tuning profile (not part of The Hermes Standard) */
+enum EHermesSocketProfile
+{
+    eHERMES_SOCKET_PROFILE_LOW_LATENCY,
+    eHERMES_SOCKET_PROFILE_OS_DEFAULT,
+    cHERMES_SOCKET_PROFILE_ENUM_SIZE = 2
+};
+
+/* What to do when the queue of callbacks delivered on their own thread is full (not part of The Hermes Standard) */
+enum EHermesCallbackQueueOverflow
+{
+    eHERMES_CALLBACK_QUEUE_OVERFLOW_WAIT,
+    eHERMES_CALLBACK_QUEUE_OVERFLOW_DISCONNECT,
+    cHERMES_CALLBACK_QUEUE_OVERFLOW_ENUM_SIZE = 2
+};
+
+/* Scheduling policy of the threads running Hermes (not part of The Hermes Standard) */
+enum EHermesThreadScheduling
+{
+    eHERMES_THREAD_SCHEDULING_INHERITED,
+    eHERMES_THREAD_SCHEDULING_OTHER,
+    eHERMES_THREAD_SCHEDULING_FIFO,
+    cHERMES_THREAD_SCHEDULING_ENUM_SIZE = 3
+};
+
+/* Type of a structured trace event (not part of The Hermes Standard) */
+enum EHermesTraceEventType
+{
+    eHERMES_TRACE_EVENT_TYPE_SOCKET_CONNECTED,
+    eHERMES_TRACE_EVENT_TYPE_MESSAGE_RECEIVED,
+    eHERMES_TRACE_EVENT_TYPE_MESSAGE_SENT,
+    eHERMES_TRACE_EVENT_TYPE_STATE_CHANGED,
+    eHERMES_TRACE_EVENT_TYPE_ERROR,
+    eHERMES_TRACE_EVENT_TYPE_HOST_NAME_RESOLVED,
+    eHERMES_TRACE_EVENT_TYPE_SEND_QUEUE_HIGH_WATERMARK,
+    eHERMES_TRACE_EVENT_TYPE_SEND_QUEUE_LOW_WATERMARK,
+    eHERMES_TRACE_EVENT_TYPE_SEND_STATISTICS,
+    cHERMES_TRACE_EVENT_TYPE_ENUM_SIZE = 9
+};
+
+/* Stage of receiving or sending a message, as measured by the latency histograms (not part of The Hermes Standard) */
+enum EHermesLatencyStage
+{
+    eHERMES_LATENCY_STAGE_RECEIVE_PARSE,
+    eHERMES_LATENCY_STAGE_RECEIVE_DESERIALIZE,
+    eHERMES_LATENCY_STAGE_RECEIVE_CALLBACK,
+    eHERMES_LATENCY_STAGE_RECEIVE_TOTAL,
+    eHERMES_LATENCY_STAGE_SEND_QUEUE,
+    eHERMES_LATENCY_STAGE_SEND_SERIALIZE,
+    eHERMES_LATENCY_STAGE_SEND_WRITE,
+    cHERMES_LATENCY_STAGE_ENUM_SIZE = 7
+};
+
 /* Error codes (not part of The Hermes Standard) */
 enum EHermesErrorCode
 {
@@ -708,6 +769,75 @@ struct HermesCommandData
     uint16_t m_command;
 };
 
+/* SocketSettings, TCP options and send queue of the upstream and downstream connections (not part of The Hermes Standard) */
+struct HermesSocketSettings
+{
+    EHermesSocketProfile m_profile;
+    uint32_t m_sendBufferSize; /* 0: OS default */
+    uint32_t m_receiveBufferSize; /* 0: OS default */
+    uint32_t m_keepAliveIdleInSeconds; /* 0: no TCP keepalive */
+    uint32_t m_keepAliveIntervalInSeconds; /* 0: OS default */
+    uint32_t m_keepAliveProbeCount; /* 0: OS default */
+    uint32_t m_sendQueueHighWatermark; /* bytes queued for writing above which SEND_QUEUE_HIGH_WATERMARK is signalled, 0: 1 MiB */
+    uint32_t m_sendQueueLowWatermark; /* bytes queued for writing at which SEND_QUEUE_LOW_WATERMARK is signalled after the high watermark, 0: a quarter of it */
+};
+
+/* ThreadSettings, for the threads running a Hermes instance or a HermesService (not part of The Hermes Standard) */
+struct HermesThreadSettings
+{
+    HermesStringView m_name; /* the thread's index is appended; empty: not named */
+    uint64_t m_cpuMask; /* bit n set: may run on CPU n; 0: not pinned */
+    EHermesThreadScheduling m_scheduling;
+    int32_t m_priority; /* for eHERMES_THREAD_SCHEDULING_FIFO: 1 (lowest) to 99 */
+};
+
+/* ThreadStatistics, what a thread running Hermes has done so far (not part of The Hermes Standard) */
+struct HermesThreadStatistics
+{
+    uint32_t m_threadIndex;
+    uint32_t m_failedSettingCount; /* thread settings that could not be applied, e.g. SCHED_FIFO without the privilege */
+    uint64_t m_handlerCount;
+    uint64_t m_runTimeInMicroseconds; /* since the thread started running */
+    uint64_t m_cpuTimeInMicroseconds; /* out of the run time */
+    uint64_t m_involuntaryContextSwitchCount; /* times the thread was preempted, where available */
+};
+
+/* TraceEvent, a structured alternative to the trace text; the members not concerning its type are zero (not part of The Hermes Standard) */
+struct HermesTraceEvent
+{
+    EHermesTraceEventType m_type;
+    uint32_t m_sessionId;
+    uint32_t m_acceptLatencyInMicroseconds; /* SOCKET_CONNECTED: from accepting the connection to reporting it, 0 for outgoing ones */
+    HermesStringView m_messageTag; /* MESSAGE_RECEIVED, MESSAGE_SENT: e.g. "BoardAvailable" */
+    uint32_t m_sizeInBytes; /* MESSAGE_RECEIVED, MESSAGE_SENT; SEND_QUEUE_HIGH_WATERMARK, SEND_QUEUE_LOW_WATERMARK: the bytes queued for writing */
+    uint32_t m_parseTimeInMicroseconds; /* MESSAGE_RECEIVED: parsing and deserializing the message */
+    uint32_t m_serializeTimeInMicroseconds; /* MESSAGE_SENT: 0 for raw xml */
+    EHermesState m_oldState; /* STATE_CHANGED */
+    EHermesState m_newState; /* STATE_CHANGED */
+    EHermesErrorCode m_errorCode; /* ERROR */
+    HermesStringView m_errorText; /* ERROR */
+    HermesStringView m_hostName; /* HOST_NAME_RESOLVED: of an accepted peer, only known after its connection was reported (see EHermesReverseLookupMode) */
+    uint64_t m_writeCount; /* SEND_STATISTICS: the socket writes so far */
+    uint64_t m_messageCount; /* SEND_STATISTICS: the messages written so far */
+    uint64_t m_byteCount; /* SEND_STATISTICS: the bytes written so far */
+    uint32_t m_maxMessagesPerWrite; /* SEND_STATISTICS: the most messages coalesced into one write */
+};
+
+/* LatencyHistogram, a summary of the latencies of one message type and stage (not part of The Hermes Standard) */
+struct HermesLatencyHistogram
+{
+    HermesStringView m_messageTag; /* empty for messages of unknown type; static, remains valid */
+    EHermesLatencyStage m_stage;
+    uint64_t m_count;
+    uint64_t m_minInNanoseconds;
+    uint64_t m_maxInNanoseconds;
+    uint64_t m_meanInNanoseconds;
+    uint64_t m_p50InNanoseconds; /* the percentiles are upper bounds, within 1/32 of the value */
+    uint64_t m_p90InNanoseconds;
+    uint64_t m_p99InNanoseconds;
+    uint64_t m_p999InNanoseconds;
+};
+
 /* UpstreamSettings, Configuration of upstream interface (not part of The Hermes Standard) */
 struct HermesUpstreamSettings
 {
@@ -718,6 +848,8 @@ struct HermesUpstreamSettings
     double m_reconnectWaitTimeInSeconds;
     EHermesCheckAliveResponseMode m_checkAliveResponseMode;
     EHermesCheckState m_checkState;
+    double m_receiveTimeoutInSeconds; /* 0: no receive timeout */
+    HermesSocketSettings m_socketSettings;
 };
 
 /* DownstreamSettings, Configuration of downstream interface (not part of The Hermes Standard) */
@@ -730,6 +862,9 @@ struct HermesDownstreamSettings
     double m_reconnectWaitTimeInSeconds;
     EHermesCheckAliveResponseMode m_checkAliveResponseMode;
     EHermesCheckState m_checkState;
+    EHermesReverseLookupMode m_reverseLookupMode;
+    double m_receiveTimeoutInSeconds; /* 0: no receive timeout */
+    HermesSocketSettings m_socketSettings;
 };
 
 /* ConfigurationServiceSettings, Configuration of configuration service interface (not part of The Hermes Standard) */
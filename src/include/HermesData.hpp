@@ -307,6 +307,9 @@ S& operator<<(S& s, ETraceType e)
     }
 }
 inline constexpr std::size_t size(ETraceType) { return 6; }
+// the bit of a trace type in the trace mask of an instance, see SetHermesDownstreamTraceMask:
+inline constexpr unsigned TraceMask(ETraceType e) { return 1U << static_cast<unsigned>(e); }
+constexpr unsigned cALL_TRACE_TYPES = (1U << size(ETraceType())) - 1U;
 
 //========== Internal state check modes of the implementation (not part of The Hermes Standard) ==========
 enum class ECheckState
@@ -344,6 +347,140 @@ S& operator<<(S& s, ECheckAliveResponseMode e)
 }
 inline constexpr std::size_t size(ECheckAliveResponseMode) { return 2; }
 
+//========== How to look up the host name of an accepted connection (not part of The Hermes Standard) ==========
+enum class EReverseLookupMode
+{
+    eASYNCHRONOUS, // look up in the background, the connection info gets the host name once it is known (see ETraceEventType::eHOST_NAME_RESOLVED)
+    eSKIP // do not look up, the connection info carries only the address
+};
+template<class S>
+S& operator<<(S& s, EReverseLookupMode e)
+{
+   switch(e)
+   {
+        case EReverseLookupMode::eASYNCHRONOUS: s << "eASYNCHRONOUS"; return s;
+        case EReverseLookupMode::eSKIP: s << "eSKIP"; return s;
+        default: s << "INVALID_REVERSE_LOOKUP_MODE: " << static_cast<int>(e); return s;
+    }
+}
+inline constexpr std::size_t size(EReverseLookupMode) { return 2; }
+
+//========== Socket tuning profile (not part of The Hermes Standard) ==========
+enum class ESocketProfile
+{
+    eLOW_LATENCY, // TCP_NODELAY and, where available, TCP_QUICKACK: no delays on small request/response exchanges
+    eOS_DEFAULT // keep Nagle's algorithm and delayed acknowledgements as configured in the OS
+};
+template<class S>
+S& operator<<(S& s, ESocketProfile e)
+{
+   switch(e)
+   {
+        case ESocketProfile::eLOW_LATENCY: s << "eLOW_LATENCY"; return s;
+        case ESocketProfile::eOS_DEFAULT: s << "eOS_DEFAULT"; return s;
+        default: s << "INVALID_SOCKET_PROFILE: " << static_cast<int>(e); return s;
+    }
+}
+inline constexpr std::size_t size(ESocketProfile) { return 2; }
+
+//========== What to do when the callback queue is full (not part of The Hermes Standard) ==========
+enum class ECallbackQueueOverflow
+{
+    eWAIT, // the network thread waits for the application to catch up; not supported on a shared pool, eDISCONNECT is used there
+    eDISCONNECT // the connection is dropped, so a stalled application cannot hold up the network thread
+};
+template<class S>
+S& operator<<(S& s, ECallbackQueueOverflow e)
+{
+   switch(e)
+   {
+        case ECallbackQueueOverflow::eWAIT: s << "eWAIT"; return s;
+        case ECallbackQueueOverflow::eDISCONNECT: s << "eDISCONNECT"; return s;
+        default: s << "INVALID_CALLBACK_QUEUE_OVERFLOW: " << static_cast<int>(e); return s;
+    }
+}
+inline constexpr std::size_t size(ECallbackQueueOverflow) { return 2; }
+
+//========== Scheduling policy of the threads running Hermes (not part of The Hermes Standard) ==========
+enum class EThreadScheduling
+{
+    eINHERITED, // as inherited from the creating thread
+    eOTHER, // SCHED_OTHER, the OS's time sharing
+    eFIFO // SCHED_FIFO real-time priority; needs the privilege, e.g. CAP_SYS_NICE
+};
+template<class S>
+S& operator<<(S& s, EThreadScheduling e)
+{
+   switch(e)
+   {
+        case EThreadScheduling::eINHERITED: s << "eINHERITED"; return s;
+        case EThreadScheduling::eOTHER: s << "eOTHER"; return s;
+        case EThreadScheduling::eFIFO: s << "eFIFO"; return s;
+        default: s << "INVALID_THREAD_SCHEDULING: " << static_cast<int>(e); return s;
+    }
+}
+inline constexpr std::size_t size(EThreadScheduling) { return 3; }
+
+//========== Type of a structured trace event (not part of The Hermes Standard) ==========
+enum class ETraceEventType
+{
+    eSOCKET_CONNECTED,
+    eMESSAGE_RECEIVED,
+    eMESSAGE_SENT,
+    eSTATE_CHANGED,
+    eERROR,
+    eHOST_NAME_RESOLVED,
+    eSEND_QUEUE_HIGH_WATERMARK,
+    eSEND_QUEUE_LOW_WATERMARK,
+    eSEND_STATISTICS
+};
+template<class S>
+S& operator<<(S& s, ETraceEventType e)
+{
+   switch(e)
+   {
+        case ETraceEventType::eSOCKET_CONNECTED: s << "eSOCKET_CONNECTED"; return s;
+        case ETraceEventType::eMESSAGE_RECEIVED: s << "eMESSAGE_RECEIVED"; return s;
+        case ETraceEventType::eMESSAGE_SENT: s << "eMESSAGE_SENT"; return s;
+        case ETraceEventType::eSTATE_CHANGED: s << "eSTATE_CHANGED"; return s;
+        case ETraceEventType::eERROR: s << "eERROR"; return s;
+        case ETraceEventType::eHOST_NAME_RESOLVED: s << "eHOST_NAME_RESOLVED"; return s;
+        case ETraceEventType::eSEND_QUEUE_HIGH_WATERMARK: s << "eSEND_QUEUE_HIGH_WATERMARK"; return s;
+        case ETraceEventType::eSEND_QUEUE_LOW_WATERMARK: s << "eSEND_QUEUE_LOW_WATERMARK"; return s;
+        case ETraceEventType::eSEND_STATISTICS: s << "eSEND_STATISTICS"; return s;
+        default: s << "INVALID_TRACE_EVENT_TYPE: " << static_cast<int>(e); return s;
+    }
+}
+inline constexpr std::size_t size(ETraceEventType) { return 9; }
+
+//========== Stage of receiving or sending a message, as measured by the latency histograms (not part of The Hermes Standard) ==========
+enum class ELatencyStage
+{
+    eRECEIVE_PARSE, // the xml of a received message
+    eRECEIVE_DESERIALIZE, // from the xml into the data
+    eRECEIVE_CALLBACK, // state machine and callback, or enqueueing it with a callback queue
+    eRECEIVE_TOTAL, // from the receive having completed to the callback having returned
+    eSEND_QUEUE, // from the Signal call to its task running on the service
+    eSEND_SERIALIZE, // from the data into the xml
+    eSEND_WRITE // from queueing the xml on the socket to having written it (TCP only)
+};
+template<class S>
+S& operator<<(S& s, ELatencyStage e)
+{
+   switch(e)
+   {
+        case ELatencyStage::eRECEIVE_PARSE: s << "eRECEIVE_PARSE"; return s;
+        case ELatencyStage::eRECEIVE_DESERIALIZE: s << "eRECEIVE_DESERIALIZE"; return s;
+        case ELatencyStage::eRECEIVE_CALLBACK: s << "eRECEIVE_CALLBACK"; return s;
+        case ELatencyStage::eRECEIVE_TOTAL: s << "eRECEIVE_TOTAL"; return s;
+        case ELatencyStage::eSEND_QUEUE: s << "eSEND_QUEUE"; return s;
+        case ELatencyStage::eSEND_SERIALIZE: s << "eSEND_SERIALIZE"; return s;
+        case ELatencyStage::eSEND_WRITE: s << "eSEND_WRITE"; return s;
+        default: s << "INVALID_LATENCY_STAGE: " << static_cast<int>(e); return s;
+    }
+}
+inline constexpr std::size_t size(ELatencyStage) { return 7; }
+
 //========== Error codes (not part of The Hermes Standard) ==========
 enum class EErrorCode
 {
@@ -598,7 +735,8 @@ struct SubBoard
 
 /* The Hermes Standard 3.6 */
 using SubBoards = std::vector<SubBoard>;
-inline std::ostream& operator<<(std::ostream& s, const SubBoards& data) 
+template<class S>
+S& operator<<(S& s, const SubBoards& data) 
 {
     s << '[';
     if (!data.empty()) { s << ' '; }
@@ -909,7 +1047,8 @@ struct UpstreamConfiguration
 
 /* The Hermes Standard 3.13 */
 using UpstreamConfigurations = std::vector<UpstreamConfiguration>;
-inline std::ostream& operator<<(std::ostream& s, const UpstreamConfigurations& data) 
+template<class S>
+S& operator<<(S& s, const UpstreamConfigurations& data) 
 {
     s << '[';
     if (!data.empty()) { s << ' '; }
@@ -959,7 +1098,8 @@ struct DownstreamConfiguration
 
 /* The Hermes Standard 3.13 */
 using DownstreamConfigurations = std::vector<DownstreamConfiguration>;
-inline std::ostream& operator<<(std::ostream& s, const DownstreamConfigurations& data) 
+template<class S>
+S& operator<<(S& s, const DownstreamConfigurations& data) 
 {
     s << '[';
     if (!data.empty()) { s << ' '; }
@@ -1980,6 +2120,196 @@ struct CommandData
     }
 };
 
+//========== TCP options and send queue of the upstream and downstream connections (not part of The Hermes Standard) ==========
+struct SocketSettings
+{
+    ESocketProfile m_profile{ESocketProfile::eLOW_LATENCY};
+    unsigned m_sendBufferSize{0}; // SO_SNDBUF, 0: OS default
+    unsigned m_receiveBufferSize{0}; // SO_RCVBUF, 0: OS default
+    unsigned m_keepAliveIdleInSeconds{0}; // 0: no TCP keepalive
+    unsigned m_keepAliveIntervalInSeconds{0}; // 0: OS default
+    unsigned m_keepAliveProbeCount{0}; // 0: OS default
+    unsigned m_sendQueueHighWatermark{0}; // bytes queued for writing above which ETraceEventType::eSEND_QUEUE_HIGH_WATERMARK is signalled, 0: 1 MiB
+    unsigned m_sendQueueLowWatermark{0}; // bytes queued for writing at which ETraceEventType::eSEND_QUEUE_LOW_WATERMARK is signalled after the high watermark, 0: a quarter of it
+
+    friend bool operator==(const SocketSettings& lhs, const SocketSettings& rhs)
+    {
+        return lhs.m_profile == rhs.m_profile
+            && lhs.m_sendBufferSize == rhs.m_sendBufferSize
+            && lhs.m_receiveBufferSize == rhs.m_receiveBufferSize
+            && lhs.m_keepAliveIdleInSeconds == rhs.m_keepAliveIdleInSeconds
+            && lhs.m_keepAliveIntervalInSeconds == rhs.m_keepAliveIntervalInSeconds
+            && lhs.m_keepAliveProbeCount == rhs.m_keepAliveProbeCount
+            && lhs.m_sendQueueHighWatermark == rhs.m_sendQueueHighWatermark
+            && lhs.m_sendQueueLowWatermark == rhs.m_sendQueueLowWatermark;
+    }
+    friend bool operator!=(const SocketSettings& lhs, const SocketSettings& rhs) { return !operator==(lhs, rhs); }
+
+    template <class S> friend S& operator<<(S& s, const SocketSettings& data) 
+    {
+        s << '{';
+        s << " Profile=" << data.m_profile;
+        s << " SendBufferSize=" << data.m_sendBufferSize;
+        s << " ReceiveBufferSize=" << data.m_receiveBufferSize;
+        s << " KeepAliveIdle=" << data.m_keepAliveIdleInSeconds;
+        s << " KeepAliveInterval=" << data.m_keepAliveIntervalInSeconds;
+        s << " KeepAliveProbeCount=" << data.m_keepAliveProbeCount;
+        s << " SendQueueHighWatermark=" << data.m_sendQueueHighWatermark;
+        s << " SendQueueLowWatermark=" << data.m_sendQueueLowWatermark;
+        s << " }";
+        return s;
+    }
+};
+
+//========== For the threads running a Hermes instance or a SharedService (not part of The Hermes Standard) ==========
+struct ThreadSettings
+{
+    std::string m_name; // the thread's index is appended, e.g. "Lane1-0"; Linux keeps 15 characters; empty: not named
+    uint64_t m_cpuMask{0}; // bit n set: may run on CPU n; 0: not pinned
+    EThreadScheduling m_scheduling{EThreadScheduling::eINHERITED};
+    int m_priority{0}; // for EThreadScheduling::eFIFO: 1 (lowest) to 99
+
+    friend bool operator==(const ThreadSettings& lhs, const ThreadSettings& rhs)
+    {
+        return lhs.m_name == rhs.m_name
+            && lhs.m_cpuMask == rhs.m_cpuMask
+            && lhs.m_scheduling == rhs.m_scheduling
+            && lhs.m_priority == rhs.m_priority;
+    }
+    friend bool operator!=(const ThreadSettings& lhs, const ThreadSettings& rhs) { return !operator==(lhs, rhs); }
+
+    template <class S> friend S& operator<<(S& s, const ThreadSettings& data) 
+    {
+        s << '{';
+        s << " Name=" << data.m_name;
+        s << " CpuMask=" << data.m_cpuMask;
+        s << " Scheduling=" << data.m_scheduling;
+        s << " Priority=" << data.m_priority;
+        s << " }";
+        return s;
+    }
+};
+
+//========== What a thread running Hermes has done so far (not part of The Hermes Standard) ==========
+// The CPU time against the run time is the thread's utilization; preemptions show other threads getting in its way.
+struct ThreadStatistics
+{
+    unsigned m_threadIndex{0};
+    unsigned m_failedSettingCount{0}; // ThreadSettings that could not be applied
+    uint64_t m_handlerCount{0};
+    uint64_t m_runTimeInMicroseconds{0};
+    uint64_t m_cpuTimeInMicroseconds{0};
+    uint64_t m_involuntaryContextSwitchCount{0}; // where available
+
+    template <class S> friend S& operator<<(S& s, const ThreadStatistics& data) 
+    {
+        s << '{';
+        s << " ThreadIndex=" << data.m_threadIndex;
+        s << " FailedSettingCount=" << data.m_failedSettingCount;
+        s << " HandlerCount=" << data.m_handlerCount;
+        s << " RunTime=" << data.m_runTimeInMicroseconds;
+        s << " CpuTime=" << data.m_cpuTimeInMicroseconds;
+        s << " InvoluntaryContextSwitchCount=" << data.m_involuntaryContextSwitchCount;
+        s << " }";
+        return s;
+    }
+};
+
+//========== A structured alternative to the trace text (not part of The Hermes Standard) ==========
+// Only the members concerning the type are set. The views are only valid during the callback.
+struct TraceEvent
+{
+    ETraceEventType m_type{ETraceEventType::eSOCKET_CONNECTED};
+    unsigned m_sessionId{0};
+    unsigned m_acceptLatencyInMicroseconds{0}; // eSOCKET_CONNECTED: from accepting the connection to reporting it, 0 for outgoing ones
+    StringView m_messageTag; // eMESSAGE_RECEIVED, eMESSAGE_SENT: e.g. "BoardAvailable"
+    unsigned m_sizeInBytes{0}; // eMESSAGE_RECEIVED, eMESSAGE_SENT; eSEND_QUEUE_HIGH_WATERMARK, eSEND_QUEUE_LOW_WATERMARK: the bytes queued for writing
+    unsigned m_parseTimeInMicroseconds{0}; // eMESSAGE_RECEIVED: parsing and deserializing the message
+    unsigned m_serializeTimeInMicroseconds{0}; // eMESSAGE_SENT: 0 for raw xml
+    EState m_oldState{EState::eNOT_CONNECTED}; // eSTATE_CHANGED
+    EState m_newState{EState::eNOT_CONNECTED}; // eSTATE_CHANGED
+    EErrorCode m_errorCode{EErrorCode::eSUCCESS}; // eERROR
+    StringView m_errorText; // eERROR
+    StringView m_hostName; // eHOST_NAME_RESOLVED: of an accepted peer, only known after its connection was reported (see EReverseLookupMode)
+    uint64_t m_writeCount{0}; // eSEND_STATISTICS: the socket writes so far
+    uint64_t m_messageCount{0}; // eSEND_STATISTICS: the messages written so far
+    uint64_t m_byteCount{0}; // eSEND_STATISTICS: the bytes written so far
+    unsigned m_maxMessagesPerWrite{0}; // eSEND_STATISTICS: the most messages coalesced into one write
+
+    template <class S> friend S& operator<<(S& s, const TraceEvent& data) 
+    {
+        s << '{';
+        s << " Type=" << data.m_type;
+        s << " SessionId=" << data.m_sessionId;
+        switch (data.m_type)
+        {
+        case ETraceEventType::eSOCKET_CONNECTED:
+            s << " AcceptLatency=" << data.m_acceptLatencyInMicroseconds;
+            break;
+        case ETraceEventType::eMESSAGE_RECEIVED:
+            s << " MessageTag=" << data.m_messageTag << " Size=" << data.m_sizeInBytes << " ParseTime=" << data.m_parseTimeInMicroseconds;
+            break;
+        case ETraceEventType::eMESSAGE_SENT:
+            s << " MessageTag=" << data.m_messageTag << " Size=" << data.m_sizeInBytes << " SerializeTime=" << data.m_serializeTimeInMicroseconds;
+            break;
+        case ETraceEventType::eSTATE_CHANGED:
+            s << " OldState=" << data.m_oldState << " NewState=" << data.m_newState;
+            break;
+        case ETraceEventType::eERROR:
+            s << " ErrorCode=" << data.m_errorCode << " ErrorText=" << data.m_errorText;
+            break;
+        case ETraceEventType::eHOST_NAME_RESOLVED:
+            s << " HostName=" << data.m_hostName;
+            break;
+        case ETraceEventType::eSEND_QUEUE_HIGH_WATERMARK:
+        case ETraceEventType::eSEND_QUEUE_LOW_WATERMARK:
+            s << " QueuedBytes=" << data.m_sizeInBytes;
+            break;
+        case ETraceEventType::eSEND_STATISTICS:
+            s << " WriteCount=" << data.m_writeCount << " MessageCount=" << data.m_messageCount
+                << " ByteCount=" << data.m_byteCount << " MaxMessagesPerWrite=" << data.m_maxMessagesPerWrite;
+            break;
+        default:
+            break;
+        }
+        s << " }";
+        return s;
+    }
+};
+
+//========== The latencies of one message type and stage (not part of The Hermes Standard) ==========
+// Summarized from a log-linear histogram; the percentiles are upper bounds, within 1/32 of the value.
+struct LatencyHistogram
+{
+    std::string m_messageTag; // empty for messages of unknown type
+    ELatencyStage m_stage{ELatencyStage::eRECEIVE_PARSE};
+    uint64_t m_count{0};
+    uint64_t m_minInNanoseconds{0};
+    uint64_t m_maxInNanoseconds{0};
+    uint64_t m_meanInNanoseconds{0};
+    uint64_t m_p50InNanoseconds{0};
+    uint64_t m_p90InNanoseconds{0};
+    uint64_t m_p99InNanoseconds{0};
+    uint64_t m_p999InNanoseconds{0};
+
+    template <class S> friend S& operator<<(S& s, const LatencyHistogram& data) 
+    {
+        s << '{';
+        s << " MessageTag=" << data.m_messageTag;
+        s << " Stage=" << data.m_stage;
+        s << " Count=" << data.m_count;
+        s << " Min=" << data.m_minInNanoseconds;
+        s << " Max=" << data.m_maxInNanoseconds;
+        s << " Mean=" << data.m_meanInNanoseconds;
+        s << " P50=" << data.m_p50InNanoseconds;
+        s << " P90=" << data.m_p90InNanoseconds;
+        s << " P99=" << data.m_p99InNanoseconds;
+        s << " P999=" << data.m_p999InNanoseconds;
+        s << " }";
+        return s;
+    }
+};
+
 //========== Configuration of upstream interface (not part of The Hermes Standard) ==========
 struct UpstreamSettings
 {
@@ -1990,6 +2320,9 @@ struct UpstreamSettings
     double m_reconnectWaitTimeInSeconds{10};
     ECheckAliveResponseMode m_checkAliveResponseMode{ECheckAliveResponseMode::eAUTO};
     ECheckState m_checkState{ECheckState::eSEND_AND_RECEIVE};
+    // disconnect if nothing has been received for that long (0: never), should exceed the peer's check alive period:
+    double m_receiveTimeoutInSeconds{0};
+    SocketSettings m_socketSettings;
 
     UpstreamSettings() = default;
     UpstreamSettings(StringView machineId,
@@ -2008,7 +2341,9 @@ struct UpstreamSettings
             && lhs.m_checkAlivePeriodInSeconds == rhs.m_checkAlivePeriodInSeconds
             && lhs.m_reconnectWaitTimeInSeconds == rhs.m_reconnectWaitTimeInSeconds
             && lhs.m_checkAliveResponseMode == rhs.m_checkAliveResponseMode
-            && lhs.m_checkState == rhs.m_checkState;
+            && lhs.m_checkState == rhs.m_checkState
+            && lhs.m_receiveTimeoutInSeconds == rhs.m_receiveTimeoutInSeconds
+            && lhs.m_socketSettings == rhs.m_socketSettings;
     }
     friend bool operator!=(const UpstreamSettings& lhs, const UpstreamSettings& rhs) { return !operator==(lhs, rhs); }
 
@@ -2022,6 +2357,8 @@ struct UpstreamSettings
         s << " ReconnectWaitTime=" << data.m_reconnectWaitTimeInSeconds;
         s << " CheckAliveResponseMode=" << data.m_checkAliveResponseMode;
         s << " CheckState=" << data.m_checkState;
+        s << " ReceiveTimeout=" << data.m_receiveTimeoutInSeconds;
+        s << " SocketSettings=" << data.m_socketSettings;
         s << " }";
         return s;
     }
@@ -2037,6 +2374,10 @@ struct DownstreamSettings
     double m_reconnectWaitTimeInSeconds{10};
     ECheckAliveResponseMode m_checkAliveResponseMode{ECheckAliveResponseMode::eAUTO};
     ECheckState m_checkState{ECheckState::eSEND_AND_RECEIVE};
+    EReverseLookupMode m_reverseLookupMode{EReverseLookupMode::eASYNCHRONOUS};
+    // disconnect if nothing has been received for that long (0: never), should exceed the peer's check alive period:
+    double m_receiveTimeoutInSeconds{0};
+    SocketSettings m_socketSettings;
 
     DownstreamSettings() = default;
     DownstreamSettings(StringView machineId,
@@ -2053,7 +2394,10 @@ struct DownstreamSettings
             && lhs.m_checkAlivePeriodInSeconds == rhs.m_checkAlivePeriodInSeconds
             && lhs.m_reconnectWaitTimeInSeconds == rhs.m_reconnectWaitTimeInSeconds
             && lhs.m_checkAliveResponseMode == rhs.m_checkAliveResponseMode
-            && lhs.m_checkState == rhs.m_checkState;
+            && lhs.m_checkState == rhs.m_checkState
+            && lhs.m_reverseLookupMode == rhs.m_reverseLookupMode
+            && lhs.m_receiveTimeoutInSeconds == rhs.m_receiveTimeoutInSeconds
+            && lhs.m_socketSettings == rhs.m_socketSettings;
     }
     friend bool operator!=(const DownstreamSettings& lhs, const DownstreamSettings& rhs) { return !operator==(lhs, rhs); }
 
@@ -2067,6 +2411,9 @@ struct DownstreamSettings
         s << " ReconnectWaitTime=" << data.m_reconnectWaitTimeInSeconds;
         s << " CheckAliveResponseMode=" << data.m_checkAliveResponseMode;
         s << " CheckState=" << data.m_checkState;
+        s << " ReverseLookupMode=" << data.m_reverseLookupMode;
+        s << " ReceiveTimeout=" << data.m_receiveTimeoutInSeconds;
+        s << " SocketSettings=" << data.m_socketSettings;
         s << " }";
         return s;
     }
@@ -50,6 +50,12 @@ namespace Hermes
     inline void CppToC(uint16_t data, uint16_t& result) { result = data; }
     inline void CToCpp(uint16_t data, uint16_t& result) { result = data; }
 
+    inline void CppToC(int data, int32_t& result) { result = data; }
+    inline void CToCpp(int32_t data, int& result) { result = data; }
+
+    inline void CppToC(uint64_t data, uint64_t& result) { result = data; }
+    inline void CToCpp(uint64_t data, uint64_t& result) { result = data; }
+
     template<class CT, class CppT>
     void CToCpp(const CT* pData, CppT& result)
     {
@@ -188,6 +194,30 @@ namespace Hermes
     inline void CppToC(ECheckAliveResponseMode data, EHermesCheckAliveResponseMode& result) { result = static_cast<EHermesCheckAliveResponseMode>(data); }
     inline void CToCpp(EHermesCheckAliveResponseMode data, ECheckAliveResponseMode& result) { result = static_cast<ECheckAliveResponseMode>(data); }
 
+    static_assert(size(EReverseLookupMode()) == cHERMES_REVERSE_LOOKUP_MODE_ENUM_SIZE, "enum mismatch");
+    inline void CppToC(EReverseLookupMode data, EHermesReverseLookupMode& result) { result = static_cast<EHermesReverseLookupMode>(data); }
+    inline void CToCpp(EHermesReverseLookupMode data, EReverseLookupMode& result) { result = static_cast<EReverseLookupMode>(data); }
+
+    static_assert(size(ESocketProfile()) == cHERMES_SOCKET_PROFILE_ENUM_SIZE, "enum mismatch");
+    inline void CppToC(ESocketProfile data, EHermesSocketProfile& result) { result = static_cast<EHermesSocketProfile>(data); }
+    inline void CToCpp(EHermesSocketProfile data, ESocketProfile& result) { result = static_cast<ESocketProfile>(data); }
+
+    static_assert(size(ECallbackQueueOverflow()) == cHERMES_CALLBACK_QUEUE_OVERFLOW_ENUM_SIZE, "enum mismatch");
+    inline void CppToC(ECallbackQueueOverflow data, EHermesCallbackQueueOverflow& result) { result = static_cast<EHermesCallbackQueueOverflow>(data); }
+    inline void CToCpp(EHermesCallbackQueueOverflow data, ECallbackQueueOverflow& result) { result = static_cast<ECallbackQueueOverflow>(data); }
+
+    static_assert(size(EThreadScheduling()) == cHERMES_THREAD_SCHEDULING_ENUM_SIZE, "enum mismatch");
+    inline void CppToC(EThreadScheduling data, EHermesThreadScheduling& result) { result = static_cast<EHermesThreadScheduling>(data); }
+    inline void CToCpp(EHermesThreadScheduling data, EThreadScheduling& result) { result = static_cast<EThreadScheduling>(data); }
+
+    static_assert(size(ETraceEventType()) == cHERMES_TRACE_EVENT_TYPE_ENUM_SIZE, "enum mismatch");
+    inline void CppToC(ETraceEventType data, EHermesTraceEventType& result) { result = static_cast<EHermesTraceEventType>(data); }
+    inline void CToCpp(EHermesTraceEventType data, ETraceEventType& result) { result = static_cast<ETraceEventType>(data); }
+
+    static_assert(size(ELatencyStage()) == cHERMES_LATENCY_STAGE_ENUM_SIZE, "enum mismatch");
+    inline void CppToC(ELatencyStage data, EHermesLatencyStage& result) { result = static_cast<EHermesLatencyStage>(data); }
+    inline void CToCpp(EHermesLatencyStage data, ELatencyStage& result) { result = static_cast<ELatencyStage>(data); }
+
     static_assert(size(EBoardArrivedTransfer()) == cHERMES_BOARD_ARRIVED_TRANSFER_ENUM_SIZE, "enum mismatch");
     inline void CppToC(EBoardArrivedTransfer data, EHermesBoardArrivedTransfer& result) { result = static_cast<EHermesBoardArrivedTransfer>(data); }
     inline void CToCpp(EHermesBoardArrivedTransfer data, EBoardArrivedTransfer& result) { result = static_cast<EBoardArrivedTransfer>(data); }
@@ -1236,6 +1266,127 @@ namespace Hermes
     }
     
 
+    // SocketSettings, plain values embedded in the upstream and downstream settings
+    inline void CppToC(const SocketSettings& data, HermesSocketSettings& result)
+    {
+        CppToC(data.m_profile, result.m_profile);
+        CppToC(data.m_sendBufferSize, result.m_sendBufferSize);
+        CppToC(data.m_receiveBufferSize, result.m_receiveBufferSize);
+        CppToC(data.m_keepAliveIdleInSeconds, result.m_keepAliveIdleInSeconds);
+        CppToC(data.m_keepAliveIntervalInSeconds, result.m_keepAliveIntervalInSeconds);
+        CppToC(data.m_keepAliveProbeCount, result.m_keepAliveProbeCount);
+        CppToC(data.m_sendQueueHighWatermark, result.m_sendQueueHighWatermark);
+        CppToC(data.m_sendQueueLowWatermark, result.m_sendQueueLowWatermark);
+    }
+    inline void CToCpp(const HermesSocketSettings& data, SocketSettings& result)
+    {
+        CToCpp(data.m_profile, result.m_profile);
+        CToCpp(data.m_sendBufferSize, result.m_sendBufferSize);
+        CToCpp(data.m_receiveBufferSize, result.m_receiveBufferSize);
+        CToCpp(data.m_keepAliveIdleInSeconds, result.m_keepAliveIdleInSeconds);
+        CToCpp(data.m_keepAliveIntervalInSeconds, result.m_keepAliveIntervalInSeconds);
+        CToCpp(data.m_keepAliveProbeCount, result.m_keepAliveProbeCount);
+        CToCpp(data.m_sendQueueHighWatermark, result.m_sendQueueHighWatermark);
+        CToCpp(data.m_sendQueueLowWatermark, result.m_sendQueueLowWatermark);
+    }
+
+    // ThreadSettings
+    template<>
+    struct Converter2C<ThreadSettings> : ConverterBase<HermesThreadSettings>
+    {
+        explicit Converter2C(const ThreadSettings& data)
+        {
+            CppToC(data.m_name, m_data.m_name);
+            CppToC(data.m_cpuMask, m_data.m_cpuMask);
+            CppToC(data.m_scheduling, m_data.m_scheduling);
+            CppToC(data.m_priority, m_data.m_priority);
+        }
+    };
+    inline ThreadSettings ToCpp(const HermesThreadSettings& data)
+    {
+        ThreadSettings result;
+        CToCpp(data.m_name, result.m_name);
+        CToCpp(data.m_cpuMask, result.m_cpuMask);
+        CToCpp(data.m_scheduling, result.m_scheduling);
+        CToCpp(data.m_priority, result.m_priority);
+        return result;
+    }
+
+    // ThreadStatistics, plain values
+    inline void CppToC(const ThreadStatistics& data, HermesThreadStatistics& result)
+    {
+        CppToC(data.m_threadIndex, result.m_threadIndex);
+        CppToC(data.m_failedSettingCount, result.m_failedSettingCount);
+        CppToC(data.m_handlerCount, result.m_handlerCount);
+        CppToC(data.m_runTimeInMicroseconds, result.m_runTimeInMicroseconds);
+        CppToC(data.m_cpuTimeInMicroseconds, result.m_cpuTimeInMicroseconds);
+        CppToC(data.m_involuntaryContextSwitchCount, result.m_involuntaryContextSwitchCount);
+    }
+    inline void CToCpp(const HermesThreadStatistics& data, ThreadStatistics& result)
+    {
+        CToCpp(data.m_threadIndex, result.m_threadIndex);
+        CToCpp(data.m_failedSettingCount, result.m_failedSettingCount);
+        CToCpp(data.m_handlerCount, result.m_handlerCount);
+        CToCpp(data.m_runTimeInMicroseconds, result.m_runTimeInMicroseconds);
+        CToCpp(data.m_cpuTimeInMicroseconds, result.m_cpuTimeInMicroseconds);
+        CToCpp(data.m_involuntaryContextSwitchCount, result.m_involuntaryContextSwitchCount);
+    }
+
+    // TraceEvent, plain values and views
+    inline void CppToC(const TraceEvent& data, HermesTraceEvent& result)
+    {
+        CppToC(data.m_type, result.m_type);
+        CppToC(data.m_sessionId, result.m_sessionId);
+        CppToC(data.m_acceptLatencyInMicroseconds, result.m_acceptLatencyInMicroseconds);
+        result.m_messageTag = ToC(data.m_messageTag);
+        CppToC(data.m_sizeInBytes, result.m_sizeInBytes);
+        CppToC(data.m_parseTimeInMicroseconds, result.m_parseTimeInMicroseconds);
+        CppToC(data.m_serializeTimeInMicroseconds, result.m_serializeTimeInMicroseconds);
+        result.m_oldState = ToC(data.m_oldState);
+        result.m_newState = ToC(data.m_newState);
+        CppToC(data.m_errorCode, result.m_errorCode);
+        result.m_errorText = ToC(data.m_errorText);
+        result.m_hostName = ToC(data.m_hostName);
+        CppToC(data.m_writeCount, result.m_writeCount);
+        CppToC(data.m_messageCount, result.m_messageCount);
+        CppToC(data.m_byteCount, result.m_byteCount);
+        CppToC(data.m_maxMessagesPerWrite, result.m_maxMessagesPerWrite);
+    }
+    inline void CToCpp(const HermesTraceEvent& data, TraceEvent& result)
+    {
+        CToCpp(data.m_type, result.m_type);
+        CToCpp(data.m_sessionId, result.m_sessionId);
+        CToCpp(data.m_acceptLatencyInMicroseconds, result.m_acceptLatencyInMicroseconds);
+        result.m_messageTag = ToCpp(data.m_messageTag);
+        CToCpp(data.m_sizeInBytes, result.m_sizeInBytes);
+        CToCpp(data.m_parseTimeInMicroseconds, result.m_parseTimeInMicroseconds);
+        CToCpp(data.m_serializeTimeInMicroseconds, result.m_serializeTimeInMicroseconds);
+        result.m_oldState = ToCpp(data.m_oldState);
+        result.m_newState = ToCpp(data.m_newState);
+        CToCpp(data.m_errorCode, result.m_errorCode);
+        result.m_errorText = ToCpp(data.m_errorText);
+        result.m_hostName = ToCpp(data.m_hostName);
+        CToCpp(data.m_writeCount, result.m_writeCount);
+        CToCpp(data.m_messageCount, result.m_messageCount);
+        CToCpp(data.m_byteCount, result.m_byteCount);
+        CToCpp(data.m_maxMessagesPerWrite, result.m_maxMessagesPerWrite);
+    }
+
+    // LatencyHistogram, plain values; the C tag is only to refer to static storage
+    inline void CToCpp(const HermesLatencyHistogram& data, LatencyHistogram& result)
+    {
+        CToCpp(data.m_messageTag, result.m_messageTag);
+        CToCpp(data.m_stage, result.m_stage);
+        CToCpp(data.m_count, result.m_count);
+        CToCpp(data.m_minInNanoseconds, result.m_minInNanoseconds);
+        CToCpp(data.m_maxInNanoseconds, result.m_maxInNanoseconds);
+        CToCpp(data.m_meanInNanoseconds, result.m_meanInNanoseconds);
+        CToCpp(data.m_p50InNanoseconds, result.m_p50InNanoseconds);
+        CToCpp(data.m_p90InNanoseconds, result.m_p90InNanoseconds);
+        CToCpp(data.m_p99InNanoseconds, result.m_p99InNanoseconds);
+        CToCpp(data.m_p999InNanoseconds, result.m_p999InNanoseconds);
+    }
+
     // UpstreamSettings
     template<>
     struct Converter2C<UpstreamSettings> : ConverterBase<HermesUpstreamSettings>
@@ -1249,6 +1400,8 @@ namespace Hermes
             CppToC(data.m_reconnectWaitTimeInSeconds, m_data.m_reconnectWaitTimeInSeconds);
             CppToC(data.m_checkAliveResponseMode, m_data.m_checkAliveResponseMode);
             CppToC(data.m_checkState, m_data.m_checkState);
+            CppToC(data.m_receiveTimeoutInSeconds, m_data.m_receiveTimeoutInSeconds);
+            CppToC(data.m_socketSettings, m_data.m_socketSettings);
         }
     };
     inline UpstreamSettings ToCpp(const HermesUpstreamSettings& data)
@@ -1261,6 +1414,8 @@ namespace Hermes
         CToCpp(data.m_reconnectWaitTimeInSeconds, result.m_reconnectWaitTimeInSeconds);
         CToCpp(data.m_checkAliveResponseMode, result.m_checkAliveResponseMode);
         CToCpp(data.m_checkState, result.m_checkState);
+        CToCpp(data.m_receiveTimeoutInSeconds, result.m_receiveTimeoutInSeconds);
+        CToCpp(data.m_socketSettings, result.m_socketSettings);
         return result;
     }
 
@@ -1277,6 +1432,9 @@ namespace Hermes
             CppToC(data.m_reconnectWaitTimeInSeconds, m_data.m_reconnectWaitTimeInSeconds);
             CppToC(data.m_checkAliveResponseMode, m_data.m_checkAliveResponseMode);
             CppToC(data.m_checkState, m_data.m_checkState);
+            CppToC(data.m_reverseLookupMode, m_data.m_reverseLookupMode);
+            CppToC(data.m_receiveTimeoutInSeconds, m_data.m_receiveTimeoutInSeconds);
+            CppToC(data.m_socketSettings, m_data.m_socketSettings);
         }
     };
     inline DownstreamSettings ToCpp(const HermesDownstreamSettings& data)
@@ -1289,6 +1447,9 @@ namespace Hermes
         CToCpp(data.m_reconnectWaitTimeInSeconds, result.m_reconnectWaitTimeInSeconds);
         CToCpp(data.m_checkAliveResponseMode, result.m_checkAliveResponseMode);
         CToCpp(data.m_checkState, result.m_checkState);
+        CToCpp(data.m_reverseLookupMode, result.m_reverseLookupMode);
+        CToCpp(data.m_receiveTimeoutInSeconds, result.m_receiveTimeoutInSeconds);
+        CToCpp(data.m_socketSettings, result.m_socketSettings);
         return result;
     }
 
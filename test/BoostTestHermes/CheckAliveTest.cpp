@@ -4,6 +4,14 @@
 #include "Runner.h"
 #include "Sinks.h"
 
+#include <boost/asio.hpp>
+
+#include <chrono>
+#include <ctime>
+#include <memory>
+#include <thread>
+#include <vector>
+
 using namespace Hermes;
 
 BOOST_AUTO_TEST_CASE(AutoCheckAliveResponseTest)
@@ -136,3 +144,101 @@ BOOST_AUTO_TEST_CASE(ApplicationCheckAliveResponseTest)
 
 }
 
+
+BOOST_AUTO_TEST_CASE(ReceiveTimeoutTest)
+{
+    TestCaseScope scope("ReceiveTimeoutTest");
+
+    std::string upstreamMachineId{"UpstreamMachineId"};
+    std::string downstreamMachineId{"DownstreamMachineId"};
+
+    DownstreamSink downstreamSink;
+    Hermes::Downstream downstream(1U, downstreamSink);
+    Runner<Hermes::Downstream> downstreamRunner(downstream);
+
+    UpstreamSink  upstreamSink;
+    Hermes::Upstream upstream(1U, upstreamSink);
+    Runner<Hermes::Upstream> upstreamRunner(upstream);
+
+    // the upstream side stays silent, so the downstream side must give up on its own:
+    DownstreamSettings downstreamSettings{upstreamMachineId, 50101};
+    downstreamSettings.m_checkAlivePeriodInSeconds = 0;
+    downstreamSettings.m_receiveTimeoutInSeconds = 0.5;
+    downstream.Enable(downstreamSettings);
+
+    Hermes::UpstreamSettings upstreamSettings(downstreamMachineId, "127.0.0.1", 50101);
+    upstreamSettings.m_checkAlivePeriodInSeconds = 0;
+    upstream.Enable(upstreamSettings);
+
+    WaitFor(downstreamSink, [&]() { return downstreamSink.m_state == EState::eSOCKET_CONNECTED; });
+    auto connectedTime = std::chrono::steady_clock::now();
+    WaitFor(downstreamSink, [&]() { return downstreamSink.m_state == EState::eDISCONNECTED; });
+    auto disconnectDelay = std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - connectedTime);
+    BOOST_TEST(disconnectDelay.count() >= 400);
+    WaitFor(upstreamSink, [&]() { return upstreamSink.m_state == EState::eDISCONNECTED; });
+}
+
+// Not a test as such: how a vertical service copes with many idle supervisory connections, each with a check alive timer,
+// run explicitly with --run_test=ManyIdleSessionsCheckAliveTest --log_level=message (mind the limit of open files)
+BOOST_AUTO_TEST_CASE(ManyIdleSessionsCheckAliveTest, *boost::unit_test::disabled())
+{
+    TestCaseScope scope("ManyIdleSessionsCheckAliveTest");
+
+    struct QuietVerticalServiceSink : VerticalServiceSink
+    {
+        void OnTrace(unsigned, ETraceType, StringView) override {}
+    };
+
+    const std::size_t cSESSION_COUNT = 10000U;
+    using Clock = std::chrono::steady_clock;
+
+    QuietVerticalServiceSink serviceSink;
+    Hermes::VerticalService verticalService(serviceSink);
+    Runner<Hermes::VerticalService> runner(verticalService);
+    VerticalServiceSettings settings("VerticalServiceId", 50100);
+    settings.m_checkAlivePeriodInSeconds = 1.0;
+    verticalService.Enable(settings);
+    std::this_thread::sleep_for(std::chrono::milliseconds(200));
+
+    // plain sockets, which never say anything:
+    boost::asio::io_context ioContext;
+    std::vector<std::unique_ptr<boost::asio::ip::tcp::socket>> sockets;
+    boost::asio::ip::tcp::endpoint endpoint(boost::asio::ip::make_address("127.0.0.1"), 50100);
+    auto connect = [&](std::size_t sessionCount)
+    {
+        auto start = Clock::now();
+        while (sockets.size() < sessionCount)
+        {
+            auto upSocket = std::make_unique<boost::asio::ip::tcp::socket>(ioContext);
+            boost::system::error_code ec;
+            upSocket->connect(endpoint, ec);
+            if (ec)
+            {
+                BOOST_TEST_MESSAGE("Stopped connecting after " << sockets.size() << " sessions: " << ec.message());
+                break;
+            }
+            sockets.push_back(std::move(upSocket));
+        }
+        WaitFor(serviceSink, [&]() { return serviceSink.m_sessionMap.size() >= sockets.size(); });
+        return std::chrono::duration<double>(Clock::now() - start).count();
+    };
+
+    // now everything happening is checking alive:
+    auto measureIdle = [&](double connectTime)
+    {
+        const auto cIDLE_TIME = std::chrono::seconds(10);
+        auto cpuStart = std::clock();
+        std::this_thread::sleep_for(cIDLE_TIME);
+        double cpuSeconds = static_cast<double>(std::clock() - cpuStart) / CLOCKS_PER_SEC;
+
+        BOOST_TEST_MESSAGE(sockets.size() << " idle sessions connected in " << connectTime << "s"
+            << ", process CPU while idle: " << 100.0 * cpuSeconds / std::chrono::duration<double>(cIDLE_TIME).count() << '%');
+    };
+
+    // a single one, whose timers alone must not keep waking the service:
+    measureIdle(connect(1U));
+    measureIdle(connect(cSESSION_COUNT));
+
+    sockets.clear();
+    verticalService.Disable(NotificationData(ENotificationCode::eMACHINE_SHUTDOWN, ESeverity::eINFO, "Done"));
+}
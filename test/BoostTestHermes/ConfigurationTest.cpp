@@ -21,6 +21,7 @@ limitations under the License.
 #include "Runner.h"
 #include "Trace.h"
 
+#include <condition_variable>
 #include <iostream>
 #include <mutex>
 
@@ -18,9 +18,89 @@ limitations under the License.
 
 #include "Runner.h"
 #include "Sinks.h"
+#include "VirtualConnection.h"
+
+#include <boost/asio.hpp>
+
+#include <algorithm>
+#include <chrono>
+#include <cstddef>
+#include <cstdlib>
+#include <filesystem>
+#include <fstream>
+#include <future>
+#include <new>
+#include <thread>
+#include <vector>
+
+#if defined(__linux__)
+#include <poll.h>
+#endif
 
 using namespace Hermes;
 
+// The global operator new and delete are replaced for the whole test program, so all of their forms are,
+// consistently: each allocation is counted for the calling thread, see DownstreamSignalAllocationTest.
+namespace
+{
+    thread_local std::uint64_t t_heapAllocationCount = 0U;
+
+    void* CountedAllocate(std::size_t size, std::size_t alignment) noexcept
+    {
+        ++t_heapAllocationCount;
+        size = size ? size : 1U;
+        if (alignment <= alignof(std::max_align_t))
+            return std::malloc(size);
+#if defined(_WIN32)
+        return ::_aligned_malloc(size, alignment);
+#else
+        return std::aligned_alloc(alignment, (size + alignment - 1U) / alignment * alignment);
+#endif
+    }
+
+    void* CountedAllocateOrThrow(std::size_t size, std::size_t alignment)
+    {
+        if (void* p = CountedAllocate(size, alignment))
+            return p;
+        throw std::bad_alloc();
+    }
+
+    void CountedDeallocate(void* p, std::size_t alignment) noexcept
+    {
+#if defined(_WIN32)
+        if (alignment > alignof(std::max_align_t))
+            return ::_aligned_free(p);
+#else
+        (void)alignment;
+#endif
+        std::free(p);
+    }
+
+    constexpr std::size_t cDEFAULT_ALIGNMENT = alignof(std::max_align_t);
+}
+
+void* operator new(std::size_t size) { return CountedAllocateOrThrow(size, cDEFAULT_ALIGNMENT); }
+void* operator new[](std::size_t size) { return CountedAllocateOrThrow(size, cDEFAULT_ALIGNMENT); }
+void* operator new(std::size_t size, const std::nothrow_t&) noexcept { return CountedAllocate(size, cDEFAULT_ALIGNMENT); }
+void* operator new[](std::size_t size, const std::nothrow_t&) noexcept { return CountedAllocate(size, cDEFAULT_ALIGNMENT); }
+void* operator new(std::size_t size, std::align_val_t alignment) { return CountedAllocateOrThrow(size, static_cast<std::size_t>(alignment)); }
+void* operator new[](std::size_t size, std::align_val_t alignment) { return CountedAllocateOrThrow(size, static_cast<std::size_t>(alignment)); }
+void* operator new(std::size_t size, std::align_val_t alignment, const std::nothrow_t&) noexcept { return CountedAllocate(size, static_cast<std::size_t>(alignment)); }
+void* operator new[](std::size_t size, std::align_val_t alignment, const std::nothrow_t&) noexcept { return CountedAllocate(size, static_cast<std::size_t>(alignment)); }
+
+void operator delete(void* p) noexcept { CountedDeallocate(p, cDEFAULT_ALIGNMENT); }
+void operator delete[](void* p) noexcept { CountedDeallocate(p, cDEFAULT_ALIGNMENT); }
+void operator delete(void* p, std::size_t) noexcept { CountedDeallocate(p, cDEFAULT_ALIGNMENT); }
+void operator delete[](void* p, std::size_t) noexcept { CountedDeallocate(p, cDEFAULT_ALIGNMENT); }
+void operator delete(void* p, const std::nothrow_t&) noexcept { CountedDeallocate(p, cDEFAULT_ALIGNMENT); }
+void operator delete[](void* p, const std::nothrow_t&) noexcept { CountedDeallocate(p, cDEFAULT_ALIGNMENT); }
+void operator delete(void* p, std::align_val_t alignment) noexcept { CountedDeallocate(p, static_cast<std::size_t>(alignment)); }
+void operator delete[](void* p, std::align_val_t alignment) noexcept { CountedDeallocate(p, static_cast<std::size_t>(alignment)); }
+void operator delete(void* p, std::size_t, std::align_val_t alignment) noexcept { CountedDeallocate(p, static_cast<std::size_t>(alignment)); }
+void operator delete[](void* p, std::size_t, std::align_val_t alignment) noexcept { CountedDeallocate(p, static_cast<std::size_t>(alignment)); }
+void operator delete(void* p, std::align_val_t alignment, const std::nothrow_t&) noexcept { CountedDeallocate(p, static_cast<std::size_t>(alignment)); }
+void operator delete[](void* p, std::align_val_t alignment, const std::nothrow_t&) noexcept { CountedDeallocate(p, static_cast<std::size_t>(alignment)); }
+
 BOOST_AUTO_TEST_CASE(DownstreamPostTest)
 {
     TestCaseScope scope("DownstreamPostTest");
@@ -58,6 +138,652 @@ BOOST_AUTO_TEST_CASE(DownstreamPostTest)
     BOOST_TEST(called2);
 }
 
+BOOST_AUTO_TEST_CASE(DownstreamPollTest)
+{
+    TestCaseScope scope("DownstreamPollTest");
+
+    // the downstream is driven from here, as from an application's event loop, and calls back on this thread:
+    DownstreamSink downstreamSink;
+    Hermes::Downstream downstream(1U, downstreamSink);
+    auto pollUntil = [&](const auto& condition)
+    {
+        auto timeout = std::chrono::steady_clock::now() + std::chrono::seconds(10);
+        while (!condition() && std::chrono::steady_clock::now() < timeout)
+        {
+            downstream.RunFor(10U);
+        }
+        return condition();
+    };
+
+    auto callingThread = std::this_thread::get_id();
+    std::thread::id postedThread;
+    downstream.Post([&]() { postedThread = std::this_thread::get_id(); });
+    BOOST_TEST(downstream.Poll() == 1U);
+    BOOST_TEST((postedThread == callingThread));
+    BOOST_TEST(downstream.Poll() == 0U);
+
+    UpstreamSink upstreamSink;
+    Hermes::Upstream upstream(1U, upstreamSink);
+    Runner<Hermes::Upstream> upstreamRunner(upstream);
+
+    downstream.Enable(Hermes::DownstreamSettings("UpstreamMachineId", 50101));
+    upstream.Enable(Hermes::UpstreamSettings("DownstreamMachineId", "127.0.0.1", 50101));
+    BOOST_TEST(pollUntil([&]() { return downstreamSink.m_state == EState::eSOCKET_CONNECTED; }));
+    WaitFor(upstreamSink, [&]() { return upstreamSink.m_state == EState::eSOCKET_CONNECTED; });
+
+    upstream.Signal(upstreamSink.m_sessionId, Hermes::ServiceDescriptionData("DownstreamMachineId", 1U));
+    BOOST_TEST(pollUntil([&]() { return downstreamSink.m_state == EState::eSERVICE_DESCRIPTION_DOWNSTREAM; }));
+    downstream.Signal(downstreamSink.m_sessionId, Hermes::ServiceDescriptionData("UpstreamMachineId", 1U));
+    BOOST_TEST(pollUntil([&]() { return downstreamSink.m_state == EState::eNOT_AVAILABLE_NOT_READY; }));
+    WaitFor(upstreamSink, [&]() { return upstreamSink.m_state == EState::eNOT_AVAILABLE_NOT_READY; });
+
+    downstream.Stop();
+    downstream.Poll();
+    BOOST_TEST(downstream.Poll() == 0U); // stopped
+}
+
+#if defined(__linux__)
+BOOST_AUTO_TEST_CASE(DownstreamPollDescriptorTest)
+{
+    TestCaseScope scope("DownstreamPollDescriptorTest");
+
+    // as DownstreamPollTest, but only polling once the descriptor says there is something to do:
+    DownstreamSink downstreamSink;
+    Hermes::Downstream downstream(1U, downstreamSink);
+    int descriptor = downstream.PollDescriptor();
+    BOOST_REQUIRE(descriptor >= 0);
+    auto isReadable = [&](int timeoutInMilliseconds)
+    {
+        pollfd entry{descriptor, POLLIN, 0};
+        return ::poll(&entry, 1, timeoutInMilliseconds) == 1;
+    };
+    auto pollUntil = [&](const auto& condition)
+    {
+        for (auto i = 0; i < 100 && !condition(); ++i)
+        {
+            if (isReadable(1000))
+            {
+                downstream.Poll();
+            }
+        }
+        return condition();
+    };
+    downstream.Poll();
+    BOOST_TEST(!isReadable(0));
+
+    // posted from elsewhere:
+    bool posted = false;
+    std::thread([&]() { downstream.Post([&]() { posted = true; }); }).join();
+    BOOST_TEST(pollUntil([&]() { return posted; }));
+    BOOST_TEST(!isReadable(0));
+
+    // the sockets:
+    UpstreamSink upstreamSink;
+    Hermes::Upstream upstream(1U, upstreamSink);
+    Runner<Hermes::Upstream> upstreamRunner(upstream);
+
+    downstream.Enable(Hermes::DownstreamSettings("UpstreamMachineId", 50101));
+    upstream.Enable(Hermes::UpstreamSettings("DownstreamMachineId", "127.0.0.1", 50101));
+    BOOST_TEST(pollUntil([&]() { return downstreamSink.m_state == EState::eSOCKET_CONNECTED; }));
+    WaitFor(upstreamSink, [&]() { return upstreamSink.m_state == EState::eSOCKET_CONNECTED; });
+
+    upstream.Signal(upstreamSink.m_sessionId, Hermes::ServiceDescriptionData("DownstreamMachineId", 1U));
+    BOOST_TEST(pollUntil([&]() { return downstreamSink.m_state == EState::eSERVICE_DESCRIPTION_DOWNSTREAM; }));
+    downstream.Signal(downstreamSink.m_sessionId, Hermes::ServiceDescriptionData("UpstreamMachineId", 1U));
+    BOOST_TEST(pollUntil([&]() { return downstreamSink.m_state == EState::eNOT_AVAILABLE_NOT_READY; }));
+    WaitFor(upstreamSink, [&]() { return upstreamSink.m_state == EState::eNOT_AVAILABLE_NOT_READY; });
+
+    downstream.Stop();
+    downstream.Poll();
+}
+#endif
+
+BOOST_AUTO_TEST_CASE(DownstreamTaskRingPollTest)
+{
+    TestCaseScope scope("DownstreamTaskRingPollTest");
+
+    // the thread posting is the one to poll, so it cannot wait for the ring to make room:
+    DownstreamSink downstreamSink;
+    Hermes::Downstream downstream(1U, downstreamSink);
+    downstream.UseTaskRing(4U);
+
+    std::vector<unsigned> order;
+    for (unsigned i = 0U; i < 100U; ++i)
+    {
+        downstream.Post([&order, i]() { order.push_back(i); });
+    }
+    while (downstream.Poll())
+    {
+    }
+    BOOST_REQUIRE(order.size() == 100U);
+    for (unsigned i = 0U; i < 100U; ++i)
+    {
+        BOOST_TEST(order[i] == i);
+    }
+}
+
+BOOST_AUTO_TEST_CASE(DownstreamThreadStatisticsTest)
+{
+    TestCaseScope scope("DownstreamThreadStatisticsTest");
+
+    DownstreamSink downstreamSink;
+    Hermes::Downstream downstream(1U, downstreamSink);
+    ThreadSettings threadSettings;
+    threadSettings.m_name = "Downstream";
+    downstream.SetThreadSettings(threadSettings);
+    BOOST_TEST(downstream.GetThreadStatistics().empty()); // not running yet
+
+    {
+        Runner<Hermes::Downstream> runner(downstream);
+        for (auto i = 0; i < 10; ++i)
+        {
+            std::promise<void> done;
+            downstream.Post([&done]() { done.set_value(); });
+            done.get_future().wait();
+        }
+
+        const auto statistics = downstream.GetThreadStatistics();
+        BOOST_TEST_REQUIRE(statistics.size() == 1U);
+        BOOST_TEST(statistics[0].m_threadIndex == 0U);
+        BOOST_TEST(statistics[0].m_failedSettingCount == 0U);
+        BOOST_TEST(statistics[0].m_handlerCount >= 10U);
+        BOOST_TEST(statistics[0].m_cpuTimeInMicroseconds <= statistics[0].m_runTimeInMicroseconds);
+    }
+    BOOST_TEST(downstream.GetThreadStatistics().empty());
+
+    // the statistics of a pool list all of its threads, once they have started:
+    Hermes::SharedService service(3U, threadSettings);
+    auto statistics = service.GetThreadStatistics();
+    for (auto i = 0; i < 100 && statistics.size() < 3U; ++i)
+    {
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+        statistics = service.GetThreadStatistics();
+    }
+    BOOST_TEST_REQUIRE(statistics.size() == 3U);
+    std::sort(statistics.begin(), statistics.end(),
+        [](const ThreadStatistics& lhs, const ThreadStatistics& rhs) { return lhs.m_threadIndex < rhs.m_threadIndex; });
+    for (unsigned i = 0U; i < 3U; ++i)
+    {
+        BOOST_TEST(statistics[i].m_threadIndex == i);
+    }
+}
+
+BOOST_AUTO_TEST_CASE(DownstreamTraceMaskTest)
+{
+    TestCaseScope scope("DownstreamTraceMaskTest");
+
+    struct CountingDownstreamSink : DownstreamSink
+    {
+        std::vector<unsigned> m_traceCounts = std::vector<unsigned>(size(ETraceType()));
+        void OnTrace(unsigned sessionId, ETraceType type, StringView trace) override
+        {
+            ++m_traceCounts[static_cast<std::size_t>(type)];
+            DownstreamSink::OnTrace(sessionId, type, trace);
+        }
+    };
+
+    VirtualConnection<CountingDownstreamSink> connection;
+    auto& downstreamSink = connection.m_downstreamSink;
+    connection.m_downstream.SetTraceMask(TraceMask(ETraceType::eWARNING) | TraceMask(ETraceType::eERROR));
+    connection.Connect();
+
+    BOOST_TEST(downstreamSink.m_traceCounts[static_cast<std::size_t>(ETraceType::eSENT)] == 0U);
+    BOOST_TEST(downstreamSink.m_traceCounts[static_cast<std::size_t>(ETraceType::eRECEIVED)] == 0U);
+    BOOST_TEST(downstreamSink.m_traceCounts[static_cast<std::size_t>(ETraceType::eDEBUG)] == 0U);
+    BOOST_TEST(downstreamSink.m_traceCounts[static_cast<std::size_t>(ETraceType::eINFO)] == 0U);
+
+    // back to everything, from now on:
+    connection.m_downstream.SetTraceMask(cALL_TRACE_TYPES);
+    connection.CompleteServiceDescription();
+    BOOST_TEST(downstreamSink.m_traceCounts[static_cast<std::size_t>(ETraceType::eSENT)] == 1U);
+    BOOST_TEST(downstreamSink.m_traceCounts[static_cast<std::size_t>(ETraceType::eDEBUG)] > 0U);
+}
+
+BOOST_AUTO_TEST_CASE(DownstreamTraceEventTest)
+{
+    TestCaseScope scope("DownstreamTraceEventTest");
+
+    struct TraceEventSink : Hermes::ITraceEventCallback
+    {
+        std::vector<TraceEvent> m_events;
+        std::vector<std::string> m_messageTags; // m_events[i].m_messageTag is only valid during the callback
+        void OnTraceEvent(const TraceEvent& event) override
+        {
+            m_events.push_back(event);
+            m_messageTags.push_back(event.m_messageTag);
+        }
+    };
+
+    VirtualConnection<> connection;
+    const auto& downstreamSink = connection.m_downstreamSink;
+    TraceEventSink eventSink;
+    connection.m_downstream.SetTraceEventCallback(eventSink);
+    connection.Handshake();
+
+    const auto find = [&](ETraceEventType type, StringView tag) -> const TraceEvent*
+    {
+        for (std::size_t i = 0U; i < eventSink.m_events.size(); ++i)
+        {
+            if (eventSink.m_events[i].m_type == type && eventSink.m_messageTags[i] == std::string(tag))
+                return &eventSink.m_events[i];
+        }
+        return nullptr;
+    };
+
+    BOOST_TEST(find(ETraceEventType::eSOCKET_CONNECTED, ""));
+    const auto* pReceived = find(ETraceEventType::eMESSAGE_RECEIVED, "ServiceDescription");
+    BOOST_REQUIRE(pReceived);
+    BOOST_TEST(pReceived->m_sessionId == downstreamSink.m_sessionId);
+    BOOST_TEST(pReceived->m_sizeInBytes > 0U);
+    const auto* pSent = find(ETraceEventType::eMESSAGE_SENT, "ServiceDescription");
+    BOOST_REQUIRE(pSent);
+    BOOST_TEST(pSent->m_sizeInBytes > 0U);
+
+    std::vector<EState> newStates;
+    for (const auto& event : eventSink.m_events)
+    {
+        if (event.m_type == ETraceEventType::eSTATE_CHANGED)
+        {
+            newStates.push_back(event.m_newState);
+        }
+    }
+    BOOST_TEST(std::count(newStates.begin(), newStates.end(), EState::eSERVICE_DESCRIPTION_DOWNSTREAM) == 1);
+    BOOST_TEST(std::count(newStates.begin(), newStates.end(), EState::eNOT_AVAILABLE_NOT_READY) == 1);
+    BOOST_TEST(!find(ETraceEventType::eERROR, ""));
+}
+
+BOOST_AUTO_TEST_CASE(DownstreamReverseLookupTest)
+{
+    TestCaseScope scope("DownstreamReverseLookupTest");
+
+    // called on the network thread:
+    struct HostNameSink : Hermes::ITraceEventCallback
+    {
+        Mutex m_mutex;
+        Cv m_cv;
+        bool m_connected{false};
+        unsigned m_acceptLatencyInMicroseconds{0U};
+        std::string m_hostName;
+
+        void OnTraceEvent(const TraceEvent& event) override
+        {
+            ChangeLock lock(this);
+            if (event.m_type == ETraceEventType::eSOCKET_CONNECTED)
+            {
+                m_connected = true;
+                m_acceptLatencyInMicroseconds = event.m_acceptLatencyInMicroseconds;
+            }
+            else if (event.m_type == ETraceEventType::eHOST_NAME_RESOLVED)
+            {
+                m_hostName = event.m_hostName;
+            }
+        }
+    };
+
+    for (auto mode : {EReverseLookupMode::eASYNCHRONOUS, EReverseLookupMode::eSKIP})
+    {
+        DownstreamSink downstreamSink;
+        HostNameSink hostNameSink;
+        Hermes::Downstream downstream(1U, downstreamSink);
+        downstream.SetTraceEventCallback(hostNameSink);
+        Runner<Hermes::Downstream> downstreamRunner(downstream);
+        Hermes::DownstreamSettings downstreamSettings("UpstreamMachineId", 50101);
+        downstreamSettings.m_reverseLookupMode = mode;
+        downstream.Enable(downstreamSettings);
+
+        UpstreamSink upstreamSink;
+        Hermes::Upstream upstream(1U, upstreamSink);
+        Runner<Hermes::Upstream> upstreamRunner(upstream);
+        upstream.Enable(Hermes::UpstreamSettings("DownstreamMachineId", "127.0.0.1", 50101));
+
+        // the connection is reported with the address only, whatever the mode:
+        WaitFor(downstreamSink, [&]() { return downstreamSink.m_state == EState::eSOCKET_CONNECTED; });
+        BOOST_TEST(downstreamSink.m_connectionInfo.m_address == "127.0.0.1");
+        WaitFor(hostNameSink, [&]() { return hostNameSink.m_connected; });
+        BOOST_TEST_MESSAGE(mode << ": accept latency " << hostNameSink.m_acceptLatencyInMicroseconds << "us");
+
+        if (mode == EReverseLookupMode::eASYNCHRONOUS)
+        {
+            WaitFor(hostNameSink, [&]() { return !hostNameSink.m_hostName.empty(); });
+            BOOST_TEST_MESSAGE("Host name resolved later: " << hostNameSink.m_hostName);
+        }
+        else
+        {
+            upstream.Signal(upstreamSink.m_sessionId, Hermes::ServiceDescriptionData("DownstreamMachineId", 1U));
+            WaitFor(downstreamSink, [&]() { return downstreamSink.m_state == EState::eSERVICE_DESCRIPTION_DOWNSTREAM; });
+            std::this_thread::sleep_for(std::chrono::milliseconds(200));
+            Lock lock(hostNameSink.m_mutex);
+            BOOST_TEST(hostNameSink.m_hostName.empty());
+        }
+    }
+}
+
+BOOST_AUTO_TEST_CASE(DownstreamSendQueueWatermarkTest)
+{
+    TestCaseScope scope("DownstreamSendQueueWatermarkTest");
+
+    // called on the network thread:
+    struct WatermarkSink : Hermes::ITraceEventCallback
+    {
+        Mutex m_mutex;
+        Cv m_cv;
+        std::vector<TraceEvent> m_events;
+        std::vector<TraceEvent> m_sendStatistics;
+
+        void OnTraceEvent(const TraceEvent& event) override
+        {
+            if (event.m_type == ETraceEventType::eSEND_STATISTICS)
+            {
+                ChangeLock lock(this);
+                m_sendStatistics.push_back(event);
+                return;
+            }
+            if (event.m_type != ETraceEventType::eSEND_QUEUE_HIGH_WATERMARK && event.m_type != ETraceEventType::eSEND_QUEUE_LOW_WATERMARK)
+                return;
+            ChangeLock lock(this);
+            m_events.push_back(event);
+        }
+    };
+
+    DownstreamSink downstreamSink;
+    WatermarkSink watermarkSink;
+    Hermes::Downstream downstream(1U, downstreamSink);
+    downstream.SetTraceEventCallback(watermarkSink);
+    Runner<Hermes::Downstream> downstreamRunner(downstream);
+    Hermes::DownstreamSettings settings("UpstreamMachineId", 50101);
+    settings.m_socketSettings.m_sendBufferSize = 8U * 1024U;
+    settings.m_socketSettings.m_sendQueueHighWatermark = 64U * 1024U;
+    settings.m_socketSettings.m_sendQueueLowWatermark = 16U * 1024U;
+    downstream.Enable(settings);
+    std::this_thread::sleep_for(std::chrono::milliseconds(200));
+
+    // a plain socket, which does not read for the time being:
+    boost::asio::io_context ioContext;
+    boost::asio::ip::tcp::socket socket(ioContext);
+    socket.open(boost::asio::ip::tcp::v4());
+    socket.set_option(boost::asio::socket_base::receive_buffer_size(8 * 1024));
+    socket.connect(boost::asio::ip::tcp::endpoint(boost::asio::ip::make_address("127.0.0.1"), 50101));
+    WaitFor(downstreamSink, [&]() { return downstreamSink.m_state == EState::eSOCKET_CONNECTED; });
+
+    const std::size_t cMESSAGE_COUNT = 1000U;
+    NotificationData notification(ENotificationCode::eUNSPECIFIC, ESeverity::eINFO, std::string(1024U, 'x'));
+    for (std::size_t i = 0U; i < cMESSAGE_COUNT; ++i)
+    {
+        downstream.Signal(downstreamSink.m_sessionId, notification);
+    }
+    WaitFor(watermarkSink, [&]() { return !watermarkSink.m_events.empty(); });
+
+    // now read until the queue has drained to the low watermark:
+    std::vector<char> buffer(64U * 1024U);
+    for (;;)
+    {
+        {
+            Lock lock(watermarkSink.m_mutex);
+            if (watermarkSink.m_events.size() > 1U)
+                break;
+        }
+        if (socket.available())
+        {
+            socket.read_some(boost::asio::buffer(buffer));
+            continue;
+        }
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+
+    {
+        Lock lock(watermarkSink.m_mutex);
+        BOOST_TEST_REQUIRE(watermarkSink.m_events.size() == 2U);
+        const auto& high = watermarkSink.m_events[0];
+        BOOST_TEST(high.m_type == ETraceEventType::eSEND_QUEUE_HIGH_WATERMARK);
+        BOOST_TEST(high.m_sessionId == downstreamSink.m_sessionId);
+        BOOST_TEST(high.m_sizeInBytes > settings.m_socketSettings.m_sendQueueHighWatermark);
+        const auto& low = watermarkSink.m_events[1];
+        BOOST_TEST(low.m_type == ETraceEventType::eSEND_QUEUE_LOW_WATERMARK);
+        BOOST_TEST(low.m_sessionId == downstreamSink.m_sessionId);
+        BOOST_TEST(low.m_sizeInBytes <= settings.m_socketSettings.m_sendQueueLowWatermark);
+    }
+    BOOST_TEST(downstreamSink.m_state == EState::eSOCKET_CONNECTED);
+
+    socket.close();
+    downstream.Disable(NotificationData(ENotificationCode::eMACHINE_SHUTDOWN, ESeverity::eINFO, "Done"));
+
+    // the closed socket has reported how its messages were coalesced:
+    BOOST_REQUIRE(WaitFor(watermarkSink, [&]() { return !watermarkSink.m_sendStatistics.empty(); }, std::chrono::seconds(10)));
+    Lock lock(watermarkSink.m_mutex);
+    const auto& statistics = watermarkSink.m_sendStatistics.back();
+    BOOST_TEST(statistics.m_sessionId == downstreamSink.m_sessionId);
+    // (the messages still queued at the low watermark may not have been written)
+    BOOST_TEST(statistics.m_messageCount > cMESSAGE_COUNT / 2U);
+    BOOST_TEST(statistics.m_writeCount > 0U);
+    BOOST_TEST(statistics.m_writeCount < statistics.m_messageCount);
+    BOOST_TEST(statistics.m_maxMessagesPerWrite > 1U);
+    BOOST_TEST(statistics.m_byteCount > statistics.m_messageCount * 1024U);
+}
+
+BOOST_AUTO_TEST_CASE(DownstreamLatencyHistogramTest)
+{
+    TestCaseScope scope("DownstreamLatencyHistogramTest");
+
+    VirtualConnection<> connection;
+    connection.m_downstream.EnableLatencyHistograms();
+    BOOST_TEST(connection.m_downstream.GetLatencyHistograms().empty());
+    connection.Handshake();
+
+    const auto histograms = connection.m_downstream.GetLatencyHistograms();
+    const auto find = [&](ELatencyStage stage) -> const LatencyHistogram*
+    {
+        for (const auto& histogram : histograms)
+        {
+            if (histogram.m_stage == stage && histogram.m_messageTag == "ServiceDescription")
+                return &histogram;
+        }
+        return nullptr;
+    };
+
+    // sending over the virtual network does not go through a socket write:
+    for (auto stage : {ELatencyStage::eRECEIVE_PARSE, ELatencyStage::eRECEIVE_DESERIALIZE, ELatencyStage::eRECEIVE_CALLBACK,
+        ELatencyStage::eRECEIVE_TOTAL, ELatencyStage::eSEND_QUEUE, ELatencyStage::eSEND_SERIALIZE})
+    {
+        const auto* pHistogram = find(stage);
+        BOOST_REQUIRE_MESSAGE(pHistogram, stage);
+        BOOST_TEST(pHistogram->m_count == 1U);
+        BOOST_TEST(pHistogram->m_minInNanoseconds == pHistogram->m_maxInNanoseconds);
+        BOOST_TEST(pHistogram->m_p50InNanoseconds == pHistogram->m_maxInNanoseconds);
+        BOOST_TEST(pHistogram->m_p999InNanoseconds == pHistogram->m_maxInNanoseconds);
+    }
+    BOOST_TEST(!find(ELatencyStage::eSEND_WRITE));
+    BOOST_TEST(find(ELatencyStage::eRECEIVE_TOTAL)->m_maxInNanoseconds >= find(ELatencyStage::eRECEIVE_CALLBACK)->m_maxInNanoseconds);
+
+    // the upstream has not enabled them:
+    BOOST_TEST(connection.m_upstream.GetLatencyHistograms().empty());
+}
+
+BOOST_AUTO_TEST_CASE(DownstreamTraceFileTest)
+{
+    TestCaseScope scope("DownstreamTraceFileTest");
+
+    const auto tracePath = (std::filesystem::temp_directory_path() / "DownstreamTraceFileTest.trace").string();
+    const auto textPath = tracePath + ".txt";
+    {
+        VirtualConnection<> connection;
+        connection.m_downstream.UseTraceFile(tracePath, 1U << 16, 1U << 20);
+        connection.Handshake();
+    }
+
+    // the downstream is gone, so the trace file is complete:
+    BOOST_TEST(Hermes::DecodeTraceFile(tracePath, textPath) > 0U);
+    std::ifstream textFile(textPath);
+    std::string text((std::istreambuf_iterator<char>(textFile)), std::istreambuf_iterator<char>());
+    BOOST_TEST(text.find("eSENT") != std::string::npos);
+    BOOST_TEST(text.find("ServiceDescription") != std::string::npos);
+    textFile.close();
+
+    std::filesystem::remove(tracePath);
+    std::filesystem::remove(textPath);
+}
+
+// Not a test as such: the cost per notification sent and received, with tracing on and off,
+// run explicitly with --run_test=DownstreamTraceMaskThroughputTest --log_level=message
+BOOST_AUTO_TEST_CASE(DownstreamTraceMaskThroughputTest, *boost::unit_test::disabled())
+{
+    TestCaseScope scope("DownstreamTraceMaskThroughputTest");
+
+    struct QuietDownstreamSink : DownstreamSink
+    {
+        void OnTrace(unsigned, ETraceType, StringView) override {}
+    };
+    struct QuietUpstreamSink : UpstreamSink
+    {
+        void OnTrace(unsigned, ETraceType, StringView) override {}
+    };
+
+    const unsigned cNOTIFICATIONS = 100000U;
+
+    // on a VirtualService, so that only the work on this thread is measured:
+    VirtualConnection<QuietDownstreamSink, QuietUpstreamSink> connection;
+    connection.Handshake();
+    auto& downstream = connection.m_downstream;
+    auto& upstream = connection.m_upstream;
+
+    const Hermes::NotificationData notification(ENotificationCode::eUNSPECIFIC, ESeverity::eINFO, "Measuring the cost of tracing");
+    for (unsigned traceMask : {cALL_TRACE_TYPES, TraceMask(ETraceType::eWARNING) | TraceMask(ETraceType::eERROR), 0U})
+    {
+        downstream.SetTraceMask(traceMask);
+        upstream.SetTraceMask(traceMask);
+
+        auto start = std::chrono::steady_clock::now();
+        for (unsigned i = 0U; i < cNOTIFICATIONS; ++i)
+        {
+            downstream.Signal(connection.m_downstreamSink.m_sessionId, notification);
+            connection.m_service.Poll();
+        }
+        std::chrono::duration<double, std::micro> duration = std::chrono::steady_clock::now() - start;
+        BOOST_TEST_MESSAGE("traceMask=" << traceMask << ": " << duration.count() / cNOTIFICATIONS << "us per notification");
+    }
+}
+
+BOOST_AUTO_TEST_CASE(DownstreamSignalAllocationTest)
+{
+    TestCaseScope scope("DownstreamSignalAllocationTest");
+
+    DownstreamSink downstreamSink;
+    Hermes::Downstream downstream(1U, downstreamSink);
+    Runner<Hermes::Downstream> runner(downstream);
+
+    // too large to be posted inline:
+    BoardAvailableData boardAvailableData;
+    boardAvailableData.m_optionalProductTypeId = "ProductTypeId";
+    boardAvailableData.m_optionalTopBarcode = "TopBarcode";
+
+    // the heap allocations of this thread while handing the Signal() calls over,
+    // not those of the downstream serializing them (nor those of the test around it).
+    // Only seen where the library shares our operator new, i.e. not with a DLL:
+    auto signalBurst = [&]()
+    {
+        // hold up the downstream, so that each burst queues the same number of tasks:
+        std::promise<void> release;
+        auto released = release.get_future().share();
+        downstream.Post([released]() { released.wait(); });
+        auto heapAllocationCount = t_heapAllocationCount;
+        for (auto i = 0; i < 100; ++i)
+        {
+            downstream.Signal(1U, boardAvailableData); // no such session, so just traced
+        }
+        heapAllocationCount = t_heapAllocationCount - heapAllocationCount;
+        release.set_value();
+
+        std::promise<void> done;
+        downstream.Post([&done]() { done.set_value(); });
+        done.get_future().wait();
+        return heapAllocationCount;
+    };
+
+    // the traces would allocate in the sink:
+    downstream.SetTraceMask(0U);
+
+    // the copy of the data handed over, e.g. the board id being too long for the small string optimization:
+    auto copyAllocationCount = t_heapAllocationCount;
+    {
+        BoardAvailableData copy(boardAvailableData);
+    }
+    copyAllocationCount = t_heapAllocationCount - copyAllocationCount;
+
+    // two bursts, as the task queue swaps its buffers:
+    signalBurst();
+    signalBurst();
+    auto allocationCount = ::GetHermesTaskAllocationCount();
+    BOOST_TEST(signalBurst() <= 100U * copyAllocationCount);
+    BOOST_TEST(signalBurst() <= 100U * copyAllocationCount);
+    BOOST_TEST(::GetHermesTaskAllocationCount() == allocationCount);
+}
+
+// Not a test as such: compares handing Signal() calls over with and without the task ring,
+// run explicitly with --run_test=DownstreamSignalThroughputTest --log_level=message
+BOOST_AUTO_TEST_CASE(DownstreamSignalThroughputTest, *boost::unit_test::disabled())
+{
+    TestCaseScope scope("DownstreamSignalThroughputTest");
+
+    struct QuietDownstreamSink : DownstreamSink
+    {
+        void OnTrace(unsigned, ETraceType, StringView) override {}
+    };
+
+    using Clock = std::chrono::steady_clock;
+    const unsigned cSIGNALS_PER_THREAD = 100000U;
+    const unsigned cSAMPLE_PERIOD = 64U; // every so many signals, the delay until the downstream gets to it is sampled
+
+    for (unsigned ringCapacity : {0U, 4096U})
+    {
+        for (unsigned threadCount : {1U, 4U, 16U})
+        {
+            QuietDownstreamSink downstreamSink;
+            Hermes::Downstream downstream(1U, downstreamSink);
+            if (ringCapacity)
+            {
+                downstream.UseTaskRing(ringCapacity);
+            }
+            Runner<Hermes::Downstream> runner(downstream);
+
+            std::vector<double> delays; // only accessed on the downstream's thread
+            delays.reserve(threadCount * (cSIGNALS_PER_THREAD / cSAMPLE_PERIOD + 1U));
+
+            auto start = Clock::now();
+            std::vector<std::thread> threads;
+            for (unsigned t = 0U; t < threadCount; ++t)
+            {
+                threads.emplace_back([&]()
+                {
+                    for (unsigned i = 0U; i < cSIGNALS_PER_THREAD; ++i)
+                    {
+                        downstream.Signal(1U, RevokeBoardAvailableData()); // no such session, so just traced
+                        if (i % cSAMPLE_PERIOD == 0U)
+                        {
+                            downstream.Post([&delays, posted = Clock::now()]()
+                            {
+                                delays.push_back(std::chrono::duration<double, std::micro>(Clock::now() - posted).count());
+                            });
+                        }
+                    }
+                });
+            }
+            for (auto& thread : threads)
+            {
+                thread.join();
+            }
+            std::promise<void> done;
+            downstream.Post([&done]() { done.set_value(); });
+            done.get_future().wait();
+            std::chrono::duration<double> elapsed = Clock::now() - start;
+
+            std::sort(delays.begin(), delays.end());
+            auto percentile = [&](double p) { return delays[static_cast<std::size_t>(p * (delays.size() - 1U))]; };
+            BOOST_TEST_MESSAGE("ringCapacity=" << ringCapacity << ", threadCount=" << threadCount
+                << ": " << static_cast<unsigned>(threadCount * cSIGNALS_PER_THREAD / elapsed.count()) << " signals/s"
+                << ", delay p50=" << percentile(0.5) << "us, p99=" << percentile(0.99) << "us, p99.9=" << percentile(0.999) << "us");
+        }
+    }
+}
+
 BOOST_AUTO_TEST_CASE(DownstreamTest)
 {
     TestCaseScope scope("DownstreamTest");
@@ -220,6 +946,38 @@ BOOST_AUTO_TEST_CASE(DownstreamAllowedHostTest)
 
 }
 
+BOOST_AUTO_TEST_CASE(DownstreamAllowedNetworkTest)
+{
+    TestCaseScope scope("DownstreamAllowedNetworkTest");
+
+    DownstreamSink downstreamSink;
+    std::string upstreamMachineId{"UpstreamMachineId"};
+    std::string downstreamMachineId{"DownstreamMachineId"};
+
+    Hermes::Downstream downstream(1U, downstreamSink);
+    Runner<Hermes::Downstream> downstreamRunner(downstream);
+    Hermes::DownstreamSettings downstreamConfig(upstreamMachineId, 50101);
+    downstreamConfig.m_optionalClientAddress = "192.0.2.1, 127.0.0.0/8"; // localhost is in the second entry
+
+    downstream.Enable(downstreamConfig);
+
+    {
+        UpstreamSink  upstreamSink;
+        Hermes::Upstream upstream(1U, upstreamSink);
+        Runner<Hermes::Upstream> upstreamRunner(upstream);
+        upstream.Enable(Hermes::UpstreamSettings(upstreamMachineId, "127.0.0.1", 50101));
+
+        WaitFor(downstreamSink, [&]() { return downstreamSink.m_state == EState::eSOCKET_CONNECTED; });
+        WaitFor(upstreamSink, [&]() { return upstreamSink.m_state == EState::eSOCKET_CONNECTED; });
+        upstream.Signal(upstreamSink.m_sessionId, Hermes::ServiceDescriptionData(downstreamMachineId, 1U));
+        WaitFor(downstreamSink, [&]() { return downstreamSink.m_state == EState::eSERVICE_DESCRIPTION_DOWNSTREAM; });
+        downstream.Signal(downstreamSink.m_sessionId, Hermes::ServiceDescriptionData(upstreamMachineId, 1U));
+
+        WaitFor(downstreamSink, [&]() { return downstreamSink.m_state == EState::eNOT_AVAILABLE_NOT_READY; });
+        WaitFor(upstreamSink, [&]() { return upstreamSink.m_state == EState::eNOT_AVAILABLE_NOT_READY; });
+    }
+}
+
 BOOST_AUTO_TEST_CASE(DownstreamHostNotAlloweHostTest)
 {
     TestCaseScope scope("DownstreamHostNotAlloweHostTest");
@@ -315,6 +315,16 @@ BOOST_FUSION_ADAPT_STRUCT(Hermes::ReplyWorkOrderInfoData,
 BOOST_FUSION_ADAPT_STRUCT(Hermes::CommandData,
     m_command
 )
+BOOST_FUSION_ADAPT_STRUCT(Hermes::SocketSettings,
+    m_profile,
+    m_sendBufferSize,
+    m_receiveBufferSize,
+    m_keepAliveIdleInSeconds,
+    m_keepAliveIntervalInSeconds,
+    m_keepAliveProbeCount,
+    m_sendQueueHighWatermark,
+    m_sendQueueLowWatermark
+)
 BOOST_FUSION_ADAPT_STRUCT(Hermes::UpstreamSettings,
     m_machineId,
     m_hostAddress,
@@ -322,7 +332,9 @@ BOOST_FUSION_ADAPT_STRUCT(Hermes::UpstreamSettings,
     m_checkAlivePeriodInSeconds,
     m_reconnectWaitTimeInSeconds,
     m_checkAliveResponseMode,
-    m_checkState
+    m_checkState,
+    m_receiveTimeoutInSeconds,
+    m_socketSettings
 )
 BOOST_FUSION_ADAPT_STRUCT(Hermes::DownstreamSettings,
     m_machineId,
@@ -331,7 +343,10 @@ BOOST_FUSION_ADAPT_STRUCT(Hermes::DownstreamSettings,
     m_checkAlivePeriodInSeconds,
     m_reconnectWaitTimeInSeconds,
     m_checkAliveResponseMode,
-    m_checkState
+    m_checkState,
+    m_reverseLookupMode,
+    m_receiveTimeoutInSeconds,
+    m_socketSettings
 )
 BOOST_FUSION_ADAPT_STRUCT(Hermes::ConfigurationServiceSettings,
     m_port,
@@ -3,9 +3,26 @@
 
 #include <HermesDataConversion.hpp>
 #include "HermesDataGenerators.h"
+#include "../../src/Hermes/StringBuilder.h" // header only, for the trace texts
 
 #include <boost/test/data/test_case.hpp>
 
+#include <cstdint>
+#include <limits>
+#include <sstream>
+#include <string>
+
+namespace
+{
+    template<class T>
+    std::string StreamString(const T& value)
+    {
+        std::ostringstream oss;
+        oss << value;
+        return oss.str();
+    }
+}
+
 BOOST_AUTO_TEST_SUITE(DataTestSuite);
 
 BOOST_AUTO_TEST_CASE_TEMPLATE(HermesDataEqualityTest, T, HermesDataTypes)
@@ -35,6 +52,54 @@ BOOST_AUTO_TEST_CASE_TEMPLATE(HermesCApiTest, T, HermesDataTypes)
     }
 }
 
+// the trace texts are built with a StringWriter, which must give what std::ostream would:
+BOOST_AUTO_TEST_CASE_TEMPLATE(HermesDataBuildStringTest, T, HermesDataTypes)
+{
+    for (const auto& sample : GenerateSamples<T>())
+    {
+        BOOST_TEST(Hermes::BuildString(sample) == StreamString(sample));
+    }
+}
+
+BOOST_AUTO_TEST_CASE(BuildStringTest)
+{
+    using Hermes::BuildString;
+
+    BOOST_TEST(BuildString(0) == StreamString(0));
+    BOOST_TEST(BuildString(-42) == StreamString(-42));
+    BOOST_TEST(BuildString(std::numeric_limits<int>::min()) == StreamString(std::numeric_limits<int>::min()));
+    BOOST_TEST(BuildString(std::numeric_limits<uint64_t>::max()) == StreamString(std::numeric_limits<uint64_t>::max()));
+    BOOST_TEST(BuildString(std::numeric_limits<int64_t>::min()) == StreamString(std::numeric_limits<int64_t>::min()));
+    BOOST_TEST(BuildString(static_cast<unsigned short>(65535U)) == StreamString(static_cast<unsigned short>(65535U)));
+
+    for (double value : {0.0, -0.0, 1.0, -1.5, 0.1, 1.0 / 3.0, 123456789.0, 1e-7, 1e300,
+        std::numeric_limits<double>::max(), std::numeric_limits<double>::min()})
+    {
+        BOOST_TEST(BuildString(value) == StreamString(value));
+    }
+    BOOST_TEST(BuildString(2.5f) == StreamString(2.5f));
+
+    BOOST_TEST(BuildString(true) == StreamString(true));
+    BOOST_TEST(BuildString(false) == StreamString(false));
+    BOOST_TEST(BuildString('x') == StreamString('x'));
+
+    int value = 0;
+    const void* pValue = &value;
+    const void* pNull = nullptr;
+    BOOST_TEST(BuildString(pValue) == StreamString(pValue));
+    BOOST_TEST(BuildString(&value) == StreamString(&value));
+    BOOST_TEST(BuildString(pNull) == StreamString(pNull));
+    BOOST_TEST(BuildString("text") == StreamString("text"));
+
+    BOOST_TEST(BuildString(Hermes::EState::eNOT_AVAILABLE_NOT_READY) == StreamString(Hermes::EState::eNOT_AVAILABLE_NOT_READY));
+    BOOST_TEST(BuildString(static_cast<Hermes::EState>(-1)) == StreamString(static_cast<Hermes::EState>(-1)));
+    BOOST_TEST(BuildString(eHERMES_STATE_DISCONNECTED) == StreamString(eHERMES_STATE_DISCONNECTED));
+
+    // longer than what fits on the stack:
+    const std::string longText(1000U, 'x');
+    BOOST_TEST(BuildString(longText, ':', 17, longText) == StreamString(longText) + ":17" + longText);
+}
+
 BOOST_AUTO_TEST_SUITE_END();
 
 
@@ -4,6 +4,7 @@
 
 #include "Trace.h"
 
+#include <chrono>
 #include <condition_variable>
 #include <iostream>
 #include <mutex>
@@ -31,6 +32,14 @@ namespace
         while (!p())
             host.m_cv.wait(lock);
     }
+
+    // false if p() did not become true in time:
+    template<class HostT, class PredicateT>
+    bool WaitFor(HostT& host, PredicateT p, std::chrono::milliseconds timeout)
+    {
+        Lock lock(host.m_mutex);
+        return host.m_cv.wait_for(lock, timeout, p);
+    }
 }
 
 
@@ -19,6 +19,16 @@ limitations under the License.
 #include "Runner.h"
 #include "Sinks.h"
 
+#include <chrono>
+#include <future>
+#include <memory>
+#include <thread>
+#include <vector>
+
+#if defined(__cpp_impl_coroutine)
+#include <HermesCoroutine.hpp>
+#endif
+
 using namespace Hermes;
 
 
@@ -178,3 +188,659 @@ BOOST_AUTO_TEST_CASE(UpstreamTest)
 
     }
 }
+
+BOOST_AUTO_TEST_CASE(UpstreamReconnectTimeTest)
+{
+    TestCaseScope scope("UpstreamReconnectTimeTest");
+
+    UpstreamSink upstreamSink;
+    std::string downstreamMachineId{"DownstreamMachineId"};
+
+    // the upstream side starts first and keeps failing to connect until the downstream side comes up:
+    Hermes::Upstream upstream(1U, upstreamSink);
+    Runner<Hermes::Upstream> upstreamRunner(upstream);
+    Hermes::UpstreamSettings upstreamSettings(downstreamMachineId, "127.0.0.1", 50101);
+    upstreamSettings.m_reconnectWaitTimeInSeconds = 10.0;
+    upstream.Enable(upstreamSettings);
+
+    std::this_thread::sleep_for(std::chrono::milliseconds(1500));
+
+    DownstreamSink downstreamSink;
+    Hermes::Downstream downstream(1U, downstreamSink);
+    Runner<Hermes::Downstream> downstreamRunner(downstream);
+    auto listenTime = std::chrono::steady_clock::now();
+    downstream.Enable(Hermes::DownstreamSettings(downstreamMachineId, 50101));
+
+    WaitFor(upstreamSink, [&]() { return upstreamSink.m_state == EState::eSOCKET_CONNECTED; });
+    auto reconnectTime = std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - listenTime);
+    BOOST_TEST_MESSAGE("Time to reconnect: " << reconnectTime.count() << "ms");
+
+    // backing off from an immediate retry must beat the fixed reconnect wait time by far:
+    BOOST_TEST(reconnectTime.count() < 5000);
+}
+
+BOOST_AUTO_TEST_CASE(UpstreamReceiveTest)
+{
+    TestCaseScope scope("UpstreamReceiveTest");
+
+    struct NotificationSink : UpstreamSink
+    {
+        std::vector<std::string> m_descriptions;
+
+        void On(unsigned sessionId, const Hermes::NotificationData& data) override
+        {
+            ChangeLock lock(this);
+            m_sessionId = sessionId;
+            m_descriptions.push_back(data.m_description);
+        }
+    };
+
+    NotificationSink upstreamSink;
+    std::string upstreamMachineId{"UpstreamMachineId"};
+    std::string downstreamMachineId{"DownstreamMachineId"};
+
+    Hermes::Upstream upstream(1U, upstreamSink);
+    Runner<Hermes::Upstream> upstreamRunner(upstream);
+    upstream.Enable(Hermes::UpstreamSettings(downstreamMachineId, "127.0.0.1", 50101));
+
+    DownstreamSink downstreamSink;
+    Hermes::Downstream downstream(1U, downstreamSink);
+    Runner<Hermes::Downstream> downstreamRunner(downstream);
+    downstream.Enable(Hermes::DownstreamSettings(downstreamMachineId, 50101));
+
+    const std::chrono::seconds cTIMEOUT{10};
+    BOOST_REQUIRE(WaitFor(upstreamSink, [&]() { return upstreamSink.m_state == EState::eSOCKET_CONNECTED; }, cTIMEOUT));
+    upstream.Signal(upstreamSink.m_sessionId, Hermes::ServiceDescriptionData(downstreamMachineId, 1U));
+    BOOST_REQUIRE(WaitFor(downstreamSink, [&]() { return downstreamSink.m_state == EState::eSERVICE_DESCRIPTION_DOWNSTREAM; }, cTIMEOUT));
+    downstream.Signal(downstreamSink.m_sessionId, Hermes::ServiceDescriptionData(upstreamMachineId, 1U));
+    BOOST_REQUIRE(WaitFor(upstreamSink, [&]() { return upstreamSink.m_state == EState::eNOT_AVAILABLE_NOT_READY; }, cTIMEOUT));
+
+    // the socket receives straight into the buffer the messages are parsed from, offering more space while it fills up
+    // and less once the traffic calms down: messages taking several receives and bursts of small ones must arrive intact,
+    // whichever way they are split up. Staying below cMAX_MESSAGE_SIZE, larger ones would be rejected:
+    std::vector<std::string> descriptions;
+    for (std::size_t round = 0U; round < 3U; ++round)
+    {
+        descriptions.push_back(std::string(60U * 1024U, static_cast<char>('a' + round)));
+        for (std::size_t i = 0U; i < 100U; ++i)
+        {
+            descriptions.push_back(std::to_string(round) + '.' + std::to_string(i));
+        }
+    }
+    for (const auto& description : descriptions)
+    {
+        downstream.Signal(downstreamSink.m_sessionId, NotificationData(ENotificationCode::eUNSPECIFIC, ESeverity::eINFO, description));
+    }
+    BOOST_REQUIRE(WaitFor(upstreamSink, [&]() { return upstreamSink.m_descriptions.size() >= descriptions.size(); }, cTIMEOUT));
+    {
+        Lock lock(upstreamSink.m_mutex);
+        BOOST_TEST(upstreamSink.m_descriptions == descriptions);
+    }
+
+    // and after an idle while, a single message again:
+    std::this_thread::sleep_for(std::chrono::milliseconds(100));
+    downstream.Signal(downstreamSink.m_sessionId, NotificationData(ENotificationCode::eUNSPECIFIC, ESeverity::eINFO, "last"));
+    BOOST_REQUIRE(WaitFor(upstreamSink, [&]() { return upstreamSink.m_descriptions.size() > descriptions.size(); }, cTIMEOUT));
+    Lock lock(upstreamSink.m_mutex);
+    BOOST_TEST(upstreamSink.m_descriptions.back() == "last");
+}
+
+BOOST_AUTO_TEST_CASE(SharedServiceTest)
+{
+    TestCaseScope scope("SharedServiceTest");
+
+    std::string upstreamMachineId{"UpstreamMachineId"};
+    std::string downstreamMachineId{"DownstreamMachineId"};
+
+    // no runners needed, the shared service's threads do the work; it must outlive the instances:
+    Hermes::SharedService service(2U);
+
+    UpstreamSink upstreamSink;
+    Hermes::Upstream upstream(service, 1U, upstreamSink);
+    upstream.Enable(Hermes::UpstreamSettings(downstreamMachineId, "localhost", 50101));
+
+    for (auto i = 0; i < 3; ++i)
+    {
+        DownstreamSink downstreamSink;
+        Hermes::Downstream downstream(service, 1U, downstreamSink);
+        downstream.Enable(Hermes::DownstreamSettings(downstreamMachineId, 50101));
+
+        WaitFor(downstreamSink, [&]() { return downstreamSink.m_state == EState::eSOCKET_CONNECTED; });
+        WaitFor(upstreamSink, [&]() { return upstreamSink.m_state == EState::eSOCKET_CONNECTED; });
+        upstream.Signal(upstreamSink.m_sessionId, Hermes::ServiceDescriptionData(downstreamMachineId, 1U));
+        WaitFor(downstreamSink, [&]() { return downstreamSink.m_state == EState::eSERVICE_DESCRIPTION_DOWNSTREAM; });
+        downstream.Signal(downstreamSink.m_sessionId, Hermes::ServiceDescriptionData(upstreamMachineId, 1U));
+        WaitFor(downstreamSink, [&]() { return downstreamSink.m_state == EState::eNOT_AVAILABLE_NOT_READY; });
+        WaitFor(upstreamSink, [&]() { return upstreamSink.m_state == EState::eNOT_AVAILABLE_NOT_READY; });
+    }
+}
+
+BOOST_AUTO_TEST_CASE(SharedServiceDeleteInCallbackTest)
+{
+    TestCaseScope scope("SharedServiceDeleteInCallbackTest");
+
+    std::string downstreamMachineId{"DownstreamMachineId"};
+
+    // with a single thread, waiting for the deletion on the strand of the other instance would never end:
+    Hermes::SharedService service(1U);
+
+    DownstreamSink otherSink;
+    auto upOther = std::make_unique<Hermes::Downstream>(service, 2U, otherSink);
+    upOther->Enable(Hermes::DownstreamSettings(downstreamMachineId, 50102));
+
+    struct DeletingSink : UpstreamSink
+    {
+        std::unique_ptr<Hermes::Downstream>* m_pupOther{nullptr};
+
+        void OnConnected(unsigned sessionId, EState state, const Hermes::ConnectionInfo& connectionInfo) override
+        {
+            m_pupOther->reset();
+            UpstreamSink::OnConnected(sessionId, state, connectionInfo);
+        }
+    };
+    DeletingSink upstreamSink;
+    upstreamSink.m_pupOther = &upOther;
+    Hermes::Upstream upstream(service, 1U, upstreamSink);
+    upstream.Enable(Hermes::UpstreamSettings(downstreamMachineId, "localhost", 50101));
+
+    DownstreamSink downstreamSink;
+    Hermes::Downstream downstream(service, 1U, downstreamSink);
+    downstream.Enable(Hermes::DownstreamSettings(downstreamMachineId, 50101));
+
+    WaitFor(upstreamSink, [&]() { return upstreamSink.m_state == EState::eSOCKET_CONNECTED; });
+    BOOST_TEST(!upOther);
+
+    // the pool's thread is still serving the others:
+    upstream.Signal(upstreamSink.m_sessionId, Hermes::ServiceDescriptionData(downstreamMachineId, 1U));
+    WaitFor(downstreamSink, [&]() { return downstreamSink.m_state == EState::eSERVICE_DESCRIPTION_DOWNSTREAM; });
+}
+
+BOOST_AUTO_TEST_CASE(VirtualServiceTest)
+{
+    TestCaseScope scope("VirtualServiceTest");
+
+    std::string upstreamMachineId{"UpstreamMachineId"};
+    std::string downstreamMachineId{"DownstreamMachineId"};
+
+    // the scenario of UpstreamReconnectTimeTest, but on the virtual clock, so it takes no real time and gives the same result each run:
+    auto reconnect = [&]()
+    {
+        Hermes::VirtualService service;
+
+        UpstreamSink upstreamSink;
+        Hermes::Upstream upstream(service, 1U, upstreamSink);
+        Hermes::UpstreamSettings upstreamSettings(downstreamMachineId, "127.0.0.1", 50101);
+        upstreamSettings.m_reconnectWaitTimeInSeconds = 10.0;
+        upstream.Enable(upstreamSettings);
+        service.Advance(1500U);
+        BOOST_TEST(upstreamSink.m_state == EState::eNOT_CONNECTED);
+
+        DownstreamSink downstreamSink;
+        Hermes::Downstream downstream(service, 1U, downstreamSink);
+        downstream.Enable(Hermes::DownstreamSettings(downstreamMachineId, 50101));
+
+        unsigned reconnectTime = 0U;
+        for (; upstreamSink.m_state != EState::eSOCKET_CONNECTED && reconnectTime < 60000U; reconnectTime += 25U)
+        {
+            service.Advance(25U);
+        }
+        BOOST_TEST(reconnectTime < 5000U);
+
+        upstream.Signal(upstreamSink.m_sessionId, Hermes::ServiceDescriptionData(downstreamMachineId, 1U));
+        service.Poll();
+        BOOST_TEST(downstreamSink.m_state == EState::eSERVICE_DESCRIPTION_DOWNSTREAM);
+        downstream.Signal(downstreamSink.m_sessionId, Hermes::ServiceDescriptionData(upstreamMachineId, 1U));
+        service.Poll();
+        BOOST_TEST(downstreamSink.m_state == EState::eNOT_AVAILABLE_NOT_READY);
+        BOOST_TEST(upstreamSink.m_state == EState::eNOT_AVAILABLE_NOT_READY);
+        return reconnectTime;
+    };
+
+    auto reconnectTime = reconnect();
+    BOOST_TEST_MESSAGE("Virtual time to reconnect: " << reconnectTime << "ms");
+    BOOST_TEST(reconnect() == reconnectTime);
+}
+
+BOOST_AUTO_TEST_CASE(UpstreamPeerRestartTest)
+{
+    TestCaseScope scope("UpstreamPeerRestartTest");
+
+    std::string upstreamMachineId{"UpstreamMachineId"};
+    std::string downstreamMachineId{"DownstreamMachineId"};
+
+    Hermes::VirtualService service;
+
+    UpstreamSink upstreamSink;
+    Hermes::Upstream upstream(service, 1U, upstreamSink);
+    Hermes::UpstreamSettings upstreamSettings(downstreamMachineId, "127.0.0.1", 50101);
+    upstreamSettings.m_reconnectWaitTimeInSeconds = 10.0;
+    upstream.Enable(upstreamSettings);
+
+    // the peer goes away once after the handshake and once before, then is back 1.5s later:
+    for (bool handshake : {true, false, true})
+    {
+        unsigned connectTime = 0U;
+        {
+            DownstreamSink downstreamSink;
+            Hermes::Downstream downstream(service, 1U, downstreamSink);
+            downstream.Enable(Hermes::DownstreamSettings(downstreamMachineId, 50101));
+
+            for (; upstreamSink.m_state != EState::eSOCKET_CONNECTED && connectTime < 60000U; connectTime += 25U)
+            {
+                service.Advance(25U);
+            }
+            BOOST_TEST_MESSAGE("Virtual time to connect: " << connectTime << "ms");
+            BOOST_TEST(connectTime < 5000U);
+
+            if (handshake)
+            {
+                upstream.Signal(upstreamSink.m_sessionId, Hermes::ServiceDescriptionData(downstreamMachineId, 1U));
+                service.Poll();
+                downstream.Signal(downstreamSink.m_sessionId, Hermes::ServiceDescriptionData(upstreamMachineId, 1U));
+                service.Poll();
+                BOOST_TEST(upstreamSink.m_state == EState::eNOT_AVAILABLE_NOT_READY);
+            }
+        }
+        service.Advance(1500U);
+        BOOST_TEST(upstreamSink.m_state == EState::eDISCONNECTED);
+    }
+}
+
+// Not a test as such: complete handshakes on a VirtualService,
+// run explicitly with --run_test=VirtualServiceHandshakeThroughputTest --log_level=message
+BOOST_AUTO_TEST_CASE(VirtualServiceHandshakeThroughputTest, *boost::unit_test::disabled())
+{
+    TestCaseScope scope("VirtualServiceHandshakeThroughputTest");
+
+    struct QuietUpstreamSink : UpstreamSink
+    {
+        void OnTrace(unsigned, ETraceType, StringView) override {}
+    };
+    struct QuietDownstreamSink : DownstreamSink
+    {
+        void OnTrace(unsigned, ETraceType, StringView) override {}
+    };
+
+    const unsigned cHANDSHAKES = 10000U;
+    std::string upstreamMachineId{"UpstreamMachineId"};
+    std::string downstreamMachineId{"DownstreamMachineId"};
+
+    Hermes::VirtualService service;
+    QuietDownstreamSink downstreamSink;
+    Hermes::Downstream downstream(service, 1U, downstreamSink);
+    downstream.Enable(Hermes::DownstreamSettings(downstreamMachineId, 50101));
+    service.Poll();
+
+    unsigned completed = 0U;
+    auto start = std::chrono::steady_clock::now();
+    for (unsigned i = 0U; i < cHANDSHAKES; ++i)
+    {
+        QuietUpstreamSink upstreamSink;
+        Hermes::Upstream upstream(service, 1U, upstreamSink);
+        upstream.Enable(Hermes::UpstreamSettings(downstreamMachineId, "127.0.0.1", 50101));
+        service.Advance(25U);
+        upstream.Signal(upstreamSink.m_sessionId, Hermes::ServiceDescriptionData(downstreamMachineId, 1U));
+        service.Poll();
+        downstream.Signal(downstreamSink.m_sessionId, Hermes::ServiceDescriptionData(upstreamMachineId, 1U));
+        service.Poll();
+        completed += upstreamSink.m_state == EState::eNOT_AVAILABLE_NOT_READY ? 1U : 0U;
+    }
+    std::chrono::duration<double> duration = std::chrono::steady_clock::now() - start;
+    service.Poll();
+
+    BOOST_TEST(completed == cHANDSHAKES);
+    BOOST_TEST_MESSAGE("Handshakes per second: " << cHANDSHAKES / duration.count());
+}
+
+BOOST_AUTO_TEST_CASE(UpstreamCallbackQueueTest)
+{
+    TestCaseScope scope("UpstreamCallbackQueueTest");
+
+    std::string upstreamMachineId{"UpstreamMachineId"};
+    std::string downstreamMachineId{"DownstreamMachineId"};
+
+    // an application that is busy with a command for as long as the test wants:
+    struct SlowUpstreamSink : UpstreamSink
+    {
+        std::shared_future<void> m_released;
+        std::vector<unsigned> m_commands;
+        bool m_busy{false};
+
+        void On(unsigned sessionId, const Hermes::CommandData& data) override
+        {
+            {
+                ChangeLock lock(this);
+                m_busy = true;
+            }
+            m_released.wait();
+            ChangeLock lock(this);
+            m_commands.push_back(data.m_command);
+        }
+    };
+
+    std::promise<void> release;
+    SlowUpstreamSink upstreamSink;
+    upstreamSink.m_released = release.get_future().share();
+
+    DownstreamSink downstreamSink;
+    Hermes::Downstream downstream(1U, downstreamSink);
+    Runner<Hermes::Downstream> downstreamRunner(downstream);
+
+    Hermes::Upstream upstream(1U, upstreamSink);
+    upstream.UseCallbackQueue(16U, ECallbackQueueOverflow::eWAIT);
+    Runner<Hermes::Upstream> upstreamRunner(upstream);
+
+    DownstreamSettings downstreamSettings{upstreamMachineId, 50101};
+    downstreamSettings.m_checkAlivePeriodInSeconds = 0;
+    downstream.Enable(downstreamSettings);
+    Hermes::UpstreamSettings upstreamSettings(downstreamMachineId, "127.0.0.1", 50101);
+    upstreamSettings.m_checkAlivePeriodInSeconds = 0;
+    upstream.Enable(upstreamSettings);
+
+    WaitFor(downstreamSink, [&]() { return downstreamSink.m_state == EState::eSOCKET_CONNECTED; });
+    WaitFor(upstreamSink, [&]() { return upstreamSink.m_state == EState::eSOCKET_CONNECTED; });
+    upstream.Signal(upstreamSink.m_sessionId, Hermes::ServiceDescriptionData(downstreamMachineId, 1U));
+    WaitFor(downstreamSink, [&]() { return downstreamSink.m_state == EState::eSERVICE_DESCRIPTION_DOWNSTREAM; });
+    downstream.Signal(downstreamSink.m_sessionId, Hermes::ServiceDescriptionData(upstreamMachineId, 1U));
+    WaitFor(upstreamSink, [&]() { return upstreamSink.m_state == EState::eNOT_AVAILABLE_NOT_READY; });
+
+    // while the upstream's application is stuck in the first command, the upstream still answers check alive:
+    for (uint16_t command = 1U; command <= 3U; ++command)
+    {
+        downstream.Signal(downstreamSink.m_sessionId, CommandData(command));
+    }
+    downstream.Signal(downstreamSink.m_sessionId, CheckAliveData{ECheckAliveType::ePING, std::string{"DownstreamId"}});
+    WaitFor(downstreamSink, [&]() { return downstreamSink.m_checkAliveData.m_optionalId.has_value(); });
+    BOOST_TEST(downstreamSink.m_checkAliveData.m_optionalType.value_or(ECheckAliveType::eUNKNOWN) == ECheckAliveType::ePONG);
+    {
+        Lock lock(upstreamSink.m_mutex);
+        BOOST_TEST(upstreamSink.m_commands.empty());
+        BOOST_TEST(!upstreamSink.m_checkAliveData.m_optionalId);
+    }
+
+    // once it gets going again, it gets all in order:
+    release.set_value();
+    WaitFor(upstreamSink, [&]() { return upstreamSink.m_checkAliveData.m_optionalId.has_value(); });
+    BOOST_TEST((upstreamSink.m_commands == std::vector<unsigned>{1U, 2U, 3U}));
+
+    // with eDISCONNECT, an overflow ends the session: what was queued before still comes, then the disconnect,
+    // but nothing of that session after the overflow, even once the queue has room again:
+    static constexpr unsigned cDISCONNECTED = 0U; // not a command, what the sink below records on disconnect (static for its use there)
+    struct OverflowingUpstreamSink : SlowUpstreamSink
+    {
+        void OnDisconnected(unsigned sessionId, EState state, const Hermes::Error& error) override
+        {
+            SlowUpstreamSink::OnDisconnected(sessionId, state, error);
+            ChangeLock lock(this);
+            m_commands.push_back(cDISCONNECTED);
+        }
+    };
+
+    std::promise<void> releaseOverflowing;
+    OverflowingUpstreamSink overflowingSink;
+    overflowingSink.m_released = releaseOverflowing.get_future().share();
+
+    DownstreamSink otherDownstreamSink;
+    Hermes::Downstream otherDownstream(2U, otherDownstreamSink);
+    Runner<Hermes::Downstream> otherDownstreamRunner(otherDownstream);
+
+    Hermes::Upstream overflowingUpstream(2U, overflowingSink);
+    overflowingUpstream.UseCallbackQueue(2U, ECallbackQueueOverflow::eDISCONNECT);
+    Runner<Hermes::Upstream> overflowingUpstreamRunner(overflowingUpstream);
+
+    downstreamSettings.m_port = 50102;
+    otherDownstream.Enable(downstreamSettings);
+    upstreamSettings.m_port = 50102;
+    overflowingUpstream.Enable(upstreamSettings);
+
+    WaitFor(otherDownstreamSink, [&]() { return otherDownstreamSink.m_state == EState::eSOCKET_CONNECTED; });
+    WaitFor(overflowingSink, [&]() { return overflowingSink.m_state == EState::eSOCKET_CONNECTED; });
+    overflowingUpstream.Signal(overflowingSink.m_sessionId, Hermes::ServiceDescriptionData(downstreamMachineId, 1U));
+    WaitFor(otherDownstreamSink, [&]() { return otherDownstreamSink.m_state == EState::eSERVICE_DESCRIPTION_DOWNSTREAM; });
+    otherDownstream.Signal(otherDownstreamSink.m_sessionId, Hermes::ServiceDescriptionData(upstreamMachineId, 1U));
+    WaitFor(overflowingSink, [&]() { return overflowingSink.m_state == EState::eNOT_AVAILABLE_NOT_READY; });
+
+    otherDownstream.Signal(otherDownstreamSink.m_sessionId, CommandData(1U));
+    WaitFor(overflowingSink, [&]() { return overflowingSink.m_busy; });
+    for (uint16_t command = 2U; command <= 6U; ++command)
+    {
+        otherDownstream.Signal(otherDownstreamSink.m_sessionId, CommandData(command));
+    }
+    // the upstream tells why it disconnects:
+    WaitFor(otherDownstreamSink, [&]() { return !otherDownstreamSink.m_notificationData.m_description.empty(); });
+
+    releaseOverflowing.set_value();
+    WaitFor(overflowingSink, [&]() { return !overflowingSink.m_commands.empty() && overflowingSink.m_commands.back() == cDISCONNECTED; });
+    BOOST_TEST((overflowingSink.m_commands == std::vector<unsigned>{1U, 2U, 3U, cDISCONNECTED}));
+}
+
+#if defined(__cpp_impl_coroutine)
+namespace
+{
+    Coroutine UpstreamTransfer(AwaitingUpstream& upstream, std::promise<TransportFinishedData>& finished)
+    {
+        auto sessionId = co_await upstream.WaitForConnection();
+        upstream.Signal(sessionId, ServiceDescriptionData("DownstreamMachineId", 1U));
+        co_await upstream.WaitFor<ServiceDescriptionData>(sessionId);
+        upstream.Signal(sessionId, MachineReadyData());
+        const auto* pBoardAvailable = co_await upstream.WaitFor<BoardAvailableData>(sessionId);
+        std::string boardId = pBoardAvailable->m_boardId;
+        finished.set_value(*co_await upstream.StartTransport(sessionId, StartTransportData(boardId)));
+        upstream.Signal(sessionId, StopTransportData(ETransferState::eCOMPLETE, boardId));
+    }
+
+    Coroutine DownstreamTransfer(AwaitingDownstream& downstream, std::promise<StopTransportData>& stopped)
+    {
+        auto sessionId = co_await downstream.WaitForConnection();
+        co_await downstream.WaitFor<ServiceDescriptionData>(sessionId);
+        downstream.Signal(sessionId, ServiceDescriptionData("UpstreamMachineId", 1U));
+        co_await downstream.WaitFor<MachineReadyData>(sessionId);
+        BoardAvailableData boardAvailable;
+        boardAvailable.m_boardId = "CoroutineBoardId";
+        downstream.Signal(sessionId, boardAvailable);
+        const auto* pStartTransport = co_await downstream.WaitFor<StartTransportData>(sessionId);
+        stopped.set_value(*co_await downstream.TransportFinished(sessionId,
+            TransportFinishedData(ETransferState::eCOMPLETE, pStartTransport->m_boardId)));
+    }
+
+    Coroutine PingPong(AwaitingUpstream& upstream, unsigned sessionId, unsigned count, std::promise<void>& done)
+    {
+        NotificationData ping(ENotificationCode::eUNSPECIFIC, ESeverity::eINFO, "Ping");
+        for (unsigned i = 0U; i < count; ++i)
+        {
+            upstream.Signal(sessionId, ping);
+            co_await upstream.WaitFor<NotificationData>(sessionId);
+        }
+        done.set_value();
+    }
+
+    Coroutine AwaitNotification(Inbox<NotificationData>& inbox, unsigned sessionId, std::vector<std::string>& descriptions)
+    {
+        const auto* pNotification = co_await inbox.WaitFor(sessionId);
+        descriptions.push_back(pNotification ? pNotification->m_description : "disconnected");
+    }
+
+    Coroutine AwaitMachineReady(AwaitingDownstream& downstream, std::vector<std::string>& steps)
+    {
+        auto sessionId = co_await downstream.WaitForConnection();
+        co_await downstream.WaitFor<ServiceDescriptionData>(sessionId);
+        downstream.Signal(sessionId, ServiceDescriptionData("UpstreamMachineId", 1U));
+        co_await downstream.WaitFor<NotificationData>(sessionId);
+        steps.push_back("notified");
+        co_await downstream.WaitFor<MachineReadyData>(sessionId);
+        steps.push_back("ready");
+        if (!co_await downstream.WaitFor<MachineReadyData>(sessionId))
+        {
+            steps.push_back("disconnected");
+        }
+    }
+}
+
+BOOST_AUTO_TEST_CASE(UpstreamCoroutineTest)
+{
+    TestCaseScope scope("UpstreamCoroutineTest");
+
+    AwaitingDownstream downstream(1U);
+    Runner<Hermes::Downstream> downstreamRunner(downstream.Instance());
+    AwaitingUpstream upstream(1U);
+    Runner<Hermes::Upstream> upstreamRunner(upstream.Instance());
+
+    // the coroutines run on the threads of their instances:
+    std::promise<StopTransportData> stopped;
+    std::promise<TransportFinishedData> finished;
+    downstream.Instance().Post([&]() { DownstreamTransfer(downstream, stopped); });
+    upstream.Instance().Post([&]() { UpstreamTransfer(upstream, finished); });
+
+    downstream.Instance().Enable(DownstreamSettings("UpstreamMachineId", 50101));
+    upstream.Instance().Enable(UpstreamSettings("DownstreamMachineId", "127.0.0.1", 50101));
+
+    auto transportFinished = finished.get_future().get();
+    BOOST_TEST(transportFinished.m_boardId == "CoroutineBoardId");
+    auto stopTransport = stopped.get_future().get();
+    BOOST_TEST(stopTransport.m_boardId == "CoroutineBoardId");
+    BOOST_TEST(stopTransport.m_transferState == ETransferState::eCOMPLETE);
+}
+
+BOOST_AUTO_TEST_CASE(CoroutineInboxTest)
+{
+    TestCaseScope scope("CoroutineInboxTest");
+
+    // only the latest unclaimed message of each session is kept:
+    {
+        Inbox<NotificationData> inbox;
+        inbox.Deliver(1U, NotificationData(ENotificationCode::eUNSPECIFIC, ESeverity::eINFO, "first"));
+        inbox.Deliver(1U, NotificationData(ENotificationCode::eUNSPECIFIC, ESeverity::eINFO, "second"));
+        inbox.Deliver(2U, NotificationData(ENotificationCode::eUNSPECIFIC, ESeverity::eINFO, "other"));
+
+        std::vector<std::string> descriptions;
+        AwaitNotification(inbox, 1U, descriptions);
+        AwaitNotification(inbox, 2U, descriptions);
+        BOOST_TEST((descriptions == std::vector<std::string>{"second", "other"}));
+
+        AwaitNotification(inbox, 1U, descriptions);
+        BOOST_TEST(descriptions.size() == 2U);
+        inbox.Deliver(1U, NotificationData(ENotificationCode::eUNSPECIFIC, ESeverity::eINFO, "third"));
+        BOOST_TEST((descriptions == std::vector<std::string>{"second", "other", "third"}));
+
+        // a disconnect resumes those awaiting the session, and only those:
+        AwaitNotification(inbox, 1U, descriptions);
+        AwaitNotification(inbox, 2U, descriptions);
+        inbox.Disconnect(1U);
+        BOOST_TEST((descriptions == std::vector<std::string>{"second", "other", "third", "disconnected"}));
+        inbox.Deliver(2U, NotificationData(ENotificationCode::eUNSPECIFIC, ESeverity::eINFO, "last"));
+        BOOST_TEST(descriptions.back() == "last");
+    }
+
+    // a MachineReady revoked before anyone awaited it is gone:
+    Hermes::VirtualService service;
+    AwaitingDownstream downstream(service, 1U);
+    std::vector<std::string> steps;
+    downstream.Instance().Post([&]() { AwaitMachineReady(downstream, steps); });
+    downstream.Instance().Enable(DownstreamSettings("UpstreamMachineId", 50101));
+
+    UpstreamSink upstreamSink;
+    Hermes::Upstream upstream(service, 1U, upstreamSink);
+    upstream.Enable(UpstreamSettings("DownstreamMachineId", "127.0.0.1", 50101));
+    service.Advance(100U);
+    upstream.Signal(upstreamSink.m_sessionId, ServiceDescriptionData("DownstreamMachineId", 1U));
+    service.Poll();
+    BOOST_TEST(upstreamSink.m_state == EState::eNOT_AVAILABLE_NOT_READY);
+
+    upstream.Signal(upstreamSink.m_sessionId, MachineReadyData());
+    service.Poll();
+    upstream.Signal(upstreamSink.m_sessionId, RevokeMachineReadyData());
+    service.Poll();
+    upstream.Signal(upstreamSink.m_sessionId, NotificationData(ENotificationCode::eUNSPECIFIC, ESeverity::eINFO, "Go on"));
+    service.Poll();
+    BOOST_TEST((steps == std::vector<std::string>{"notified"}));
+
+    upstream.Signal(upstreamSink.m_sessionId, MachineReadyData());
+    service.Poll();
+    BOOST_TEST((steps == std::vector<std::string>{"notified", "ready"}));
+
+    // awaiting the next one when the upstream goes away:
+    upstream.Disable(NotificationData(ENotificationCode::eMACHINE_SHUTDOWN, ESeverity::eINFO, "Done"));
+    service.Poll();
+    BOOST_TEST((steps == std::vector<std::string>{"notified", "ready", "disconnected"}));
+}
+
+// Not a test as such: round trips of notifications, once awaited and once answered from the callback,
+// run explicitly with --run_test=UpstreamCoroutineRoundTripTest --log_level=message
+BOOST_AUTO_TEST_CASE(UpstreamCoroutineRoundTripTest, *boost::unit_test::disabled())
+{
+    TestCaseScope scope("UpstreamCoroutineRoundTripTest");
+
+    struct EchoDownstream : DownstreamSink
+    {
+        Hermes::Downstream* m_pDownstream{nullptr};
+        void On(unsigned sessionId, const NotificationData& data) override { m_pDownstream->Signal(sessionId, data); }
+        void OnTrace(unsigned, ETraceType, StringView) override {}
+    };
+
+    struct PingingUpstream : UpstreamSink
+    {
+        Hermes::Upstream* m_pUpstream{nullptr};
+        unsigned m_count{0U};
+        std::promise<void> m_done;
+        void On(unsigned sessionId, const NotificationData& data) override
+        {
+            if (--m_count)
+                return m_pUpstream->Signal(sessionId, data);
+            m_done.set_value();
+        }
+        void OnTrace(unsigned, ETraceType, StringView) override {}
+    };
+
+    const unsigned cROUND_TRIPS = 10000U;
+    using Clock = std::chrono::steady_clock;
+
+    EchoDownstream downstreamSink;
+    Hermes::Downstream downstream(1U, downstreamSink);
+    downstreamSink.m_pDownstream = &downstream;
+    Runner<Hermes::Downstream> downstreamRunner(downstream);
+    downstream.Enable(DownstreamSettings("UpstreamMachineId", 50101));
+
+    // the plain callbacks first:
+    std::chrono::duration<double> callbackTime;
+    {
+        PingingUpstream upstreamSink;
+        Hermes::Upstream upstream(1U, upstreamSink);
+        upstreamSink.m_pUpstream = &upstream;
+        upstreamSink.m_count = cROUND_TRIPS;
+        Runner<Hermes::Upstream> upstreamRunner(upstream);
+        upstream.Enable(UpstreamSettings("DownstreamMachineId", "127.0.0.1", 50101));
+        WaitFor(upstreamSink, [&]() { return upstreamSink.m_state == EState::eSOCKET_CONNECTED; });
+
+        auto start = Clock::now();
+        upstream.Signal(upstreamSink.m_sessionId, NotificationData(ENotificationCode::eUNSPECIFIC, ESeverity::eINFO, "Ping"));
+        upstreamSink.m_done.get_future().wait();
+        callbackTime = Clock::now() - start;
+    }
+    WaitFor(downstreamSink, [&]() { return downstreamSink.m_state == EState::eDISCONNECTED; });
+
+    std::chrono::duration<double> coroutineTime;
+    {
+        AwaitingUpstream upstream(1U);
+        Runner<Hermes::Upstream> upstreamRunner(upstream.Instance());
+        std::promise<unsigned> connected;
+        upstream.Instance().Post([&]()
+        {
+            [](AwaitingUpstream& upstream, std::promise<unsigned>& connected) -> Coroutine
+            {
+                connected.set_value(co_await upstream.WaitForConnection());
+            }(upstream, connected);
+        });
+        upstream.Instance().Enable(UpstreamSettings("DownstreamMachineId", "127.0.0.1", 50101));
+        auto sessionId = connected.get_future().get();
+
+        std::promise<void> done;
+        auto start = Clock::now();
+        upstream.Instance().Post([&]() { PingPong(upstream, sessionId, cROUND_TRIPS, done); });
+        done.get_future().wait();
+        coroutineTime = Clock::now() - start;
+    }
+
+    BOOST_TEST_MESSAGE("Round trip with callbacks: " << 1e6 * callbackTime.count() / cROUND_TRIPS << "us"
+        << ", awaited: " << 1e6 * coroutineTime.count() / cROUND_TRIPS << "us");
+}
+#endif
@@ -6,7 +6,9 @@
 
 #include <boost/mp11.hpp>
 
+#include <algorithm>
 #include <array>
+#include <thread>
 #include <HermesSerialization.hpp>
 
 using namespace Hermes;
@@ -354,6 +356,73 @@ BOOST_AUTO_TEST_CASE(VerticalBoardTrackingTest)
     clients.clear(); // desctruction should terminate all client threads
 }
 
+BOOST_AUTO_TEST_CASE(VerticalMultiThreadedServiceTest)
+{
+    TestCaseScope scope("VerticalMultiThreadedServiceTest");
+
+    std::string serviceSystemId{ "MyService" };
+    VerticalServiceSink serviceSink;
+    Hermes::VerticalService verticalService(serviceSink);
+    std::thread serviceThread([&]() { verticalService.Run(4U); });
+    verticalService.Enable(Hermes::VerticalServiceSettings(serviceSystemId, 50100));
+
+    Hermes::SupervisoryServiceDescriptionData serviceDescription{ serviceSystemId };
+    Hermes::SupervisoryServiceDescriptionData clientDescription{ std::string{} };
+    clientDescription.m_supportedFeatures.m_optionalFeatureBoardTracking = Hermes::FeatureBoardTracking{};
+
+    const std::size_t cCLIENT_COUNT = 6;
+    Clients clients;
+    for (auto i = 0U; i < cCLIENT_COUNT; ++i)
+    {
+        clients.emplace_back(std::make_unique<Client>(i));
+        auto& client = *clients.back();
+        client.m_impl.Enable(Hermes::VerticalClientSettings(client.m_systemId, "127.0.0.1", 50100));
+        WaitFor(client.m_sink, [&]() { return client.m_sink.m_state == Hermes::EVerticalState::eSOCKET_CONNECTED; });
+        client.Signal(clientDescription);
+    }
+
+    // the sessions are served on different threads, so they come up in any order:
+    WaitFor(serviceSink, [&]()
+    {
+        return serviceSink.m_sessionMap.size() == cCLIENT_COUNT && std::all_of(serviceSink.m_sessionMap.begin(), serviceSink.m_sessionMap.end(),
+            [](const auto& entry) { return entry.second.m_state == Hermes::EVerticalState::eSUPERVISORY_SERVICE_DESCRIPTION; });
+    });
+    std::vector<unsigned> sessionIds;
+    for (const auto& entry : serviceSink.m_sessionMap)
+    {
+        sessionIds.push_back(entry.first);
+    }
+    for (auto sessionId : sessionIds)
+    {
+        verticalService.Signal(sessionId, serviceDescription);
+    }
+    for (auto& upClient : clients)
+    {
+        auto& clientSink = upClient->m_sink;
+        WaitFor(clientSink, [&]() { return clientSink.m_state == Hermes::EVerticalState::eCONNECTED; });
+    }
+
+    // each session keeps the order of what is signalled to it:
+    BoardArrivedData boardArrivedData{ "Arrived", 1, EBoardArrivedTransfer::eINSERTED, "ArrivedId", "myself"
+        , EBoardQuality::eGOOD, EFlippedBoard::eTOP_SIDE_IS_UP };
+    NotificationData notificationData{ ENotificationCode::eMACHINE_SHUTDOWN, ESeverity::eINFO, "Synchronizer" };
+    verticalService.Signal(boardArrivedData);
+    for (auto sessionId : sessionIds)
+    {
+        verticalService.Signal(sessionId, notificationData);
+    }
+    for (auto& upClient : clients)
+    {
+        auto& clientSink = upClient->m_sink;
+        WaitFor(clientSink, [&]() { return clientSink.m_notificationData == notificationData; });
+        BOOST_TEST(clientSink.m_boardArrivedData == boardArrivedData);
+    }
+
+    clients.clear();
+    verticalService.Stop();
+    serviceThread.join();
+}
+
 BOOST_AUTO_TEST_CASE(VerticalCheckAliveTest)
 {
     TestCaseScope scope("VerticalCheckAliveTest");
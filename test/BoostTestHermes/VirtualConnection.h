@@ -0,0 +1,42 @@
+// Copyright (c) ASM Assembly Systems GmbH & Co. KG
+#pragma once
+
+#include "Sinks.h"
+
+// A Downstream on port 50101 and an Upstream connecting to it, on a VirtualService driven by the test thread.
+// Set up the two as needed (trace mask, trace file, ...) before Connect():
+template<class DownstreamSinkT = Hermes::DownstreamSink, class UpstreamSinkT = Hermes::UpstreamSink>
+struct VirtualConnection
+{
+    Hermes::VirtualService m_service;
+    DownstreamSinkT m_downstreamSink;
+    Hermes::Downstream m_downstream{m_service, 1U, m_downstreamSink};
+    UpstreamSinkT m_upstreamSink;
+    Hermes::Upstream m_upstream{m_service, 1U, m_upstreamSink};
+
+    // up to the ServiceDescription of the upstream:
+    void Connect()
+    {
+        m_downstream.Enable(Hermes::DownstreamSettings("UpstreamMachineId", 50101));
+        m_upstream.Enable(Hermes::UpstreamSettings("DownstreamMachineId", "127.0.0.1", 50101));
+        m_service.Advance(100U);
+        m_upstream.Signal(m_upstreamSink.m_sessionId, Hermes::ServiceDescriptionData("DownstreamMachineId", 1U));
+        m_service.Poll();
+        BOOST_TEST(m_downstreamSink.m_state == Hermes::EState::eSERVICE_DESCRIPTION_DOWNSTREAM);
+    }
+
+    // the ServiceDescription of the downstream, after Connect():
+    void CompleteServiceDescription()
+    {
+        m_downstream.Signal(m_downstreamSink.m_sessionId, Hermes::ServiceDescriptionData("UpstreamMachineId", 1U));
+        m_service.Poll();
+        BOOST_TEST(m_downstreamSink.m_state == Hermes::EState::eNOT_AVAILABLE_NOT_READY);
+        BOOST_TEST(m_upstreamSink.m_state == Hermes::EState::eNOT_AVAILABLE_NOT_READY);
+    }
+
+    void Handshake()
+    {
+        Connect();
+        CompleteServiceDescription();
+    }
+};